@@ -0,0 +1,22 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+// 各模块的用例注册入口，由main按顺序调用
+
+// MathUtils：三点圆弧、贝塞尔、外接圆、平面拟合
+void registerMathBenchmarks();
+
+// constraint::* 约束函数
+void registerConstraintBenchmarks();
+
+// 每种Geo3D在各细分级别下的构建、重建和拖拽；检查按阶段局部重建的顶点/边/面与全量重建一致
+void registerGeometryBenchmarks();
+
+// GeometryPickingSystem::pickGeometry 合成场景拾取
+void registerPickingBenchmarks();
+
+// GeoOsgbIO 保存/读取往返；BatchProcessor 单线程与多线程对照
+void registerIOBenchmarks();
+
+// GeoEntityStore 批量创建、包围盒更新和区域查询（对照Geo3D创建）；检查场景对象与实体存储同步
+void registerEntityBenchmarks();
@@ -0,0 +1,294 @@
+﻿#include "BenchmarkHarness.h"
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QRegularExpression>
+#include <QSysInfo>
+#include <QTextStream>
+#include <osg/Timer>
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace
+{
+    const int kResultFormatVersion = 1;
+
+    volatile double g_benchmarkSink = 0.0;
+
+    QTextStream& out()
+    {
+        static QTextStream stream(stdout);
+        return stream;
+    }
+
+    double percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty()) return 0.0;
+        size_t index = std::min(sorted.size() - 1, static_cast<size_t>(std::ceil(sorted.size() * p)) - 1);
+        return sorted[index];
+    }
+}
+
+void benchmarkKeep(double value)
+{
+    g_benchmarkSink = g_benchmarkSink + value;
+}
+
+// ============= BenchmarkStats =============
+
+QJsonObject BenchmarkStats::toJson() const
+{
+    QJsonObject object;
+    object["name"] = name;
+    object["iterations"] = iterations;
+    object["operations"] = operations;
+    object["min_ms"] = minMs;
+    object["median_ms"] = medianMs;
+    object["mean_ms"] = meanMs;
+    object["p95_ms"] = p95Ms;
+    object["max_ms"] = maxMs;
+    object["stddev_ms"] = stddevMs;
+    object["ns_per_op"] = nsPerOperation();
+    return object;
+}
+
+BenchmarkStats BenchmarkStats::fromJson(const QJsonObject& object)
+{
+    BenchmarkStats stats;
+    stats.name = object["name"].toString();
+    stats.iterations = object["iterations"].toInt();
+    stats.operations = object["operations"].toInt(1);
+    stats.minMs = object["min_ms"].toDouble();
+    stats.medianMs = object["median_ms"].toDouble();
+    stats.meanMs = object["mean_ms"].toDouble();
+    stats.p95Ms = object["p95_ms"].toDouble();
+    stats.maxMs = object["max_ms"].toDouble();
+    stats.stddevMs = object["stddev_ms"].toDouble();
+    return stats;
+}
+
+QString BenchmarkStats::toString() const
+{
+    return QString("%1  中位%2ms  平均%3ms  最小%4ms  P95 %5ms  最大%6ms  (%7ns/op, n=%8)")
+        .arg(name, -48)
+        .arg(medianMs, 0, 'f', 4)
+        .arg(meanMs, 0, 'f', 4)
+        .arg(minMs, 0, 'f', 4)
+        .arg(p95Ms, 0, 'f', 4)
+        .arg(maxMs, 0, 'f', 4)
+        .arg(nsPerOperation(), 0, 'f', 1)
+        .arg(iterations);
+}
+
+// ============= BenchmarkRegistry =============
+
+BenchmarkRegistry& BenchmarkRegistry::getInstance()
+{
+    static BenchmarkRegistry instance;
+    return instance;
+}
+
+void BenchmarkRegistry::add(const QString& name, int operations, BenchmarkFactory factory)
+{
+    BenchmarkCase benchmarkCase;
+    benchmarkCase.name = name;
+    benchmarkCase.operations = std::max(1, operations);
+    benchmarkCase.factory = std::move(factory);
+    m_cases.push_back(std::move(benchmarkCase));
+}
+
+void BenchmarkRegistry::addCheck(const QString& name, BenchmarkCheck check)
+{
+    BenchmarkCheckCase checkCase;
+    checkCase.name = name;
+    checkCase.check = std::move(check);
+    m_checks.push_back(std::move(checkCase));
+}
+
+// ============= BenchmarkRunner =============
+
+BenchmarkStats BenchmarkRunner::runCase(const BenchmarkCase& benchmarkCase, const BenchmarkOptions& options)
+{
+    BenchmarkStats stats;
+    stats.name = benchmarkCase.name;
+    stats.operations = benchmarkCase.operations;
+
+    BenchmarkBody body = benchmarkCase.factory();
+    if (!body) return stats;
+
+    for (int i = 0; i < options.warmupIterations; ++i) {
+        body();
+    }
+
+    std::vector<double> samples;
+    samples.reserve(options.iterations);
+    osg::Timer* timer = osg::Timer::instance();
+    for (int i = 0; i < options.iterations; ++i) {
+        osg::Timer_t start = timer->tick();
+        body();
+        samples.push_back(timer->delta_m(start, timer->tick()));
+    }
+    if (samples.empty()) return stats;
+
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (double value : samples) total += value;
+
+    stats.iterations = static_cast<int>(samples.size());
+    stats.minMs = samples.front();
+    stats.maxMs = samples.back();
+    stats.meanMs = total / samples.size();
+    stats.medianMs = samples.size() % 2 == 1
+        ? samples[samples.size() / 2]
+        : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) * 0.5;
+    stats.p95Ms = percentile(samples, 0.95);
+
+    double variance = 0.0;
+    for (double value : samples) variance += (value - stats.meanMs) * (value - stats.meanMs);
+    stats.stddevMs = std::sqrt(variance / samples.size());
+
+    return stats;
+}
+
+std::vector<BenchmarkStats> BenchmarkRunner::runAll(const BenchmarkOptions& options)
+{
+    std::vector<BenchmarkStats> results;
+    QRegularExpression filter(options.filter);
+
+    for (const BenchmarkCase& benchmarkCase : BenchmarkRegistry::getInstance().cases()) {
+        if (!options.filter.isEmpty() && !filter.match(benchmarkCase.name).hasMatch()) continue;
+
+        BenchmarkStats stats = runCase(benchmarkCase, options);
+        out() << stats.toString() << Qt::endl;
+        results.push_back(stats);
+    }
+    return results;
+}
+
+int BenchmarkRunner::runChecks(const QString& filterText)
+{
+    int failed = 0;
+    int total = 0;
+    QRegularExpression filter(filterText);
+
+    for (const BenchmarkCheckCase& checkCase : BenchmarkRegistry::getInstance().checks()) {
+        if (!filterText.isEmpty() && !filter.match(checkCase.name).hasMatch()) continue;
+
+        QString message;
+        const bool passed = checkCase.check(message);
+        ++total;
+        if (!passed) ++failed;
+
+        out() << QString("%1  %2").arg(checkCase.name, -48).arg(passed ? "通过" : "失败");
+        if (!message.isEmpty()) out() << "  " << message;
+        out() << Qt::endl;
+    }
+
+    out() << QString("检查%1项，失败%2项").arg(total).arg(failed) << Qt::endl;
+    return failed;
+}
+
+bool BenchmarkRunner::writeJson(const QString& filePath, const std::vector<BenchmarkStats>& results)
+{
+    QJsonArray array;
+    for (const BenchmarkStats& stats : results) {
+        array.append(stats.toJson());
+    }
+
+    QJsonObject root;
+    root["format_version"] = kResultFormatVersion;
+    root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    root["host"] = QSysInfo::machineHostName();
+    root["cpu_arch"] = QSysInfo::currentCpuArchitecture();
+    root["os"] = QSysInfo::prettyProductName();
+#ifdef NDEBUG
+    root["build"] = "release";
+#else
+    root["build"] = "debug";
+#endif
+    root["results"] = array;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        out() << QString("无法写入结果文件: %1").arg(filePath) << Qt::endl;
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return true;
+}
+
+bool BenchmarkRunner::readJson(const QString& filePath, std::vector<BenchmarkStats>& results)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        out() << QString("无法读取结果文件: %1").arg(filePath) << Qt::endl;
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()) {
+        out() << QString("结果文件格式错误: %1 (%2)").arg(filePath, error.errorString()) << Qt::endl;
+        return false;
+    }
+
+    results.clear();
+    for (const QJsonValue& value : document.object()["results"].toArray()) {
+        results.push_back(BenchmarkStats::fromJson(value.toObject()));
+    }
+    return true;
+}
+
+int BenchmarkRunner::compare(const QString& baselinePath, const QString& currentPath, double thresholdPercent)
+{
+    std::vector<BenchmarkStats> baseline;
+    std::vector<BenchmarkStats> current;
+    if (!readJson(baselinePath, baseline) || !readJson(currentPath, current)) return -1;
+
+    std::map<QString, BenchmarkStats> baselineByName;
+    for (const BenchmarkStats& stats : baseline) {
+        baselineByName[stats.name] = stats;
+    }
+
+    int regressions = 0;
+    int improvements = 0;
+    out() << QString("%1 %2 %3 %4").arg("用例", -48).arg("基线(ms)", 12).arg("当前(ms)", 12).arg("变化", 10) << Qt::endl;
+
+    for (const BenchmarkStats& stats : current) {
+        auto it = baselineByName.find(stats.name);
+        if (it == baselineByName.end()) {
+            out() << QString("%1 %2 %3 %4").arg(stats.name, -48).arg("-", 12)
+                         .arg(stats.medianMs, 12, 'f', 4).arg("新增", 10) << Qt::endl;
+            continue;
+        }
+
+        const BenchmarkStats& base = it->second;
+        double deltaPercent = base.medianMs > 0.0 ? (stats.medianMs - base.medianMs) / base.medianMs * 100.0 : 0.0;
+        QString marker;
+        if (deltaPercent > thresholdPercent) {
+            marker = "  <-- 变慢";
+            ++regressions;
+        } else if (deltaPercent < -thresholdPercent) {
+            marker = "  变快";
+            ++improvements;
+        }
+
+        out() << QString("%1 %2 %3 %4%5").arg(stats.name, -48)
+                     .arg(base.medianMs, 12, 'f', 4)
+                     .arg(stats.medianMs, 12, 'f', 4)
+                     .arg(QString("%1%2%").arg(deltaPercent >= 0.0 ? "+" : "").arg(deltaPercent, 0, 'f', 1), 10)
+                     .arg(marker) << Qt::endl;
+        baselineByName.erase(it);
+    }
+
+    for (const auto& removed : baselineByName) {
+        out() << QString("%1 %2 %3 %4").arg(removed.first, -48)
+                     .arg(removed.second.medianMs, 12, 'f', 4).arg("-", 12).arg("已移除", 10) << Qt::endl;
+    }
+
+    out() << QString("阈值±%1%: 变慢%2个, 变快%3个").arg(thresholdPercent, 0, 'f', 1)
+                 .arg(regressions).arg(improvements) << Qt::endl;
+    return regressions;
+}
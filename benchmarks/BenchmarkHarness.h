@@ -0,0 +1,99 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <QJsonObject>
+#include <QString>
+#include <functional>
+#include <vector>
+
+// 一次迭代的计时体；准备工作在工厂里完成，不计入耗时
+using BenchmarkBody = std::function<void()>;
+using BenchmarkFactory = std::function<BenchmarkBody()>;
+
+// 基准用例
+struct BenchmarkCase
+{
+    QString name;               // 唯一名称，如 "math/arc_three_points"，比较两次运行时按名称对齐
+    int operations = 1;         // 每次迭代包含的操作数，用于换算单次操作耗时
+    BenchmarkFactory factory;
+};
+
+// 正确性检查：与基准共用场景构建代码，失败时返回false并在message中说明原因
+using BenchmarkCheck = std::function<bool(QString& message)>;
+
+struct BenchmarkCheckCase
+{
+    QString name;
+    BenchmarkCheck check;
+};
+
+// 单个用例的统计结果
+struct BenchmarkStats
+{
+    QString name;
+    int iterations = 0;
+    int operations = 1;
+    double minMs = 0.0;
+    double medianMs = 0.0;
+    double meanMs = 0.0;
+    double p95Ms = 0.0;
+    double maxMs = 0.0;
+    double stddevMs = 0.0;
+
+    double nsPerOperation() const { return operations > 0 ? medianMs * 1.0e6 / operations : 0.0; }
+
+    QJsonObject toJson() const;
+    static BenchmarkStats fromJson(const QJsonObject& object);
+    QString toString() const;
+};
+
+// 运行参数
+struct BenchmarkOptions
+{
+    int warmupIterations = 3;
+    int iterations = 20;
+    QString filter;             // 正则，匹配用例名称，为空时运行全部
+};
+
+// 用例注册表 - 各模块在main中显式注册，避免静态初始化顺序问题
+class BenchmarkRegistry
+{
+public:
+    static BenchmarkRegistry& getInstance();
+
+    void add(const QString& name, int operations, BenchmarkFactory factory);
+    const std::vector<BenchmarkCase>& cases() const { return m_cases; }
+
+    void addCheck(const QString& name, BenchmarkCheck check);
+    const std::vector<BenchmarkCheckCase>& checks() const { return m_checks; }
+
+private:
+    BenchmarkRegistry() = default;
+
+    std::vector<BenchmarkCase> m_cases;
+    std::vector<BenchmarkCheckCase> m_checks;
+};
+
+// 基准运行器
+class BenchmarkRunner
+{
+public:
+    static BenchmarkStats runCase(const BenchmarkCase& benchmarkCase, const BenchmarkOptions& options);
+    static std::vector<BenchmarkStats> runAll(const BenchmarkOptions& options);
+
+    // 运行名称匹配filter的检查，返回失败数
+    static int runChecks(const QString& filter);
+
+    // 机器可读结果，格式见writeJson
+    static bool writeJson(const QString& filePath, const std::vector<BenchmarkStats>& results);
+    static bool readJson(const QString& filePath, std::vector<BenchmarkStats>& results);
+
+    // 按中位数比较两次运行，返回变慢超过阈值的用例数，文件读取失败返回-1
+    static int compare(const QString& baselinePath, const QString& currentPath, double thresholdPercent);
+
+private:
+    BenchmarkRunner() = delete;  // 禁止实例化
+};
+
+// 吞掉计算结果，防止编译器把被测代码优化掉
+void benchmarkKeep(double value);
@@ -0,0 +1,141 @@
+﻿#include "BenchmarkScenes.h"
+#include "../src/core/managers/GeoControlPointManager.h"
+#include "../src/core/managers/GeoNodeManager.h"
+#include "../src/core/managers/GeoStateManager.h"
+#include "../src/util/GeometryFactory.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const int kOpenStagePoints = 6;     // 无上限阶段喂入的点数
+    const int kMaxFeedPoints = 64;      // 防止异常阶段描述导致死循环
+    const double kGridSpacing = 2.0;
+    const double kTriangleSize = 1.0;
+    const double kMixedSpacing = 30.0;
+
+    // 螺旋上升的输入点，相邻点不共线也不共面，交给各阶段约束去投影
+    glm::dvec3 feedPoint(int index, const glm::dvec3& offset)
+    {
+        double angle = index * 1.3;
+        double radius = 5.0 + index * 0.1;
+        return offset + glm::dvec3(radius * std::cos(angle), radius * std::sin(angle), index * 0.7);
+    }
+}
+
+const std::vector<BenchmarkGeoType>& benchmarkGeoTypes()
+{
+    static const std::vector<BenchmarkGeoType> types = {
+        { Geo_Point3D, "Point" },
+        { Geo_Line3D, "Line" },
+        { Geo_Arc3D, "Arc" },
+        { Geo_BezierCurve3D, "BezierCurve" },
+        { Geo_Triangle3D, "Triangle" },
+        { Geo_Quad3D, "Quad" },
+        { Geo_Polygon3D, "Polygon" },
+        { Geo_Box3D, "Box" },
+        { Geo_Cube3D, "Cube" },
+        { Geo_Cone3D, "Cone" },
+        { Geo_Cylinder3D, "Cylinder" },
+        { Geo_Prism3D, "Prism" },
+        { Geo_Torus3D, "Torus" },
+        { Geo_Sphere3D, "Sphere" },
+        { Geo_Hemisphere3D, "Hemisphere" },
+        { Geo_Ellipsoid3D, "Ellipsoid" },
+        { Geo_FlatHouse3D, "FlatHouse" },
+        { Geo_DomeHouse3D, "DomeHouse" },
+        { Geo_SpireHouse3D, "SpireHouse" },
+        { Geo_GableHouse3D, "GableHouse" },
+        { Geo_LHouse3D, "LHouse" },
+    };
+    return types;
+}
+
+Geo3D::Ptr buildBenchmarkGeometry(GeoType3D type, SubdivisionLevel3D level, const glm::dvec3& offset)
+{
+    Geo3D::Ptr geo = GeometryFactory::createGeometry(type);
+    if (!geo) return geo;
+
+    GeoParameters3D params = geo->getParameters();
+    params.subdivisionLevel = level;
+    geo->setParameters(params);
+
+    GeoControlPointManager* controlPoints = geo->mm_controlPoint();
+    const StageDescriptors& descriptors = geo->getStageDescriptors();
+
+    for (int fed = 0; fed < kMaxFeedPoints; ++fed) {
+        if (geo->mm_state()->isStateComplete() || geo->mm_state()->isStateInvalid()) break;
+
+        // 未完成时返回的最后一个阶段末尾带有预览用的临时点，不计入已放置的点数
+        const auto& stages = controlPoints->getAllStageControlPoints();
+        size_t stageIdx = stages.size() - 1;
+        if (stageIdx >= descriptors.size()) break;
+
+        const StageDescriptor& descriptor = descriptors[stageIdx];
+        int placed = static_cast<int>(stages.back().size()) - 1;
+        int target = std::min(descriptor.maxControlPoints, std::max(descriptor.minControlPoints, kOpenStagePoints));
+        if (placed >= target) {
+            // 达到上限的阶段会在addControlPoint里自动切换，这里只处理上限更大的阶段
+            controlPoints->nextStage();
+            continue;
+        }
+        controlPoints->addControlPoint(Point3D(feedPoint(fed, offset)));
+    }
+
+    return geo;
+}
+
+void buildTriangleGridScene(osg::Group* root, int objectCount, std::vector<Geo3D::Ptr>& geometries)
+{
+    int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(objectCount))));
+    geometries.reserve(geometries.size() + objectCount);
+
+    for (int i = 0; i < objectCount; ++i) {
+        double x = (i % columns) * kGridSpacing;
+        double y = (i / columns) * kGridSpacing;
+
+        Geo3D::Ptr geo = GeometryFactory::createGeometry(Geo_Triangle3D);
+        if (!geo) continue;
+
+        auto controlPointManager = geo->mm_controlPoint();
+        controlPointManager->addControlPoint(Point3D(x, y, 0.0));
+        controlPointManager->addControlPoint(Point3D(x + kTriangleSize, y, 0.0));
+        controlPointManager->addControlPoint(Point3D(x, y + kTriangleSize, 0.0));
+
+        root->addChild(geo->mm_node()->getOSGNode().get());
+        geometries.push_back(geo);
+    }
+}
+
+void buildMixedScene(osg::Group* root, int objectCount, SubdivisionLevel3D level, std::vector<Geo3D::Ptr>& geometries)
+{
+    const std::vector<BenchmarkGeoType>& types = benchmarkGeoTypes();
+    int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(objectCount))));
+    geometries.reserve(geometries.size() + objectCount);
+
+    for (int i = 0; i < objectCount; ++i) {
+        glm::dvec3 offset((i % columns) * kMixedSpacing, (i / columns) * kMixedSpacing, 0.0);
+        Geo3D::Ptr geo = buildBenchmarkGeometry(types[i % types.size()].type, level, offset);
+        if (!geo || !geo->mm_state()->isStateComplete()) continue;
+
+        root->addChild(geo->mm_node()->getOSGNode().get());
+        geometries.push_back(geo);
+    }
+}
+
+osg::ref_ptr<osg::Camera> createBenchmarkCamera(const osg::BoundingSphere& bound, int width, int height)
+{
+    osg::ref_ptr<osg::Camera> camera = new osg::Camera();
+    camera->setReferenceFrame(osg::Transform::ABSOLUTE_RF);
+    camera->setViewport(0, 0, width, height);
+
+    const double fovy = 45.0;
+    camera->setProjectionMatrixAsPerspective(fovy, static_cast<double>(width) / height, 0.1, 100000.0);
+
+    double radius = bound.valid() ? bound.radius() : 1.0;
+    double distance = radius / std::sin(osg::DegreesToRadians(fovy * 0.5));
+    osg::Vec3d center = bound.valid() ? osg::Vec3d(bound.center()) : osg::Vec3d();
+    camera->setViewMatrixAsLookAt(center + osg::Vec3d(0.0, 0.0, distance), center, osg::Vec3d(0.0, 1.0, 0.0));
+
+    return camera;
+}
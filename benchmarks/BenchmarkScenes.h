@@ -0,0 +1,31 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include "../src/core/Common3D.h"
+#include "../src/core/GeometryBase.h"
+#include <osg/Camera>
+#include <osg/Group>
+#include <QString>
+#include <vector>
+
+// 参与基准的几何类型及其在用例名中的标识
+struct BenchmarkGeoType
+{
+    GeoType3D type;
+    const char* name;
+};
+
+const std::vector<BenchmarkGeoType>& benchmarkGeoTypes();
+
+// 按阶段描述喂入控制点直到绘制完成，模拟一次完整的交互绘制
+// 无上限的阶段（如多边形）喂满固定点数后手动切换阶段
+Geo3D::Ptr buildBenchmarkGeometry(GeoType3D type, SubdivisionLevel3D level, const glm::dvec3& offset = glm::dvec3(0.0));
+
+// 三角形网格场景，与PickingBenchmark一致
+void buildTriangleGridScene(osg::Group* root, int objectCount, std::vector<Geo3D::Ptr>& geometries);
+
+// 混合类型场景，依次轮换所有几何类型
+void buildMixedScene(osg::Group* root, int objectCount, SubdivisionLevel3D level, std::vector<Geo3D::Ptr>& geometries);
+
+// 俯视整个场景的离屏相机，不创建图形上下文
+osg::ref_ptr<osg::Camera> createBenchmarkCamera(const osg::BoundingSphere& bound, int width, int height);
@@ -0,0 +1,186 @@
+﻿#include "BenchmarkCases.h"
+#include "BenchmarkHarness.h"
+#include "BenchmarkScenes.h"
+#include "../src/core/GeometryBase.h"
+#include "../src/core/managers/GeoControlPointManager.h"
+#include "../src/core/world/GeoEntityStore.h"
+#include "../src/core/world/SceneManager3D.h"
+#include "../src/util/GeometryFactory.h"
+#include <cmath>
+#include <memory>
+
+namespace
+{
+    const double kGridSpacing = 2.0;
+    const double kMixedSpacing = 30.0;
+
+    typedef std::vector<std::vector<Point3D>> Stages;
+
+    Stages triangleStages(int i, int columns)
+    {
+        double x = (i % columns) * kGridSpacing;
+        double y = (i / columns) * kGridSpacing;
+        return { { Point3D(x, y, 0.0), Point3D(x + 1.0, y, 0.0), Point3D(x, y + 1.0, 0.0) } };
+    }
+
+    // 每种类型用基准驱动画一次，取其控制点作为模板，平移后批量写入存储
+    struct MixedTemplate
+    {
+        GeoType3D type;
+        Stages stages;
+    };
+
+    std::vector<MixedTemplate> createMixedTemplates()
+    {
+        std::vector<MixedTemplate> templates;
+        for (const BenchmarkGeoType& geoType : benchmarkGeoTypes()) {
+            Geo3D::Ptr geo = buildBenchmarkGeometry(geoType.type, Subdivision_Medium3D, glm::dvec3(0.0));
+            if (!geo || !geo->mm_state()->isStateComplete()) continue;
+            templates.push_back({ geoType.type, geo->mm_controlPoint()->getAllStageControlPoints() });
+        }
+        return templates;
+    }
+
+    std::shared_ptr<GeoEntityStore> createMixedStore(int objectCount)
+    {
+        const std::vector<MixedTemplate> templates = createMixedTemplates();
+        if (templates.empty()) return nullptr;
+
+        auto store = std::make_shared<GeoEntityStore>();
+        int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(objectCount))));
+        for (int i = 0; i < objectCount; ++i) {
+            const MixedTemplate& source = templates[i % templates.size()];
+            glm::dvec3 offset((i % columns) * kMixedSpacing, (i / columns) * kMixedSpacing, 0.0);
+
+            Stages stages = source.stages;
+            for (auto& stage : stages) {
+                for (Point3D& point : stage) point.position += offset;
+            }
+            store->createFromStages(source.type, stages);
+        }
+        store->updateBounds();
+        return store;
+    }
+
+    bool sameBounds(const BoundingBox3D& a, const osg::BoundingBox& b)
+    {
+        return a.isValid() == b.valid()
+            && (!b.valid() || (a.min == glm::dvec3(b.xMin(), b.yMin(), b.zMin()) && a.max == glm::dvec3(b.xMax(), b.yMax(), b.zMax())));
+    }
+}
+
+void registerEntityBenchmarks()
+{
+    BenchmarkRegistry& registry = BenchmarkRegistry::getInstance();
+
+    // 同样的三角形分别写入实体存储和创建Geo3D（含节点与网格生成），对比每对象开销
+    const int storeCounts[] = { 10000, 100000 };
+    for (int objectCount : storeCounts) {
+        registry.add(QString("entity/store/triangle/%1/create").arg(objectCount), objectCount, [objectCount]() -> BenchmarkBody {
+            int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(objectCount))));
+            return [objectCount, columns]() {
+                GeoEntityStore store;
+                store.reserve(objectCount, objectCount * 3);
+                for (int i = 0; i < objectCount; ++i) {
+                    store.createFromStages(Geo_Triangle3D, triangleStages(i, columns));
+                }
+                benchmarkKeep(static_cast<double>(store.getMemoryUsage()));
+            };
+        });
+    }
+
+    registry.add("entity/geo3d/triangle/10000/create", 10000, []() -> BenchmarkBody {
+        const int objectCount = 10000;
+        int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(objectCount))));
+        return [objectCount, columns]() {
+            std::vector<Geo3D::Ptr> geometries;
+            geometries.reserve(objectCount);
+            for (int i = 0; i < objectCount; ++i) {
+                Geo3D::Ptr geo = GeometryFactory::createGeometry(Geo_Triangle3D);
+                geo->mm_controlPoint()->restoreStages(triangleStages(i, columns));
+                geometries.push_back(geo);
+            }
+            benchmarkKeep(geometries.size());
+        };
+    });
+
+    // 控制点整体变化后重新估算全部包围盒
+    registry.add("entity/store/mixed/100000/update_bounds", 100000, []() -> BenchmarkBody {
+        std::shared_ptr<GeoEntityStore> store = createMixedStore(100000);
+        if (!store) return BenchmarkBody();
+        auto entities = std::make_shared<std::vector<GeoEntity>>();
+        store->forEach([&entities](GeoEntity entity) { entities->push_back(entity); });
+        return [store, entities]() {
+            for (GeoEntity entity : *entities) {
+                store->setControlPoint(entity, 0, Point3D(store->getControlPoints(entity)[0] + glm::dvec3(0.0, 0.0, 1e-3)));
+            }
+            store->updateBounds();
+            benchmarkKeep(store->getBounds(entities->back()).max.z);
+        };
+    });
+
+    // 10%场景范围的区域查询（框选、视锥粗筛）
+    registry.add("entity/store/mixed/100000/query", 100000, []() -> BenchmarkBody {
+        std::shared_ptr<GeoEntityStore> store = createMixedStore(100000);
+        if (!store) return BenchmarkBody();
+        double extent = std::sqrt(100000.0) * kMixedSpacing;
+        auto results = std::make_shared<std::vector<GeoEntity>>();
+        return [store, extent, results]() {
+            results->clear();
+            BoundingBox3D box(glm::dvec3(extent * 0.45, extent * 0.45, -1e6), glm::dvec3(extent * 0.55, extent * 0.55, 1e6));
+            store->queryBounds(box, *results);
+            benchmarkKeep(results->size());
+        };
+    });
+
+    // 加入场景的Geo3D只是外观：选中、样式、拖拽控制点后，场景实体存储中的数据与对象一致，移出场景后数据搬回对象
+    registry.addCheck("entity/scene/facade_sync", [](QString& message) {
+        Geo3D::Ptr geo = buildBenchmarkGeometry(Geo_Box3D, Subdivision_Medium3D);
+        if (!geo.valid() || !geo->mm_state()->isStateComplete()) {
+            message = "无法完成绘制";
+            return false;
+        }
+
+        SceneManager3D scene;
+        scene.addGeometry(geo);
+        const GeoEntityStore& store = scene.getEntityStore();
+        const GeoEntity entity = geo->getEntity();
+        if (geo->getEntityStore() != &store || !store.isAlive(entity) || store.getFacade(entity) != geo.get()) {
+            message = "加入场景后没有绑定实体";
+            return false;
+        }
+
+        scene.setSelectedGeometry(geo);
+        if (!(store.getState(entity) & GeoState_Selected3D) || scene.getSelectionCount() != 1) {
+            message = "选中位没有写入实体存储";
+            return false;
+        }
+
+        GeoParameters3D params = geo->getParameters();
+        params.lineWidth += 1.0;
+        geo->setParameters(params);
+        if (store.getStyle(entity) != geo->getStyle() || !(store.getParameters(entity) == params)) {
+            message = "样式没有写入实体存储";
+            return false;
+        }
+
+        const Point3D moved(store.getControlPoints(entity)[0] + glm::dvec3(0.5, 0.25, 0.0));
+        geo->mm_controlPoint()->setControlPoint(0, moved);
+        if (store.getControlPoints(entity)[0] != geo->mm_controlPoint()->getAllStageControlPoints()[0][0].position) {
+            message = "拖拽后的控制点没有写回实体存储";
+            return false;
+        }
+        if (!sameBounds(store.getBounds(entity), geo->mm_node()->getBoundingBox())) {
+            message = "包围盒与网格不一致";
+            return false;
+        }
+
+        const GeoStyle* style = geo->getStyle();
+        scene.removeGeometry(geo);
+        if (geo->getEntityStore() || store.size() != 0 || geo->getStyle() != style || geo->mm_state()->isStateSelected()) {
+            message = "移出场景后状态或样式没有搬回对象";
+            return false;
+        }
+        return true;
+    });
+}
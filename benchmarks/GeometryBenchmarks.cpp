@@ -0,0 +1,233 @@
+﻿#include "BenchmarkCases.h"
+#include "BenchmarkHarness.h"
+#include "BenchmarkScenes.h"
+#include "../src/core/managers/GeoControlPointManager.h"
+#include "../src/core/managers/GeoNodeManager.h"
+#include "../src/core/managers/GeoStateManager.h"
+#include "../src/core/GeoStyleTable.h"
+#include <QStringList>
+#include <cmath>
+
+namespace
+{
+    struct LevelName
+    {
+        SubdivisionLevel3D level;
+        const char* name;
+    };
+
+    const LevelName kLevels[] = {
+        { Subdivision_Low3D, "low" },
+        { Subdivision_Medium3D, "medium" },
+        { Subdivision_High3D, "high" },
+        { Subdivision_Ultra3D, "ultra" },
+    };
+
+    const unsigned int kShapeComponents = GeoComponent_Vertex3D | GeoComponent_Edge3D | GeoComponent_Face3D;
+    const unsigned int kComponentOrder[3] = { GeoComponent_Vertex3D, GeoComponent_Edge3D, GeoComponent_Face3D };
+    const glm::dvec3 kDragOffset(0.05, 0.03, 0.02);
+    const double kCompareTolerance = 1e-4;  // 两次离散化的float坐标允许的误差
+
+    QString componentNames(unsigned int components)
+    {
+        QStringList names;
+        if (components & GeoComponent_Vertex3D) names << "顶点";
+        if (components & GeoComponent_Edge3D) names << "边";
+        if (components & GeoComponent_Face3D) names << "面";
+        return names.isEmpty() ? QString("无") : names.join("|");
+    }
+
+    // 阶段stageIdx第一个控制点的全局下标，阶段为空时返回-1
+    int firstPointOfStage(Geo3D* geo, int stageIdx)
+    {
+        const auto& stages = geo->mm_controlPoint()->getAllStageControlPoints();
+        if (stageIdx >= static_cast<int>(stages.size()) || stages[stageIdx].empty()) return -1;
+
+        int globalIndex = 0;
+        for (int i = 0; i < stageIdx; ++i) {
+            globalIndex += static_cast<int>(stages[i].size());
+        }
+        return globalIndex;
+    }
+
+    Point3D movedPoint(Geo3D* geo, int stageIdx, const glm::dvec3& offset)
+    {
+        const Point3D& point = geo->mm_controlPoint()->getAllStageControlPoints()[stageIdx][0];
+        return Point3D(point.x() + offset.x, point.y() + offset.y, point.z() + offset.z);
+    }
+
+    // 一个组件几何体的内容：到场景坐标的矩阵（引用单位网格时含网格变换）、顶点、法线和展开的图元
+    struct ComponentSnapshot
+    {
+        osg::Matrixd matrix;
+        std::vector<osg::Vec3> vertices;
+        std::vector<osg::Vec3> normals;
+        std::vector<unsigned int> primitives;  // 每个图元集依次为模式、下标数和各下标
+    };
+
+    ComponentSnapshot captureComponent(const osg::Geometry* geometry, const osg::Matrixd& matrix)
+    {
+        ComponentSnapshot snapshot;
+        snapshot.matrix = matrix;
+        if (!geometry) return snapshot;
+
+        if (const osg::Vec3Array* vertices = dynamic_cast<const osg::Vec3Array*>(geometry->getVertexArray())) {
+            snapshot.vertices.assign(vertices->begin(), vertices->end());
+        }
+        if (const osg::Vec3Array* normals = dynamic_cast<const osg::Vec3Array*>(geometry->getNormalArray())) {
+            snapshot.normals.assign(normals->begin(), normals->end());
+        }
+        for (unsigned int i = 0; i < geometry->getNumPrimitiveSets(); ++i) {
+            const osg::PrimitiveSet* primitive = geometry->getPrimitiveSet(i);
+            snapshot.primitives.push_back(primitive->getMode());
+            snapshot.primitives.push_back(primitive->getNumIndices());
+            for (unsigned int j = 0; j < primitive->getNumIndices(); ++j) {
+                snapshot.primitives.push_back(primitive->index(j));
+            }
+        }
+        return snapshot;
+    }
+
+    // 按kComponentOrder的顺序取顶点/边/面
+    std::vector<ComponentSnapshot> captureShape(Geo3D* geo)
+    {
+        GeoNodeManager* nodeManager = geo->mm_node();
+        return {
+            captureComponent(nodeManager->getVertexGeometry().get(), osg::Matrixd::identity()),
+            captureComponent(nodeManager->getEdgeGeometry().get(), nodeManager->getEdgeWorldMatrix()),
+            captureComponent(nodeManager->getFaceGeometry().get(), nodeManager->getFaceWorldMatrix()),
+        };
+    }
+
+    bool sameComponent(const ComponentSnapshot& a, const ComponentSnapshot& b)
+    {
+        auto sameVectors = [](const std::vector<osg::Vec3>& x, const std::vector<osg::Vec3>& y) {
+            if (x.size() != y.size()) return false;
+            for (size_t i = 0; i < x.size(); ++i) {
+                if ((x[i] - y[i]).length() > kCompareTolerance) return false;
+            }
+            return true;
+        };
+
+        for (int i = 0; i < 16; ++i) {
+            if (std::abs(a.matrix.ptr()[i] - b.matrix.ptr()[i]) > kCompareTolerance) return false;
+        }
+        return a.primitives == b.primitives && sameVectors(a.vertices, b.vertices) && sameVectors(a.normals, b.normals);
+    }
+}
+
+void registerGeometryBenchmarks()
+{
+    BenchmarkRegistry& registry = BenchmarkRegistry::getInstance();
+
+    for (const BenchmarkGeoType& geoType : benchmarkGeoTypes()) {
+        for (const LevelName& level : kLevels) {
+            GeoType3D type = geoType.type;
+            SubdivisionLevel3D subdivision = level.level;
+
+            // 完整绘制流程：创建对象、逐点约束、阶段切换以及每次加点触发的增量重建
+            registry.add(QString("geometry/%1/%2/build").arg(geoType.name, level.name), 1, [type, subdivision]() -> BenchmarkBody {
+                return [type, subdivision]() {
+                    Geo3D::Ptr geo = buildBenchmarkGeometry(type, subdivision);
+                    benchmarkKeep(geo.valid() ? geo->mm_node()->getBoundingBox().radius() : 0.0);
+                };
+            });
+
+            // 已完成对象的全量重建，只含顶点/边/面离散化
+            registry.add(QString("geometry/%1/%2/rebuild").arg(geoType.name, level.name), 1, [type, subdivision]() -> BenchmarkBody {
+                Geo3D::Ptr geo = buildBenchmarkGeometry(type, subdivision);
+                if (!geo.valid()) return BenchmarkBody();
+                return [geo]() {
+                    geo->mm_node()->updateGeometries();
+                    benchmarkKeep(geo->mm_node()->getBoundingBox().radius());
+                };
+            });
+
+            // 拖拽最后一个阶段的控制点：只重建几何体为该阶段声明的组件，来回各一次
+            registry.add(QString("geometry/%1/%2/drag").arg(geoType.name, level.name), 2, [type, subdivision]() -> BenchmarkBody {
+                Geo3D::Ptr geo = buildBenchmarkGeometry(type, subdivision);
+                if (!geo.valid() || !geo->mm_state()->isStateComplete()) return BenchmarkBody();
+
+                const int stageIdx = static_cast<int>(geo->mm_controlPoint()->getAllStageControlPoints().size()) - 1;
+                const int index = firstPointOfStage(geo.get(), stageIdx);
+                if (index < 0) return BenchmarkBody();
+
+                const Point3D original = movedPoint(geo.get(), stageIdx, glm::dvec3(0.0));
+                const Point3D moved = movedPoint(geo.get(), stageIdx, kDragOffset);
+                return [geo, index, original, moved]() {
+                    geo->mm_controlPoint()->setControlPoint(index, moved);
+                    geo->mm_controlPoint()->setControlPoint(index, original);
+                    benchmarkKeep(geo->mm_node()->getBoundingBox().radius());
+                };
+            });
+        }
+
+        // 拖拽每个阶段的控制点，按getStageDependentComponents局部重建后，再全量重建一次：
+        // 局部重建跳过的组件若实际受该阶段影响，两次的顶点/边/面内容就会不同
+        GeoType3D type = geoType.type;
+        registry.addCheck(QString("geometry/%1/stage_components").arg(geoType.name), [type](QString& message) {
+            Geo3D::Ptr geo = buildBenchmarkGeometry(type, Subdivision_Medium3D);
+            if (!geo.valid() || !geo->mm_state()->isStateComplete()) {
+                message = "无法完成绘制，跳过";
+                return true;
+            }
+
+            QStringList stageResults;
+            const int stageCount = static_cast<int>(geo->mm_controlPoint()->getAllStageControlPoints().size());
+            for (int stageIdx = 0; stageIdx < stageCount; ++stageIdx) {
+                const int index = firstPointOfStage(geo.get(), stageIdx);
+                if (index < 0) continue;
+
+                geo->mm_controlPoint()->setControlPoint(index, movedPoint(geo.get(), stageIdx, kDragOffset));
+                const std::vector<ComponentSnapshot> partial = captureShape(geo.get());
+
+                geo->mm_node()->updateGeometries(GeoComponent_Geometry3D);
+                const std::vector<ComponentSnapshot> full = captureShape(geo.get());
+
+                unsigned int differing = 0;
+                for (size_t i = 0; i < partial.size(); ++i) {
+                    if (!sameComponent(partial[i], full[i])) differing |= kComponentOrder[i];
+                }
+
+                const unsigned int declared = geo->getStageDependentComponents(stageIdx) & kShapeComponents;
+                if (differing) {
+                    message = QString("阶段%1: 局部重建%2后，%3与全量重建不一致")
+                        .arg(stageIdx).arg(componentNames(declared)).arg(componentNames(differing));
+                    return false;
+                }
+                stageResults << QString("阶段%1跳过%2").arg(stageIdx).arg(componentNames(kShapeComponents & ~declared));
+            }
+            message = stageResults.join(", ");
+            return true;
+        });
+    }
+
+    // 对象换用新样式后，旧样式不再被引用，清除后样式表回到原来的大小
+    registry.addCheck("geometry/style/sweep_unused", [](QString& message) {
+        Geo3D::Ptr geo = buildBenchmarkGeometry(Geo_Line3D, Subdivision_Medium3D);
+        if (!geo.valid()) {
+            message = "无法创建几何体";
+            return false;
+        }
+
+        GeoStyleTable& table = GeoStyleTable::getInstance();
+        table.sweepUnused();
+        const size_t baseline = table.getStyleCount();
+
+        const GeoParameters3D original = geo->getParameters();
+        const int kStyleCount = 200;
+        for (int i = 1; i <= kStyleCount; ++i) {
+            GeoParameters3D params = original;
+            params.lineWidth = original.lineWidth + i * 0.01;
+            geo->setParameters(params);
+        }
+        geo->setParameters(original);
+
+        table.sweepUnused();
+        if (table.getStyleCount() != baseline) {
+            message = QString("清除后剩余%1种样式，应为%2种").arg(table.getStyleCount()).arg(baseline);
+            return false;
+        }
+        return true;
+    });
+}
@@ -0,0 +1,144 @@
+﻿#include "BenchmarkCases.h"
+#include "BenchmarkHarness.h"
+#include "BenchmarkScenes.h"
+#include "../src/util/GeoOsgbIO.h"
+#include "../src/util/BatchProcessor.h"
+#include <QTemporaryDir>
+#include <QThread>
+#include <algorithm>
+#include <memory>
+
+namespace
+{
+    // 保存/读取共享的场景和临时目录
+    struct IOFixture
+    {
+        QTemporaryDir directory;
+        osg::ref_ptr<osg::Group> root;
+        std::vector<Geo3D::Ptr> geometries;
+
+        QString filePath() const { return directory.filePath("benchmark.osgb"); }
+    };
+
+    std::shared_ptr<IOFixture> createFixture(int objectCount, bool saveFirst)
+    {
+        auto fixture = std::make_shared<IOFixture>();
+        if (!fixture->directory.isValid()) return nullptr;
+
+        fixture->root = new osg::Group();
+        buildMixedScene(fixture->root.get(), objectCount, Subdivision_Medium3D, fixture->geometries);
+
+        if (saveFirst && !GeoOsgbIO::saveGeoList(fixture->filePath(), fixture->geometries)) {
+            return nullptr;
+        }
+        return fixture;
+    }
+
+    // 批处理：目录下若干osgb文件，按控制点以另一细分级别重新生成后校验
+    const int kBatchFileCount = 16;
+    const int kBatchObjectsPerFile = 100;
+
+    std::shared_ptr<QTemporaryDir> createBatchDirectory()
+    {
+        auto directory = std::make_shared<QTemporaryDir>();
+        if (!directory->isValid()) return nullptr;
+
+        for (int i = 0; i < kBatchFileCount; ++i) {
+            osg::ref_ptr<osg::Group> root = new osg::Group();
+            std::vector<Geo3D::Ptr> geometries;
+            buildMixedScene(root.get(), kBatchObjectsPerFile, Subdivision_Low3D, geometries);
+            if (!GeoOsgbIO::saveGeoList(directory->filePath(QString("batch_%1.osgb").arg(i)), geometries)) {
+                return nullptr;
+            }
+        }
+        return directory;
+    }
+
+    BatchOptions batchOptions(const QTemporaryDir& directory, int jobs)
+    {
+        BatchOptions options;
+        options.inputs << directory.path();
+        options.validateOnly = true;
+        options.subdivision = Subdivision_High3D;
+        options.jobs = jobs;
+        return options;
+    }
+}
+
+void registerIOBenchmarks()
+{
+    BenchmarkRegistry& registry = BenchmarkRegistry::getInstance();
+
+    const int objectCounts[] = { 100, 1000 };
+    for (int objectCount : objectCounts) {
+        registry.add(QString("io/osgb/%1/save").arg(objectCount), objectCount, [objectCount]() -> BenchmarkBody {
+            std::shared_ptr<IOFixture> fixture = createFixture(objectCount, false);
+            if (!fixture) return BenchmarkBody();
+            return [fixture]() {
+                benchmarkKeep(GeoOsgbIO::saveGeoList(fixture->filePath(), fixture->geometries) ? 1.0 : 0.0);
+            };
+        });
+
+        registry.add(QString("io/osgb/%1/load").arg(objectCount), objectCount, [objectCount]() -> BenchmarkBody {
+            std::shared_ptr<IOFixture> fixture = createFixture(objectCount, true);
+            if (!fixture) return BenchmarkBody();
+            return [fixture]() {
+                benchmarkKeep(GeoOsgbIO::loadGeoList(fixture->filePath()).size());
+            };
+        });
+
+        // 往返：保存后立即读回，对应另存再打开
+        registry.add(QString("io/osgb/%1/round_trip").arg(objectCount), objectCount, [objectCount]() -> BenchmarkBody {
+            std::shared_ptr<IOFixture> fixture = createFixture(objectCount, false);
+            if (!fixture) return BenchmarkBody();
+            return [fixture]() {
+                GeoOsgbIO::saveGeoList(fixture->filePath(), fixture->geometries);
+                benchmarkKeep(GeoOsgbIO::loadGeoList(fixture->filePath()).size());
+            };
+        });
+    }
+
+    // 批处理按文件并行：未加入场景的对象没有场景锁，各工作线程重建几何互不等待，
+    // 单线程与全部核心两组对照即为并行加速比
+    const int jobCounts[] = { 1, std::max(1, QThread::idealThreadCount()) };
+    for (int jobs : jobCounts) {
+        registry.add(QString("io/batch/%1x%2/jobs_%3").arg(kBatchFileCount).arg(kBatchObjectsPerFile).arg(jobs == 1 ? QString("1") : QString("all")),
+                     kBatchFileCount, [jobs]() -> BenchmarkBody {
+            std::shared_ptr<QTemporaryDir> directory = createBatchDirectory();
+            if (!directory) return BenchmarkBody();
+            return [directory, jobs]() {
+                benchmarkKeep(BatchProcessor::run(batchOptions(*directory, jobs)).succeeded);
+            };
+        });
+    }
+
+    // 批处理读出的对象不在任何场景中，不能挂上场景锁，否则工作线程会在同一把锁上排队
+    registry.addCheck("io/batch/unlocked", [](QString& message) {
+        osg::ref_ptr<osg::Group> root = new osg::Group();
+        std::vector<Geo3D::Ptr> geometries;
+        buildMixedScene(root.get(), 20, Subdivision_Low3D, geometries);
+
+        QTemporaryDir directory;
+        const QString filePath = directory.filePath("unlocked.osgb");
+        if (!directory.isValid() || !GeoOsgbIO::saveGeoList(filePath, geometries)) {
+            message = "无法写出临时文件";
+            return false;
+        }
+
+        GeoLoadOptions loadOptions;
+        loadOptions.rebuildFromControlPoints = true;
+        loadOptions.subdivisionOverride = Subdivision_Medium3D;
+        const std::vector<Geo3D::Ptr> loaded = GeoOsgbIO::loadGeoList(filePath, loadOptions);
+        if (loaded.size() != geometries.size()) {
+            message = QString("读回%1个对象，应为%2个").arg(loaded.size()).arg(geometries.size());
+            return false;
+        }
+        for (const Geo3D::Ptr& geo : loaded) {
+            if (geo->getSceneLock()) {
+                message = "读回的对象挂上了场景锁";
+                return false;
+            }
+        }
+        return true;
+    });
+}
@@ -0,0 +1,196 @@
+﻿#include "BenchmarkCases.h"
+#include "BenchmarkHarness.h"
+#include "../src/core/ConstraintSystem.h"
+#include "../src/util/MathUtils.h"
+#include <cmath>
+#include <memory>
+#include <random>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+    const int kInputCount = 1000;   // 每次迭代处理的输入数
+
+    // 固定种子的随机点，保证多次运行输入一致
+    std::vector<glm::dvec3> randomPoints(int count, unsigned int seed, double range = 100.0)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> dist(-range, range);
+        std::vector<glm::dvec3> points;
+        points.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            points.emplace_back(dist(rng), dist(rng), dist(rng));
+        }
+        return points;
+    }
+
+    // 倾斜平面上带微小噪声的点，用于平面拟合
+    std::vector<glm::dvec3> noisyPlanePoints(int count, unsigned int seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> dist(-10.0, 10.0);
+        std::uniform_real_distribution<double> noise(-0.01, 0.01);
+        std::vector<glm::dvec3> points;
+        points.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            // 按角度排列，保证多边形不自交
+            double angle = 2.0 * M_PI * i / count;
+            double radius = 5.0 + std::abs(dist(rng)) * 0.2;
+            double x = radius * std::cos(angle);
+            double y = radius * std::sin(angle);
+            points.emplace_back(x, y, 0.3 * x - 0.2 * y + noise(rng));
+        }
+        return points;
+    }
+
+    double sum(const glm::dvec3& v)
+    {
+        return v.x + v.y + v.z;
+    }
+
+    void registerConstraint(const QString& name, constraint::ConstraintFunction function)
+    {
+        BenchmarkRegistry::getInstance().add(QString("constraint/%1").arg(name), kInputCount, [function]() -> BenchmarkBody {
+            auto inputs = std::make_shared<std::vector<Point3D>>();
+            for (const glm::dvec3& p : randomPoints(kInputCount, 7)) {
+                inputs->emplace_back(p);
+            }
+            // 不共线的参考点：A为圆心/起点，B、C确定平面和半径
+            auto references = std::make_shared<std::vector<Point3D>>(std::vector<Point3D>{
+                Point3D(0.0, 0.0, 0.0), Point3D(10.0, 0.0, 1.0), Point3D(3.0, 8.0, -2.0), Point3D(-4.0, 5.0, 0.5) });
+
+            return [function, inputs, references]() {
+                double acc = 0.0;
+                for (const Point3D& input : *inputs) {
+                    acc += sum(function(input, *references).position);
+                }
+                benchmarkKeep(acc);
+            };
+        });
+    }
+}
+
+void registerMathBenchmarks()
+{
+    BenchmarkRegistry& registry = BenchmarkRegistry::getInstance();
+
+    registry.add("math/arc_from_three_points", kInputCount, []() -> BenchmarkBody {
+        auto points = std::make_shared<std::vector<glm::dvec3>>(randomPoints(kInputCount * 3, 1));
+        return [points]() {
+            double acc = 0.0;
+            for (size_t i = 0; i + 2 < points->size(); i += 3) {
+                acc += MathUtils::calculateArcFromThreePoints((*points)[i], (*points)[i + 1], (*points)[i + 2]).radius;
+            }
+            benchmarkKeep(acc);
+        };
+    });
+
+    // 按细分级别生成圆弧离散点
+    const int segmentCounts[] = { 8, 16, 32, 64 };
+    for (int segments : segmentCounts) {
+        registry.add(QString("math/arc_points/%1").arg(segments), kInputCount / 10, [segments]() -> BenchmarkBody {
+            auto params = std::make_shared<std::vector<MathUtils::ArcParameters>>();
+            std::vector<glm::dvec3> points = randomPoints(kInputCount / 10 * 3, 2);
+            for (size_t i = 0; i + 2 < points.size(); i += 3) {
+                params->push_back(MathUtils::calculateArcFromThreePoints(points[i], points[i + 1], points[i + 2]));
+            }
+            return [params, segments]() {
+                double acc = 0.0;
+                for (const MathUtils::ArcParameters& arc : *params) {
+                    acc += MathUtils::generateArcPoints(arc, segments).size();
+                }
+                benchmarkKeep(acc);
+            };
+        });
+    }
+
+    // 三阶与七阶贝塞尔曲线
+    const int controlPointCounts[] = { 4, 8 };
+    for (int controlCount : controlPointCounts) {
+        registry.add(QString("math/bezier_curve/%1_points").arg(controlCount), kInputCount / 10, [controlCount]() -> BenchmarkBody {
+            auto curves = std::make_shared<std::vector<std::vector<glm::dvec3>>>();
+            std::vector<glm::dvec3> points = randomPoints(kInputCount / 10 * controlCount, 3);
+            for (size_t i = 0; i + controlCount <= points.size(); i += controlCount) {
+                curves->emplace_back(points.begin() + i, points.begin() + i + controlCount);
+            }
+            return [curves]() {
+                double acc = 0.0;
+                for (const std::vector<glm::dvec3>& controlPoints : *curves) {
+                    acc += sum(MathUtils::generateBezierCurve(controlPoints, 50).back());
+                }
+                benchmarkKeep(acc);
+            };
+        });
+    }
+
+    registry.add("math/circle_center_radius", kInputCount, []() -> BenchmarkBody {
+        auto points = std::make_shared<std::vector<glm::dvec3>>(randomPoints(kInputCount * 3, 4));
+        return [points]() {
+            double acc = 0.0;
+            glm::dvec3 center;
+            double radius = 0.0;
+            for (size_t i = 0; i + 2 < points->size(); i += 3) {
+                if (MathUtils::calculateCircleCenterAndRadius((*points)[i], (*points)[i + 1], (*points)[i + 2], center, radius)) {
+                    acc += radius;
+                }
+            }
+            benchmarkKeep(acc);
+        };
+    });
+
+    // 平面拟合：多边形法向 + 把各点投影到拟合平面
+    registry.add("math/plane_fit/16_points", kInputCount / 10, []() -> BenchmarkBody {
+        auto polygons = std::make_shared<std::vector<std::vector<glm::dvec3>>>();
+        for (int i = 0; i < kInputCount / 10; ++i) {
+            polygons->push_back(noisyPlanePoints(16, 5 + i));
+        }
+        return [polygons]() {
+            double acc = 0.0;
+            for (const std::vector<glm::dvec3>& polygon : *polygons) {
+                glm::dvec3 normal = MathUtils::calculatePolygonNormal(polygon);
+                glm::dvec3 centroid = MathUtils::calculateCentroid(polygon);
+                for (const glm::dvec3& point : polygon) {
+                    acc += sum(MathUtils::projectPointOnPlane(point, normal, centroid));
+                }
+            }
+            benchmarkKeep(acc);
+        };
+    });
+}
+
+void registerConstraintBenchmarks()
+{
+    registerConstraint("no_constraint", constraint::noConstraint);
+    registerConstraint("plane", constraint::planeConstraint);
+    registerConstraint("line", constraint::lineConstraint);
+    registerConstraint("z_plane", constraint::zPlaneConstraint);
+    registerConstraint("vertical_to_base", constraint::verticalToBaseConstraint);
+    registerConstraint("perpendicular_to_last_two_points", constraint::perpendicularToLastTwoPointsConstraint);
+    registerConstraint("circle", constraint::circleConstraint);
+    registerConstraint("perpendicular_to_circle_plane", constraint::perpendicularToCirclePlaneConstraint);
+    registerConstraint("equal_length", constraint::equalLengthConstraint);
+
+    // 绘制时实际走的路径：按[阶段, 点]取参考点再串联多个约束
+    BenchmarkRegistry::getInstance().add("constraint/stage_combined", kInputCount, []() -> BenchmarkBody {
+        auto inputs = std::make_shared<std::vector<Point3D>>();
+        for (const glm::dvec3& p : randomPoints(kInputCount, 8)) {
+            inputs->emplace_back(p);
+        }
+        auto stages = std::make_shared<std::vector<std::vector<Point3D>>>(std::vector<std::vector<Point3D>>{
+            { Point3D(0.0, 0.0, 0.0), Point3D(10.0, 0.0, 1.0), Point3D(3.0, 8.0, -2.0) } });
+        auto stageConstraint = std::make_shared<constraint::StageConstraintFunction>(constraint::combineStageConstraints({
+            constraint::createConstraintCall(constraint::planeConstraint, { {0, 0}, {0, 1}, {0, 2} }),
+            constraint::createConstraintCall(constraint::circleConstraint, { {0, 0}, {0, 1} }) }));
+
+        return [inputs, stages, stageConstraint]() {
+            double acc = 0.0;
+            for (const Point3D& input : *inputs) {
+                acc += sum((*stageConstraint)(input, *stages).position);
+            }
+            benchmarkKeep(acc);
+        };
+    });
+}
@@ -0,0 +1,331 @@
+﻿#include "BenchmarkCases.h"
+#include "BenchmarkHarness.h"
+#include "BenchmarkScenes.h"
+#include "../src/core/picking/GeometryPickingSystem.h"
+#include "../src/core/picking/SnapEngine.h"
+#include "../src/core/picking/RayQueryService.h"
+#include "../src/core/managers/GeoControlPointManager.h"
+#include "../src/core/managers/GeoNodeManager.h"
+#include "../src/core/managers/GeoStateManager.h"
+#include "../src/core/managers/SpatialIndexBuilder.h"
+#include "../src/core/world/SceneBVH.h"
+#include "../src/util/GeometryFactory.h"
+#include <memory>
+#include <random>
+
+namespace
+{
+    const int kViewportWidth = 1280;
+    const int kViewportHeight = 720;
+    const int kSampleCount = 100;   // 每次迭代拾取的屏幕位置数
+    const int kSnapObjectCount = 34000;  // 每个三角形3条边，约10万条边
+    const int kRayCount = 10000;         // 批量射线查询每次迭代的线段数
+    const int kSnapCheckTriangles = 400;      // 小三角形把格子边长压到约3个单位
+    const double kSnapCheckPixel = 4.0;       // 正交投影下一个像素的世界长度，10像素的捕捉半径覆盖十几个格子
+    const osg::Vec3d kSnapCheckCursor(0.0, -200.0, 0.0);  // 光标正对的场景位置，离三角形网格50像素
+
+    // 拾取用例共享的场景，各模式使用同一组采样点
+    struct PickingFixture
+    {
+        osg::ref_ptr<osg::Group> root;
+        std::vector<Geo3D::Ptr> geometries;
+        osg::ref_ptr<osg::Camera> camera;
+        osg::ref_ptr<GeometryPickingSystem> pickingSystem;
+        std::unique_ptr<SceneBVH> sceneBVH;
+        std::vector<std::pair<int, int>> samples;
+
+        ~PickingFixture()
+        {
+            if (pickingSystem) {
+                pickingSystem->setSceneBVH(nullptr);
+                pickingSystem->shutdown();
+            }
+        }
+    };
+
+    enum PickMode
+    {
+        PickMode_Separate,      // 顶点/边/面三次独立遍历
+        PickMode_Hybrid,        // 单次遍历混合拾取
+        PickMode_SceneBVH,      // 场景BVH粗筛 + 单次遍历
+        PickMode_VertexGrid,    // 单次遍历（面/边） + 屏幕空间顶点网格
+        PickMode_EdgeBVH        // 单次遍历（面/顶点） + 边的线段BVH
+    };
+
+    std::shared_ptr<PickingFixture> createFixture(int objectCount, bool mixed, PickMode mode)
+    {
+        auto fixture = std::make_shared<PickingFixture>();
+        fixture->root = new osg::Group();
+        if (mixed) {
+            buildMixedScene(fixture->root.get(), objectCount, Subdivision_Medium3D, fixture->geometries);
+        } else {
+            buildTriangleGridScene(fixture->root.get(), objectCount, fixture->geometries);
+        }
+
+        fixture->camera = createBenchmarkCamera(fixture->root->getBound(), kViewportWidth, kViewportHeight);
+        fixture->pickingSystem = new GeometryPickingSystem();
+        if (!fixture->pickingSystem->initialize(fixture->camera.get(), fixture->root.get())) {
+            return nullptr;
+        }
+
+        PickConfig config = fixture->pickingSystem->getConfig();
+        config.useHybridTraversal = mode != PickMode_Separate;
+        config.useVertexGrid = mode == PickMode_VertexGrid;
+        config.useEdgeSegmentBVH = mode == PickMode_EdgeBVH;
+        fixture->pickingSystem->setConfig(config);
+
+        if (mode == PickMode_SceneBVH) {
+            fixture->sceneBVH.reset(new SceneBVH());
+            for (const Geo3D::Ptr& geo : fixture->geometries) {
+                fixture->sceneBVH->insert(geo.get(), geo->mm_node()->getBoundingBox());
+            }
+            fixture->pickingSystem->setSceneBVH(fixture->sceneBVH.get());
+        }
+
+        std::mt19937 rng(12345);
+        std::uniform_int_distribution<int> xDist(0, kViewportWidth - 1);
+        std::uniform_int_distribution<int> yDist(0, kViewportHeight - 1);
+        for (int i = 0; i < kSampleCount; ++i) {
+            fixture->samples.emplace_back(xDist(rng), yDist(rng));
+        }
+
+        // 空间索引在首次拾取时后台构建，先拾取一轮并等索引换入，计时只含建好索引后的拾取
+        for (const auto& sample : fixture->samples) {
+            fixture->pickingSystem->pickGeometry(sample.first, sample.second);
+        }
+        SpatialIndexBuilder::getInstance().waitForIdle();
+        SpatialIndexBuilder::getInstance().processFinished();
+        return fixture;
+    }
+
+    void registerPickCase(const QString& name, int objectCount, bool mixed, PickMode mode)
+    {
+        BenchmarkRegistry::getInstance().add(name, kSampleCount, [objectCount, mixed, mode]() -> BenchmarkBody {
+            std::shared_ptr<PickingFixture> fixture = createFixture(objectCount, mixed, mode);
+            if (!fixture) return BenchmarkBody();
+
+            return [fixture]() {
+                int hits = 0;
+                for (const auto& sample : fixture->samples) {
+                    if (fixture->pickingSystem->pickGeometry(sample.first, sample.second).hasResult) ++hits;
+                }
+                benchmarkKeep(hits);
+            };
+        });
+    }
+
+    // 每次迭代先轻微平移相机，再拾取一次：测的是网格重建（投影 + 分桶）的耗时
+    void registerGridRebuildCase(const QString& name, int objectCount)
+    {
+        BenchmarkRegistry::getInstance().add(name, 1, [objectCount]() -> BenchmarkBody {
+            std::shared_ptr<PickingFixture> fixture = createFixture(objectCount, false, PickMode_VertexGrid);
+            if (!fixture) return BenchmarkBody();
+
+            auto step = std::make_shared<int>(0);
+            return [fixture, step]() {
+                const osg::Matrixd offset = osg::Matrixd::translate((++*step % 2) ? 0.01 : -0.01, 0.0, 0.0);
+                fixture->camera->setViewMatrix(fixture->camera->getViewMatrix() * offset);
+                const auto& sample = fixture->samples.front();
+                benchmarkKeep(fixture->pickingSystem->pickGeometry(sample.first, sample.second).hasResult);
+            };
+        });
+    }
+
+    // 捕捉查询：特征在准备阶段提取并分桶，计时只含查询
+    void registerSnapCase(const QString& name, int objectCount)
+    {
+        BenchmarkRegistry::getInstance().add(name, kSampleCount, [objectCount]() -> BenchmarkBody {
+            std::shared_ptr<PickingFixture> fixture = std::make_shared<PickingFixture>();
+            fixture->root = new osg::Group();
+            buildTriangleGridScene(fixture->root.get(), objectCount, fixture->geometries);
+            fixture->camera = createBenchmarkCamera(fixture->root->getBound(), kViewportWidth, kViewportHeight);
+
+            auto snapEngine = std::make_shared<SnapEngine>();
+            for (const Geo3D::Ptr& geo : fixture->geometries) {
+                snapEngine->insert(geo.get());
+            }
+
+            PickCameraState cameraState;
+            cameraState.viewport = fixture->camera->getViewport();
+            cameraState.projectionMatrix = fixture->camera->getProjectionMatrix();
+            cameraState.viewMatrix = fixture->camera->getViewMatrix();
+
+            std::mt19937 rng(12345);
+            std::uniform_int_distribution<int> xDist(0, kViewportWidth - 1);
+            std::uniform_int_distribution<int> yDist(0, kViewportHeight - 1);
+            for (int i = 0; i < kSampleCount; ++i) {
+                fixture->samples.emplace_back(xDist(rng), yDist(rng));
+            }
+
+            const std::vector<Geo3D*> excluded;
+            SnapResult warmup;
+            snapEngine->snap(cameraState, 0.0, 0.0, excluded, warmup);
+
+            return [fixture, snapEngine, cameraState, excluded]() {
+                int hits = 0;
+                SnapResult result;
+                for (const auto& sample : fixture->samples) {
+                    if (snapEngine->snap(cameraState, sample.first, sample.second, excluded, result)) ++hits;
+                }
+                benchmarkKeep(hits);
+            };
+        });
+    }
+
+    // 按控制点逐个放置，未自动完成的对象（折线）手动结束绘制
+    Geo3D::Ptr createSnapCheckGeometry(GeoType3D type, const std::vector<glm::dvec3>& points)
+    {
+        Geo3D::Ptr geo = GeometryFactory::createGeometry(type);
+        if (!geo) return geo;
+
+        for (const glm::dvec3& point : points) {
+            geo->mm_controlPoint()->addControlPoint(Point3D(point));
+        }
+        if (!geo->mm_state()->isStateComplete()) {
+            geo->mm_controlPoint()->nextStage();
+        }
+        return geo;
+    }
+
+    // 在三角形网格和extras组成的场景中，从正上方正交投影对准kSnapCheckCursor捕捉
+    bool snapAtCheckCursor(const std::vector<Geo3D::Ptr>& extras, SnapResult& result)
+    {
+        osg::ref_ptr<osg::Group> root = new osg::Group();
+        std::vector<Geo3D::Ptr> geometries;
+        buildTriangleGridScene(root.get(), kSnapCheckTriangles, geometries);
+
+        SnapEngine snapEngine;
+        for (const Geo3D::Ptr& geo : geometries) {
+            snapEngine.insert(geo.get());
+        }
+        for (const Geo3D::Ptr& geo : extras) {
+            snapEngine.insert(geo.get());
+        }
+
+        const double halfWidth = kViewportWidth * 0.5 * kSnapCheckPixel;
+        const double halfHeight = kViewportHeight * 0.5 * kSnapCheckPixel;
+        PickCameraState cameraState;
+        cameraState.viewport = new osg::Viewport(0, 0, kViewportWidth, kViewportHeight);
+        cameraState.projectionMatrix = osg::Matrixd::ortho(-halfWidth, halfWidth, -halfHeight, halfHeight, 1.0, 1000.0);
+        cameraState.viewMatrix = osg::Matrixd::lookAt(kSnapCheckCursor + osg::Vec3d(0.0, 0.0, 500.0), kSnapCheckCursor,
+                                                      osg::Vec3d(0.0, 1.0, 0.0));
+
+        const std::vector<Geo3D*> excluded;
+        return snapEngine.snap(cameraState, kViewportWidth * 0.5, kViewportHeight * 0.5, excluded, result);
+    }
+
+    bool checkSnappedEndpoint(bool snapped, const SnapResult& result, const Geo3D::Ptr& expected, QString& message)
+    {
+        if (!snapped) {
+            message = "未捕捉到任何特征";
+            return false;
+        }
+        if (result.type != SnapType::ENDPOINT || result.geometry != expected.get()) {
+            message = QString("捕捉类型为%1，应为端点").arg(static_cast<int>(result.type));
+            return false;
+        }
+        message = QString("像素距离%1").arg(result.pixelDistance, 0, 'f', 2);
+        return true;
+    }
+
+    // 批量射线查询：竖直线段随机落在场景范围内，threadCount为0时按CPU核数
+    void registerRayBatchCase(const QString& name, int objectCount, int threadCount)
+    {
+        BenchmarkRegistry::getInstance().add(name, kRayCount, [objectCount, threadCount]() -> BenchmarkBody {
+            std::shared_ptr<PickingFixture> fixture = std::make_shared<PickingFixture>();
+            fixture->root = new osg::Group();
+            buildMixedScene(fixture->root.get(), objectCount, Subdivision_Medium3D, fixture->geometries);
+
+            fixture->sceneBVH.reset(new SceneBVH());
+            for (const Geo3D::Ptr& geo : fixture->geometries) {
+                fixture->sceneBVH->insert(geo.get(), geo->mm_node()->getBoundingBox());
+            }
+
+            auto service = std::make_shared<RayQueryService>();
+            RayQueryConfig config;
+            config.threadCount = threadCount;
+            service->setConfig(config);
+            service->setSceneBVH(fixture->sceneBVH.get());
+
+            const osg::BoundingSphere bound = fixture->root->getBound();
+            const glm::dvec3 center(bound.center().x(), bound.center().y(), bound.center().z());
+            const double radius = bound.radius();
+            auto rays = std::make_shared<std::vector<RayQuery>>();
+            std::mt19937 rng(12345);
+            std::uniform_real_distribution<double> offset(-radius, radius);
+            for (int i = 0; i < kRayCount; ++i) {
+                const glm::dvec3 point = center + glm::dvec3(offset(rng), offset(rng), 0.0);
+                rays->emplace_back(point + glm::dvec3(0.0, 0.0, radius), point - glm::dvec3(0.0, 0.0, radius));
+            }
+
+            // 第一批会提交空间索引构建，等索引换入后再计时
+            auto results = std::make_shared<std::vector<PickResult>>();
+            service->query(fixture->geometries, *rays, *results);
+            SpatialIndexBuilder::getInstance().waitForIdle();
+            SpatialIndexBuilder::getInstance().processFinished();
+
+            return [fixture, service, rays, results]() {
+                service->query(fixture->geometries, *rays, *results);
+                int hits = 0;
+                for (const PickResult& result : *results) {
+                    if (result.hasResult) ++hits;
+                }
+                benchmarkKeep(hits);
+            };
+        });
+    }
+}
+
+void registerPickingBenchmarks()
+{
+    const int objectCounts[] = { 1000, 10000 };
+    for (int objectCount : objectCounts) {
+        registerPickCase(QString("picking/triangle_grid/%1/separate").arg(objectCount), objectCount, false, PickMode_Separate);
+        registerPickCase(QString("picking/triangle_grid/%1/hybrid").arg(objectCount), objectCount, false, PickMode_Hybrid);
+        registerPickCase(QString("picking/triangle_grid/%1/scene_bvh").arg(objectCount), objectCount, false, PickMode_SceneBVH);
+        registerPickCase(QString("picking/triangle_grid/%1/vertex_grid").arg(objectCount), objectCount, false, PickMode_VertexGrid);
+        registerPickCase(QString("picking/triangle_grid/%1/edge_bvh").arg(objectCount), objectCount, false, PickMode_EdgeBVH);
+        registerGridRebuildCase(QString("picking/triangle_grid/%1/vertex_grid_rebuild").arg(objectCount), objectCount);
+    }
+
+    // 曲面体和建筑的三角形远多于平面三角形，单独覆盖
+    registerPickCase("picking/mixed/500/hybrid", 500, true, PickMode_Hybrid);
+    registerPickCase("picking/mixed/500/scene_bvh", 500, true, PickMode_SceneBVH);
+    registerPickCase("picking/mixed/500/edge_bvh", 500, true, PickMode_EdgeBVH);
+
+    registerSnapCase(QString("picking/snap/triangle_grid/%1").arg(kSnapObjectCount), kSnapObjectCount);
+
+    BenchmarkRegistry& registry = BenchmarkRegistry::getInstance();
+
+    // 光标下的边后面25个单位（在捕捉半径的40个单位内，超过两个格子）有一个点，端点优先于边上最近点
+    registry.addCheck("picking/snap/vertex_behind_edge", [](QString& message) {
+        const glm::dvec3 cursor(kSnapCheckCursor.x(), kSnapCheckCursor.y(), kSnapCheckCursor.z());
+        Geo3D::Ptr line = createSnapCheckGeometry(Geo_Line3D, { cursor + glm::dvec3(-240.0, 0.0, 0.0), cursor + glm::dvec3(120.0, 0.0, 0.0) });
+        Geo3D::Ptr point = createSnapCheckGeometry(Geo_Point3D, { cursor + glm::dvec3(0.0, 0.0, -25.0) });
+        if (!line.valid() || !point.valid()) {
+            message = "无法创建几何体";
+            return false;
+        }
+
+        SnapResult result;
+        const bool snapped = snapAtCheckCursor({ line, point }, result);
+        return checkSnappedEndpoint(snapped, result, point, message);
+    });
+
+    // 缩得很远时捕捉半径覆盖十几个格子，横向8像素（11个格子）处的点仍应捕捉到
+    registry.addCheck("picking/snap/zoomed_out", [](QString& message) {
+        const glm::dvec3 cursor(kSnapCheckCursor.x(), kSnapCheckCursor.y(), kSnapCheckCursor.z());
+        Geo3D::Ptr point = createSnapCheckGeometry(Geo_Point3D, { cursor + glm::dvec3(8.0 * kSnapCheckPixel, 0.0, 0.0) });
+        if (!point.valid()) {
+            message = "无法创建几何体";
+            return false;
+        }
+
+        SnapResult result;
+        const bool snapped = snapAtCheckCursor({ point }, result);
+        return checkSnappedEndpoint(snapped, result, point, message);
+    });
+
+    registerRayBatchCase("picking/ray_batch/mixed/500/single_thread", 500, 1);
+    registerRayBatchCase("picking/ray_batch/mixed/500/all_threads", 500, 0);
+}
@@ -0,0 +1,89 @@
+﻿#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <algorithm>
+
+#include "BenchmarkCases.h"
+#include "BenchmarkHarness.h"
+#include "../src/util/LogManager.h"
+
+// 无界面基准程序：只构建OSG场景图和离屏相机矩阵，不创建窗口和图形上下文
+//   3Drawing_benchmark [--filter 正则] [--iterations N] [--warmup N] [--output 结果.json]
+//   3Drawing_benchmark --list
+//   3Drawing_benchmark --check [--filter 正则]
+//   3Drawing_benchmark --compare 基线.json 当前.json [--threshold 百分比]
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("3Drawing_benchmark");
+    app.setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("3Drawing 性能基准");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption listOption("list", "列出全部用例");
+    QCommandLineOption checkOption("check", "只运行正确性检查，有失败时返回非零");
+    QCommandLineOption filterOption("filter", "只运行名称匹配该正则的用例", "regex");
+    QCommandLineOption iterationsOption("iterations", "计时迭代次数（默认20）", "n", "20");
+    QCommandLineOption warmupOption("warmup", "预热迭代次数（默认3）", "n", "3");
+    QCommandLineOption outputOption("output", "把结果写入JSON文件", "file");
+    QCommandLineOption compareOption("compare", "比较两个结果文件：--compare 基线.json 当前.json");
+    QCommandLineOption thresholdOption("threshold", "比较时视为变化的百分比阈值（默认5）", "percent", "5");
+    parser.addOptions({ listOption, checkOption, filterOption, iterationsOption, warmupOption,
+                        outputOption, compareOption, thresholdOption });
+    parser.addPositionalArgument("files", "--compare 模式下的基线和当前结果文件", "[基线.json 当前.json]");
+    parser.process(app);
+
+    QTextStream out(stdout);
+
+    if (parser.isSet(compareOption)) {
+        const QStringList files = parser.positionalArguments();
+        if (files.size() != 2) {
+            out << "--compare 需要两个结果文件" << Qt::endl;
+            return 2;
+        }
+        int regressions = BenchmarkRunner::compare(files[0], files[1], parser.value(thresholdOption).toDouble());
+        if (regressions < 0) return 2;
+        return regressions > 0 ? 1 : 0;
+    }
+
+    // 日志走异步线程，基准期间只保留警告以上，避免格式化和写盘干扰计时
+    LogManager::getInstance()->setFileOutput(false);
+    LogManager::setMinLevel(LogLevel::Warning);
+
+    registerMathBenchmarks();
+    registerConstraintBenchmarks();
+    registerGeometryBenchmarks();
+    registerPickingBenchmarks();
+    registerIOBenchmarks();
+    registerEntityBenchmarks();
+
+    if (parser.isSet(listOption)) {
+        for (const BenchmarkCase& benchmarkCase : BenchmarkRegistry::getInstance().cases()) {
+            out << benchmarkCase.name << Qt::endl;
+        }
+        for (const BenchmarkCheckCase& checkCase : BenchmarkRegistry::getInstance().checks()) {
+            out << checkCase.name << "  [检查]" << Qt::endl;
+        }
+        return 0;
+    }
+
+    if (parser.isSet(checkOption)) {
+        return BenchmarkRunner::runChecks(parser.value(filterOption)) > 0 ? 1 : 0;
+    }
+
+    BenchmarkOptions options;
+    options.filter = parser.value(filterOption);
+    options.iterations = std::max(1, parser.value(iterationsOption).toInt());
+    options.warmupIterations = std::max(0, parser.value(warmupOption).toInt());
+
+    std::vector<BenchmarkStats> results = BenchmarkRunner::runAll(options);
+    out << QString("共运行%1个用例").arg(results.size()) << Qt::endl;
+
+    if (parser.isSet(outputOption) && !BenchmarkRunner::writeJson(parser.value(outputOption), results)) {
+        return 2;
+    }
+    return 0;
+}
@@ -24,8 +24,6 @@ bool GlobalShowPoints3D = true;
 bool GlobalShowEdges3D = true;
 bool GlobalShowFaces3D = true;
 
-QStatusBar* GlobalStatusBar3D = nullptr;
-
 // GeoParameters3D 实现
 GeoParameters3D::GeoParameters3D()
 {
@@ -8,7 +8,6 @@
 #include <QColor>
 #include <QDebug>
 #include <QString>
-#include <QStatusBar>
 #include <QObject>
 #include <vector>
 #include <filesystem>
@@ -45,8 +44,6 @@ extern bool GlobalShowPoints3D;
 extern bool GlobalShowEdges3D;
 extern bool GlobalShowFaces3D;
 
-extern QStatusBar* GlobalStatusBar3D;
-
 // 三维点结构
 struct Point3D
 {
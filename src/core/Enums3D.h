@@ -286,6 +286,8 @@ namespace NodeTags3D
     const std::string CONTROL_POINTS_GEOMETRY = "3D_CONTROL_POINTS_GEOM";
     const std::string BOUNDING_BOX_GEOMETRY = "3D_BOUNDING_BOX_GEOM";
     const std::string TRANSFORM_NODE = "3D_TRANSFORM_NODE";
+    const std::string FACE_TRANSFORM_NODE = "3D_FACE_TRANSFORM_NODE";  // 面几何体引用单位网格时的对象矩阵
+    const std::string EDGE_TRANSFORM_NODE = "3D_EDGE_TRANSFORM_NODE";  // 边几何体引用单位网格时的对象矩阵
     const std::string ROOT_GROUP = "3D_ROOT_GROUP";
     const std::string SCENE_ROOT = "3D_SCENE_ROOT";  // 场景根节点标识
 }
@@ -346,3 +348,20 @@ inline uint32_t toggleNodeMask(uint32_t currentMask, NodeMask3D toggleMask)
     return currentMask ^ toggleMask;
 }
 
+
+// 几何组件脏标记 - 用于GeoNodeManager的增量重建
+// 每个组件使用独立的位标识，子类按绘制阶段声明依赖的组件
+enum GeoComponent3D : uint32_t
+{
+    GeoComponent_None3D          = 0,
+    GeoComponent_ControlPoints3D = 1 << 0,  // 控制点几何体
+    GeoComponent_Vertex3D        = 1 << 1,  // 顶点几何体
+    GeoComponent_Edge3D          = 1 << 2,  // 边几何体
+    GeoComponent_Face3D          = 1 << 3,  // 面几何体
+    GeoComponent_Bounds3D        = 1 << 4,  // 包围盒
+    GeoComponent_SpatialIndex3D  = 1 << 5,  // 边的线段BVH、面的KdTree
+
+    // 组合
+    GeoComponent_Geometry3D = GeoComponent_ControlPoints3D | GeoComponent_Vertex3D | GeoComponent_Edge3D | GeoComponent_Face3D,
+    GeoComponent_All3D      = GeoComponent_Geometry3D | GeoComponent_Bounds3D | GeoComponent_SpatialIndex3D
+};
@@ -0,0 +1,209 @@
+﻿#include "GeoStyleTable.h"
+#include "managers/StateSetCache.h"
+#include "../util/LogManager.h"
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+    template<typename T>
+    void hashCombine(size_t& seed, const T& value)
+    {
+        seed ^= std::hash<T>()(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+    }
+
+    void hashColor(size_t& seed, const Color3D& color)
+    {
+        hashCombine(seed, color.r);
+        hashCombine(seed, color.g);
+        hashCombine(seed, color.b);
+        hashCombine(seed, color.a);
+    }
+
+    osg::Vec4 colorToOsgVec4(const Color3D& color)
+    {
+        return osg::Vec4(
+            static_cast<float>(color.r),
+            static_cast<float>(color.g),
+            static_cast<float>(color.b),
+            static_cast<float>(color.a)
+        );
+    }
+
+    // 样式数达到上次清除后的两倍（且不少于该值）时清除一次，均摊到每次新增
+    const size_t kMinSweepThreshold = 64;
+
+    void applyLineStyle(RenderStateKey& key, LineStyle3D style, double dashPattern)
+    {
+        switch (style) {
+            case Line_Dashed3D:     key.stipplePattern = 0xF0F0; break;  // 短虚线
+            case Line_Dotted3D:     key.stipplePattern = 0xAAAA; break;  // 点线
+            case Line_DashDot3D:    key.stipplePattern = 0xFF18; break;  // 点划线
+            case Line_DashDotDot3D: key.stipplePattern = 0xFE38; break;  // 双点划线
+            case Line_Custom3D:                                          // 自定义虚线模式，使用dashPattern参数
+                key.stipplePattern = 0xF0F0;
+                key.stippleFactor = static_cast<int>(std::max(1.0, dashPattern));
+                break;
+            default:
+                key.stipplePattern = 0;
+                break;
+        }
+    }
+}
+
+// ============= GeoStyle =============
+
+GeoStyle::GeoStyle(uint32_t id, size_t hash, const GeoParameters3D& params)
+    : m_id(id)
+    , m_hash(hash)
+    , m_parameters(params)
+{
+    createStateSets();
+}
+
+void GeoStyle::createStateSets()
+{
+    // 三个组件各自按渲染状态组合取共享StateSet，只差面颜色的两种样式仍共用点和边的状态
+    const GeoParameters3D& params = m_parameters;
+    StateSetCache& cache = StateSetCache::getInstance();
+
+    RenderStateKey pointKey;
+    pointKey.primitive = RenderStateKey::Primitive_Points;
+    pointKey.color = colorToOsgVec4(params.pointColor);
+    pointKey.pointSize = static_cast<float>(params.pointSize);
+    m_pointStateSet = cache.get(pointKey);
+
+    RenderStateKey edgeKey;
+    edgeKey.primitive = RenderStateKey::Primitive_Lines;
+    edgeKey.color = colorToOsgVec4(params.lineColor);
+    edgeKey.lineWidth = static_cast<float>(params.lineWidth);
+    applyLineStyle(edgeKey, params.lineStyle, params.lineDashPattern);
+    m_edgeStateSet = cache.get(edgeKey);
+
+    RenderStateKey faceKey;
+    faceKey.primitive = RenderStateKey::Primitive_Surface;
+    faceKey.color = colorToOsgVec4(params.fillColor);
+    m_faceStateSet = cache.get(faceKey);
+}
+
+// ============= GeoStyleTable =============
+
+GeoStyleTable& GeoStyleTable::getInstance()
+{
+    static GeoStyleTable instance;
+    return instance;
+}
+
+GeoStyleTable::GeoStyleTable()
+{
+    intern(GeoParameters3D());  // 编号0：默认参数
+}
+
+osg::ref_ptr<const GeoStyle> GeoStyleTable::intern(const GeoParameters3D& params)
+{
+    const size_t hash = hashParameters(params);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto range = m_stylesByHash.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second->getParameters() == params) return it->second;
+    }
+
+    // 先清除再新增，刚创建的样式还没有调用方持有
+    if (m_styleCount >= m_sweepThreshold) {
+        sweepUnusedLocked();
+        m_sweepThreshold = std::max(m_styleCount * 2, kMinSweepThreshold);
+    }
+
+    uint32_t id;
+    if (!m_freeIds.empty()) {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+    } else {
+        id = static_cast<uint32_t>(m_styles.size());
+        m_styles.emplace_back();
+    }
+    osg::ref_ptr<GeoStyle> style = new GeoStyle(id, hash, params);
+    m_styles[id] = style;
+    m_stylesByHash.emplace(hash, style.get());
+    ++m_styleCount;
+
+    LOG_DEBUG(QString("新增样式 #%1，共%2种").arg(id).arg(m_styleCount), "样式");
+    return style;
+}
+
+osg::ref_ptr<const GeoStyle> GeoStyleTable::getStyle(uint32_t id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return id < m_styles.size() ? m_styles[id].get() : nullptr;
+}
+
+size_t GeoStyleTable::sweepUnused()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return sweepUnusedLocked();
+}
+
+size_t GeoStyleTable::sweepUnusedLocked()
+{
+    // 只剩样式表自身引用的样式不会再被取到（查找都在锁内），可以安全释放；默认样式常驻
+    size_t removed = 0;
+    for (uint32_t id = 1; id < m_styles.size(); ++id) {
+        osg::ref_ptr<GeoStyle>& style = m_styles[id];
+        if (!style.valid() || style->referenceCount() > 1) continue;
+
+        auto range = m_stylesByHash.equal_range(style->getHash());
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == style.get()) {
+                m_stylesByHash.erase(it);
+                break;
+            }
+        }
+        style = nullptr;
+        m_freeIds.push_back(id);
+        ++removed;
+    }
+    m_styleCount -= removed;
+
+    if (removed > 0) {
+        LOG_DEBUG(QString("清除%1种未使用的样式，剩余%2种").arg(removed).arg(m_styleCount), "样式");
+    }
+    return removed;
+}
+
+size_t GeoStyleTable::getStyleCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_styleCount;
+}
+
+size_t GeoStyleTable::hashParameters(const GeoParameters3D& params)
+{
+    // 与GeoParameters3D::operator==比较的字段一致
+    size_t seed = 0;
+    hashCombine(seed, static_cast<int>(params.pointShape));
+    hashCombine(seed, params.pointSize);
+    hashColor(seed, params.pointColor);
+    hashCombine(seed, params.showPoints);
+
+    hashCombine(seed, static_cast<int>(params.lineStyle));
+    hashCombine(seed, params.lineWidth);
+    hashColor(seed, params.lineColor);
+    hashCombine(seed, params.lineDashPattern);
+    hashCombine(seed, params.showEdges);
+
+    hashCombine(seed, static_cast<int>(params.fillType));
+    hashColor(seed, params.fillColor);
+    hashCombine(seed, params.showFaces);
+
+    hashColor(seed, params.material.ambient);
+    hashColor(seed, params.material.diffuse);
+    hashColor(seed, params.material.specular);
+    hashColor(seed, params.material.emission);
+    hashCombine(seed, params.material.shininess);
+    hashCombine(seed, params.material.transparency);
+    hashCombine(seed, static_cast<int>(params.material.type));
+
+    hashCombine(seed, static_cast<int>(params.subdivisionLevel));
+    return seed;
+}
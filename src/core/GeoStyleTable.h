@@ -0,0 +1,81 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include "Common3D.h"
+#include <osg/Referenced>
+#include <osg/StateSet>
+#include <osg/ref_ptr>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// 共享样式：内容相同的GeoParameters3D只存一份，创建后不可修改。
+// 点/边/面StateSet取自StateSetCache，使用该样式的所有对象直接引用；
+// 只有部分组件不同的样式也共用相同组件的StateSet。
+// 对象用ref_ptr持有样式，样式表定期清除只剩自身引用的样式。
+class GeoStyle : public osg::Referenced
+{
+public:
+    uint32_t getId() const { return m_id; }
+    size_t getHash() const { return m_hash; }
+    const GeoParameters3D& getParameters() const { return m_parameters; }
+
+    // 共享状态，不能再修改（需要不同状态时换用另一个样式）
+    osg::StateSet* getPointStateSet() const { return m_pointStateSet.get(); }
+    osg::StateSet* getEdgeStateSet() const { return m_edgeStateSet.get(); }
+    osg::StateSet* getFaceStateSet() const { return m_faceStateSet.get(); }
+
+protected:
+    virtual ~GeoStyle() = default;
+
+private:
+    friend class GeoStyleTable;
+    GeoStyle(uint32_t id, size_t hash, const GeoParameters3D& params);
+
+    void createStateSets();
+
+    uint32_t m_id;
+    size_t m_hash;
+    GeoParameters3D m_parameters;
+
+    osg::ref_ptr<osg::StateSet> m_pointStateSet;
+    osg::ref_ptr<osg::StateSet> m_edgeStateSet;
+    osg::ref_ptr<osg::StateSet> m_faceStateSet;
+};
+
+// 全局样式表 - 按内容哈希驻留参数，对象只保存样式引用。
+// 没有对象引用的样式在新增样式数翻倍时统一清除，编号随之回收；可在工作线程中调用（批处理并行读取）。
+class GeoStyleTable
+{
+public:
+    static GeoStyleTable& getInstance();
+
+    // 返回与params内容相同的样式，没有则新建；调用方须持有返回的引用，否则样式可能在下次清除时释放
+    osg::ref_ptr<const GeoStyle> intern(const GeoParameters3D& params);
+
+    // 按编号查找，编号0为样式表创建时的默认参数（常驻）；已清除的编号返回空
+    osg::ref_ptr<const GeoStyle> getStyle(uint32_t id) const;
+    osg::ref_ptr<const GeoStyle> getDefaultStyle() const { return getStyle(0); }
+
+    // 立即清除没有对象引用的样式，返回清除数量
+    size_t sweepUnused();
+
+    size_t getStyleCount() const;
+
+    static size_t hashParameters(const GeoParameters3D& params);
+
+private:
+    GeoStyleTable();
+    GeoStyleTable(const GeoStyleTable&) = delete;
+    GeoStyleTable& operator=(const GeoStyleTable&) = delete;
+
+    size_t sweepUnusedLocked();
+
+    mutable std::mutex m_mutex;
+    std::vector<osg::ref_ptr<GeoStyle>> m_styles;                    // 编号 -> 样式（已清除的为空）
+    std::vector<uint32_t> m_freeIds;                                 // 已清除样式的编号，新样式优先复用
+    std::unordered_multimap<size_t, const GeoStyle*> m_stylesByHash; // 哈希 -> 样式（冲突时再逐项比较）
+    size_t m_styleCount = 0;                                         // 当前样式数
+    size_t m_sweepThreshold = 0;                                     // 样式数达到该值时清除一次
+};
@@ -43,7 +43,10 @@
 // ========================================= 基类 Geo3D =========================================
 Geo3D::Geo3D()
     : m_geoType(Geo_Undefined3D)
+    , m_style(GeoStyleTable::getInstance().getDefaultStyle())
     , m_parametersChanged(false)
+    , m_sceneLock(nullptr)
+    , m_entityStore(nullptr)
 {
     setupManagers();
     initialize();
@@ -106,14 +109,60 @@ void Geo3D::connectManagerSignals()
                 }
             });
 
+    // 控制点变化时只重建依赖该阶段的组件
     connect(m_controlPointManager.get(), &GeoControlPointManager::controlPointChanged,
         this, [this]() {
-            mm_node()->updateGeometries();
+            int stageIdx = mm_controlPoint()->getLastChangedStage();
+            unsigned int components = stageIdx < 0 ? GeoComponent_Geometry3D : getStageDependentComponents(stageIdx);
+            if (m_entityStore) {
+                m_entityStore->syncControlPoints(m_entity, this);
+            }
+            // 控制点自身总是跟着变化
+            mm_node()->updateGeometries(components | GeoComponent_ControlPoints3D);
+        });
+
+    // 网格包围盒变化时写回实体存储
+    connect(m_nodeManager.get(), &GeoNodeManager::boundingBoxChanged,
+        this, [this]() {
+            if (!m_entityStore) return;
+            const osg::BoundingBox& box = mm_node()->getBoundingBox();
+            if (box.valid()) {
+                m_entityStore->setBounds(m_entity, BoundingBox3D(glm::dvec3(box.xMin(), box.yMin(), box.zMin()),
+                                                                 glm::dvec3(box.xMax(), box.yMax(), box.zMax())));
+            } else {
+                m_entityStore->setBounds(m_entity, BoundingBox3D());
+            }
         });
 
     qDebug() << "Geo3D::connectManagerSignals: 所有管理器信号连接完成";
 }
 
+// ========================================= 实体存储 =========================================
+void Geo3D::bindEntityStore(GeoEntityStore* store)
+{
+    if (store == m_entityStore) return;
+
+    if (m_entityStore) {
+        // 状态位和样式搬回对象自身，再释放实体
+        m_style = m_entityStore->getStyle(m_entity);
+        m_stateManager->m_geoState = m_entityStore->getState(m_entity);
+        GeoEntityStore* oldStore = m_entityStore;
+        GeoEntity oldEntity = m_entity;
+        m_entityStore = nullptr;
+        m_entity = GeoEntity();
+        oldStore->destroy(oldEntity);
+    }
+
+    if (store) {
+        GeoEntity entity = store->capture(this);
+        if (entity.isNull()) return;  // 写入失败时保持未绑定，对象自身的数据仍然可用
+        store->setFacade(entity, this);
+        m_entityStore = store;
+        m_entity = entity;
+        m_style = nullptr;
+    }
+}
+
 // ========================================= 参数管理 =========================================
 void Geo3D::setParameters(const GeoParameters3D& params)
 {
@@ -122,44 +171,52 @@ void Geo3D::setParameters(const GeoParameters3D& params)
     // 应用显示约束：确保至少有一个组件可见
     constrainedParams.enforceVisibilityConstraint();
     
-    // 检查是否有需要重新计算几何体的参数变化
-    bool needsGeometryRecalculation = false;
+    // 检查是否有需要重新计算几何体的参数变化，只标记受影响的组件
+    unsigned int dirtyComponents = GeoComponent_None3D;
     
-    if (m_parameters.pointShape != constrainedParams.pointShape) {
-        needsGeometryRecalculation = true;
+    const GeoParameters3D& oldParams = getParameters();
+    if (oldParams.pointShape != constrainedParams.pointShape) {
+        dirtyComponents |= GeoComponent_Vertex3D;
     }
     
-    if (m_parameters.subdivisionLevel != constrainedParams.subdivisionLevel) {
-        needsGeometryRecalculation = true;
+    // 细分级别只影响边和面的离散化
+    if (oldParams.subdivisionLevel != constrainedParams.subdivisionLevel) {
+        dirtyComponents |= GeoComponent_Edge3D | GeoComponent_Face3D;
     }
     
     // 如果需要重新计算几何体，先更新参数，然后重建几何体
-    if (needsGeometryRecalculation) {
-        m_parameters = constrainedParams;
-        if (m_nodeManager) {
-            m_nodeManager->updateGeometries();
-        }
-    } else {
-        // 只更新参数
-        m_parameters = constrainedParams;
+    assignStyle(GeoStyleTable::getInstance().intern(constrainedParams));
+    if (dirtyComponents != GeoComponent_None3D && m_nodeManager) {
+        m_nodeManager->updateGeometries(dirtyComponents);
     }
     
-    // 使用简化的渲染管理器接口更新所有渲染参数
+    // 换用新样式的共享渲染状态
     if (m_renderManager) {
-        m_renderManager->updateRenderingParameters(constrainedParams);
+        m_renderManager->applyStyle(getStyle());
     }
     
     m_parametersChanged = true;
+    emit parametersChanged();
 }
 
 // ========================================= 初始化和更新 =========================================
 void Geo3D::initialize()
 {
     // 获得此时的全局参数
-    m_parameters.resetToGlobal();
+    assignStyle(GeoStyleTable::getInstance().intern(GeoParameters3D()));
+    m_renderManager->applyStyle(getStyle());
     mm_state()->setStateInitialized();
 }
 
+void Geo3D::assignStyle(osg::ref_ptr<const GeoStyle> style)
+{
+    if (m_entityStore) {
+        m_entityStore->setStyle(m_entity, style.get());
+    } else {
+        m_style = style;
+    }
+}
+
 void Geo3D::buildControlPointGeometries()
 {
     mm_node()->clearControlPointsGeometry();
@@ -175,7 +232,7 @@ void Geo3D::buildControlPointGeometries()
     }
 
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
 
     // 添加所有控制点
     for (auto& points : controlPointss)
@@ -184,9 +241,7 @@ void Geo3D::buildControlPointGeometries()
             vertices->push_back(osg::Vec3(point.x(), point.y(), point.z()));
         }
 
-    geometry->setVertexArray(vertices);
-    osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, vertices->size());
-    geometry->addPrimitiveSet(drawArrays);
+    mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::POINTS, 0, vertices->size());
 }
 
 // ============================================================================
@@ -198,7 +253,7 @@ QString Geo3D::serialize() const
     // 序列化格式：几何体类型|参数数据
     QString result;
     result += QString::number(static_cast<int>(m_geoType)) + "|";
-    result += QString::fromStdString(m_parameters.toString());
+    result += QString::fromStdString(getParameters().toString());
     return result;
 }
 
@@ -222,10 +277,12 @@ bool Geo3D::deserialize(const QString& data)
     
     // 恢复参数数据
     QString paramData = parts.mid(1).join("|"); // 重新组合参数部分
-    if (!m_parameters.fromString(paramData.toStdString())) {
+    GeoParameters3D params = getParameters();
+    if (!params.fromString(paramData.toStdString())) {
         LOG_ERROR("反序列化参数数据失败", "几何体");
         return false;
     }
+    assignStyle(GeoStyleTable::getInstance().intern(params));
     
     return true;
 }
@@ -2,9 +2,12 @@
 #pragma execution_character_set("utf-8")
 
 #include "Common3D.h"
+#include "GeoStyleTable.h"
+#include "SceneLock.h"
 #include "managers/GeoStateManager.h"
 #include "managers/GeoNodeManager.h"
 #include "managers/GeoRenderManager.h"
+#include "world/GeoEntityStore.h"
 
 #include "managers/GeoControlPointManager.h"
 #include "managers/GeoRenderManager.h"
@@ -64,8 +67,19 @@ public:
     GeoRenderManager*       mm_render() const { return m_renderManager.get(); }
     GeoControlPointManager* mm_controlPoint() const { return m_controlPointManager.get(); }
 
-    // 参数设置
-    const GeoParameters3D& getParameters() const { return m_parameters; }
+    // 所在场景的读写锁（不在场景中时为空），管理器修改可拾取的子图前持有写锁
+    SceneLock* getSceneLock() const { return m_sceneLock; }
+    void setSceneLock(SceneLock* lock) { m_sceneLock = lock; }
+
+    // 所在场景的实体存储（不在场景中时为空）。绑定后状态位和样式只保存在存储中，
+    // 控制点和包围盒变化时写回存储，对象本身只作为界面编辑和显示的外观
+    GeoEntityStore* getEntityStore() const { return m_entityStore; }
+    GeoEntity getEntity() const { return m_entity; }
+    void bindEntityStore(GeoEntityStore* store);  // 传空解绑，状态位和样式搬回对象
+
+    // 参数设置（参数驻留在全局样式表中，对象只持有共享样式）
+    const GeoParameters3D& getParameters() const { return getStyle()->getParameters(); }
+    const GeoStyle* getStyle() const { return m_entityStore ? m_entityStore->getStyle(m_entity) : m_style.get(); }
     void setParameters(const GeoParameters3D& params);
     
     // 序列化/反序列化参数描述 (用于文件保存/加载)
@@ -80,6 +94,20 @@ public:
         static StageDescriptors stageDescriptors{};
         return stageDescriptors;
     }
+    
+    // 声明某个阶段的控制点变化会影响哪些组件(GeoComponent3D位组合)
+    // 节点管理器据此只重建受影响的组件，stageIdx为-1表示点数或阶段结构变化
+    virtual unsigned int getStageDependentComponents(int stageIdx) const
+    {
+        return GeoComponent_Geometry3D;
+    }
+    
+    // =============================== 捕捉相关 ==============================
+    // 可作为捕捉目标的中心点（圆弧圆心、球心、圆柱底/顶面圆心），与控制点同一坐标系
+    virtual void getSnapCenters(std::vector<glm::dvec3>& centers) const {}
+
+signals:
+    void parametersChanged();  // 样式参数更新后发出（实例化批次据此刷新颜色和归属）
 
 protected:
     
@@ -95,8 +123,11 @@ protected:
 protected:
     // 基本属性
     GeoType3D m_geoType;
-    GeoParameters3D m_parameters;
+    osg::ref_ptr<const GeoStyle> m_style;  // 未绑定实体存储时使用
     bool m_parametersChanged;
+    SceneLock* m_sceneLock;
+    GeoEntityStore* m_entityStore;
+    GeoEntity m_entity;
     // 管理器组件
     std::unique_ptr<GeoStateManager> m_stateManager;
     std::unique_ptr<GeoNodeManager> m_nodeManager;
@@ -106,5 +137,6 @@ protected:
     // 创建管理器和连接信号
     void setupManagers();
     void connectManagerSignals();
+    void assignStyle(osg::ref_ptr<const GeoStyle> style);
 };
 
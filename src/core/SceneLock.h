@@ -0,0 +1,16 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <QReadWriteLock>
+
+// 场景读写锁（每个场景一把，由SceneManager3D持有）
+// 后台拾取和批量射线查询遍历场景图时持有读锁；修改可被拾取的子图时持有写锁，
+// 包括重建几何、改变换、换入空间索引、换StateSet、改节点掩码以及增删节点。
+// 对象加入场景时挂上场景的锁，移出时摘下；不在任何场景中的对象（批处理加载、尚未添加的）
+// 没有其他线程遍历，getSceneLock()为空，QReadLocker/QWriteLocker对空指针不加锁。
+class SceneLock : public QReadWriteLock
+{
+public:
+    // 递归：主线程持有写锁时可能再次触发几何重建（如选中时补建控制点）
+    SceneLock() : QReadWriteLock(QReadWriteLock::Recursive) {}
+};
@@ -250,6 +250,8 @@ void CameraController::invalidateDirectionCache()
         // LOG_DEBUG("方向缓存已失效", "相机");
         m_directionCacheValid = false;
     }
+    // 相机位姿变化，通知视图重绘（按需渲染）
+    emit cameraChanged();
 }
 
 osg::Vec3d CameraController::getForwardVector() const
@@ -476,7 +478,7 @@ void CameraController::rotateVertical(double angle)
     // 垂直旋转（移除调试日志）
     
     // 这里可以实现垂直旋转，暂时使用OSG的默认旋转
-    m_directionCacheValid = false;
+    invalidateDirectionCache();
 }
 
 void CameraController::setPosition(const osg::Vec3d& eye, const osg::Vec3d& center, const osg::Vec3d& up)
@@ -494,7 +496,7 @@ void CameraController::setPosition(const osg::Vec3d& eye, const osg::Vec3d& cent
     m_currentManipulator->setHomePosition(eye, center, up);
     m_currentManipulator->home(0.0);
     
-    m_directionCacheValid = false;
+    invalidateDirectionCache();
 }
 
 void CameraController::setHomePosition(const osg::Vec3d& eye, const osg::Vec3d& center, const osg::Vec3d& up)
@@ -510,7 +512,7 @@ void CameraController::setHomePosition(const osg::Vec3d& eye, const osg::Vec3d&
              .arg(up.x(), 0, 'f', 2).arg(up.y(), 0, 'f', 2).arg(up.z(), 0, 'f', 2), "相机");
     
     m_currentManipulator->setHomePosition(eye, center, up);
-    m_directionCacheValid = false;
+    invalidateDirectionCache();
 }
 
 void CameraController::home()
@@ -523,7 +525,7 @@ void CameraController::home()
     LOG_INFO("相机回到初始位置", "相机");
     
     m_currentManipulator->home(0.0);
-    m_directionCacheValid = false;
+    invalidateDirectionCache();
 }
 
 void CameraController::setRotationCenter(const osg::Vec3d& center)
@@ -567,7 +569,7 @@ void CameraController::setRotationCenter(const osg::Vec3d& center)
                  .arg(center.z(), 0, 'f', 2), "相机");
     }
     
-    m_directionCacheValid = false;
+    invalidateDirectionCache();
 }
 
 osg::Vec3d CameraController::getRotationCenter() const
@@ -916,6 +918,8 @@ void CameraController::updateProjectionMatrix(int viewportWidth, int viewportHei
         //           .arg(m_near, 0, 'f', 2)
         //           .arg(m_far, 0, 'f', 2), "相机");
     }
+
+    emit cameraChanged();
 }
 
 // ========================================= 摄像机移动控制方法（从OSGWidget转移） =========================================
@@ -165,6 +165,8 @@ signals:
     void wheelMoveSensitivityChanged(double sensitivity);
     void accelerationRateChanged(double rate);
     void maxAccelerationSpeedChanged(double speed);
+    // 相机位姿或投影发生变化（用于按需渲染触发重绘）
+    void cameraChanged();
 
 private slots:
     void onUpdateTimer();
@@ -11,6 +11,38 @@ Arc3D_Geo::Arc3D_Geo()
     initialize();
 }
 
+void Arc3D_Geo::getSnapCenters(std::vector<glm::dvec3>& centers) const
+{
+    std::vector<glm::dvec3> allPoints;
+    for (const auto& points : mm_controlPoint()->getAllStageControlPoints())
+        for (const auto& point : points)
+        {
+            allPoints.push_back(glm::dvec3(point.x(), point.y(), point.z()));
+        }
+    if (allPoints.size() < 3) return;
+
+    glm::dvec3 center;
+    double radius;
+    if (MathUtils::calculateCircleCenterAndRadius(allPoints[0], allPoints[1], allPoints[2], center, radius))
+    {
+        centers.push_back(center);
+    }
+
+    // 后续各段与buildEdgeGeometries相同：由上一段末尾两个细分点和新控制点确定
+    int subdivisionLevel = static_cast<int>(getParameters().subdivisionLevel);
+    std::vector<glm::dvec3> arcPoints = MathUtils::generateArcPointsFromThreePoints(allPoints[0], allPoints[1], allPoints[2], subdivisionLevel);
+    for (size_t i = 3; i < allPoints.size() && arcPoints.size() >= 2; ++i)
+    {
+        glm::dvec3 lastPoint1 = arcPoints[arcPoints.size() - 2];
+        glm::dvec3 lastPoint2 = arcPoints[arcPoints.size() - 1];
+        if (MathUtils::calculateCircleCenterAndRadius(lastPoint1, lastPoint2, allPoints[i], center, radius))
+        {
+            centers.push_back(center);
+        }
+        arcPoints = MathUtils::generateArcPointsFromThreePoints(lastPoint1, lastPoint2, allPoints[i], subdivisionLevel);
+    }
+}
+
 void Arc3D_Geo::buildVertexGeometries()
 {
     mm_node()->clearVertexGeometry();
@@ -46,10 +78,10 @@ void Arc3D_Geo::buildEdgeGeometries()
     }
 
     // 从参数获取细分级别
-    int subdivisionLevel = static_cast<int>(m_parameters.subdivisionLevel);
+    int subdivisionLevel = static_cast<int>(getParameters().subdivisionLevel);
 
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     if (allPoints.size() == 2)
     {
@@ -60,9 +92,7 @@ void Arc3D_Geo::buildEdgeGeometries()
             vertices->push_back(MathUtils::glmToOsg(vertex));
         }
         
-        geometry->setVertexArray(vertices);
-        osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, vertices->size());
-        geometry->addPrimitiveSet(drawArrays);
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::LINES, 0, vertices->size());
     }
     else if (allPoints.size() >= 3)
     {
@@ -104,9 +134,7 @@ void Arc3D_Geo::buildEdgeGeometries()
             }
         }
         
-        geometry->setVertexArray(vertices);
-        osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, 0, vertices->size());
-        geometry->addPrimitiveSet(drawArrays);
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::LINE_STRIP, 0, vertices->size());
     }
 }
 
@@ -28,6 +28,15 @@ public:
         return stageDescriptors;
     }
 
+    // 圆弧不绘制顶点也没有面，拖拽时只重建边
+    virtual unsigned int getStageDependentComponents(int stageIdx) const override
+    {
+        return GeoComponent_Edge3D;
+    }
+
+    // 捕捉：各段圆弧的圆心
+    virtual void getSnapCenters(std::vector<glm::dvec3>& centers) const override;
+
 protected:
     virtual void buildVertexGeometries() override;
     virtual void buildEdgeGeometries() override;
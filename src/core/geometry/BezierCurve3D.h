@@ -22,6 +22,12 @@ public:
         return stageDescriptors;
     }
 
+    // 曲线没有面
+    virtual unsigned int getStageDependentComponents(int stageIdx) const override
+    {
+        return GeoComponent_Vertex3D | GeoComponent_Edge3D;
+    }
+
 protected:
     virtual void buildVertexGeometries() override;
     virtual void buildEdgeGeometries() override;
@@ -13,6 +13,8 @@ Box3D_Geo::Box3D_Geo()
 
 void Box3D_Geo::buildVertexGeometries()
 {
+    mm_node()->clearVertexGeometry();
+    
     // 获取现有的几何体
     osg::ref_ptr<osg::Geometry> geometry = mm_node()->getVertexGeometry();
     if (!geometry.valid())
@@ -26,7 +28,7 @@ void Box3D_Geo::buildVertexGeometries()
     if (allStagePoints.empty()) return;
     
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     if (allStagePoints.size() == 1) {
         // 第一阶段：确定一条边 (1-2个点)
@@ -116,17 +118,16 @@ void Box3D_Geo::buildVertexGeometries()
         }
     }
     
-    // 设置顶点数组
-    geometry->setVertexArray(vertices);
-    
     // 添加点绘制原语
     if (vertices->size() > 0) {
-        geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, vertices->size()));
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::POINTS, 0, vertices->size());
     }
 }
 
 void Box3D_Geo::buildEdgeGeometries()
 {
+    mm_node()->clearEdgeGeometry();
+    
     // 获取现有的几何体
     osg::ref_ptr<osg::Geometry> geometry = mm_node()->getEdgeGeometry();
     if (!geometry.valid())
@@ -139,8 +140,8 @@ void Box3D_Geo::buildEdgeGeometries()
     if (allStagePoints.empty()) return;
     
     // 创建顶点数组和索引数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(osg::PrimitiveSet::LINES);
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+    osg::ref_ptr<osg::DrawElementsUInt> indices = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::LINES);
     
     if (allStagePoints.size() == 1) {
         // 第一阶段：1条边
@@ -245,14 +246,12 @@ void Box3D_Geo::buildEdgeGeometries()
             indices->push_back(3); indices->push_back(7); // D-D2
         }
     }
-    
-    // 设置顶点数组和索引
-    geometry->setVertexArray(vertices);
-    geometry->addPrimitiveSet(indices);
 }
 
 void Box3D_Geo::buildFaceGeometries()
 {
+    mm_node()->clearFaceGeometry();
+    
     // 获取现有的几何体
     osg::ref_ptr<osg::Geometry> geometry = mm_node()->getFaceGeometry();
     if (!geometry.valid())
@@ -263,7 +262,7 @@ void Box3D_Geo::buildFaceGeometries()
     const auto& allStagePoints = mm_controlPoint()->getAllStageControlPoints();
     
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     if (allStagePoints.size() == 2) {
         // 第二阶段：底面1个面
@@ -287,7 +286,7 @@ void Box3D_Geo::buildFaceGeometries()
             vertices->push_back(osg::Vec3(D.x(), D.y(), D.z()));
             
             // 添加底面
-            geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::QUADS, 0, 4));
+            mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::QUADS, 0, 4);
         }
     }
     else if (allStagePoints.size() >= 3) {
@@ -362,13 +361,10 @@ void Box3D_Geo::buildFaceGeometries()
             
             // 添加6个四边形面
             for (int i = 0; i < 6; i++) {
-                geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::QUADS, i * 4, 4));
+                mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::QUADS, i * 4, 4);
             }
         }
     }
-    
-    // 设置顶点数组
-    geometry->setVertexArray(vertices);
 }
 
 
@@ -1,5 +1,6 @@
 ﻿#include "Cone3D.h"
 #include "../managers/GeoControlPointManager.h"
+#include "UnitMeshCache.h"
 #include <osg/Geometry>
 #include <osg/Array>
 #include <osg/PrimitiveSet>
@@ -18,6 +19,48 @@ Cone3D_Geo::Cone3D_Geo()
     initialize();
 }
 
+bool Cone3D_Geo::computeUnitMeshMatrix(osg::Matrixd& matrix) const
+{
+    // 底面圆和锥顶都确定、且锥顶不在底面上时才能引用单位圆锥
+    const auto& allStagePoints = mm_controlPoint()->getAllStageControlPoints();
+    if (allStagePoints.size() < 3 || allStagePoints[0].size() < 2 || allStagePoints[1].empty() || allStagePoints[2].empty()) return false;
+
+    // stage1[0] 是圆心，stage1[1] 是半径点，stage2[0] 是第三点，stage3[0] 是锥顶点
+    const Point3D& centerPoint = allStagePoints[0][0];
+    const Point3D& radiusPoint = allStagePoints[0][1];
+    const Point3D& thirdPoint = allStagePoints[1][0];
+    const Point3D& apexPoint = allStagePoints[2][0];
+
+    glm::dvec3 center = glm::dvec3(centerPoint.x(), centerPoint.y(), centerPoint.z());
+    glm::dvec3 p1 = glm::dvec3(radiusPoint.x(), radiusPoint.y(), radiusPoint.z());
+    glm::dvec3 p2 = glm::dvec3(thirdPoint.x(), thirdPoint.y(), thirdPoint.z());
+    glm::dvec3 apex = glm::dvec3(apexPoint.x(), apexPoint.y(), apexPoint.z());
+
+    double radius = glm::distance(center, p1);
+    glm::dvec3 v1 = glm::normalize(p1 - center);
+    glm::dvec3 v2 = glm::normalize(p2 - center);
+
+    // 三点共线时没有底面
+    if (glm::length(glm::cross(v1, v2)) < 1e-6f) return false;
+    glm::dvec3 normal = glm::normalize(glm::cross(v1, v2));
+
+    // 锥顶点在底面平面上（退化情况）
+    double distanceToPlane = std::abs(glm::dot(apex - center, normal));
+    if (distanceToPlane < 1e-4f) return false;
+
+    // 局部X/Y映射到底面半径方向，Z映射到圆心指向锥顶的向量（斜圆锥同样适用）
+    glm::dvec3 radiusVec = v1;  // 从圆心到半径点的向量
+    glm::dvec3 perpVec = glm::normalize(glm::cross(normal, radiusVec));
+    glm::dvec3 apexVec = apex - center;
+
+    matrix = UnitMeshCache::makeFrameMatrix(
+        osg::Vec3d(radiusVec.x, radiusVec.y, radiusVec.z) * radius,
+        osg::Vec3d(perpVec.x, perpVec.y, perpVec.z) * radius,
+        osg::Vec3d(apexVec.x, apexVec.y, apexVec.z),
+        osg::Vec3d(center.x, center.y, center.z));
+    return true;
+}
+
 void Cone3D_Geo::buildVertexGeometries()
 {
     mm_node()->clearVertexGeometry();
@@ -34,10 +77,10 @@ void Cone3D_Geo::buildVertexGeometries()
     if (allStagePoints.empty()) return;
     
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     // 从参数获取圆周细分数量
-    int circleSegments = static_cast<int>(m_parameters.subdivisionLevel);
+    int circleSegments = static_cast<int>(getParameters().subdivisionLevel);
     
     if (allStagePoints.size() == 1) 
     {
@@ -75,13 +118,10 @@ void Cone3D_Geo::buildVertexGeometries()
         vertices->push_back(osg::Vec3(top.x(), top.y(), top.z()));
     }
     
-    // 设置顶点数组
-    geometry->setVertexArray(vertices);
-    
     // 添加点绘制原语
     if (vertices->size() > 0) 
     {
-        geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, vertices->size()));
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::POINTS, 0, vertices->size());
     }
 }
 
@@ -99,12 +139,20 @@ void Cone3D_Geo::buildEdgeGeometries()
     
     if (allStagePoints.empty()) return;
     
-    // 创建顶点数组和索引数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(osg::PrimitiveSet::LINES);
-    
     // 从参数获取圆周细分数量
-    int circleSegments = static_cast<int>(m_parameters.subdivisionLevel);
+    int circleSegments = static_cast<int>(getParameters().subdivisionLevel);
+    
+    // 正常圆锥的线框（底面圆周 + 母线）引用同细分级别共享的单位圆锥，与面共用顶点
+    osg::Matrixd unitMatrix;
+    if (computeUnitMeshMatrix(unitMatrix))
+    {
+        mm_node()->setEdgeUnitMesh(UnitMeshCache::getInstance()->getCone(circleSegments).get(), unitMatrix);
+        return;
+    }
+    
+    // 创建顶点数组和索引数组
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+    osg::ref_ptr<osg::DrawElementsUInt> indices = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::LINES);
     
     if (allStagePoints.size() == 1) 
     {
@@ -194,7 +242,7 @@ void Cone3D_Geo::buildEdgeGeometries()
     }
     else if (allStagePoints.size() >= 3) 
     {
-        // 第三阶段：完整圆锥的边线（圆周 + 母线）
+        // 第三阶段：正常圆锥已引用单位圆锥线框（圆周 + 母线），这里只处理退化情况
         const auto& stage1 = allStagePoints[0];
         const auto& stage2 = allStagePoints[1];
         const auto& stage3 = allStagePoints[2];
@@ -209,7 +257,6 @@ void Cone3D_Geo::buildEdgeGeometries()
             glm::dvec3 center = glm::dvec3(centerPoint.x(), centerPoint.y(), centerPoint.z());
             glm::dvec3 p1 = glm::dvec3(radiusPoint.x(), radiusPoint.y(), radiusPoint.z());
             glm::dvec3 p2 = glm::dvec3(thirdPoint.x(), thirdPoint.y(), thirdPoint.z());
-            glm::dvec3 apex = glm::dvec3(apexPoint.x(), apexPoint.y(), apexPoint.z());
             
             // 计算半径
             double radius = glm::distance(center, p1);
@@ -234,9 +281,7 @@ void Cone3D_Geo::buildEdgeGeometries()
                 indices->push_back(1); indices->push_back(3);
                 indices->push_back(2); indices->push_back(3);
             } else {
-                // 检测锥顶点是否在底面平面上（退化情况）
-                double distanceToPlane = std::abs(glm::dot(apex - center, normal));
-                bool isDegenerate = distanceToPlane < 1e-4f; // 很小的阈值
+                // 锥顶不在底面上时已引用单位圆锥线框，到这里是锥顶落在底面上的退化情况，只绘制底面圆周
                 
                 // 添加圆心
                 vertices->push_back(osg::Vec3(center.x, center.y, center.z)); // index 0
@@ -262,26 +307,9 @@ void Cone3D_Geo::buildEdgeGeometries()
                     indices->push_back(1 + i);
                     indices->push_back(1 + next);
                 }
-                
-                if (!isDegenerate) {
-                    // 只有当锥顶点不在底面平面上时，才添加锥顶点和母线
-                    
-                    // 添加锥顶点
-                    vertices->push_back(osg::Vec3(apexPoint.x(), apexPoint.y(), apexPoint.z())); // index circleSegments+1
-                    
-                    // 母线（从锥顶到圆周上的点）
-                    for (int i = 0; i < circleSegments; i += 2) { // 只绘制一半的母线，避免太密
-                        indices->push_back(circleSegments + 1); // 锥顶
-                        indices->push_back(1 + i);               // 圆周点
-                    }
-                }
             }
         }
     }
-    
-    // 设置顶点数组和索引
-    geometry->setVertexArray(vertices);
-    geometry->addPrimitiveSet(indices);
 }
 
 void Cone3D_Geo::buildFaceGeometries()
@@ -296,11 +324,16 @@ void Cone3D_Geo::buildFaceGeometries()
     }
     const auto& allStagePoints = mm_controlPoint()->getAllStageControlPoints();
     
-    // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    
     // 从参数获取圆周细分数量
-    int circleSegments = static_cast<int>(m_parameters.subdivisionLevel);
+    int circleSegments = static_cast<int>(getParameters().subdivisionLevel);
+    
+    // 正常圆锥引用同细分级别共享的单位圆锥
+    osg::Matrixd unitMatrix;
+    if (computeUnitMeshMatrix(unitMatrix))
+    {
+        mm_node()->setFaceUnitMesh(UnitMeshCache::getInstance()->getCone(circleSegments).get(), unitMatrix);
+        return;
+    }
     
     if (allStagePoints.size() == 2) 
     {
@@ -330,6 +363,9 @@ void Cone3D_Geo::buildFaceGeometries()
             // 检查是否三点共线
             if (glm::length(glm::cross(v1, v2)) >= 1e-6f) 
             {
+                // 创建顶点数组
+                osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+                
                 // 添加圆心
                 vertices->push_back(osg::Vec3(center.x, center.y, center.z)); // 圆心
                 
@@ -353,29 +389,27 @@ void Cone3D_Geo::buildFaceGeometries()
                 vertices->push_back(osg::Vec3(firstCirclePoint.x, firstCirclePoint.y, firstCirclePoint.z));
                 
                 // 添加底面圆形（三角形扇形）
-                geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, 0, circleSegments + 2));
+                mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::TRIANGLE_FAN, 0, circleSegments + 2);
             }
             // 如果三点共线，不绘制面
         }
     }
     else if (allStagePoints.size() >= 3) 
     {
-        // 第三阶段：完整圆锥（底面 + 侧面）
+        // 第三阶段：正常圆锥已引用单位圆锥（底面 + 侧面），这里只处理退化情况
         const auto& stage1 = allStagePoints[0];
         const auto& stage2 = allStagePoints[1];
         const auto& stage3 = allStagePoints[2];
         
         if (stage1.size() >= 2 && stage2.size() >= 1 && stage3.size() >= 1) {
-            // stage1[0] 是圆心，stage1[1] 是半径点，stage2[0] 是第三点，stage3[0] 是锥顶点
+            // stage1[0] 是圆心，stage1[1] 是半径点，stage2[0] 是第三点
             Point3D centerPoint = stage1[0];
             Point3D radiusPoint = stage1[1];
             Point3D thirdPoint = stage2[0];
-            Point3D apexPoint = stage3[0];
             
             glm::dvec3 center = glm::dvec3(centerPoint.x(), centerPoint.y(), centerPoint.z());
             glm::dvec3 p1 = glm::dvec3(radiusPoint.x(), radiusPoint.y(), radiusPoint.z());
             glm::dvec3 p2 = glm::dvec3(thirdPoint.x(), thirdPoint.y(), thirdPoint.z());
-            glm::dvec3 apex = glm::dvec3(apexPoint.x(), apexPoint.y(), apexPoint.z());
             
             // 计算半径
             double radius = glm::distance(center, p1);
@@ -387,92 +421,37 @@ void Cone3D_Geo::buildFaceGeometries()
             
             // 检查是否三点共线
             if (glm::length(glm::cross(v1, v2)) >= 1e-6f) {
-                // 检测锥顶点是否在底面平面上（退化情况）
-                double distanceToPlane = std::abs(glm::dot(apex - center, normal));
-                bool isDegenerate = distanceToPlane < 1e-4f; // 很小的阈值
+                // 锥顶不在底面上时已引用单位圆锥，到这里是锥顶落在底面上的退化情况，只绘制底面圆
+                osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
                 
-                if (isDegenerate) {
-                    // 锥顶点在底面平面上，只绘制底面圆
-                    
-                    // 底面圆心
-                    vertices->push_back(osg::Vec3(center.x, center.y, center.z)); // index 0
-                    
-                    // 计算圆平面上的两个正交向量
-                    glm::dvec3 radiusVec = v1;  // 从圆心到半径点的向量
-                    glm::dvec3 perpVec = glm::normalize(glm::cross(normal, radiusVec));
-                    
-                    // 圆周上的点
-                    for (int i = 0; i < circleSegments; i++) {
-                        double angle = 2.0 * M_PI * i / circleSegments;
-                        
-                        glm::dvec3 circlePoint = center + radius * (
-                            cos(angle) * radiusVec + sin(angle) * perpVec
-                        );
-                        
-                        vertices->push_back(osg::Vec3(circlePoint.x, circlePoint.y, circlePoint.z)); // index 1+i
-                    }
-                    
-                    // 为了确保TRIANGLE_FAN正确封闭，添加第一个圆周点
-                    glm::dvec3 firstCirclePoint = center + radius * radiusVec; // angle = 0
-                    vertices->push_back(osg::Vec3(firstCirclePoint.x, firstCirclePoint.y, firstCirclePoint.z));
-                    
-                    // 只绘制底面圆形（三角形扇形）
-                    geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, 0, circleSegments + 2));
-                } else {
-                    // 正常圆锥，锥顶点不在底面平面上
-                    
-                    // 底面圆心
-                    vertices->push_back(osg::Vec3(center.x, center.y, center.z)); // index 0
-                    
-                    // 计算圆平面上的两个正交向量
-                    glm::dvec3 radiusVec = v1;  // 从圆心到半径点的向量
-                    glm::dvec3 perpVec = glm::normalize(glm::cross(normal, radiusVec));
-                    
-                    // 圆周上的点
-                    for (int i = 0; i < circleSegments; i++) {
-                        double angle = 2.0 * M_PI * i / circleSegments;
-                        
-                        glm::dvec3 circlePoint = center + radius * (
-                            cos(angle) * radiusVec + sin(angle) * perpVec
-                        );
-                        
-                        vertices->push_back(osg::Vec3(circlePoint.x, circlePoint.y, circlePoint.z)); // index 1+i
-                    }
-                    
-                    // 为了确保TRIANGLE_FAN正确封闭，添加第一个圆周点
-                    glm::dvec3 firstCirclePoint = center + radius * radiusVec; // angle = 0
-                    vertices->push_back(osg::Vec3(firstCirclePoint.x, firstCirclePoint.y, firstCirclePoint.z));
-                    
-                    // 锥顶点
-                    vertices->push_back(osg::Vec3(apexPoint.x(), apexPoint.y(), apexPoint.z())); // index circleSegments+2
+                // 底面圆心
+                vertices->push_back(osg::Vec3(center.x, center.y, center.z)); // index 0
+                
+                // 计算圆平面上的两个正交向量
+                glm::dvec3 radiusVec = v1;  // 从圆心到半径点的向量
+                glm::dvec3 perpVec = glm::normalize(glm::cross(normal, radiusVec));
+                
+                // 圆周上的点
+                for (int i = 0; i < circleSegments; i++) {
+                    double angle = 2.0 * M_PI * i / circleSegments;
                     
-                    // 底面圆形（三角形扇形）
-                    geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, 0, circleSegments + 2));
+                    glm::dvec3 circlePoint = center + radius * (
+                        cos(angle) * radiusVec + sin(angle) * perpVec
+                    );
                     
-                    // 侧面：为了正确绘制，需要重新排列顶点
-                    // 我们使用多个三角形来绘制侧面，而不是一个扇形
-                    for (int i = 0; i < circleSegments; i++) {
-                        int next = (i + 1) % circleSegments;
-                        
-                        // 为每个侧面三角形创建单独的primitive
-                        osg::ref_ptr<osg::DrawElementsUInt> triangleIndices = 
-                            new osg::DrawElementsUInt(osg::PrimitiveSet::TRIANGLES);
-                        
-                        // 三角形：锥顶点 -> 当前圆周点 -> 下一个圆周点
-                        triangleIndices->push_back(circleSegments + 2);  // 锥顶点（索引调整）
-                        triangleIndices->push_back(1 + i);               // 当前圆周点
-                        triangleIndices->push_back(1 + next);            // 下一个圆周点
-                        
-                        geometry->addPrimitiveSet(triangleIndices);
-                    }
+                    vertices->push_back(osg::Vec3(circlePoint.x, circlePoint.y, circlePoint.z)); // index 1+i
                 }
+                
+                // 为了确保TRIANGLE_FAN正确封闭，添加第一个圆周点
+                glm::dvec3 firstCirclePoint = center + radius * radiusVec; // angle = 0
+                vertices->push_back(osg::Vec3(firstCirclePoint.x, firstCirclePoint.y, firstCirclePoint.z));
+                
+                // 只绘制底面圆形（三角形扇形）
+                mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::TRIANGLE_FAN, 0, circleSegments + 2);
             }
             // 如果三点共线，不绘制面
         }
     }
-    
-    // 设置顶点数组
-    geometry->setVertexArray(vertices);
 }
 
 
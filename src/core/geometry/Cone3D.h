@@ -27,6 +27,12 @@ public:
         return stageDescriptors;
     }
 
+    // 拖拽只发生在绘制完成后，完成的圆锥不显示顶点，任何阶段都只影响边和面
+    virtual unsigned int getStageDependentComponents(int stageIdx) const override
+    {
+        return GeoComponent_Edge3D | GeoComponent_Face3D;
+    }
+
 protected:
     // 第一阶段：确定底面圆心半径 (1-2个点)
     //   - 点A：圆心
@@ -54,6 +60,8 @@ protected:
     virtual void buildFaceGeometries() override;
 
 private:
+    // 正常圆锥（底面确定且锥顶不在底面上）时给出单位圆锥 -> 对象坐标的矩阵（面和线框共用），否则返回false
+    bool computeUnitMeshMatrix(osg::Matrixd& matrix) const;
 };
 
 
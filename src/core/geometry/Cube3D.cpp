@@ -32,7 +32,7 @@ void Cube3D_Geo::buildVertexGeometries()
     if (allStagePoints.empty()) return;
     
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     if (allStagePoints.size() == 1) 
     {
@@ -115,13 +115,10 @@ void Cube3D_Geo::buildVertexGeometries()
         }
     }
     
-    // 设置顶点数组
-    geometry->setVertexArray(vertices);
-    
     // 添加点绘制原语
     if (vertices->size() > 0) 
     {
-        geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, vertices->size()));
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::POINTS, 0, vertices->size());
     }
 }
 
@@ -141,8 +138,8 @@ void Cube3D_Geo::buildEdgeGeometries()
     if (allStagePoints.empty()) return;
     
     // 创建顶点数组和索引数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(osg::PrimitiveSet::LINES);
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+    osg::ref_ptr<osg::DrawElementsUInt> indices = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::LINES);
     
     if (allStagePoints.size() == 1) 
     {
@@ -233,12 +230,6 @@ void Cube3D_Geo::buildEdgeGeometries()
             }
         }
     }
-    
-    // 设置顶点数组和索引
-    geometry->setVertexArray(vertices);
-    if (indices->size() > 0) {
-        geometry->addPrimitiveSet(indices);
-    }
 }
 
 void Cube3D_Geo::buildFaceGeometries()
@@ -255,7 +246,7 @@ void Cube3D_Geo::buildFaceGeometries()
     const auto& allStagePoints = mm_controlPoint()->getAllStageControlPoints();
     
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     if (allStagePoints.size() == 2)
     {
@@ -310,52 +301,37 @@ void Cube3D_Geo::buildFaceGeometries()
                 // 立方体的6个面，每个面用4个顶点的四边形
                 
                 // 底面：v0,v1,v3,v2
-                osg::ref_ptr<osg::DrawElementsUInt> bottomFace = 
-                    new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
+                osg::ref_ptr<osg::DrawElementsUInt> bottomFace = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::QUADS);
                 bottomFace->push_back(0); bottomFace->push_back(1); 
                 bottomFace->push_back(3); bottomFace->push_back(2);
-                geometry->addPrimitiveSet(bottomFace);
                 
                 // 顶面：v4,v6,v7,v5
-                osg::ref_ptr<osg::DrawElementsUInt> topFace = 
-                    new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
+                osg::ref_ptr<osg::DrawElementsUInt> topFace = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::QUADS);
                 topFace->push_back(4); topFace->push_back(6); 
                 topFace->push_back(7); topFace->push_back(5);
-                geometry->addPrimitiveSet(topFace);
                 
                 // 前面：v0,v4,v5,v1
-                osg::ref_ptr<osg::DrawElementsUInt> frontFace = 
-                    new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
+                osg::ref_ptr<osg::DrawElementsUInt> frontFace = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::QUADS);
                 frontFace->push_back(0); frontFace->push_back(4); 
                 frontFace->push_back(5); frontFace->push_back(1);
-                geometry->addPrimitiveSet(frontFace);
                 
                 // 后面：v2,v3,v7,v6
-                osg::ref_ptr<osg::DrawElementsUInt> backFace = 
-                    new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
+                osg::ref_ptr<osg::DrawElementsUInt> backFace = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::QUADS);
                 backFace->push_back(2); backFace->push_back(3); 
                 backFace->push_back(7); backFace->push_back(6);
-                geometry->addPrimitiveSet(backFace);
                 
                 // 左面：v0,v2,v6,v4
-                osg::ref_ptr<osg::DrawElementsUInt> leftFace = 
-                    new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
+                osg::ref_ptr<osg::DrawElementsUInt> leftFace = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::QUADS);
                 leftFace->push_back(0); leftFace->push_back(2); 
                 leftFace->push_back(6); leftFace->push_back(4);
-                geometry->addPrimitiveSet(leftFace);
                 
                 // 右面：v1,v5,v7,v3
-                osg::ref_ptr<osg::DrawElementsUInt> rightFace = 
-                    new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
+                osg::ref_ptr<osg::DrawElementsUInt> rightFace = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::QUADS);
                 rightFace->push_back(1); rightFace->push_back(5); 
                 rightFace->push_back(7); rightFace->push_back(3);
-                geometry->addPrimitiveSet(rightFace);
             }
         }
     }
-    
-    // 设置顶点数组
-    geometry->setVertexArray(vertices);
 }
 
 
@@ -1,5 +1,6 @@
 ﻿#include "Cylinder3D.h"
 #include "../managers/GeoControlPointManager.h"
+#include "UnitMeshCache.h"
 #include <osg/Geometry>
 #include <osg/Array>
 #include <osg/PrimitiveSet>
@@ -18,6 +19,68 @@ Cylinder3D_Geo::Cylinder3D_Geo()
     initialize();
 }
 
+void Cylinder3D_Geo::getSnapCenters(std::vector<glm::dvec3>& centers) const
+{
+    const auto& allStagePoints = mm_controlPoint()->getAllStageControlPoints();
+    if (allStagePoints.empty() || allStagePoints[0].size() < 3) return;
+
+    const auto& stage1 = allStagePoints[0];
+    glm::dvec3 p1 = glm::dvec3(stage1[0].x(), stage1[0].y(), stage1[0].z());
+    glm::dvec3 p2 = glm::dvec3(stage1[1].x(), stage1[1].y(), stage1[1].z());
+    glm::dvec3 p3 = glm::dvec3(stage1[2].x(), stage1[2].y(), stage1[2].z());
+
+    glm::dvec3 center;
+    double radius;
+    if (!MathUtils::calculateCircleCenterAndRadius(p1, p2, p3, center, radius)) return;
+    centers.push_back(center);
+
+    // 顶面圆心：与buildVertexGeometries相同，底面圆心沿p1到高度点的向量平移
+    if (allStagePoints.size() >= 2 && !allStagePoints[1].empty())
+    {
+        const Point3D& heightPoint = allStagePoints[1][0];
+        glm::dvec3 hp = glm::dvec3(heightPoint.x(), heightPoint.y(), heightPoint.z());
+        centers.push_back(center + (hp - p1));
+    }
+}
+
+bool Cylinder3D_Geo::computeUnitMeshMatrix(osg::Matrixd& matrix) const
+{
+    // 底面圆和高度都确定后才能引用单位圆柱
+    const auto& allStagePoints = mm_controlPoint()->getAllStageControlPoints();
+    if (allStagePoints.size() != 2 || allStagePoints[0].size() < 3 || allStagePoints[1].empty()) return false;
+
+    const auto& stage1 = allStagePoints[0];
+    const Point3D& heightPoint = allStagePoints[1][0];
+    glm::dvec3 p1 = glm::dvec3(stage1[0].x(), stage1[0].y(), stage1[0].z());
+    glm::dvec3 p2 = glm::dvec3(stage1[1].x(), stage1[1].y(), stage1[1].z());
+    glm::dvec3 p3 = glm::dvec3(stage1[2].x(), stage1[2].y(), stage1[2].z());
+    glm::dvec3 hp = glm::dvec3(heightPoint.x(), heightPoint.y(), heightPoint.z());
+
+    glm::dvec3 center;
+    double radius;
+    if (!MathUtils::calculateCircleCenterAndRadius(p1, p2, p3, center, radius)) return false;
+
+    // 计算高度向量和圆的法向量
+    glm::dvec3 heightVector = hp - p1;
+    glm::dvec3 v1 = glm::normalize(p1 - center);
+    glm::dvec3 v2 = glm::normalize(p2 - center);
+    glm::dvec3 normal = glm::normalize(glm::cross(v1, v2));
+
+    assert(glm::length(glm::cross(glm::normalize(heightVector), normal)) < 0.1 && "不垂直，约束计算错误(误差好像很大)");
+
+    // 计算圆平面上的两个正交向量
+    glm::dvec3 radiusVec = v1;
+    glm::dvec3 perpVec = glm::normalize(glm::cross(normal, radiusVec));
+
+    // 局部X/Y映射到底面半径方向，Z映射到高度向量（斜圆柱同样适用）
+    matrix = UnitMeshCache::makeFrameMatrix(
+        osg::Vec3d(radiusVec.x, radiusVec.y, radiusVec.z) * radius,
+        osg::Vec3d(perpVec.x, perpVec.y, perpVec.z) * radius,
+        osg::Vec3d(heightVector.x, heightVector.y, heightVector.z),
+        osg::Vec3d(center.x, center.y, center.z));
+    return true;
+}
+
 void Cylinder3D_Geo::buildVertexGeometries()
 {
     mm_node()->clearVertexGeometry();
@@ -35,10 +98,10 @@ void Cylinder3D_Geo::buildVertexGeometries()
     if (allStagePoints.empty()) return;
     
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     // 从参数获取圆周细分数量
-    int circleSegments = static_cast<int>(m_parameters.subdivisionLevel);
+    int circleSegments = static_cast<int>(getParameters().subdivisionLevel);
     
     if (allStagePoints.size() == 1) 
     {
@@ -116,13 +179,10 @@ void Cylinder3D_Geo::buildVertexGeometries()
         }
     }
     
-    // 设置顶点数组
-    geometry->setVertexArray(vertices);
-    
     // 添加点绘制原语
     if (vertices->size() > 0) 
     {
-        geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, vertices->size()));
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::POINTS, 0, vertices->size());
     }
 }
 
@@ -141,12 +201,20 @@ void Cylinder3D_Geo::buildEdgeGeometries()
     
     if (allStagePoints.empty()) return;
     
-    // 创建顶点数组和索引数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(osg::PrimitiveSet::LINES);
-    
     // 从参数获取圆周细分数量
-    int circleSegments = static_cast<int>(m_parameters.subdivisionLevel);
+    int circleSegments = static_cast<int>(getParameters().subdivisionLevel);
+    
+    // 确定了高度后线框（底面、顶面圆周）引用同细分级别共享的单位圆柱，与面共用顶点
+    osg::Matrixd unitMatrix;
+    if (computeUnitMeshMatrix(unitMatrix))
+    {
+        mm_node()->setEdgeUnitMesh(UnitMeshCache::getInstance()->getCylinder(circleSegments).get(), unitMatrix);
+        return;
+    }
+    
+    // 创建顶点数组和索引数组
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+    osg::ref_ptr<osg::DrawElementsUInt> indices = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::LINES);
     
     if (allStagePoints.size() == 1) 
     {
@@ -216,89 +284,6 @@ void Cylinder3D_Geo::buildEdgeGeometries()
             }
         }
     }
-    else if (allStagePoints.size() == 2)
-    {
-        // 第二阶段：显示完整圆柱体的边线
-        const auto& stage1 = allStagePoints[0];
-        const auto& stage2 = allStagePoints[1];
-        
-        assert(stage1.size() >= 3 && stage2.size() >= 1);
-        
-        Point3D point1 = stage1[0];
-        Point3D point2 = stage1[1];
-        Point3D point3 = stage1[2];
-        Point3D heightPoint = stage2[0];
-        
-        glm::dvec3 p1 = glm::dvec3(point1.x(), point1.y(), point1.z());
-        glm::dvec3 p2 = glm::dvec3(point2.x(), point2.y(), point2.z());
-        glm::dvec3 p3 = glm::dvec3(point3.x(), point3.y(), point3.z());
-        glm::dvec3 hp = glm::dvec3(heightPoint.x(), heightPoint.y(), heightPoint.z());
-        
-        glm::dvec3 center;
-        double radius;
-        
-        if (MathUtils::calculateCircleCenterAndRadius(p1, p2, p3, center, radius)) 
-        {
-            // 计算高度向量
-            glm::dvec3 heightVector = hp - p1;
-            
-            // 计算圆的法向量
-            glm::dvec3 v1 = glm::normalize(p1 - center);
-            glm::dvec3 v2 = glm::normalize(p2 - center);
-            glm::dvec3 normal = glm::normalize(glm::cross(v1, v2));
-            
-            // 误差累积得好大
-            assert(std::abs(glm::length(glm::cross(glm::normalize(heightVector), normal)) - 1) > 0.1 && "再怎么样为啥高会与平面法向量垂直啊");
-            assert(glm::length(glm::cross(glm::normalize(heightVector), normal)) < 0.1 && "约束计算错误");
-
-            // 计算圆平面上的两个正交向量
-            glm::dvec3 radiusVec = v1;
-            glm::dvec3 perpVec = glm::normalize(glm::cross(normal, radiusVec));
-            
-            // 生成底面圆周上的点
-            for (int i = 0; i < circleSegments; i++) {
-                double angle = 2.0 * M_PI * i / circleSegments;
-                
-                glm::dvec3 bottomPoint = center + radius * (
-                    cos(angle) * radiusVec + sin(angle) * perpVec
-                );
-                
-                glm::dvec3 topPoint = bottomPoint + heightVector;
-                
-                vertices->push_back(osg::Vec3(bottomPoint.x, bottomPoint.y, bottomPoint.z)); // index i*2
-                vertices->push_back(osg::Vec3(topPoint.x, topPoint.y, topPoint.z)); // index i*2+1
-            }
-            
-            // 底面圆周连线
-            for (int i = 0; i < circleSegments; i++) 
-            {
-                int next = (i + 1) % circleSegments;
-                indices->push_back(i * 2);
-                indices->push_back(next * 2);
-            }
-            
-            // 顶面圆周连线
-            for (int i = 0; i < circleSegments; i++) 
-            {
-                int next = (i + 1) % circleSegments;
-                indices->push_back(i * 2 + 1);
-                indices->push_back(next * 2 + 1);
-            }
-            
-            // // 垂直母线（只绘制一半，避免太密）
-            // for (int i = 0; i < circleSegments; i += 2) 
-            // {
-            //     indices->push_back(i * 2);     // 底面点
-            //     indices->push_back(i * 2 + 1); // 对应顶面点
-            // }
-        }
-    }
-    
-    // 设置顶点数组和索引
-    geometry->setVertexArray(vertices);
-    if (indices->size() > 0) {
-        geometry->addPrimitiveSet(indices);
-    }
 }
 
 void Cylinder3D_Geo::buildFaceGeometries()
@@ -314,11 +299,16 @@ void Cylinder3D_Geo::buildFaceGeometries()
     
     const auto& allStagePoints = mm_controlPoint()->getAllStageControlPoints();
     
-    // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    
     // 从参数获取圆周细分数量
-    int circleSegments = static_cast<int>(m_parameters.subdivisionLevel);
+    int circleSegments = static_cast<int>(getParameters().subdivisionLevel);
+    
+    // 确定了高度后引用同细分级别共享的单位圆柱（底面 + 顶面 + 侧面）
+    osg::Matrixd unitMatrix;
+    if (computeUnitMeshMatrix(unitMatrix))
+    {
+        mm_node()->setFaceUnitMesh(UnitMeshCache::getInstance()->getCylinder(circleSegments).get(), unitMatrix);
+        return;
+    }
     
     if (allStagePoints.size() == 1) 
     {
@@ -340,6 +330,9 @@ void Cylinder3D_Geo::buildFaceGeometries()
             
             if (MathUtils::calculateCircleCenterAndRadius(p1, p2, p3, center, radius)) 
             {
+                // 创建顶点数组
+                osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+                
                 // 添加圆心
                 vertices->push_back(osg::Vec3(center.x, center.y, center.z)); // 圆心
                 
@@ -368,111 +361,10 @@ void Cylinder3D_Geo::buildFaceGeometries()
                 vertices->push_back(osg::Vec3(firstCirclePoint.x, firstCirclePoint.y, firstCirclePoint.z));
                 
                 // 添加底面圆形（三角形扇形）
-                geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, 0, circleSegments + 2));
-            }
-        }
-    }
-    else if (allStagePoints.size() == 2)
-    {
-        // 第二阶段：显示完整圆柱体（底面 + 顶面 + 侧面）
-        const auto& stage1 = allStagePoints[0];
-        const auto& stage2 = allStagePoints[1];
-        
-        assert(stage1.size() >= 3 && stage2.size() >= 1);
-        
-        Point3D point1 = stage1[0];
-        Point3D point2 = stage1[1];
-        Point3D point3 = stage1[2];
-        Point3D heightPoint = stage2[0];
-        
-        glm::dvec3 p1 = glm::dvec3(point1.x(), point1.y(), point1.z());
-        glm::dvec3 p2 = glm::dvec3(point2.x(), point2.y(), point2.z());
-        glm::dvec3 p3 = glm::dvec3(point3.x(), point3.y(), point3.z());
-        glm::dvec3 hp = glm::dvec3(heightPoint.x(), heightPoint.y(), heightPoint.z());
-        
-        glm::dvec3 center;
-        double radius;
-        
-        if (MathUtils::calculateCircleCenterAndRadius(p1, p2, p3, center, radius)) 
-        {
-            // 计算高度向量
-            glm::dvec3 heightVector = hp - p1;
-            glm::dvec3 topCenter = center + heightVector;
-            
-            // 计算圆的法向量
-            glm::dvec3 v1 = glm::normalize(p1 - center);
-            glm::dvec3 v2 = glm::normalize(p2 - center);
-            glm::dvec3 normal = glm::normalize(glm::cross(v1, v2));
-            
-            assert(glm::length(glm::cross(glm::normalize(heightVector), normal)) < 0.1 && "不垂直，约束计算错误(误差好像很大)");
-
-            // 计算圆平面上的两个正交向量
-            glm::dvec3 radiusVec = v1;
-            glm::dvec3 perpVec = glm::normalize(glm::cross(normal, radiusVec));
-            
-            // 添加底面圆心
-            vertices->push_back(osg::Vec3(center.x, center.y, center.z)); // index 0
-            
-            // 添加底面圆周上的点
-            for (int i = 0; i < circleSegments; i++) {
-                double angle = 2.0 * M_PI * i / circleSegments;
-                
-                glm::dvec3 circlePoint = center + radius * (
-                    cos(angle) * radiusVec + sin(angle) * perpVec
-                );
-                
-                vertices->push_back(osg::Vec3(circlePoint.x, circlePoint.y, circlePoint.z)); // index 1+i
-            }
-            
-            // 为了确保TRIANGLE_FAN正确封闭，添加第一个圆周点
-            glm::dvec3 firstCirclePoint = center + radius * radiusVec;
-            vertices->push_back(osg::Vec3(firstCirclePoint.x, firstCirclePoint.y, firstCirclePoint.z)); // index circleSegments+1
-            
-            // 添加顶面圆心
-            vertices->push_back(osg::Vec3(topCenter.x, topCenter.y, topCenter.z)); // index circleSegments+2
-            
-            // 添加顶面圆周上的点
-            for (int i = 0; i < circleSegments; i++) {
-                double angle = 2.0 * M_PI * i / circleSegments;
-                
-                glm::dvec3 circlePoint = topCenter + radius * (
-                    cos(angle) * radiusVec + sin(angle) * perpVec
-                );
-                
-                vertices->push_back(osg::Vec3(circlePoint.x, circlePoint.y, circlePoint.z)); // index circleSegments+3+i
-            }
-            
-            // 为了确保TRIANGLE_FAN正确封闭，添加第一个顶面圆周点
-            glm::dvec3 firstTopCirclePoint = topCenter + radius * radiusVec;
-            vertices->push_back(osg::Vec3(firstTopCirclePoint.x, firstTopCirclePoint.y, firstTopCirclePoint.z)); // index 2*circleSegments+3
-            
-            // 底面圆形（三角形扇形）
-            geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, 0, circleSegments + 2));
-            
-            // 顶面圆形（三角形扇形）
-            geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, circleSegments + 2, circleSegments + 2));
-            
-            // 侧面：使用四边形条带
-            for (int i = 0; i < circleSegments; i++) {
-                int next = (i + 1) % circleSegments;
-                
-                // 为每个侧面四边形创建单独的primitive
-                osg::ref_ptr<osg::DrawElementsUInt> quadIndices = 
-                    new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
-                
-                // 四边形：底面当前点 -> 底面下一点 -> 顶面下一点 -> 顶面当前点
-                quadIndices->push_back(1 + i);                           // 底面当前点
-                quadIndices->push_back(1 + next);                        // 底面下一点
-                quadIndices->push_back(circleSegments + 3 + next);       // 顶面下一点
-                quadIndices->push_back(circleSegments + 3 + i);          // 顶面当前点
-                
-                geometry->addPrimitiveSet(quadIndices);
+                mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::TRIANGLE_FAN, 0, circleSegments + 2);
             }
         }
     }
-    
-    // 设置顶点数组
-    geometry->setVertexArray(vertices);
 } 
 
 
@@ -31,12 +31,17 @@ public:
         return stageDescriptors;
     }
 
+    // 捕捉：底面和顶面圆心
+    virtual void getSnapCenters(std::vector<glm::dvec3>& centers) const override;
+
 protected:
     virtual void buildVertexGeometries() override;
     virtual void buildEdgeGeometries() override;
     virtual void buildFaceGeometries() override;
 
 private:
+    // 底面圆和高度都确定时给出单位圆柱 -> 对象坐标的矩阵（面和线框共用），否则返回false
+    bool computeUnitMeshMatrix(osg::Matrixd& matrix) const;
     
 private:
 };
@@ -26,7 +26,7 @@ void Point3D_Geo::buildVertexGeometries()
     }
 
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
 
     // 收集所有控制点 - 点几何体直接显示所有控制点
     for (auto& points : controlPointss)
@@ -37,9 +37,7 @@ void Point3D_Geo::buildVertexGeometries()
 
     if (vertices->size() > 0)
     {
-        geometry->setVertexArray(vertices);
-        osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, vertices->size());
-        geometry->addPrimitiveSet(drawArrays);
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::POINTS, 0, vertices->size());
     }
 }
 
@@ -23,6 +23,12 @@ public:
         return stageDescriptors;
     }
 
+    // 点没有边和面，拖拽时只重建顶点
+    virtual unsigned int getStageDependentComponents(int stageIdx) const override
+    {
+        return GeoComponent_Vertex3D;
+    }
+
 protected:
     virtual void buildVertexGeometries() override;
     virtual void buildEdgeGeometries() override;
@@ -26,7 +26,7 @@ void Polygon3D_Geo::buildVertexGeometries()
     }
 
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
 
     // 收集所有控制点
     for (auto& points : controlPointss)
@@ -35,9 +35,7 @@ void Polygon3D_Geo::buildVertexGeometries()
             vertices->push_back(osg::Vec3(point.x(), point.y(), point.z()));
         }
 
-    geometry->setVertexArray(vertices);
-    osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, vertices->size());
-    geometry->addPrimitiveSet(drawArrays);
+    mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::POINTS, 0, vertices->size());
 }
 
 void Polygon3D_Geo::buildEdgeGeometries()
@@ -69,7 +67,7 @@ void Polygon3D_Geo::buildEdgeGeometries()
     }
 
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     if (allPoints.size() == 2)
     {
@@ -80,9 +78,7 @@ void Polygon3D_Geo::buildEdgeGeometries()
             vertices->push_back(MathUtils::glmToOsg(vertex));
         }
         
-        geometry->setVertexArray(vertices);
-        osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, vertices->size());
-        geometry->addPrimitiveSet(drawArrays);
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::LINES, 0, vertices->size());
     }
     else
     {
@@ -93,9 +89,7 @@ void Polygon3D_Geo::buildEdgeGeometries()
             vertices->push_back(MathUtils::glmToOsg(allPoints[(i + 1) % allPoints.size()]));
         }
         
-        geometry->setVertexArray(vertices);
-        osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, vertices->size());
-        geometry->addPrimitiveSet(drawArrays);
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::LINES, 0, vertices->size());
     }
 }
 
@@ -128,8 +122,8 @@ void Polygon3D_Geo::buildFaceGeometries()
     }
 
     // 创建顶点数组和法向量数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+    osg::ref_ptr<osg::Vec3Array> normals = mm_node()->reuseNormalArray(geometry.get());
     
     // 计算多边形法向量
     glm::dvec3 normal = MathUtils::calculatePolygonNormal(allPoints);
@@ -175,12 +169,7 @@ void Polygon3D_Geo::buildFaceGeometries()
         }
     }
     
-    geometry->setVertexArray(vertices);
-    geometry->setNormalArray(normals);
-    geometry->setNormalBinding(osg::Geometry::BIND_PER_VERTEX);
-    
-    osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::TRIANGLES, 0, vertices->size());
-    geometry->addPrimitiveSet(drawArrays);
+    mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::TRIANGLES, 0, vertices->size());
 }
 
 
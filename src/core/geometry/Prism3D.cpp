@@ -35,7 +35,7 @@ void Prism3D_Geo::buildVertexGeometries()
     if (allStagePoints.empty()) return;
     
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     if (allStagePoints.size() == 1) 
     {
@@ -83,13 +83,10 @@ void Prism3D_Geo::buildVertexGeometries()
         vertices->push_back(osg::Vec3(topCenter.x, topCenter.y, topCenter.z));
     }
     
-    // 设置顶点数组
-    geometry->setVertexArray(vertices);
-    
     // 添加点绘制原语
     if (vertices->size() > 0) 
     {
-        geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, vertices->size()));
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::POINTS, 0, vertices->size());
     }
 }
 
@@ -109,8 +106,8 @@ void Prism3D_Geo::buildEdgeGeometries()
     if (allStagePoints.empty()) return;
     
     // 创建顶点数组和索引数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(osg::PrimitiveSet::LINES);
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+    osg::ref_ptr<osg::DrawElementsUInt> indices = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::LINES);
     
     if (allStagePoints.size() == 1) 
     {
@@ -193,12 +190,6 @@ void Prism3D_Geo::buildEdgeGeometries()
             indices->push_back(i * 2 + 1); // 对应顶面点
         }
     }
-    
-    // 设置顶点数组和索引
-    geometry->setVertexArray(vertices);
-    if (indices->size() > 0) {
-        geometry->addPrimitiveSet(indices);
-    }
 }
 
 void Prism3D_Geo::buildFaceGeometries()
@@ -215,7 +206,7 @@ void Prism3D_Geo::buildFaceGeometries()
     const auto& allStagePoints = mm_controlPoint()->getAllStageControlPoints();
     
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     if (allStagePoints.size() == 1) 
     {
@@ -248,7 +239,7 @@ void Prism3D_Geo::buildFaceGeometries()
             vertices->push_back(osg::Vec3(firstPoint.x(), firstPoint.y(), firstPoint.z()));
             
             // 添加底面多边形（三角形扇形）
-            geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, 0, stage1.size() + 2));
+            mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::TRIANGLE_FAN, 0, stage1.size() + 2);
         }
     }
     else if (allStagePoints.size() == 2)
@@ -312,10 +303,10 @@ void Prism3D_Geo::buildFaceGeometries()
         vertices->push_back(osg::Vec3(firstTopPoint.x, firstTopPoint.y, firstTopPoint.z)); // index 2*numPolygonVertices+3
         
         // 底面多边形（三角形扇形）
-        geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, 0, numPolygonVertices + 2));
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::TRIANGLE_FAN, 0, numPolygonVertices + 2);
         
         // 顶面多边形（三角形扇形）
-        geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, numPolygonVertices + 2, numPolygonVertices + 2));
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::TRIANGLE_FAN, numPolygonVertices + 2, numPolygonVertices + 2);
         
         // 侧面：使用四边形条带
         for (size_t i = 0; i < numPolygonVertices; i++) 
@@ -323,20 +314,14 @@ void Prism3D_Geo::buildFaceGeometries()
             size_t next = (i + 1) % numPolygonVertices;
             
             // 为每个侧面四边形创建单独的primitive
-            osg::ref_ptr<osg::DrawElementsUInt> quadIndices = 
-                new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
+            osg::ref_ptr<osg::DrawElementsUInt> quadIndices = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::QUADS);
             
             // 四边形：底面当前点 -> 底面下一点 -> 顶面下一点 -> 顶面当前点
             quadIndices->push_back(1 + i);                                          // 底面当前点
             quadIndices->push_back(1 + next);                                       // 底面下一点
             quadIndices->push_back(numPolygonVertices + 3 + next);                  // 顶面下一点
             quadIndices->push_back(numPolygonVertices + 3 + i);                     // 顶面当前点
-            
-            geometry->addPrimitiveSet(quadIndices);
         }
     }
-    
-    // 设置顶点数组
-    geometry->setVertexArray(vertices);
 } 
 
@@ -26,7 +26,7 @@ void Quad3D_Geo::buildVertexGeometries()
     }
 
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
 
     // 收集所有控制点
     for (auto& points : controlPointss)
@@ -35,9 +35,7 @@ void Quad3D_Geo::buildVertexGeometries()
             vertices->push_back(osg::Vec3(point.x(), point.y(), point.z()));
         }
 
-    geometry->setVertexArray(vertices);
-    osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, vertices->size());
-    geometry->addPrimitiveSet(drawArrays);
+    mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::POINTS, 0, vertices->size());
 }
 
 void Quad3D_Geo::buildEdgeGeometries()
@@ -69,7 +67,7 @@ void Quad3D_Geo::buildEdgeGeometries()
     }
 
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     if (allPoints.size() == 2)
     {
@@ -79,9 +77,7 @@ void Quad3D_Geo::buildEdgeGeometries()
         {
             vertices->push_back(MathUtils::glmToOsg(vertex));
         }
-        geometry->setVertexArray(vertices);
-        osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, vertices->size());
-        geometry->addPrimitiveSet(drawArrays);
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::LINES, 0, vertices->size());
     }
     else if (allPoints.size() == 3)
     {
@@ -93,9 +89,7 @@ void Quad3D_Geo::buildEdgeGeometries()
         vertices->push_back(MathUtils::glmToOsg(allPoints[2]));
         vertices->push_back(MathUtils::glmToOsg(allPoints[0]));
         
-        geometry->setVertexArray(vertices);
-        osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, vertices->size());
-        geometry->addPrimitiveSet(drawArrays);
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::LINES, 0, vertices->size());
     }
     else if (allPoints.size() >= 4)
     {
@@ -109,9 +103,7 @@ void Quad3D_Geo::buildEdgeGeometries()
         vertices->push_back(MathUtils::glmToOsg(allPoints[3]));
         vertices->push_back(MathUtils::glmToOsg(allPoints[0]));
         
-        geometry->setVertexArray(vertices);
-        osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, vertices->size());
-        geometry->addPrimitiveSet(drawArrays);
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::LINES, 0, vertices->size());
     }
 }
 
@@ -144,8 +136,8 @@ void Quad3D_Geo::buildFaceGeometries()
     }
 
     // 创建顶点数组和法向量数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+    osg::ref_ptr<osg::Vec3Array> normals = mm_node()->reuseNormalArray(geometry.get());
     
     if (allPoints.size() == 3)
     {
@@ -172,12 +164,7 @@ void Quad3D_Geo::buildFaceGeometries()
         }
     }
     
-    geometry->setVertexArray(vertices);
-    geometry->setNormalArray(normals);
-    geometry->setNormalBinding(osg::Geometry::BIND_PER_VERTEX);
-    
-    osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::TRIANGLES, 0, vertices->size());
-    geometry->addPrimitiveSet(drawArrays);
+    mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::TRIANGLES, 0, vertices->size());
 } 
 
 
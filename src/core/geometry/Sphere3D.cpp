@@ -1,5 +1,6 @@
 ﻿#include "Sphere3D.h"
 #include "../managers/GeoControlPointManager.h"
+#include "UnitMeshCache.h"
 #include <osg/Geometry>
 #include <osg/Array>
 #include <osg/PrimitiveSet>
@@ -70,6 +71,57 @@ Sphere3D_Geo::Sphere3D_Geo()
     initialize();
 }
 
+void Sphere3D_Geo::getSnapCenters(std::vector<glm::dvec3>& centers) const
+{
+    const auto& allStagePoints = mm_controlPoint()->getAllStageControlPoints();
+    if (allStagePoints.empty() || allStagePoints[0].size() < 3) return;
+
+    const auto& stage1 = allStagePoints[0];
+    glm::dvec3 p1 = glm::dvec3(stage1[0].x(), stage1[0].y(), stage1[0].z());
+    glm::dvec3 p2 = glm::dvec3(stage1[1].x(), stage1[1].y(), stage1[1].z());
+    glm::dvec3 p3 = glm::dvec3(stage1[2].x(), stage1[2].y(), stage1[2].z());
+
+    glm::dvec3 center;
+    double radius;
+    if (allStagePoints.size() >= 2 && !allStagePoints[1].empty())
+    {
+        const Point3D& point4 = allStagePoints[1][0];
+        glm::dvec3 p4 = glm::dvec3(point4.x(), point4.y(), point4.z());
+        if (calculateSphereCenterAndRadius(p1, p2, p3, p4, center, radius))
+        {
+            centers.push_back(center);
+            return;
+        }
+    }
+
+    if (MathUtils::calculateCircleCenterAndRadius(p1, p2, p3, center, radius))
+    {
+        centers.push_back(center);
+    }
+}
+
+bool Sphere3D_Geo::computeUnitMeshMatrix(osg::Matrixd& matrix) const
+{
+    // 只有四点确定了球体时才能引用单位球
+    const auto& allStagePoints = mm_controlPoint()->getAllStageControlPoints();
+    if (allStagePoints.size() != 2 || allStagePoints[0].size() < 3 || allStagePoints[1].empty()) return false;
+
+    const auto& stage1 = allStagePoints[0];
+    const Point3D& point4 = allStagePoints[1][0];
+    glm::dvec3 p1 = glm::dvec3(stage1[0].x(), stage1[0].y(), stage1[0].z());
+    glm::dvec3 p2 = glm::dvec3(stage1[1].x(), stage1[1].y(), stage1[1].z());
+    glm::dvec3 p3 = glm::dvec3(stage1[2].x(), stage1[2].y(), stage1[2].z());
+    glm::dvec3 p4 = glm::dvec3(point4.x(), point4.y(), point4.z());
+
+    glm::dvec3 center;
+    double radius;
+    if (!calculateSphereCenterAndRadius(p1, p2, p3, p4, center, radius)) return false;
+
+    // 单位球只需缩放+平移
+    matrix = osg::Matrixd::scale(radius, radius, radius) * osg::Matrixd::translate(center.x, center.y, center.z);
+    return true;
+}
+
 void Sphere3D_Geo::buildVertexGeometries()
 {
     mm_node()->clearVertexGeometry();
@@ -87,7 +139,7 @@ void Sphere3D_Geo::buildVertexGeometries()
     if (allStagePoints.empty()) return;
     
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     if (allStagePoints.size() == 1) 
     {
@@ -170,13 +222,10 @@ void Sphere3D_Geo::buildVertexGeometries()
         }
     }
     
-    // 设置顶点数组
-    geometry->setVertexArray(vertices);
-    
     // 添加点绘制原语
     if (vertices->size() > 0) 
     {
-        geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, vertices->size()));
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::POINTS, 0, vertices->size());
     }
 }
 
@@ -195,12 +244,20 @@ void Sphere3D_Geo::buildEdgeGeometries()
     
     if (allStagePoints.empty()) return;
     
-    // 创建顶点数组和索引数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(osg::PrimitiveSet::LINES);
-    
     // 从参数获取球面细分数量
-    int sphereSegments = static_cast<int>(m_parameters.subdivisionLevel);
+    int sphereSegments = static_cast<int>(getParameters().subdivisionLevel);
+    
+    // 确定了球体时线框引用同细分级别共享的单位球（与面共用顶点），不再逐对象生成
+    osg::Matrixd unitMatrix;
+    if (computeUnitMeshMatrix(unitMatrix))
+    {
+        mm_node()->setEdgeUnitMesh(UnitMeshCache::getInstance()->getSphere(sphereSegments).get(), unitMatrix);
+        return;
+    }
+    
+    // 创建顶点数组和索引数组
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+    osg::ref_ptr<osg::DrawElementsUInt> indices = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::LINES);
     
     if (allStagePoints.size() == 1) 
     {
@@ -272,118 +329,54 @@ void Sphere3D_Geo::buildEdgeGeometries()
     }
     else if (allStagePoints.size() == 2)
     {
-        // 第二阶段：显示球体的线框
+        // 第二阶段：确定了球体时已引用单位球线框，
+        // 到这里说明四点共面或无法确定球体，降级为绘制前三点确定的截面圆
         const auto& stage1 = allStagePoints[0];
-        const auto& stage2 = allStagePoints[1];
         
-        assert(stage1.size() >= 3 && stage2.size() >= 1);
+        assert(stage1.size() >= 3);
         
         Point3D point1 = stage1[0];
         Point3D point2 = stage1[1];
         Point3D point3 = stage1[2];
-        Point3D point4 = stage2[0];
         
         glm::dvec3 p1 = glm::dvec3(point1.x(), point1.y(), point1.z());
         glm::dvec3 p2 = glm::dvec3(point2.x(), point2.y(), point2.z());
         glm::dvec3 p3 = glm::dvec3(point3.x(), point3.y(), point3.z());
-        glm::dvec3 p4 = glm::dvec3(point4.x(), point4.y(), point4.z());
         
-        glm::dvec3 center;
-        double radius;
+        glm::dvec3 circleCenter;
+        double circleRadius;
         
-        if (calculateSphereCenterAndRadius(p1, p2, p3, p4, center, radius)) 
+        if (MathUtils::calculateCircleCenterAndRadius(p1, p2, p3, circleCenter, circleRadius)) 
         {
-            // 生成球体线框
-            int rings = sphereSegments / 2;
+            // 计算圆的法向量
+            glm::dvec3 v1 = glm::normalize(p1 - circleCenter);
+            glm::dvec3 v2 = glm::normalize(p2 - circleCenter);
+            glm::dvec3 normal = glm::normalize(glm::cross(v1, v2));
             
-            // 生成球面顶点
-            for (int ring = 0; ring <= rings; ring++) {
-                double phi = M_PI * ring / rings;
-                double sinPhi = sin(phi);
-                double cosPhi = cos(phi);
-                
-                for (int seg = 0; seg <= sphereSegments; seg++) {
-                    double theta = 2.0 * M_PI * seg / sphereSegments;
-                    double sinTheta = sin(theta);
-                    double cosTheta = cos(theta);
-                    
-                    glm::dvec3 normal(sinPhi * cosTheta, sinPhi * sinTheta, cosPhi);
-                    glm::dvec3 point = center + radius * normal;
-                    
-                    vertices->push_back(osg::Vec3(point.x, point.y, point.z));
-                }
-            }
+            // 计算圆平面上的两个正交向量
+            glm::dvec3 radiusVec = v1;
+            glm::dvec3 perpVec = glm::normalize(glm::cross(normal, radiusVec));
             
-            // 连接纬线
-            for (int ring = 0; ring <= rings; ring++) {
-                for (int seg = 0; seg < sphereSegments; seg++) {
-                    int curr = ring * (sphereSegments + 1) + seg;
-                    int next = ring * (sphereSegments + 1) + (seg + 1);
-                    
-                    indices->push_back(curr);
-                    indices->push_back(next);
-                }
+            // 生成圆周上的点
+            for (int i = 0; i < sphereSegments; i++) {
+                double angle = 2.0 * M_PI * i / sphereSegments;
+                
+                glm::dvec3 circlePoint = circleCenter + circleRadius * (
+                    cos(angle) * radiusVec + sin(angle) * perpVec
+                );
+                
+                vertices->push_back(osg::Vec3(circlePoint.x, circlePoint.y, circlePoint.z));
             }
             
-            // 连接经线
-            for (int seg = 0; seg <= sphereSegments; seg += 2) { // 只绘制一半经线，避免太密
-                for (int ring = 0; ring < rings; ring++) {
-                    int curr = ring * (sphereSegments + 1) + seg;
-                    int next = (ring + 1) * (sphereSegments + 1) + seg;
-                    
-                    indices->push_back(curr);
-                    indices->push_back(next);
-                }
-            }
-        }
-        else
-        {
-            // 四点共面或无法确定球体，降级为绘制前三点确定的截面圆
-            glm::dvec3 circleCenter;
-            double circleRadius;
-            
-            if (MathUtils::calculateCircleCenterAndRadius(p1, p2, p3, circleCenter, circleRadius)) 
+            // 圆周连线
+            for (int i = 0; i < sphereSegments; i++) 
             {
-                // 重新构建顶点数组（只包含圆周点）
-                vertices->clear();
-                indices->clear();
-                
-                // 计算圆的法向量
-                glm::dvec3 v1 = glm::normalize(p1 - circleCenter);
-                glm::dvec3 v2 = glm::normalize(p2 - circleCenter);
-                glm::dvec3 normal = glm::normalize(glm::cross(v1, v2));
-                
-                // 计算圆平面上的两个正交向量
-                glm::dvec3 radiusVec = v1;
-                glm::dvec3 perpVec = glm::normalize(glm::cross(normal, radiusVec));
-                
-                // 生成圆周上的点
-                for (int i = 0; i < sphereSegments; i++) {
-                    double angle = 2.0 * M_PI * i / sphereSegments;
-                    
-                    glm::dvec3 circlePoint = circleCenter + circleRadius * (
-                        cos(angle) * radiusVec + sin(angle) * perpVec
-                    );
-                    
-                    vertices->push_back(osg::Vec3(circlePoint.x, circlePoint.y, circlePoint.z));
-                }
-                
-                // 圆周连线
-                for (int i = 0; i < sphereSegments; i++) 
-                {
-                    int next = (i + 1) % sphereSegments;
-                    indices->push_back(i);
-                    indices->push_back(next);
-                }
+                int next = (i + 1) % sphereSegments;
+                indices->push_back(i);
+                indices->push_back(next);
             }
         }
     }
-    
-    // 设置顶点数组和索引
-    geometry->setVertexArray(vertices);
-    if (indices->size() > 0) {
-        geometry->addPrimitiveSet(indices);
-    }
 }
 
 void Sphere3D_Geo::buildFaceGeometries()
@@ -400,7 +393,15 @@ void Sphere3D_Geo::buildFaceGeometries()
     const auto& allStagePoints = mm_controlPoint()->getAllStageControlPoints();
     
     // 从参数获取球面细分数量
-    int sphereSegments = static_cast<int>(m_parameters.subdivisionLevel);
+    int sphereSegments = static_cast<int>(getParameters().subdivisionLevel);
+    
+    // 确定了球体时引用同细分级别共享的单位球，对象只保留缩放+平移矩阵
+    osg::Matrixd unitMatrix;
+    if (computeUnitMeshMatrix(unitMatrix))
+    {
+        mm_node()->setFaceUnitMesh(UnitMeshCache::getInstance()->getSphere(sphereSegments).get(), unitMatrix);
+        return;
+    }
     
     if (allStagePoints.size() == 1) 
     {
@@ -423,7 +424,7 @@ void Sphere3D_Geo::buildFaceGeometries()
             if (MathUtils::calculateCircleCenterAndRadius(p1, p2, p3, center, radius)) 
             {
                 // 创建顶点数组
-                osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+                osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
                 
                 // 添加圆心
                 vertices->push_back(osg::Vec3(center.x, center.y, center.z));
@@ -452,96 +453,64 @@ void Sphere3D_Geo::buildFaceGeometries()
                 glm::dvec3 firstCirclePoint = center + radius * radiusVec;
                 vertices->push_back(osg::Vec3(firstCirclePoint.x, firstCirclePoint.y, firstCirclePoint.z));
                 
-                geometry->setVertexArray(vertices);
-                
                 // 添加截面圆形（三角形扇形）
-                geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, 0, sphereSegments + 2));
+                mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::TRIANGLE_FAN, 0, sphereSegments + 2);
             }
         }
     }
     else if (allStagePoints.size() == 2)
     {
-        // 第二阶段：显示完整球体
+        // 第二阶段：确定了球体时已引用单位球，
+        // 到这里说明四点共面或无法确定球体，降级为绘制前三点确定的截面圆
         const auto& stage1 = allStagePoints[0];
-        const auto& stage2 = allStagePoints[1];
         
-        assert(stage1.size() >= 3 && stage2.size() >= 1);
+        assert(stage1.size() >= 3);
         
         Point3D point1 = stage1[0];
         Point3D point2 = stage1[1];
         Point3D point3 = stage1[2];
-        Point3D point4 = stage2[0];
         
         glm::dvec3 p1 = glm::dvec3(point1.x(), point1.y(), point1.z());
         glm::dvec3 p2 = glm::dvec3(point2.x(), point2.y(), point2.z());
         glm::dvec3 p3 = glm::dvec3(point3.x(), point3.y(), point3.z());
-        glm::dvec3 p4 = glm::dvec3(point4.x(), point4.y(), point4.z());
         
-        glm::dvec3 center;
-        double radius;
+        glm::dvec3 circleCenter;
+        double circleRadius;
         
-        if (calculateSphereCenterAndRadius(p1, p2, p3, p4, center, radius)) 
+        if (MathUtils::calculateCircleCenterAndRadius(p1, p2, p3, circleCenter, circleRadius)) 
         {
-            // 成功计算出球心，绘制完整球体
-            osg::ref_ptr<osg::Geometry> sphereGeom = OSGUtils::createSphere(center, radius, sphereSegments);
+            // 创建顶点数组
+            osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
             
-            if (sphereGeom.valid()) 
-            {
-                // 复制球体几何到当前几何对象
-                geometry->setVertexArray(sphereGeom->getVertexArray());
-                geometry->setNormalArray(sphereGeom->getNormalArray());
-                geometry->setNormalBinding(sphereGeom->getNormalBinding());
-                
-                // 复制所有primitives
-                for (unsigned int i = 0; i < sphereGeom->getNumPrimitiveSets(); i++) 
-                {
-                    geometry->addPrimitiveSet(sphereGeom->getPrimitiveSet(i));
-                }
-            }
-        }
-        else
-        {
-            // 四点共面或无法确定球体，降级为绘制前三点确定的截面圆
-            glm::dvec3 circleCenter;
-            double circleRadius;
+            // 添加圆心
+            vertices->push_back(osg::Vec3(circleCenter.x, circleCenter.y, circleCenter.z));
             
-            if (MathUtils::calculateCircleCenterAndRadius(p1, p2, p3, circleCenter, circleRadius)) 
-            {
-                // 创建顶点数组
-                osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-                
-                // 添加圆心
-                vertices->push_back(osg::Vec3(circleCenter.x, circleCenter.y, circleCenter.z));
-                
-                // 计算圆的法向量
-                glm::dvec3 v1 = glm::normalize(p1 - circleCenter);
-                glm::dvec3 v2 = glm::normalize(p2 - circleCenter);
-                glm::dvec3 normal = glm::normalize(glm::cross(v1, v2));
-                
-                // 计算圆平面上的两个正交向量
-                glm::dvec3 radiusVec = v1;
-                glm::dvec3 perpVec = glm::normalize(glm::cross(normal, radiusVec));
-                
-                // 生成圆周上的点
-                for (int i = 0; i < sphereSegments; i++) {
-                    double angle = 2.0 * M_PI * i / sphereSegments;
-                    
-                    glm::dvec3 circlePoint = circleCenter + circleRadius * (
-                        cos(angle) * radiusVec + sin(angle) * perpVec
-                    );
-                    
-                    vertices->push_back(osg::Vec3(circlePoint.x, circlePoint.y, circlePoint.z));
-                }
-                
-                // 为了确保TRIANGLE_FAN正确封闭，添加第一个圆周点
-                glm::dvec3 firstCirclePoint = circleCenter + circleRadius * radiusVec;
-                vertices->push_back(osg::Vec3(firstCirclePoint.x, firstCirclePoint.y, firstCirclePoint.z));
+            // 计算圆的法向量
+            glm::dvec3 v1 = glm::normalize(p1 - circleCenter);
+            glm::dvec3 v2 = glm::normalize(p2 - circleCenter);
+            glm::dvec3 normal = glm::normalize(glm::cross(v1, v2));
+            
+            // 计算圆平面上的两个正交向量
+            glm::dvec3 radiusVec = v1;
+            glm::dvec3 perpVec = glm::normalize(glm::cross(normal, radiusVec));
+            
+            // 生成圆周上的点
+            for (int i = 0; i < sphereSegments; i++) {
+                double angle = 2.0 * M_PI * i / sphereSegments;
                 
-                geometry->setVertexArray(vertices);
+                glm::dvec3 circlePoint = circleCenter + circleRadius * (
+                    cos(angle) * radiusVec + sin(angle) * perpVec
+                );
                 
-                // 添加截面圆形（三角形扇形）
-                geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, 0, sphereSegments + 2));
+                vertices->push_back(osg::Vec3(circlePoint.x, circlePoint.y, circlePoint.z));
             }
+            
+            // 为了确保TRIANGLE_FAN正确封闭，添加第一个圆周点
+            glm::dvec3 firstCirclePoint = circleCenter + circleRadius * radiusVec;
+            vertices->push_back(osg::Vec3(firstCirclePoint.x, firstCirclePoint.y, firstCirclePoint.z));
+            
+            // 添加截面圆形（三角形扇形）
+            mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::TRIANGLE_FAN, 0, sphereSegments + 2);
         }
     }
 }
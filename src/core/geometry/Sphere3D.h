@@ -29,12 +29,17 @@ public:
         return stageDescriptors;
     }
 
+    // 捕捉：球心（确定球之前为截面圆心）
+    virtual void getSnapCenters(std::vector<glm::dvec3>& centers) const override;
+
 protected:
     virtual void buildVertexGeometries() override;
     virtual void buildEdgeGeometries() override;
     virtual void buildFaceGeometries() override;
 
 private:
+    // 确定了球体时给出单位球 -> 对象坐标的矩阵（面和线框共用），否则返回false
+    bool computeUnitMeshMatrix(osg::Matrixd& matrix) const;
     
 private:
 };
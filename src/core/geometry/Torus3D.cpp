@@ -1,5 +1,7 @@
 ﻿#include "Torus3D.h"
 #include "../managers/GeoControlPointManager.h"
+#include "../managers/GeoStateManager.h"
+#include "UnitMeshCache.h"
 #include <osg/Geometry>
 #include <osg/Array>
 #include <osg/PrimitiveSet>
@@ -16,6 +18,56 @@ Torus3D_Geo::Torus3D_Geo()
     m_geoType = Geo_Torus3D;
     // 确保基类正确初始化
     initialize();
+    
+    // 绘制完成时改为引用共享的单位圆环
+    connect(mm_state(), &GeoStateManager::stateCompleted, this, [this]() {
+        mm_node()->updateGeometries(GeoComponent_Edge3D | GeoComponent_Face3D);
+    });
+}
+
+bool Torus3D_Geo::computeUnitMeshMatrix(osg::Matrixd& matrix, double& minorRatio) const
+{
+    if (!mm_state()->isStateComplete()) return false;
+    
+    const auto& allStagePoints = mm_controlPoint()->getAllStageControlPoints();
+    if (allStagePoints.size() != 3 || allStagePoints[0].size() < 2 || allStagePoints[1].empty() || allStagePoints[2].empty()) return false;
+    
+    const Point3D& point1 = allStagePoints[0][0];
+    const Point3D& point2 = allStagePoints[0][1];
+    const Point3D& point3 = allStagePoints[1][0];
+    const Point3D& point4 = allStagePoints[2][0];
+    
+    glm::dvec3 p1 = glm::dvec3(point1.x(), point1.y(), point1.z());
+    glm::dvec3 p2 = glm::dvec3(point2.x(), point2.y(), point2.z());
+    glm::dvec3 p3 = glm::dvec3(point3.x(), point3.y(), point3.z());
+    glm::dvec3 p4 = glm::dvec3(point4.x(), point4.y(), point4.z());
+    
+    // 计算圆环参数
+    glm::dvec3 torusCenter = (p1 + p2) * 0.5;
+    double majorRadius = glm::length(p2 - p1) * 0.5;
+    
+    // 主半径退化时无法归一化到单位圆环
+    if (majorRadius < 1e-9) return false;
+    glm::dvec3 axisDir = glm::normalize(p2 - p1);
+    
+    // 确定圆环平面
+    glm::dvec3 toP3 = p3 - torusCenter;
+    glm::dvec3 radialDir = glm::normalize(toP3 - glm::dot(toP3, axisDir) * axisDir);
+    glm::dvec3 tangentDir = glm::normalize(glm::cross(axisDir, radialDir));
+    
+    // 计算次半径（内环半径）
+    glm::dvec3 toP4 = p4 - torusCenter;
+    glm::dvec3 p4InPlane = toP4 - glm::dot(toP4, axisDir) * axisDir;
+    double minorRadius = std::abs(glm::length(p4InPlane) - majorRadius);
+    
+    // 局部X为径向、Y为切向、Z为轴线，整体按主半径缩放
+    minorRatio = UnitMeshCache::quantizeRatio(minorRadius / majorRadius);
+    matrix = UnitMeshCache::makeFrameMatrix(
+        osg::Vec3d(radialDir.x, radialDir.y, radialDir.z) * majorRadius,
+        osg::Vec3d(tangentDir.x, tangentDir.y, tangentDir.z) * majorRadius,
+        osg::Vec3d(axisDir.x, axisDir.y, axisDir.z) * majorRadius,
+        osg::Vec3d(torusCenter.x, torusCenter.y, torusCenter.z));
+    return true;
 }
 
 void Torus3D_Geo::buildVertexGeometries()
@@ -35,7 +87,7 @@ void Torus3D_Geo::buildVertexGeometries()
     if (allStagePoints.empty()) return;
     
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     if (allStagePoints.size() == 1) 
     {
@@ -89,13 +141,10 @@ void Torus3D_Geo::buildVertexGeometries()
         vertices->push_back(osg::Vec3(torusCenter.x, torusCenter.y, torusCenter.z));
     }
     
-    // 设置顶点数组
-    geometry->setVertexArray(vertices);
-    
     // 添加点绘制原语
     if (vertices->size() > 0) 
     {
-        geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, vertices->size()));
+        mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::POINTS, 0, vertices->size());
     }
 }
 
@@ -114,12 +163,21 @@ void Torus3D_Geo::buildEdgeGeometries()
     
     if (allStagePoints.empty()) return;
     
-    // 创建顶点数组和索引数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(osg::PrimitiveSet::LINES);
-    
     // 从参数获取细分数量
-    int segments = static_cast<int>(m_parameters.subdivisionLevel);
+    int segments = static_cast<int>(getParameters().subdivisionLevel);
+    
+    // 绘制完成后线框引用共享的单位圆环，与面共用顶点
+    osg::Matrixd unitMatrix;
+    double minorRatio = 0.0;
+    if (computeUnitMeshMatrix(unitMatrix, minorRatio))
+    {
+        mm_node()->setEdgeUnitMesh(UnitMeshCache::getInstance()->getTorus(segments, minorRatio).get(), unitMatrix);
+        return;
+    }
+    
+    // 创建顶点数组和索引数组
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+    osg::ref_ptr<osg::DrawElementsUInt> indices = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::LINES);
     
     if (allStagePoints.size() == 1) 
     {
@@ -186,7 +244,7 @@ void Torus3D_Geo::buildEdgeGeometries()
     }
     else if (allStagePoints.size() == 3)
     {
-        // 第三阶段：绘制圆环的边线（不绘制面）
+        // 第三阶段：绘制过程中按对象生成圆环的边线
         const auto& stage1 = allStagePoints[0];
         const auto& stage2 = allStagePoints[1];
         const auto& stage3 = allStagePoints[2];
@@ -265,12 +323,6 @@ void Torus3D_Geo::buildEdgeGeometries()
             }
         }
     }
-    
-    // 设置顶点数组和索引
-    geometry->setVertexArray(vertices);
-    if (indices->size() > 0) {
-        geometry->addPrimitiveSet(indices);
-    }
 }
 
 void Torus3D_Geo::buildFaceGeometries()
@@ -289,6 +341,18 @@ void Torus3D_Geo::buildFaceGeometries()
     // 只在第三阶段绘制面
     if (allStagePoints.size() != 3) return;
     
+    // 从参数获取细分数量
+    int majorSegs = static_cast<int>(getParameters().subdivisionLevel);
+    
+    // 绘制完成后引用共享的单位圆环（按次/主半径比例量化缓存）
+    osg::Matrixd unitMatrix;
+    double minorRatio = 0.0;
+    if (computeUnitMeshMatrix(unitMatrix, minorRatio))
+    {
+        mm_node()->setFaceUnitMesh(UnitMeshCache::getInstance()->getTorus(majorSegs, minorRatio).get(), unitMatrix);
+        return;
+    }
+    
     const auto& stage1 = allStagePoints[0];
     const auto& stage2 = allStagePoints[1];
     const auto& stage3 = allStagePoints[2];
@@ -321,13 +385,13 @@ void Torus3D_Geo::buildFaceGeometries()
     double distanceToAxis = glm::length(p4InPlane);
     double minorRadius = std::abs(distanceToAxis - majorRadius);
     
-    // 从参数获取细分数量
-    int majorSegs = static_cast<int>(m_parameters.subdivisionLevel);
+    // 绘制过程中次半径逐帧变化，按对象生成网格
     int minorSegs = majorSegs / 2;
     
     // 创建顶点数组和法向量数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+    osg::ref_ptr<osg::Vec3Array> normals = mm_node()->reuseNormalArray(geometry.get());
+    osg::ref_ptr<osg::DrawElementsUInt> quadIndices = mm_node()->reuseDrawElements(geometry.get(), osg::PrimitiveSet::QUADS);
     
     // 生成圆环表面顶点和法向量
     for (int i = 0; i < majorSegs; i++) {
@@ -353,10 +417,6 @@ void Torus3D_Geo::buildFaceGeometries()
         }
     }
     
-    geometry->setVertexArray(vertices);
-    geometry->setNormalArray(normals);
-    geometry->setNormalBinding(osg::Geometry::BIND_PER_VERTEX);
-    
     // 生成四边形面片
     for (int i = 0; i < majorSegs; i++) {
         for (int j = 0; j < minorSegs; j++) {
@@ -365,16 +425,10 @@ void Torus3D_Geo::buildFaceGeometries()
             int nextI = ((i + 1) % majorSegs) * minorSegs + j;
             int nextBoth = ((i + 1) % majorSegs) * minorSegs + (j + 1) % minorSegs;
             
-            // 创建四边形面片
-            osg::ref_ptr<osg::DrawElementsUInt> quadIndices = 
-                new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
-            
             quadIndices->push_back(curr);
             quadIndices->push_back(nextJ);
             quadIndices->push_back(nextBoth);
             quadIndices->push_back(nextI);
-            
-            geometry->addPrimitiveSet(quadIndices);
         }
     }
 }
@@ -32,12 +32,21 @@ public:
         return stageDescriptors;
     }
 
+    // 完成后的顶点只有由轴线算出的圆环中心，主圆和内圆半径只影响边和面
+    virtual unsigned int getStageDependentComponents(int stageIdx) const override
+    {
+        return stageIdx == 0 ? GeoComponent_Geometry3D : (GeoComponent_Edge3D | GeoComponent_Face3D);
+    }
+
 protected:
     virtual void buildVertexGeometries() override;
     virtual void buildEdgeGeometries() override;
     virtual void buildFaceGeometries() override;
 
 private:
+    // 绘制完成后给出单位圆环 -> 对象坐标的矩阵和量化后的次/主半径比例（面和线框共用），否则返回false
+    // 绘制过程中比例逐帧变化，按对象生成网格，避免每帧缓存一个新比例的网格和KdTree
+    bool computeUnitMeshMatrix(osg::Matrixd& matrix, double& minorRatio) const;
     
 private:
 };
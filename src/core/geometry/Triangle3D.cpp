@@ -45,22 +45,20 @@ void Triangle3D_Geo::buildEdgeGeometries()
         // 不足3个点，绘制已有的线段
         if (allPoints.size() == 2)
         {
-            osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+            osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
             auto lineVertices = MathUtils::generateLineVertices(allPoints[0], allPoints[1]);
             for (const auto& vertex : lineVertices)
             {
                 vertices->push_back(MathUtils::glmToOsg(vertex));
             }
             
-            geometry->setVertexArray(vertices);
-            osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, vertices->size());
-            geometry->addPrimitiveSet(drawArrays);
+            mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::LINES, 0, vertices->size());
         }
         return;
     }
 
     // 创建顶点数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
     
     // 绘制三角形的三条边
     vertices->push_back(MathUtils::glmToOsg(allPoints[0]));
@@ -70,9 +68,7 @@ void Triangle3D_Geo::buildEdgeGeometries()
     vertices->push_back(MathUtils::glmToOsg(allPoints[2]));
     vertices->push_back(MathUtils::glmToOsg(allPoints[0]));
     
-    geometry->setVertexArray(vertices);
-    osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, vertices->size());
-    geometry->addPrimitiveSet(drawArrays);
+    mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::LINES, 0, vertices->size());
 }
 
 void Triangle3D_Geo::buildFaceGeometries()
@@ -104,8 +100,8 @@ void Triangle3D_Geo::buildFaceGeometries()
     }
 
     // 创建顶点数组和法向量数组
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> vertices = mm_node()->reuseVertexArray(geometry.get());
+    osg::ref_ptr<osg::Vec3Array> normals = mm_node()->reuseNormalArray(geometry.get());
     
     // 生成三角形顶点和法向量
     glm::dvec3 normal;
@@ -117,12 +113,7 @@ void Triangle3D_Geo::buildFaceGeometries()
         normals->push_back(MathUtils::glmToOsg(normal));
     }
     
-    geometry->setVertexArray(vertices);
-    geometry->setNormalArray(normals);
-    geometry->setNormalBinding(osg::Geometry::BIND_PER_VERTEX);
-    
-    osg::ref_ptr<osg::DrawArrays> drawArrays = new osg::DrawArrays(osg::PrimitiveSet::TRIANGLES, 0, vertices->size());
-    geometry->addPrimitiveSet(drawArrays);
+    mm_node()->reuseDrawArrays(geometry.get(), osg::PrimitiveSet::TRIANGLES, 0, vertices->size());
 }
 
 
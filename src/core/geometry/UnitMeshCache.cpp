@@ -0,0 +1,438 @@
+﻿#include "UnitMeshCache.h"
+#include "../../util/LogManager.h"
+#include "../../util/Tracer.h"
+#include <osg/KdTree>
+#include <osg/Array>
+#include <osg/PrimitiveSet>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+    // 缓存中允许保留的未被引用网格数量，超过后淘汰最久未用的
+    const int MAX_UNUSED_MESHES = 16;
+
+    // 圆环比例的对数量化：相邻两档相差1%，次半径误差不超过0.5%；
+    // 比例小于下限的圆环按下限处理（管径已远小于一个细分段）
+    const double RATIO_LOG_STEP = std::log1p(0.01);
+    const double MIN_RATIO = 1e-3;
+}
+
+UnitMeshCache* UnitMeshCache::s_instance = nullptr;
+
+UnitMeshCache* UnitMeshCache::getInstance()
+{
+    if (!s_instance)
+    {
+        s_instance = new UnitMeshCache();
+    }
+    return s_instance;
+}
+
+osg::ref_ptr<UnitMesh> UnitMeshCache::getSphere(int segments)
+{
+    return getOrCreate(UnitMeshKind::Sphere, segments, 0.0);
+}
+
+osg::ref_ptr<UnitMesh> UnitMeshCache::getCylinder(int segments)
+{
+    return getOrCreate(UnitMeshKind::Cylinder, segments, 0.0);
+}
+
+osg::ref_ptr<UnitMesh> UnitMeshCache::getCone(int segments)
+{
+    return getOrCreate(UnitMeshKind::Cone, segments, 0.0);
+}
+
+osg::ref_ptr<UnitMesh> UnitMeshCache::getTorus(int majorSegments, double minorRatio)
+{
+    return getOrCreate(UnitMeshKind::Torus, majorSegments, quantizeRatio(minorRatio));
+}
+
+double UnitMeshCache::quantizeRatio(double ratio)
+{
+    return std::exp(ratioLevel(ratio) * RATIO_LOG_STEP);
+}
+
+long long UnitMeshCache::ratioLevel(double ratio)
+{
+    return std::llround(std::log(std::max(ratio, MIN_RATIO)) / RATIO_LOG_STEP);
+}
+
+int UnitMeshCache::getMeshCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_meshes.size());
+}
+
+void UnitMeshCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_meshes.clear();
+}
+
+osg::Matrixd UnitMeshCache::makeFrameMatrix(const osg::Vec3d& xAxis, const osg::Vec3d& yAxis,
+                                            const osg::Vec3d& zAxis, const osg::Vec3d& origin)
+{
+    // OSG按行向量右乘矩阵，前三行是基向量的像，第四行是平移
+    return osg::Matrixd(xAxis.x(),  xAxis.y(),  xAxis.z(),  0.0,
+                        yAxis.x(),  yAxis.y(),  yAxis.z(),  0.0,
+                        zAxis.x(),  zAxis.y(),  zAxis.z(),  0.0,
+                        origin.x(), origin.y(), origin.z(), 1.0);
+}
+
+osg::StateSet* UnitMeshCache::getFaceTransformStateSet()
+{
+    // 所有对象共用一个，不为每个变换节点各建一个状态集
+    static osg::ref_ptr<osg::StateSet> stateSet = []() {
+        osg::ref_ptr<osg::StateSet> normalize = new osg::StateSet();
+        normalize->setMode(GL_NORMALIZE, osg::StateAttribute::ON);
+        normalize->setDataVariance(osg::Object::STATIC);
+        return normalize;
+    }();
+    return stateSet.get();
+}
+
+// ============= 私有函数 =============
+
+osg::ref_ptr<UnitMesh> UnitMeshCache::getOrCreate(UnitMeshKind kind, int segments, double ratio)
+{
+    if (segments < 3) return nullptr;
+
+    MeshKey key(static_cast<int>(kind), segments, kind == UnitMeshKind::Torus ? ratioLevel(ratio) : 0);
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_meshes.find(key);
+    if (it != m_meshes.end())
+    {
+        it->second.lastUsed = ++m_useCounter;
+        return it->second.mesh;
+    }
+
+    osg::ref_ptr<UnitMesh> mesh = createMesh(kind, segments, ratio);
+    if (!mesh.valid()) return nullptr;
+
+    CacheEntry& entry = m_meshes[key];
+    entry.mesh = mesh;
+    entry.lastUsed = ++m_useCounter;
+    evictUnused();
+    return mesh;
+}
+
+osg::ref_ptr<UnitMesh> UnitMeshCache::createMesh(UnitMeshKind kind, int segments, double ratio) const
+{
+    osg::ref_ptr<osg::Geometry> prototype;
+    switch (kind)
+    {
+    case UnitMeshKind::Sphere:   prototype = buildSphere(segments); break;
+    case UnitMeshKind::Cylinder: prototype = buildCylinder(segments); break;
+    case UnitMeshKind::Cone:     prototype = buildCone(segments); break;
+    case UnitMeshKind::Torus:    prototype = buildTorus(segments, ratio); break;
+    }
+    if (!prototype.valid()) return nullptr;
+
+    // 数组被所有对象共享，只在生成时写入一次
+    prototype->getVertexArray()->setDataVariance(osg::Object::STATIC);
+    if (prototype->getNormalArray())
+    {
+        prototype->getNormalArray()->setDataVariance(osg::Object::STATIC);
+    }
+
+    // KdTree同样只建一次，各对象的面几何体共享
+    {
+        TRACE_ZONE("KdTree::build", "空间索引");
+        osg::ref_ptr<osg::KdTree> kdTree = new osg::KdTree;
+        osg::KdTree::BuildOptions buildOptions;
+        if (kdTree->build(buildOptions, prototype.get()))
+        {
+            prototype->setShape(kdTree.get());
+        }
+    }
+
+    // 线框与面共用顶点数组，线段BVH同样只建一次
+    osg::ref_ptr<osg::Geometry> edgePrototype = buildEdges(kind, segments, prototype->getVertexArray());
+    osg::ref_ptr<EdgeSegmentBVH> edgeBVH = edgePrototype.valid() ? EdgeSegmentBVH::build(edgePrototype.get()) : nullptr;
+
+    osg::ref_ptr<UnitMesh> mesh = new UnitMesh;
+    mesh->kind = kind;
+    mesh->segments = segments;
+    mesh->ratio = ratio;
+    mesh->prototype = prototype;
+    mesh->edgePrototype = edgePrototype;
+    mesh->edgeBVH = edgeBVH;
+
+    LOG_DEBUG(QString("生成单位网格: 类型%1 细分%2 比例%3 顶点%4")
+        .arg(static_cast<int>(kind)).arg(segments).arg(ratio)
+        .arg(prototype->getVertexArray()->getNumElements()), "单位网格缓存");
+    return mesh;
+}
+
+void UnitMeshCache::evictUnused()
+{
+    // 引用计数为1表示只有缓存自身持有；刚取出的网格已被调用方的ref_ptr持有，不会被淘汰
+    std::vector<std::pair<uint64_t, MeshKey>> unused;
+    for (const auto& entry : m_meshes)
+    {
+        if (entry.second.mesh->referenceCount() == 1)
+        {
+            unused.emplace_back(entry.second.lastUsed, entry.first);
+        }
+    }
+    if (unused.size() <= static_cast<size_t>(MAX_UNUSED_MESHES)) return;
+
+    std::sort(unused.begin(), unused.end());
+    const size_t evictCount = unused.size() - MAX_UNUSED_MESHES;
+    for (size_t i = 0; i < evictCount; ++i)
+    {
+        m_meshes.erase(unused[i].second);
+    }
+    LOG_DEBUG(QString("淘汰%1个未使用的单位网格").arg(evictCount), "单位网格缓存");
+}
+
+osg::Geometry* UnitMeshCache::buildSphere(int segments)
+{
+    // 与OSGUtils::createSphere相同的经纬划分
+    osg::Geometry* geometry = new osg::Geometry;
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+
+    int rings = segments / 2;
+    vertices->reserve((rings + 1) * (segments + 1));
+    normals->reserve((rings + 1) * (segments + 1));
+
+    for (int ring = 0; ring <= rings; ring++)
+    {
+        double phi = M_PI * ring / rings;
+        for (int seg = 0; seg <= segments; seg++)
+        {
+            double theta = 2.0 * M_PI * seg / segments;
+            osg::Vec3 normal(sin(phi) * cos(theta), sin(phi) * sin(theta), cos(phi));
+            vertices->push_back(normal);
+            normals->push_back(normal);
+        }
+    }
+
+    geometry->setVertexArray(vertices);
+    geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+
+    for (int ring = 0; ring < rings; ring++)
+    {
+        osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(osg::PrimitiveSet::TRIANGLE_STRIP);
+        indices->reserve(2 * (segments + 1));
+        for (int seg = 0; seg <= segments; seg++)
+        {
+            indices->push_back(ring * (segments + 1) + seg);
+            indices->push_back((ring + 1) * (segments + 1) + seg);
+        }
+        geometry->addPrimitiveSet(indices);
+    }
+    return geometry;
+}
+
+osg::Geometry* UnitMeshCache::buildCylinder(int segments)
+{
+    // 顶点顺序与Cylinder3D_Geo逐对象构建时一致：
+    // 底面圆心、底面圆周、底面闭合点、顶面圆心、顶面圆周、顶面闭合点
+    osg::Geometry* geometry = new osg::Geometry;
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    vertices->reserve(2 * segments + 4);
+
+    for (int cap = 0; cap < 2; cap++)
+    {
+        float z = static_cast<float>(cap);
+        vertices->push_back(osg::Vec3(0.0f, 0.0f, z));
+        for (int i = 0; i < segments; i++)
+        {
+            double angle = 2.0 * M_PI * i / segments;
+            vertices->push_back(osg::Vec3(cos(angle), sin(angle), z));
+        }
+        vertices->push_back(osg::Vec3(1.0f, 0.0f, z));
+    }
+    geometry->setVertexArray(vertices);
+
+    // 底面、顶面三角形扇形
+    geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, 0, segments + 2));
+    geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, segments + 2, segments + 2));
+
+    // 侧面四边形合并为一个图元集
+    osg::ref_ptr<osg::DrawElementsUInt> quadIndices = new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
+    quadIndices->reserve(4 * segments);
+    for (int i = 0; i < segments; i++)
+    {
+        int next = (i + 1) % segments;
+        quadIndices->push_back(1 + i);
+        quadIndices->push_back(1 + next);
+        quadIndices->push_back(segments + 3 + next);
+        quadIndices->push_back(segments + 3 + i);
+    }
+    geometry->addPrimitiveSet(quadIndices);
+    return geometry;
+}
+
+osg::Geometry* UnitMeshCache::buildCone(int segments)
+{
+    // 顶点顺序与Cone3D_Geo一致：底面圆心、底面圆周、闭合点、锥顶
+    osg::Geometry* geometry = new osg::Geometry;
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    vertices->reserve(segments + 3);
+
+    vertices->push_back(osg::Vec3(0.0f, 0.0f, 0.0f));
+    for (int i = 0; i < segments; i++)
+    {
+        double angle = 2.0 * M_PI * i / segments;
+        vertices->push_back(osg::Vec3(cos(angle), sin(angle), 0.0f));
+    }
+    vertices->push_back(osg::Vec3(1.0f, 0.0f, 0.0f));
+    vertices->push_back(osg::Vec3(0.0f, 0.0f, 1.0f));
+    geometry->setVertexArray(vertices);
+
+    geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_FAN, 0, segments + 2));
+
+    osg::ref_ptr<osg::DrawElementsUInt> triangleIndices = new osg::DrawElementsUInt(osg::PrimitiveSet::TRIANGLES);
+    triangleIndices->reserve(3 * segments);
+    for (int i = 0; i < segments; i++)
+    {
+        int next = (i + 1) % segments;
+        triangleIndices->push_back(segments + 2);
+        triangleIndices->push_back(1 + i);
+        triangleIndices->push_back(1 + next);
+    }
+    geometry->addPrimitiveSet(triangleIndices);
+    return geometry;
+}
+
+osg::Geometry* UnitMeshCache::buildTorus(int majorSegments, double minorRatio)
+{
+    // 与Torus3D_Geo相同的参数化，局部系：X为径向，Y为切向，Z为轴线
+    int minorSegments = majorSegments / 2;
+    if (minorSegments < 1) return nullptr;
+
+    osg::Geometry* geometry = new osg::Geometry;
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+    vertices->reserve(majorSegments * minorSegments);
+    normals->reserve(majorSegments * minorSegments);
+
+    const osg::Vec3d axis(0.0, 0.0, 1.0);
+    for (int i = 0; i < majorSegments; i++)
+    {
+        double majorAngle = 2.0 * M_PI * i / majorSegments;
+        osg::Vec3d tubeRadial(cos(majorAngle), sin(majorAngle), 0.0);
+        osg::Vec3d tubeTangent = axis ^ tubeRadial;
+        tubeTangent.normalize();
+
+        for (int j = 0; j < minorSegments; j++)
+        {
+            double minorAngle = 2.0 * M_PI * j / minorSegments;
+            osg::Vec3d localNormal = tubeTangent * cos(minorAngle) + axis * sin(minorAngle);
+            vertices->push_back(tubeRadial + localNormal * minorRatio);
+            normals->push_back(localNormal);
+        }
+    }
+
+    geometry->setVertexArray(vertices);
+    geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+
+    osg::ref_ptr<osg::DrawElementsUInt> quadIndices = new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
+    quadIndices->reserve(4 * majorSegments * minorSegments);
+    for (int i = 0; i < majorSegments; i++)
+    {
+        for (int j = 0; j < minorSegments; j++)
+        {
+            quadIndices->push_back(i * minorSegments + j);
+            quadIndices->push_back(i * minorSegments + (j + 1) % minorSegments);
+            quadIndices->push_back(((i + 1) % majorSegments) * minorSegments + (j + 1) % minorSegments);
+            quadIndices->push_back(((i + 1) % majorSegments) * minorSegments + j);
+        }
+    }
+    geometry->addPrimitiveSet(quadIndices);
+    return geometry;
+}
+
+osg::Geometry* UnitMeshCache::buildEdges(UnitMeshKind kind, int segments, osg::Array* vertices)
+{
+    // 下标与对应的面原型一致，线框疏密与各对象逐对象构建时相同
+    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(osg::PrimitiveSet::LINES);
+    switch (kind)
+    {
+    case UnitMeshKind::Sphere:
+    {
+        // 纬线全部绘制，经线只绘制一半，避免太密
+        int rings = segments / 2;
+        for (int ring = 0; ring <= rings; ring++)
+        {
+            for (int seg = 0; seg < segments; seg++)
+            {
+                indices->push_back(ring * (segments + 1) + seg);
+                indices->push_back(ring * (segments + 1) + seg + 1);
+            }
+        }
+        for (int seg = 0; seg <= segments; seg += 2)
+        {
+            for (int ring = 0; ring < rings; ring++)
+            {
+                indices->push_back(ring * (segments + 1) + seg);
+                indices->push_back((ring + 1) * (segments + 1) + seg);
+            }
+        }
+        break;
+    }
+    case UnitMeshKind::Cylinder:
+        // 底面、顶面圆周
+        for (int i = 0; i < segments; i++)
+        {
+            int next = (i + 1) % segments;
+            indices->push_back(1 + i);
+            indices->push_back(1 + next);
+            indices->push_back(segments + 3 + i);
+            indices->push_back(segments + 3 + next);
+        }
+        break;
+    case UnitMeshKind::Cone:
+        // 底面圆周，母线只绘制一半
+        for (int i = 0; i < segments; i++)
+        {
+            int next = (i + 1) % segments;
+            indices->push_back(1 + i);
+            indices->push_back(1 + next);
+        }
+        for (int i = 0; i < segments; i += 2)
+        {
+            indices->push_back(segments + 2);
+            indices->push_back(1 + i);
+        }
+        break;
+    case UnitMeshKind::Torus:
+    {
+        // 次方向全部绘制，主方向只绘制一半
+        int minorSegments = segments / 2;
+        for (int i = 0; i < segments; i++)
+        {
+            for (int j = 0; j < minorSegments; j++)
+            {
+                int curr = i * minorSegments + j;
+                indices->push_back(curr);
+                indices->push_back(i * minorSegments + (j + 1) % minorSegments);
+                if (j % 2 == 0)
+                {
+                    indices->push_back(curr);
+                    indices->push_back(((i + 1) % segments) * minorSegments + j);
+                }
+            }
+        }
+        break;
+    }
+    }
+    if (indices->empty()) return nullptr;
+
+    osg::Geometry* geometry = new osg::Geometry;
+    geometry->setVertexArray(vertices);
+    geometry->addPrimitiveSet(indices.get());
+    return geometry;
+}
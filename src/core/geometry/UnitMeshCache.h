@@ -0,0 +1,93 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <osg/Geometry>
+#include <osg/Matrixd>
+#include <osg/StateSet>
+#include "../picking/EdgeSegmentBVH.h"
+#include <QMutex>
+#include <cstdint>
+#include <map>
+#include <tuple>
+
+// 单位网格类型
+enum class UnitMeshKind
+{
+    Sphere,     // 单位球：球心原点，半径1
+    Cylinder,   // 单位圆柱：底面圆心原点，半径1，高度沿+Z为1
+    Cone,       // 单位圆锥：底面圆心原点，半径1，锥顶(0,0,1)
+    Torus       // 单位圆环：主半径1，次半径为比例参数，轴线沿Z
+};
+
+// 共享的单位网格
+// prototype持有顶点/法线/图元和KdTree，edgePrototype与之共用顶点数组、只含线框的LINES图元并带线段BVH，
+// 都不挂在场景中；各对象的面/边几何体直接引用这些数组，只读共享
+struct UnitMesh : public osg::Referenced
+{
+    UnitMeshKind kind;
+    int segments;
+    double ratio;
+    osg::ref_ptr<osg::Geometry> prototype;
+    osg::ref_ptr<osg::Geometry> edgePrototype;
+    osg::ref_ptr<EdgeSegmentBVH> edgeBVH;
+};
+
+// 进程级单位网格缓存
+// 按（类型, 细分级别, 圆环比例）缓存，同一细分级别的所有球/圆柱/圆锥/圆环
+// 共享一份网格，对象自身只保留一个变换矩阵；没有对象引用的网格按最近使用顺序淘汰
+class UnitMeshCache
+{
+public:
+    static UnitMeshCache* getInstance();
+
+    // 获取（必要时生成）单位网格
+    osg::ref_ptr<UnitMesh> getSphere(int segments);
+    osg::ref_ptr<UnitMesh> getCylinder(int segments);
+    osg::ref_ptr<UnitMesh> getCone(int segments);
+    osg::ref_ptr<UnitMesh> getTorus(int majorSegments, double minorRatio);
+
+    // 圆环比例按对数刻度量化（相邻两档相差1%），拖拽时连续变化的比例落到有限个网格上
+    static double quantizeRatio(double ratio);
+
+    int getMeshCount() const;
+    void clear();
+
+    // ============= 单位网格 -> 对象的变换矩阵 =============
+    // 按列给出局部X/Y/Z轴在场景中的像和原点位置（允许非正交，用于斜圆柱/斜圆锥）
+    static osg::Matrixd makeFrameMatrix(const osg::Vec3d& xAxis, const osg::Vec3d& yAxis,
+                                        const osg::Vec3d& zAxis, const osg::Vec3d& origin);
+
+    // 面单位网格变换节点共用的状态集：法线随缩放矩阵变换，需要重新归一化
+    static osg::StateSet* getFaceTransformStateSet();
+
+private:
+    UnitMeshCache() = default;
+
+    typedef std::tuple<int, int, long long> MeshKey;  // 类型, 细分, 比例档位
+
+    struct CacheEntry
+    {
+        osg::ref_ptr<UnitMesh> mesh;
+        uint64_t lastUsed = 0;  // 最近一次被取用的序号
+    };
+
+    static long long ratioLevel(double ratio);
+
+    osg::ref_ptr<UnitMesh> getOrCreate(UnitMeshKind kind, int segments, double ratio);
+    osg::ref_ptr<UnitMesh> createMesh(UnitMeshKind kind, int segments, double ratio) const;
+    void evictUnused();  // 只被缓存自身引用的网格超过上限时，淘汰最久未用的
+
+    static osg::Geometry* buildSphere(int segments);
+    static osg::Geometry* buildCylinder(int segments);
+    static osg::Geometry* buildCone(int segments);
+    static osg::Geometry* buildTorus(int majorSegments, double minorRatio);
+    static osg::Geometry* buildEdges(UnitMeshKind kind, int segments, osg::Array* vertices);
+
+    static UnitMeshCache* s_instance;
+
+    mutable QMutex m_mutex;
+    std::map<MeshKey, CacheEntry> m_meshes;
+    uint64_t m_useCounter = 0;
+};
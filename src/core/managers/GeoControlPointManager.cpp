@@ -6,6 +6,7 @@
 GeoControlPointManager::GeoControlPointManager(osg::ref_ptr<Geo3D> parent)
     : QObject(parent.get())
     , m_parent(parent)
+    , m_lastChangedStage(-1)
 {
     /**
     * 默认有一个空的阶段
@@ -39,6 +40,7 @@ bool GeoControlPointManager::addControlPoint(const Point3D& point)
     {
         nextStage();
     }
+    m_lastChangedStage = -1;
     emit controlPointChanged();
     return true;
 }
@@ -54,6 +56,7 @@ bool GeoControlPointManager::undoLastControlPoint()
     if (currentStagePointSize())
     {
         currentStage().pop_back();
+        m_lastChangedStage = -1;
         emit controlPointChanged();
     }
     else
@@ -91,6 +94,7 @@ void GeoControlPointManager::setTempPoint(const Point3D& point)
 {
     assert(!getState()->isStateComplete() && "应该在没有绘制完成时调用");
     m_tempPoint = point;
+    m_lastChangedStage = -1;
     emit controlPointChanged();
 }
 
@@ -119,8 +123,14 @@ bool GeoControlPointManager::setControlPoint(int globalIndex, const Point3D& poi
     {
         if (globalIndex < m_stages[stageIdx].size())
         {
+            // 位置没有变化（如拖拽被约束住）时不触发重建
+            if (m_stages[stageIdx][globalIndex].position == point.position)
+                return true;
+
             m_stages[stageIdx][globalIndex] = point;
             // 控制点点更新，按顺序，后续依次用约束更新,为了方便全部更新
+            // 只记录所在阶段，由几何体声明哪些组件依赖该阶段
+            m_lastChangedStage = stageIdx;
             emit controlPointChanged();
             return true;
         }
@@ -156,6 +166,29 @@ const std::vector<std::vector<Point3D>>& GeoControlPointManager::getAllStageCont
     }
 }
 
+bool GeoControlPointManager::restoreStages(const std::vector<std::vector<Point3D>>& stages)
+{
+    assert(!getState()->isStateComplete() && "应该在空对象上重放");
+
+    for (const auto& stagePoints : stages)
+    {
+        if (getState()->isStateComplete() || getState()->isStateInvalid()) break;
+
+        std::size_t stageIdx = currentStageIdx();
+        for (const Point3D& point : stagePoints)
+        {
+            addControlPoint(point);
+        }
+
+        // 达到上限的阶段已在addControlPoint里自动切换，未达上限的阶段手动切换
+        if (!getState()->isStateComplete() && currentStageIdx() == stageIdx)
+        {
+            nextStage();
+        }
+    }
+    return getState()->isStateComplete();
+}
+
 const StageDescriptors& GeoControlPointManager::getStageDescriptors() const
 {
     assert(m_parent);
@@ -74,6 +74,12 @@ public:
     
     // 6. 获得所有控制点
     const std::vector<std::vector<Point3D>>& getAllStageControlPoints();
+    
+    // 7. 按阶段重放控制点（读取文件后重建），走与交互绘制相同的约束和阶段切换，返回是否绘制完成
+    bool restoreStages(const std::vector<std::vector<Point3D>>& stages);
+    
+    // 最近一次变化所在的阶段（-1表示点数或阶段结构发生变化）
+    int getLastChangedStage() const { return m_lastChangedStage; }
 
 signals:
     void controlPointChanged();
@@ -113,6 +119,7 @@ private:
     Stages m_stages;
     Stages m_stagesTemp;
     Point3D m_tempPoint;
+    int m_lastChangedStage;
 };
 
 
@@ -1,5 +1,7 @@
 ﻿
 #include "GeoNodeManager.h"
+#include "StateSetCache.h"
+#include "SpatialIndexBuilder.h"
 #include "../GeometryBase.h"
 #include <osg/Geode>
 #include <osg/Material>
@@ -14,9 +16,12 @@
 #include <osg/Array>
 #include <osg/PrimitiveSet>
 #include "../../util/LogManager.h"
+#include "../../util/Tracer.h"
 #include "../Enums3D.h"
 #include <algorithm>
 
+std::atomic<uint64_t> GeoNodeManager::s_sceneGeometryVersion{ 0 };
+
 // ============= 构造函数 =============
 
 GeoNodeManager::GeoNodeManager(osg::ref_ptr<Geo3D> parent)
@@ -24,18 +29,29 @@ GeoNodeManager::GeoNodeManager(osg::ref_ptr<Geo3D> parent)
     , m_parent(parent)
     , m_initialized(false)
     , m_selected(false)
+    , m_dirtyComponents(GeoComponent_All3D)
+    , m_lastRebuiltComponents(GeoComponent_None3D)
+    , m_geometryVersion(0)
+    , m_indexGeneration(1)
+    , m_requestedIndexGeneration(0)
 {
     initializeNodes();
 }
 
+GeoNodeManager::~GeoNodeManager()
+{
+    // 丢弃尚未换入的后台索引，避免完成后回调到已销毁的对象
+    if (m_requestedIndexGeneration.load() != 0) {
+        SpatialIndexBuilder::getInstance().cancel(this);
+    }
+}
+
 // ============= 几何体管理 =============
 
 void GeoNodeManager::clearVertexGeometry()
 {
     if (m_vertexGeometry.valid()) {
-        m_vertexGeometry->removePrimitiveSet(0, m_vertexGeometry->getNumPrimitiveSets());
-        m_vertexGeometry->setVertexArray(nullptr);
-        m_vertexGeometry->setColorArray(nullptr);
+        resetGeometry(m_vertexGeometry.get());
         emit geometryChanged();
     }
 }
@@ -43,10 +59,13 @@ void GeoNodeManager::clearVertexGeometry()
 void GeoNodeManager::clearEdgeGeometry()
 {
     if (m_edgeGeometry.valid()) {
-        m_edgeGeometry->removePrimitiveSet(0, m_edgeGeometry->getNumPrimitiveSets());
-        m_edgeGeometry->setVertexArray(nullptr);
-        m_edgeGeometry->setColorArray(nullptr);
-        m_edgeGeometry->setShape(nullptr);  // 清除KdTree
+        if (m_edgeUnitMesh.mesh.valid()) {
+            // 共享数组不能清空，等本轮重建结束再决定是否解除引用
+            m_edgeUnitMesh.claimed = false;
+        } else {
+            resetGeometry(m_edgeGeometry.get());
+        }
+        m_edgeSegmentBVH = nullptr;  // 清除线段BVH
         emit geometryChanged();
     }
 }
@@ -54,10 +73,13 @@ void GeoNodeManager::clearEdgeGeometry()
 void GeoNodeManager::clearFaceGeometry()
 {
     if (m_faceGeometry.valid()) {
-        m_faceGeometry->removePrimitiveSet(0, m_faceGeometry->getNumPrimitiveSets());
-        m_faceGeometry->setVertexArray(nullptr);
-        m_faceGeometry->setColorArray(nullptr);
-        m_faceGeometry->setShape(nullptr);  // 清除KdTree
+        if (m_faceUnitMesh.mesh.valid()) {
+            // 共享数组不能清空，等本轮重建结束再决定是否解除引用
+            m_faceUnitMesh.claimed = false;
+        } else {
+            resetGeometry(m_faceGeometry.get());
+            m_faceGeometry->setShape(nullptr);  // 清除KdTree
+        }
         emit geometryChanged();
     }
 }
@@ -65,27 +87,389 @@ void GeoNodeManager::clearFaceGeometry()
 void GeoNodeManager::clearControlPointsGeometry()
 {
     if (m_controlPointsGeometry.valid()) {
-        m_controlPointsGeometry->removePrimitiveSet(0, m_controlPointsGeometry->getNumPrimitiveSets());
-        m_controlPointsGeometry->setVertexArray(nullptr);
-        m_controlPointsGeometry->setColorArray(nullptr);
+        resetGeometry(m_controlPointsGeometry.get());
         emit geometryChanged();
     }
 }
 
-void GeoNodeManager::updateGeometries()
+// ============= 数组复用 =============
+
+osg::Vec3Array* GeoNodeManager::reuseVertexArray(osg::Geometry* geometry, unsigned int reserveSize)
+{
+    if (!geometry) return nullptr;
+    if (UnitMeshBinding* binding = boundUnitMesh(geometry)) releaseUnitMesh(geometry, *binding);
+
+    osg::Vec3Array* vertices = dynamic_cast<osg::Vec3Array*>(geometry->getVertexArray());
+    if (!vertices) {
+        // 首次构建（或外部节点的数组类型不同）才真正分配
+        vertices = new osg::Vec3Array;
+        vertices->setDataVariance(osg::Object::DYNAMIC);
+        geometry->setVertexArray(vertices);
+    }
+    vertices->reserve(reserveSize);
+    return vertices;
+}
+
+osg::Vec3Array* GeoNodeManager::reuseNormalArray(osg::Geometry* geometry, unsigned int reserveSize)
+{
+    if (!geometry) return nullptr;
+    if (UnitMeshBinding* binding = boundUnitMesh(geometry)) releaseUnitMesh(geometry, *binding);
+
+    osg::Vec3Array* normals = dynamic_cast<osg::Vec3Array*>(geometry->getNormalArray());
+    if (!normals) {
+        normals = new osg::Vec3Array;
+        normals->setDataVariance(osg::Object::DYNAMIC);
+        geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+    } else if (normals->getBinding() != osg::Array::BIND_PER_VERTEX) {
+        geometry->setNormalBinding(osg::Geometry::BIND_PER_VERTEX);
+    }
+    normals->reserve(reserveSize);
+    return normals;
+}
+
+osg::DrawArrays* GeoNodeManager::reuseDrawArrays(osg::Geometry* geometry, GLenum mode, GLint first, GLsizei count)
+{
+    if (!geometry) return nullptr;
+    if (UnitMeshBinding* binding = boundUnitMesh(geometry)) releaseUnitMesh(geometry, *binding);
+
+    unsigned int& cursor = primitiveCursor(geometry);
+    osg::DrawArrays* drawArrays = cursor < geometry->getNumPrimitiveSets()
+        ? dynamic_cast<osg::DrawArrays*>(geometry->getPrimitiveSet(cursor)) : nullptr;
+
+    if (drawArrays) {
+        drawArrays->set(mode, first, count);
+    } else {
+        drawArrays = new osg::DrawArrays(mode, first, count);
+        if (cursor < geometry->getNumPrimitiveSets()) {
+            geometry->setPrimitiveSet(cursor, drawArrays);
+        } else {
+            geometry->addPrimitiveSet(drawArrays);
+        }
+    }
+    ++cursor;
+    return drawArrays;
+}
+
+osg::DrawElementsUInt* GeoNodeManager::reuseDrawElements(osg::Geometry* geometry, GLenum mode, unsigned int reserveSize)
+{
+    if (!geometry) return nullptr;
+    if (UnitMeshBinding* binding = boundUnitMesh(geometry)) releaseUnitMesh(geometry, *binding);
+
+    unsigned int& cursor = primitiveCursor(geometry);
+    osg::DrawElementsUInt* drawElements = cursor < geometry->getNumPrimitiveSets()
+        ? dynamic_cast<osg::DrawElementsUInt*>(geometry->getPrimitiveSet(cursor)) : nullptr;
+
+    if (drawElements) {
+        drawElements->setMode(mode);
+        drawElements->clear();
+    } else {
+        drawElements = new osg::DrawElementsUInt(mode);
+        drawElements->setDataVariance(osg::Object::DYNAMIC);
+        if (cursor < geometry->getNumPrimitiveSets()) {
+            geometry->setPrimitiveSet(cursor, drawElements);
+        } else {
+            geometry->addPrimitiveSet(drawElements);
+        }
+    }
+    drawElements->reserve(reserveSize);
+    ++cursor;
+    return drawElements;
+}
+
+void GeoNodeManager::resetGeometry(osg::Geometry* geometry)
+{
+    // 数组长度清零但保留容量，builder提前返回时几何体也是空的
+    // 被其他几何体共享的数组（如从文件加载时合并的）只解除引用，不能原地清空
+    osg::Vec3Array* vertices = dynamic_cast<osg::Vec3Array*>(geometry->getVertexArray());
+    if (vertices && vertices->referenceCount() == 1) {
+        vertices->clear();
+    } else {
+        geometry->setVertexArray(nullptr);
+    }
+    osg::Vec3Array* normals = dynamic_cast<osg::Vec3Array*>(geometry->getNormalArray());
+    if (normals && normals->referenceCount() == 1) {
+        normals->clear();
+    } else if (normals) {
+        geometry->setNormalArray(nullptr);
+    }
+    if (geometry->getColorArray()) {
+        geometry->setColorArray(nullptr);
+    }
+
+    // 图元对象保留在原位置等待复用，先置空避免引用已清空的顶点
+    for (unsigned int i = 0; i < geometry->getNumPrimitiveSets(); ) {
+        osg::PrimitiveSet* primitiveSet = geometry->getPrimitiveSet(i);
+        if (primitiveSet->referenceCount() > 1) {
+            geometry->removePrimitiveSet(i);
+        } else if (osg::DrawArrays* drawArrays = dynamic_cast<osg::DrawArrays*>(primitiveSet)) {
+            drawArrays->setCount(0);
+            ++i;
+        } else if (osg::DrawElementsUInt* drawElements = dynamic_cast<osg::DrawElementsUInt*>(primitiveSet)) {
+            drawElements->clear();
+            ++i;
+        } else {
+            geometry->removePrimitiveSet(i);
+        }
+    }
+
+    m_primitiveCursors[geometry] = 0;
+}
+
+void GeoNodeManager::finishGeometry(osg::Geometry* geometry)
+{
+    // 只处理本轮clear过的几何体，外部加载的节点保持原样
+    if (UnitMeshBinding* binding = boundUnitMesh(geometry)) {
+        // 本轮仍引用单位网格时不做任何修改；builder改走逐对象构建的分支则解除引用
+        if (binding->claimed) return;
+        releaseUnitMesh(geometry, *binding);
+    }
+
+    auto it = m_primitiveCursors.find(geometry);
+    if (it == m_primitiveCursors.end()) return;
+
+    unsigned int used = it->second;
+    m_primitiveCursors.erase(it);
+
+    // 图元数变少时裁掉多余的
+    if (geometry->getNumPrimitiveSets() > used) {
+        geometry->removePrimitiveSet(used, geometry->getNumPrimitiveSets() - used);
+    }
+
+    // 通知已有的缓冲对象重新上传数据
+    if (osg::Array* vertices = geometry->getVertexArray()) {
+        vertices->dirty();
+    }
+    if (osg::Array* normals = geometry->getNormalArray()) {
+        // 本次没有写法线（如从球体退回截面圆）时去掉空的法线数组
+        if (normals->getNumElements() == 0) {
+            geometry->setNormalArray(nullptr);
+        } else {
+            normals->dirty();
+        }
+    }
+    for (unsigned int i = 0; i < geometry->getNumPrimitiveSets(); ++i) {
+        geometry->getPrimitiveSet(i)->dirty();
+    }
+    geometry->dirtyBound();
+}
+
+unsigned int& GeoNodeManager::primitiveCursor(osg::Geometry* geometry)
+{
+    return m_primitiveCursors[geometry];
+}
+
+// ============= 共享单位网格 =============
+
+void GeoNodeManager::setFaceUnitMesh(UnitMesh* mesh, const osg::Matrixd& matrix)
+{
+    if (!m_faceGeometry.valid() || !mesh || !mesh->prototype.valid()) return;
+    bindUnitMesh(m_faceGeometry.get(), m_faceUnitMesh, mesh, mesh->prototype.get(), matrix);
+}
+
+void GeoNodeManager::setEdgeUnitMesh(UnitMesh* mesh, const osg::Matrixd& matrix)
 {
-    m_parent->buildControlPointGeometries();
-    m_parent->buildVertexGeometries();
-    m_parent->buildEdgeGeometries();
-    m_parent->buildFaceGeometries();
+    if (!m_edgeGeometry.valid() || !mesh || !mesh->edgePrototype.valid()) return;
+    bindUnitMesh(m_edgeGeometry.get(), m_edgeUnitMesh, mesh, mesh->edgePrototype.get(), matrix);
+
+    // 线段BVH与单位网格一起共享，在单位网格坐标系下
+    m_edgeSegmentBVH = mesh->edgeBVH;
+}
+
+osg::Matrixd GeoNodeManager::getFaceWorldMatrix() const
+{
+    return getUnitMeshWorldMatrix(m_faceUnitMesh);
+}
+
+osg::Matrixd GeoNodeManager::getEdgeWorldMatrix() const
+{
+    return getUnitMeshWorldMatrix(m_edgeUnitMesh);
+}
+
+osg::Matrixd GeoNodeManager::getUnitMeshWorldMatrix(const UnitMeshBinding& binding) const
+{
+    osg::Matrixd matrix;
+    if (binding.transformNode.valid()) {
+        matrix = binding.transformNode->getMatrix();
+    }
+    if (m_transformNode.valid()) {
+        matrix.postMult(m_transformNode->getMatrix());
+    }
+    return matrix;
+}
+
+GeoNodeManager::UnitMeshBinding* GeoNodeManager::boundUnitMesh(osg::Geometry* geometry)
+{
+    if (geometry == m_faceGeometry.get() && m_faceUnitMesh.mesh.valid()) return &m_faceUnitMesh;
+    if (geometry == m_edgeGeometry.get() && m_edgeUnitMesh.mesh.valid()) return &m_edgeUnitMesh;
+    return nullptr;
+}
+
+void GeoNodeManager::bindUnitMesh(osg::Geometry* geometry, UnitMeshBinding& binding, UnitMesh* mesh,
+                                  osg::Geometry* prototype, const osg::Matrixd& matrix)
+{
+    ensureUnitMeshTransformNode(geometry, binding);
+    binding.transformNode->setMatrix(matrix);
+    binding.claimed = true;
+
+    // 同一网格只需更新矩阵，数组和空间索引都不动
+    if (binding.mesh.get() == mesh) return;
+
+    geometry->removePrimitiveSet(0, geometry->getNumPrimitiveSets());
+    geometry->setVertexArray(prototype->getVertexArray());
+    if (prototype->getNormalArray()) {
+        geometry->setNormalArray(prototype->getNormalArray(), osg::Array::BIND_PER_VERTEX);
+    } else {
+        geometry->setNormalArray(nullptr);
+    }
+    geometry->setColorArray(nullptr);
+    for (unsigned int i = 0; i < prototype->getNumPrimitiveSets(); ++i) {
+        geometry->addPrimitiveSet(prototype->getPrimitiveSet(i));
+    }
+    geometry->setShape(prototype->getShape());
+    geometry->dirtyBound();
+
+    binding.mesh = mesh;
+    m_primitiveCursors.erase(geometry);
+}
+
+void GeoNodeManager::ensureUnitMeshTransformNode(osg::Geometry* geometry, UnitMeshBinding& binding)
+{
+    if (binding.transformNode.valid()) return;
+
+    binding.transformNode = new osg::MatrixTransform();
+    if (geometry == m_faceGeometry.get()) {
+        binding.transformNode->setName(NodeTags3D::FACE_TRANSFORM_NODE);
+        // 单位网格的法线随缩放矩阵变换，需要重新归一化（共享状态集）
+        binding.transformNode->setStateSet(UnitMeshCache::getFaceTransformStateSet());
+    } else {
+        binding.transformNode->setName(NodeTags3D::EDGE_TRANSFORM_NODE);
+    }
+
+    // 替换几何体在原父节点中的位置，保持子节点顺序
+    osg::Node::ParentList parents = geometry->getParents();
+    for (osg::Group* parent : parents) {
+        parent->replaceChild(geometry, binding.transformNode.get());
+    }
+    if (parents.empty() && m_transformNode.valid()) {
+        m_transformNode->addChild(binding.transformNode.get());
+    }
+    binding.transformNode->addChild(geometry);
+}
+
+void GeoNodeManager::releaseUnitMesh(osg::Geometry* geometry, UnitMeshBinding& binding)
+{
+    // 只解除引用，不修改共享的数组和图元
+    geometry->removePrimitiveSet(0, geometry->getNumPrimitiveSets());
+    geometry->setVertexArray(nullptr);
+    geometry->setNormalArray(nullptr);
+    geometry->setShape(nullptr);
+    geometry->dirtyBound();
+    if (binding.transformNode.valid()) {
+        binding.transformNode->setMatrix(osg::Matrixd::identity());
+    }
+    if (geometry == m_edgeGeometry.get()) {
+        m_edgeSegmentBVH = nullptr;
+    }
+
+    binding.mesh = nullptr;
+    binding.claimed = false;
+    m_primitiveCursors[geometry] = 0;
+}
+
+void GeoNodeManager::updateGeometries(unsigned int components)
+{
+    TRACE_ZONE("GeoNodeManager::updateGeometries", "几何体");
+
+    // 重建期间阻止后台拾取线程遍历本几何体
+    QWriteLocker sceneLocker(m_parent->getSceneLock());
+    
+    m_dirtyComponents |= components;
+    if (m_dirtyComponents != GeoComponent_None3D) {
+        incrementGeometryVersion();
+    }
+    unsigned int rebuilt = GeoComponent_None3D;
+
+    // 控制点只在选中时可见，隐藏期间推迟到setSelected(true)再重建
+    if (isDirty(GeoComponent_ControlPoints3D) && m_selected) {
+        TRACE_ZONE("构建控制点", "几何体");
+        m_parent->buildControlPointGeometries();
+        finishGeometry(m_controlPointsGeometry.get());
+        m_dirtyComponents &= ~GeoComponent_ControlPoints3D;
+        rebuilt |= GeoComponent_ControlPoints3D;
+        m_dirtyComponents |= GeoComponent_Bounds3D;
+    }
+    if (isDirty(GeoComponent_Vertex3D)) {
+        TRACE_ZONE("构建顶点", "几何体");
+        m_parent->buildVertexGeometries();
+        finishGeometry(m_vertexGeometry.get());
+        m_dirtyComponents &= ~GeoComponent_Vertex3D;
+        rebuilt |= GeoComponent_Vertex3D;
+        m_dirtyComponents |= GeoComponent_Bounds3D;
+    }
+    // 边/面重建会清掉各自的索引（线段BVH/KdTree），空间索引随之变脏，构建中的旧索引作废
+    if (isDirty(GeoComponent_Edge3D)) {
+        TRACE_ZONE("构建边", "几何体");
+        m_parent->buildEdgeGeometries();
+        finishGeometry(m_edgeGeometry.get());
+        m_dirtyComponents &= ~GeoComponent_Edge3D;
+        rebuilt |= GeoComponent_Edge3D;
+        m_dirtyComponents |= GeoComponent_Bounds3D | GeoComponent_SpatialIndex3D;
+        ++m_indexGeneration;
+    }
+    if (isDirty(GeoComponent_Face3D)) {
+        TRACE_ZONE("构建面", "几何体");
+        m_parent->buildFaceGeometries();
+        finishGeometry(m_faceGeometry.get());
+        m_dirtyComponents &= ~GeoComponent_Face3D;
+        rebuilt |= GeoComponent_Face3D;
+        m_dirtyComponents |= GeoComponent_Bounds3D | GeoComponent_SpatialIndex3D;
+        ++m_indexGeneration;
+    }
 
     // 更新包围盒
-    updateBoundingBoxGeometry();
+    if (isDirty(GeoComponent_Bounds3D)) {
+        TRACE_ZONE("更新包围盒", "几何体");
+        updateBoundingBoxGeometry();
+        m_dirtyComponents &= ~GeoComponent_Bounds3D;
+        rebuilt |= GeoComponent_Bounds3D;
+
+        // 在写锁内预先计算包围球，避免拾取线程与渲染线程同时惰性计算
+        for (osg::Node* node = m_osgNode.get(); node; node = node->getNumParents() ? node->getParent(0) : nullptr) {
+            node->getBound();
+        }
+    }
 
-    if (!m_parent->mm_state()->isStateComplete())return;
-    // 绘制完成才建索引
-    // 更新空间索引
-    updateSpatialIndex();
+    // 空间索引不在这里同步构建：加载大场景时大部分对象从不被拾取，
+    // 等首次拾取调用requestSpatialIndex再交给后台线程
+    m_dirtyComponents &= ~GeoComponent_SpatialIndex3D;
+    m_lastRebuiltComponents = rebuilt;
+}
+
+// ============= 版本 =============
+
+void GeoNodeManager::incrementGeometryVersion()
+{
+    ++m_geometryVersion;
+    
+    // 绘制中的对象不可拾取（NODE_MASK_NOSELECT），它的变化不影响场景级的拾取缓存
+    if (m_osgNode.valid() && (m_osgNode->getNodeMask() & NODE_MASK_ALL_VISIBLE) != 0) {
+        ++s_sceneGeometryVersion;
+    }
+}
+
+// ============= 变换管理 =============
+
+void GeoNodeManager::setTransformMatrix(const osg::Matrix& matrix)
+{
+    if (!m_transformNode.valid()) return;
+    
+    QWriteLocker sceneLocker(m_parent->getSceneLock());
+    
+    m_transformNode->setMatrix(matrix);
+    updateBoundingBoxGeometry();
+    incrementGeometryVersion();
+    
+    emit transformChanged();
 }
 
 // ============= 节点设置 =============
@@ -99,6 +483,11 @@ void GeoNodeManager::setOSGNode(osg::ref_ptr<osg::Node> node)
 
     LOG_INFO("开始设置OSG节点", "几何体管理");
 
+    // 替换和挂接子节点期间阻止后台拾取线程遍历
+    QWriteLocker sceneLocker(m_parent->getSceneLock());
+    m_edgeSegmentBVH = nullptr;  // 边几何体可能被替换，线段BVH在下次拾取时重建
+    ++m_indexGeneration;
+
     // 检查是否为Group类型且有名字
     osg::Group* groupNode = dynamic_cast<osg::Group*>(node.get());
     if (groupNode && node->getName() == NodeTags3D::ROOT_GROUP) {
@@ -130,7 +519,11 @@ void GeoNodeManager::setSelected(bool selected)
 {
     if (m_selected == selected) return;
     
+    // 包围盒和控制点的节点掩码是拾取遍历读取的状态
+    QWriteLocker sceneLocker(m_parent->getSceneLock());
+    
     m_selected = selected;
+    incrementGeometryVersion();  // 控制点随选中状态显示/隐藏
     
     if (selected) {
         // 选中时显示包围盒和控制点
@@ -140,6 +533,10 @@ void GeoNodeManager::setSelected(bool selected)
         if (m_controlPointsGeometry.valid()) {
             m_controlPointsGeometry->setNodeMask(NODE_MASK_CONTROL_POINTS);
         }
+        // 补建隐藏期间推迟的控制点几何体
+        if (isDirty(GeoComponent_ControlPoints3D)) {
+            updateGeometries(GeoComponent_None3D);
+        }
         LOG_INFO("几何体已选中，显示包围盒和控制点", "选择管理");
     } else {
         // 取消选中时隐藏包围盒和控制点
@@ -159,7 +556,9 @@ void GeoNodeManager::onDrawingCompleted()
 {
     // 绘制完成后，允许节点被拾取
     if (m_osgNode.valid()) {
+        QWriteLocker sceneLocker(m_parent->getSceneLock());
         m_osgNode->setNodeMask(NODE_MASK_ALL_VISIBLE);
+        incrementGeometryVersion();
         LOG_INFO("绘制完成，节点已可拾取", "几何体管理");
     }
 }
@@ -200,6 +599,14 @@ void GeoNodeManager::initializeNodes()
         m_controlPointsGeometry->setUserData(m_parent);
         m_boundingBoxGeometry->setUserData(m_parent);
 
+        // 拖拽时数组原地更新，用VBO的dirty()增量上传，不走显示列表重编译
+        for (osg::Geometry* geometry : { m_vertexGeometry.get(), m_edgeGeometry.get(), m_faceGeometry.get(),
+                                         m_controlPointsGeometry.get(), m_boundingBoxGeometry.get() }) {
+            geometry->setUseDisplayList(false);
+            geometry->setUseVertexBufferObjects(true);
+            geometry->setDataVariance(osg::Object::DYNAMIC);
+        }
+
         m_transformNode->addChild(m_vertexGeometry.get());
         m_transformNode->addChild(m_edgeGeometry.get());
         m_transformNode->addChild(m_faceGeometry.get());
@@ -259,6 +666,18 @@ void GeoNodeManager::findAndAssignNodeComponents(osg::Node* node)
             }
         }
 
+        virtual void apply(osg::MatrixTransform& transform) override
+        {
+            if (transform.getName() == NodeTags3D::FACE_TRANSFORM_NODE) {
+                m_manager->m_faceUnitMesh.transformNode = &transform;
+                LOG_INFO("找到并分配面变换节点", "几何体管理");
+            } else if (transform.getName() == NodeTags3D::EDGE_TRANSFORM_NODE) {
+                m_manager->m_edgeUnitMesh.transformNode = &transform;
+                LOG_INFO("找到并分配边变换节点", "几何体管理");
+            }
+            traverse(transform);
+        }
+
     private:
         GeoNodeManager* m_manager;
     };
@@ -276,36 +695,45 @@ void GeoNodeManager::findAndAssignNodeComponents(osg::Node* node)
     }
 }
 
-// ============= 私有函数：空间索引管理 =============
-
-void GeoNodeManager::updateSpatialIndex()
-{
-    // 为边和面几何体构建KdTree以加速射线拾取
-    buildKdTreeForGeometry(m_edgeGeometry.get());
-    buildKdTreeForGeometry(m_faceGeometry.get());
-}
+// ============= 空间索引 =============
 
-void GeoNodeManager::clearSpatialIndex()
+void GeoNodeManager::requestSpatialIndex()
 {
-    if (m_edgeGeometry.valid()) {
-        m_edgeGeometry->setShape(nullptr);
+    // 同一代只提交一次；两个拾取线程同时请求时只有一个拿到旧值
+    const uint64_t generation = m_indexGeneration.load();
+    if (m_requestedIndexGeneration.exchange(generation) == generation) return;
+
+    // 在调用线程复制数据（调用方持有场景读锁，主线程此时不会重建几何体），
+    // 图元数低于阈值的几何体不建索引，拾取时逐图元求交
+    osg::ref_ptr<osg::Geometry> edgeSnapshot;
+    if (m_edgeGeometry.valid() && !m_edgeSegmentBVH.valid() && !m_edgeUnitMesh.mesh.valid() &&
+        EdgeSegmentBVH::countSegments(m_edgeGeometry.get()) >= SpatialIndexBuilder::MIN_INDEXED_SEGMENTS) {
+        edgeSnapshot = SpatialIndexBuilder::snapshot(m_edgeGeometry.get());
     }
-    if (m_faceGeometry.valid()) {
-        m_faceGeometry->setShape(nullptr);
+
+    // 引用单位网格的面共享原型上的KdTree
+    osg::ref_ptr<osg::Geometry> faceSnapshot;
+    if (m_faceGeometry.valid() && !m_faceUnitMesh.mesh.valid() && !m_faceGeometry->getShape() &&
+        SpatialIndexBuilder::countTriangles(m_faceGeometry.get()) >= SpatialIndexBuilder::MIN_INDEXED_TRIANGLES) {
+        faceSnapshot = SpatialIndexBuilder::snapshot(m_faceGeometry.get());
     }
+
+    SpatialIndexBuilder::getInstance().submit(this, generation, edgeSnapshot, faceSnapshot);
 }
 
-void GeoNodeManager::buildKdTreeForGeometry(osg::Geometry* geometry)
+void GeoNodeManager::installSpatialIndex(uint64_t generation, osg::ref_ptr<EdgeSegmentBVH> edgeBVH, osg::ref_ptr<osg::KdTree> faceKdTree)
 {
-    if (!geometry || !geometry->getVertexArray()) return;
+    // 换入期间阻止后台拾取线程读取索引
+    QWriteLocker sceneLocker(m_parent->getSceneLock());
 
-    osg::ref_ptr<osg::KdTree> kdTree = new osg::KdTree;
-    osg::KdTree::BuildOptions buildOptions;
-    if (kdTree->build(buildOptions, geometry)) {
-        geometry->setShape(kdTree.get());
-        LOG_INFO("为几何体构建KdTree成功", "空间索引");
-    } else {
-        LOG_WARNING("为几何体构建KdTree失败", "空间索引");
+    // 构建期间边/面又被重建，结果已过期
+    if (generation != m_indexGeneration.load()) return;
+
+    if (edgeBVH.valid() && !m_edgeUnitMesh.mesh.valid()) {
+        m_edgeSegmentBVH = edgeBVH;
+    }
+    if (faceKdTree.valid() && m_faceGeometry.valid() && !m_faceUnitMesh.mesh.valid()) {
+        m_faceGeometry->setShape(faceKdTree.get());
     }
 }
 
@@ -323,17 +751,26 @@ void GeoNodeManager::updateBoundingBoxGeometry()
     if (boundingBox.valid()) {
         createBoundingBoxGeometry(boundingBox);
     }
+
+    // 包围盒变化时通知场景BVH
+    bool changed = boundingBox.valid() != m_boundingBox.valid()
+        || (boundingBox.valid() && (boundingBox._min != m_boundingBox._min || boundingBox._max != m_boundingBox._max));
+    if (changed) {
+        m_boundingBox = boundingBox;
+        emit boundingBoxChanged();
+    }
 }
 
 void GeoNodeManager::createBoundingBoxGeometry(const osg::BoundingBox& boundingBox)
 {
     if (!m_boundingBoxGeometry.valid() || !boundingBox.valid()) return;
 
-    // 清除现有数据
-    m_boundingBoxGeometry->removePrimitiveSet(0, m_boundingBoxGeometry->getNumPrimitiveSets());
-
-    // 创建包围盒的8个顶点
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(8);
+    // 8个顶点原地覆盖，线框索引只在首次创建
+    osg::Vec3Array* vertices = dynamic_cast<osg::Vec3Array*>(m_boundingBoxGeometry->getVertexArray());
+    bool reuse = vertices && vertices->size() == 8 && m_boundingBoxGeometry->getNumPrimitiveSets() == 1;
+    if (!reuse) {
+        vertices = new osg::Vec3Array(8);
+    }
     const osg::Vec3& min = boundingBox._min;
     const osg::Vec3& max = boundingBox._max;
 
@@ -346,7 +783,15 @@ void GeoNodeManager::createBoundingBoxGeometry(const osg::BoundingBox& boundingB
     (*vertices)[6] = osg::Vec3(max.x(), max.y(), max.z());
     (*vertices)[7] = osg::Vec3(min.x(), max.y(), max.z());
 
-    m_boundingBoxGeometry->setVertexArray(vertices.get());
+    if (reuse) {
+        vertices->dirty();
+        m_boundingBoxGeometry->dirtyBound();
+        return;
+    }
+
+    // 清除现有数据
+    m_boundingBoxGeometry->removePrimitiveSet(0, m_boundingBoxGeometry->getNumPrimitiveSets());
+    m_boundingBoxGeometry->setVertexArray(vertices);
 
     // 创建线框
     osg::ref_ptr<osg::DrawElementsUShort> lineIndices = 
@@ -379,38 +824,24 @@ void GeoNodeManager::setupControlPointsRendering()
 {
     if (!m_controlPointsGeometry.valid()) return;
 
-    osg::ref_ptr<osg::StateSet> stateSet = m_controlPointsGeometry->getOrCreateStateSet();
-    
-    // 设置点的大小和颜色
-    osg::ref_ptr<osg::Point> pointSize = new osg::Point(8.0f);
-    stateSet->setAttributeAndModes(pointSize.get(), osg::StateAttribute::ON);
-    
-    // 设置材质
-    osg::ref_ptr<osg::Material> material = new osg::Material();
-    material->setDiffuse(osg::Material::FRONT_AND_BACK, osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f));  // 黄色
-    material->setAmbient(osg::Material::FRONT_AND_BACK, osg::Vec4(0.8f, 0.8f, 0.0f, 1.0f));
-    stateSet->setAttributeAndModes(material.get(), osg::StateAttribute::ON);
-    
-    // 关闭光照
-    stateSet->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+    // 所有对象的控制点共用同一个状态：黄色、8像素、关闭光照
+    RenderStateKey key;
+    key.primitive = RenderStateKey::Primitive_Points;
+    key.color = osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f);
+    key.pointSize = 8.0f;
+    key.lighting = false;
+    m_controlPointsGeometry->setStateSet(StateSetCache::getInstance().get(key));
 }
 
 void GeoNodeManager::setupBoundingBoxRendering()
 {
     if (!m_boundingBoxGeometry.valid()) return;
 
-    osg::ref_ptr<osg::StateSet> stateSet = m_boundingBoxGeometry->getOrCreateStateSet();
-    
-    // 设置线宽
-    osg::ref_ptr<osg::LineWidth> lineWidth = new osg::LineWidth(2.0f);
-    stateSet->setAttributeAndModes(lineWidth.get(), osg::StateAttribute::ON);
-    
-    // 设置材质
-    osg::ref_ptr<osg::Material> material = new osg::Material();
-    material->setDiffuse(osg::Material::FRONT_AND_BACK, osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f));  // 黄色
-    material->setAmbient(osg::Material::FRONT_AND_BACK, osg::Vec4(0.8f, 0.8f, 0.0f, 1.0f));
-    stateSet->setAttributeAndModes(material.get(), osg::StateAttribute::ON);
-    
-    // 关闭光照
-    stateSet->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+    // 所有对象的包围盒共用同一个状态：黄色、2像素线宽、关闭光照
+    RenderStateKey key;
+    key.primitive = RenderStateKey::Primitive_Lines;
+    key.color = osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f);
+    key.lineWidth = 2.0f;
+    key.lighting = false;
+    m_boundingBoxGeometry->setStateSet(StateSetCache::getInstance().get(key));
 }
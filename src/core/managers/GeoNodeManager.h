@@ -2,6 +2,8 @@
 #pragma execution_character_set("utf-8")
 
 #include "../Common3D.h"
+#include "../geometry/UnitMeshCache.h"
+#include "../picking/EdgeSegmentBVH.h"
 #include <osg/Group>
 #include <osg/Geometry>
 #include <osg/MatrixTransform>
@@ -9,6 +11,9 @@
 #include <osg/KdTree>
 #include <osg/BoundingBox>
 #include <QObject>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
 
 // 前向声明
 class Geo3D;
@@ -18,7 +23,7 @@ class GeoNodeManager : public QObject
     Q_OBJECT
 public:
     explicit GeoNodeManager(osg::ref_ptr<Geo3D> parent);
-    ~GeoNodeManager() = default;
+    ~GeoNodeManager();
 
     // ============= 节点访问 =============
     osg::ref_ptr<osg::Group> getOSGNode() const { return m_osgNode; }
@@ -30,6 +35,17 @@ public:
     osg::ref_ptr<osg::Geometry> getFaceGeometry() const { return m_faceGeometry; }
     osg::ref_ptr<osg::Geometry> getControlPointsGeometry() const { return m_controlPointsGeometry; }
     
+    // ============= 空间索引 =============
+    // 边的线段BVH和面的KdTree在首次拾取时由SpatialIndexBuilder后台构建，建好前及图元数低于阈值时逐图元求交
+    EdgeSegmentBVH* getEdgeSegmentBVH() const { return m_edgeSegmentBVH.get(); }
+    bool needsSpatialIndex() const { return m_requestedIndexGeneration.load() != m_indexGeneration.load(); }
+    void requestSpatialIndex();  // 可在拾取线程调用（需持有场景读锁），同一次重建只提交一次
+    void installSpatialIndex(uint64_t generation, osg::ref_ptr<EdgeSegmentBVH> edgeBVH, osg::ref_ptr<osg::KdTree> faceKdTree);  // 主线程
+    
+    // ============= 包围盒与变换 =============
+    const osg::BoundingBox& getBoundingBox() const { return m_boundingBox; }  // 场景坐标系下的包围盒
+    void setTransformMatrix(const osg::Matrix& matrix);
+    
     // ============= 节点设置 =============
     void setOSGNode(osg::ref_ptr<osg::Node> node);  // 加载外部节点
     
@@ -38,7 +54,38 @@ public:
     void clearEdgeGeometry();
     void clearFaceGeometry();
     void clearControlPointsGeometry();
-    void updateGeometries();
+    void updateGeometries(unsigned int components = GeoComponent_All3D);  // 标记组件为脏并增量重建
+    
+    // ============= 数组复用（原地重建） =============
+    // clear*Geometry只把数组和图元长度清零并保留容量，builder通过以下接口原地覆盖写入，
+    // 重建结束后由updateGeometries统一裁掉多余图元并dirty()，避免拖拽时反复分配和重建VBO
+    osg::Vec3Array* reuseVertexArray(osg::Geometry* geometry, unsigned int reserveSize = 0);
+    osg::Vec3Array* reuseNormalArray(osg::Geometry* geometry, unsigned int reserveSize = 0);  // 按顶点绑定
+    osg::DrawArrays* reuseDrawArrays(osg::Geometry* geometry, GLenum mode, GLint first, GLsizei count);
+    osg::DrawElementsUInt* reuseDrawElements(osg::Geometry* geometry, GLenum mode, unsigned int reserveSize = 0);
+    
+    // ============= 共享单位网格 =============
+    // 面/边几何体直接引用UnitMeshCache中的顶点/法线/图元和空间索引（面的KdTree、边的线段BVH），
+    // 对象只在几何体上方的变换节点保留一个矩阵；本轮重建未调用时（退回逐对象构建的阶段）自动解除引用
+    void setFaceUnitMesh(UnitMesh* mesh, const osg::Matrixd& matrix);
+    void setEdgeUnitMesh(UnitMesh* mesh, const osg::Matrixd& matrix);
+    bool isFaceUsingUnitMesh() const { return m_faceUnitMesh.mesh.valid(); }
+    bool isEdgeUsingUnitMesh() const { return m_edgeUnitMesh.mesh.valid(); }
+    UnitMesh* getFaceUnitMesh() const { return m_faceUnitMesh.mesh.get(); }
+    osg::Matrixd getFaceWorldMatrix() const;  // 面几何体局部坐标 -> 场景坐标（面变换 × 对象变换）
+    osg::Matrixd getEdgeWorldMatrix() const;  // 边几何体局部坐标 -> 场景坐标（边变换 × 对象变换）
+    
+    // ============= 脏标记 =============
+    void markDirty(unsigned int components) { m_dirtyComponents |= components; }
+    bool isDirty(unsigned int components) const { return (m_dirtyComponents & components) != 0; }
+    unsigned int getDirtyComponents() const { return m_dirtyComponents; }
+    unsigned int getLastRebuiltComponents() const { return m_lastRebuiltComponents; }  // 上次updateGeometries实际重建的组件
+    
+    // ============= 版本 =============
+    // 可拾取内容（几何数据、变换、节点掩码）每变化一次加一，供屏幕空间拾取缓存等判断是否过期
+    uint64_t getGeometryVersion() const { return m_geometryVersion.load(); }
+    void incrementGeometryVersion();
+    static uint64_t getSceneGeometryVersion() { return s_sceneGeometryVersion.load(); }  // 所有对象的版本变化总数
     
     // ============= 选中状态管理 =============
     void setSelected(bool selected);  // 自动控制包围盒和控制点显示
@@ -50,6 +97,7 @@ public slots:
 signals:
     void geometryChanged();     // 用于更新材质和渲染
     void transformChanged();    // 用于更新渲染
+    void boundingBoxChanged();  // 用于更新场景BVH
 
 private:
     // ============= 初始化 =============
@@ -58,10 +106,24 @@ private:
     // ============= 外部节点处理 =============
     void findAndAssignNodeComponents(osg::Node* node);  // 基于标记查找组件
     
-    // ============= 空间索引管理 =============
-    void updateSpatialIndex();
-    void clearSpatialIndex();
-    void buildKdTreeForGeometry(osg::Geometry* geometry);
+    // ============= 数组复用 =============
+    void resetGeometry(osg::Geometry* geometry);   // 长度清零，保留数组、图元对象和容量
+    void finishGeometry(osg::Geometry* geometry);  // 裁掉本次未复用的图元并标记缓冲区脏
+    unsigned int& primitiveCursor(osg::Geometry* geometry);
+    
+    // ============= 共享单位网格 =============
+    struct UnitMeshBinding
+    {
+        osg::ref_ptr<osg::MatrixTransform> transformNode;  // 首次引用时插在几何体上方
+        osg::ref_ptr<UnitMesh> mesh;
+        bool claimed = false;  // 本轮重建是否再次引用了单位网格
+    };
+    UnitMeshBinding* boundUnitMesh(osg::Geometry* geometry);  // 该几何体正引用单位网格时返回其绑定
+    void bindUnitMesh(osg::Geometry* geometry, UnitMeshBinding& binding, UnitMesh* mesh,
+                      osg::Geometry* prototype, const osg::Matrixd& matrix);
+    void ensureUnitMeshTransformNode(osg::Geometry* geometry, UnitMeshBinding& binding);
+    void releaseUnitMesh(osg::Geometry* geometry, UnitMeshBinding& binding);  // 解除共享数组，恢复为逐对象构建
+    osg::Matrixd getUnitMeshWorldMatrix(const UnitMeshBinding& binding) const;
     
     // ============= 包围盒管理 =============
     void updateBoundingBoxGeometry();
@@ -85,8 +147,29 @@ private:
     osg::ref_ptr<osg::Geometry> m_controlPointsGeometry;
     osg::ref_ptr<osg::Geometry> m_boundingBoxGeometry;
     
+    // 边几何体的线段BVH（KdTree只处理三角形，对边无效）
+    osg::ref_ptr<EdgeSegmentBVH> m_edgeSegmentBVH;
+    
+    // 面/边几何体引用单位网格时的变换节点和网格（点/控制点仍在对象坐标系）
+    UnitMeshBinding m_faceUnitMesh;
+    UnitMeshBinding m_edgeUnitMesh;
+    
+    // 场景坐标系下的包围盒（含变换）
+    osg::BoundingBox m_boundingBox;
+    
     // 状态标志
     bool m_initialized;
     bool m_selected;
+    unsigned int m_dirtyComponents;  // GeoComponent3D位组合
+    unsigned int m_lastRebuiltComponents;
+    
+    // 版本（拾取线程只读）
+    std::atomic<uint64_t> m_geometryVersion;
+    std::atomic<uint64_t> m_indexGeneration;           // 边/面每重建一次加一，过期的后台索引据此丢弃
+    std::atomic<uint64_t> m_requestedIndexGeneration;  // 已提交构建请求的重建代数
+    static std::atomic<uint64_t> s_sceneGeometryVersion;
+    
+    // 每个几何体本次重建已写入的图元数量（复用下标）
+    std::unordered_map<osg::Geometry*, unsigned int> m_primitiveCursors;
 }; 
 
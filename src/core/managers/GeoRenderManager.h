@@ -2,20 +2,16 @@
 #pragma execution_character_set("utf-8")
 
 #include "../Common3D.h"
-#include <osg/Material>
-#include <osg/StateSet>
-#include <osg/BlendFunc>
-#include <osg/LineWidth>
-#include <osg/Point>
-#include <osg/LineStipple>
 #include <osg/ref_ptr>
 
 // 前向声明
 class Geo3D;
+class GeoStyle;
 
 /**
  * @brief 几何体渲染管理器
- * 专注于几何体的渲染属性设置（颜色、大小、透明度、线型等）
+ * 把样式表中共享的点/边/面StateSet挂到几何体上，并按参数控制各组件的显示
+ * 参数变化时只替换StateSet指针，不修改也不持有每个对象私有的渲染状态
  * 选中状态显示由GeoNodeManager管理
  */
 class GeoRenderManager
@@ -24,32 +20,12 @@ public:
     explicit GeoRenderManager(osg::ref_ptr<Geo3D> parent);
     ~GeoRenderManager() = default;
 
-    // 更新渲染参数
-    void updateRenderingParameters(const GeoParameters3D& params);
+    // 应用样式（几何体节点被替换后也需要重新调用）
+    void applyStyle(const GeoStyle* style);
 
 private:
-    void initializeRenderStates();
-    void updatePointRendering(const GeoParameters3D& params);
-    void updateLineRendering(const GeoParameters3D& params);
-    void updateSurfaceRendering(const GeoParameters3D& params);
     void updateVisibilityStates(const GeoParameters3D& params);
-    
-    void applyLineStyle(LineStyle3D style, double dashPattern);
-    osg::Vec4 colorToOsgVec4(const Color3D& color) const;
 
 private:
     osg::ref_ptr<Geo3D> m_parent;
-    
-
-    GeoParameters3D m_currentParams;
-    
-    osg::ref_ptr<osg::Material> m_pointMaterial;
-    osg::ref_ptr<osg::Material> m_lineMaterial;
-    osg::ref_ptr<osg::Material> m_surfaceMaterial;
-    
-    osg::ref_ptr<osg::Point> m_pointSize;
-    osg::ref_ptr<osg::LineWidth> m_lineWidth;
-    osg::ref_ptr<osg::LineStipple> m_lineStipple;
-    osg::ref_ptr<osg::BlendFunc> m_blendFunc;
 }; 
-
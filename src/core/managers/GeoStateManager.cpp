@@ -10,52 +10,75 @@ GeoStateManager::GeoStateManager(osg::ref_ptr<Geo3D> parent)
     setStateInitialized();
 }
 
+int GeoStateManager::getState() const
+{
+    // 加入场景后状态位保存在场景的实体存储中
+    if (GeoEntityStore* store = m_parent->getEntityStore()) {
+        return store->getState(m_parent->getEntity());
+    }
+    return m_geoState;
+}
+
+void GeoStateManager::storeState(int state)
+{
+    if (GeoEntityStore* store = m_parent->getEntityStore()) {
+        store->setState(m_parent->getEntity(), state);
+    } else {
+        m_geoState = state;
+    }
+}
+
 void GeoStateManager::setStateInitialized()
 {
-    int oldState = m_geoState;
-    m_geoState |= GeoState_Initialized3D;
+    int oldState = getState();
+    int newState = oldState | GeoState_Initialized3D;
+    storeState(newState);
     
-    if (oldState != m_geoState) {
+    if (oldState != newState) {
         emit stateInitialized();
     }
 }
 
 void GeoStateManager::setStateComplete()
 {
-    int oldState = m_geoState;
-    m_geoState |= GeoState_Complete3D;
+    int oldState = getState();
+    int newState = oldState | GeoState_Complete3D;
+    storeState(newState);
     
-    if (oldState != m_geoState) {
+    if (oldState != newState) {
         emit stateCompleted();
     }
 }
 
 void GeoStateManager::setStateInvalid()
 {
-    int oldState = m_geoState;
-    m_geoState |= GeoState_Invalid3D;
+    int oldState = getState();
+    int newState = oldState | GeoState_Invalid3D;
+    storeState(newState);
     
-    if (oldState != m_geoState) {
+    if (oldState != newState) {
         emit stateInvalidated();
     }
 }
 
 void GeoStateManager::setStateSelected()
 {
-    int oldState = m_geoState;
-    m_geoState |= GeoState_Selected3D;
+    int oldState = getState();
+    int newState = oldState | GeoState_Selected3D;
+    storeState(newState);
     
-    if (oldState != m_geoState) {
+    if (oldState != newState) {
         emit stateSelected();
     }
 }
 
 void GeoStateManager::setStateEditing()
 {
-    int oldState = m_geoState;
-    m_geoState |= GeoState_Editing3D;
+    int oldState = getState();
+    int newState = oldState | GeoState_Editing3D;
+    storeState(newState);
     
-    if (oldState != m_geoState) {
+    if (oldState != newState) {
         
         emit editingStarted();
     }
@@ -63,30 +86,33 @@ void GeoStateManager::setStateEditing()
 
 void GeoStateManager::clearStateComplete()
 {
-    int oldState = m_geoState;
-    m_geoState &= ~GeoState_Complete3D;
+    int oldState = getState();
+    int newState = oldState & ~GeoState_Complete3D;
+    storeState(newState);
     
-    if (oldState != m_geoState) {
+    if (oldState != newState) {
         
     }
 }
 
 void GeoStateManager::clearStateInvalid()
 {
-    int oldState = m_geoState;
-    m_geoState &= ~GeoState_Invalid3D;
+    int oldState = getState();
+    int newState = oldState & ~GeoState_Invalid3D;
+    storeState(newState);
     
-    if (oldState != m_geoState) {
+    if (oldState != newState) {
         
     }
 }
 
 void GeoStateManager::clearStateSelected()
 {
-    int oldState = m_geoState;
-    m_geoState &= ~GeoState_Selected3D;
+    int oldState = getState();
+    int newState = oldState & ~GeoState_Selected3D;
+    storeState(newState);
     
-    if (oldState != m_geoState) {
+    if (oldState != newState) {
         
         emit stateDeselected();
     }
@@ -94,10 +120,11 @@ void GeoStateManager::clearStateSelected()
 
 void GeoStateManager::clearStateEditing()
 {
-    int oldState = m_geoState;
-    m_geoState &= ~GeoState_Editing3D;
+    int oldState = getState();
+    int newState = oldState & ~GeoState_Editing3D;
+    storeState(newState);
     
-    if (oldState != m_geoState) {
+    if (oldState != newState) {
         
         emit editingFinished();
     }
@@ -105,21 +132,21 @@ void GeoStateManager::clearStateEditing()
 
 void GeoStateManager::setState(int state)
 {
-    int oldState = m_geoState;
-    m_geoState = state;
+    int oldState = getState();
+    storeState(state);
     
-    if (oldState != m_geoState) {
-        emitStateChangedSignals(oldState, m_geoState);
+    if (oldState != state) {
+        emitStateChangedSignals(oldState, state);
     }
 }
 
 void GeoStateManager::reset()
 {
-    int oldState = m_geoState;
-    m_geoState = GeoState_Initialized3D;
+    int oldState = getState();
+    storeState(GeoState_Initialized3D);
     
-    if (oldState != m_geoState) {
-        emitStateChangedSignals(oldState, m_geoState);
+    if (oldState != GeoState_Initialized3D) {
+        emitStateChangedSignals(oldState, GeoState_Initialized3D);
     }
 }
 
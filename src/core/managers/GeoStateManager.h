@@ -21,11 +21,11 @@ public:
     ~GeoStateManager() = default;
 
     // 状态查询
-    bool isStateInitialized() const { return m_geoState & GeoState_Initialized3D; }
-    bool isStateComplete() const { return m_geoState & GeoState_Complete3D; }
-    bool isStateInvalid() const { return m_geoState & GeoState_Invalid3D; }
-    bool isStateSelected() const { return m_geoState & GeoState_Selected3D; }
-    bool isStateEditing() const { return m_geoState & GeoState_Editing3D; }
+    bool isStateInitialized() const { return getState() & GeoState_Initialized3D; }
+    bool isStateComplete() const { return getState() & GeoState_Complete3D; }
+    bool isStateInvalid() const { return getState() & GeoState_Invalid3D; }
+    bool isStateSelected() const { return getState() & GeoState_Selected3D; }
+    bool isStateEditing() const { return getState() & GeoState_Editing3D; }
 
     // 状态设置
     void setStateInitialized();
@@ -40,8 +40,8 @@ public:
     void clearStateSelected();
     void clearStateEditing();
 
-    // 获取完整状态
-    int getState() const { return m_geoState; }
+    // 获取完整状态（对象加入场景后读写场景实体存储中的状态位）
+    int getState() const;
     void setState(int state);
 
     // 状态重置
@@ -68,9 +68,12 @@ signals:
 private:
     void emitStateChangedSignals(int oldState, int newState);
     bool hasStateChanged(int oldState, int newState, int stateMask) const;
+    void storeState(int state);
 
 private:
     osg::ref_ptr<Geo3D> m_parent;
-    int m_geoState;
+    int m_geoState;  // 未绑定实体存储时使用
+
+    friend class Geo3D;  // 绑定/解绑实体存储时迁移状态位
 }; 
 
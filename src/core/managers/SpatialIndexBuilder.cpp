@@ -0,0 +1,196 @@
+﻿#include "SpatialIndexBuilder.h"
+#include "GeoNodeManager.h"
+#include "../../util/Tracer.h"
+#include <osg/TriangleIndexFunctor>
+#include <QCoreApplication>
+#include <algorithm>
+
+namespace
+{
+    struct TriangleCounter
+    {
+        unsigned int count = 0;
+        void operator()(unsigned int, unsigned int, unsigned int) { ++count; }
+    };
+}
+
+SpatialIndexBuilder& SpatialIndexBuilder::getInstance()
+{
+    static SpatialIndexBuilder instance;
+    return instance;
+}
+
+SpatialIndexBuilder::SpatialIndexBuilder()
+    : m_stopRequested(false)
+    , m_processPosted(false)
+{
+}
+
+SpatialIndexBuilder::~SpatialIndexBuilder()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+        m_queue.clear();
+    }
+    m_condition.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void SpatialIndexBuilder::startWorkers()
+{
+    // 调用方已持有m_mutex；留一个核给主线程和渲染
+    const unsigned int hardwareThreads = std::max(2u, std::thread::hardware_concurrency());
+    const unsigned int workerCount = std::min(4u, hardwareThreads - 1);
+    for (unsigned int i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&SpatialIndexBuilder::workerLoop, this);
+    }
+}
+
+void SpatialIndexBuilder::submit(GeoNodeManager* owner, uint64_t generation,
+                                 osg::ref_ptr<osg::Geometry> edgeSnapshot, osg::ref_ptr<osg::Geometry> faceSnapshot)
+{
+    if (!owner || (!edgeSnapshot.valid() && !faceSnapshot.valid())) return;
+
+    auto job = std::make_shared<Job>();
+    job->owner = owner;
+    job->generation = generation;
+    job->edgeSnapshot = edgeSnapshot;
+    job->faceSnapshot = faceSnapshot;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopRequested) return;
+        if (m_workers.empty()) {
+            startWorkers();
+        }
+        m_queue.push_back(job);
+    }
+    m_condition.notify_one();
+}
+
+void SpatialIndexBuilder::cancel(GeoNodeManager* owner)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(),
+        [owner](const std::shared_ptr<Job>& job) { return job->owner == owner; }), m_queue.end());
+    m_finished.erase(std::remove_if(m_finished.begin(), m_finished.end(),
+        [owner](const std::shared_ptr<Job>& job) { return job->owner == owner; }), m_finished.end());
+
+    // 正在构建的请求无法中断，完成后不再放入m_finished
+    for (const std::shared_ptr<Job>& job : m_running) {
+        if (job->owner == owner) job->cancelled = true;
+    }
+}
+
+void SpatialIndexBuilder::processFinished()
+{
+    std::vector<std::shared_ptr<Job>> finished;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        finished.swap(m_finished);
+        m_processPosted = false;
+    }
+
+    // cancel与本函数都在主线程执行，取出的请求对应的对象仍然存活
+    for (const std::shared_ptr<Job>& job : finished) {
+        job->owner->installSpatialIndex(job->generation, job->edgeBVH, job->faceKdTree);
+    }
+}
+
+void SpatialIndexBuilder::waitForIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCondition.wait(lock, [this]() { return m_queue.empty() && m_running.empty(); });
+}
+
+size_t SpatialIndexBuilder::getPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queue.size() + m_running.size();
+}
+
+void SpatialIndexBuilder::workerLoop()
+{
+    Tracer::getInstance()->setCurrentThreadName("空间索引线程");
+
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopRequested || !m_queue.empty(); });
+            if (m_stopRequested) return;
+
+            job = m_queue.front();
+            m_queue.pop_front();
+            m_running.push_back(job);
+        }
+
+        build(*job);
+
+        bool postProcess = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running.erase(std::find(m_running.begin(), m_running.end(), job));
+            if (!job->cancelled) {
+                m_finished.push_back(job);
+                postProcess = !m_processPosted;
+                m_processPosted = true;
+            }
+            if (m_queue.empty() && m_running.empty()) {
+                m_idleCondition.notify_all();
+            }
+        }
+
+        // 排队到主线程换入（没有应用对象时由调用方手动processFinished）
+        if (postProcess && QCoreApplication::instance()) {
+            QMetaObject::invokeMethod(QCoreApplication::instance(), []() {
+                SpatialIndexBuilder::getInstance().processFinished();
+            }, Qt::QueuedConnection);
+        }
+    }
+}
+
+void SpatialIndexBuilder::build(Job& job)
+{
+    if (job.edgeSnapshot.valid()) {
+        job.edgeBVH = EdgeSegmentBVH::build(job.edgeSnapshot.get());
+    }
+
+    if (job.faceSnapshot.valid()) {
+        TRACE_ZONE("KdTree::build", "空间索引");
+        osg::ref_ptr<osg::KdTree> kdTree = new osg::KdTree;
+        osg::KdTree::BuildOptions buildOptions;
+        if (kdTree->build(buildOptions, job.faceSnapshot.get())) {
+            job.faceKdTree = kdTree;
+        }
+    }
+
+    // 快照只在构建时使用（KdTree引用的是快照的顶点数组，其余可以释放）
+    job.edgeSnapshot = nullptr;
+    job.faceSnapshot = nullptr;
+}
+
+osg::ref_ptr<osg::Geometry> SpatialIndexBuilder::snapshot(const osg::Geometry* geometry)
+{
+    if (!geometry || !geometry->getVertexArray()) return nullptr;
+
+    osg::ref_ptr<osg::Geometry> copy = new osg::Geometry();
+    copy->setVertexArray(static_cast<osg::Array*>(geometry->getVertexArray()->clone(osg::CopyOp::DEEP_COPY_ALL)));
+    for (unsigned int i = 0; i < geometry->getNumPrimitiveSets(); ++i) {
+        copy->addPrimitiveSet(static_cast<osg::PrimitiveSet*>(geometry->getPrimitiveSet(i)->clone(osg::CopyOp::DEEP_COPY_ALL)));
+    }
+    return copy;
+}
+
+unsigned int SpatialIndexBuilder::countTriangles(const osg::Geometry* geometry)
+{
+    if (!geometry) return 0;
+
+    osg::TriangleIndexFunctor<TriangleCounter> counter;
+    geometry->accept(counter);
+    return counter.count;
+}
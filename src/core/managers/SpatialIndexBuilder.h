@@ -0,0 +1,82 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include "../picking/EdgeSegmentBVH.h"
+#include <osg/Geometry>
+#include <osg/KdTree>
+#include <osg/ref_ptr>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 前向声明
+class GeoNodeManager;
+
+// 空间索引后台构建
+// 对象第一次被拾取时由GeoNodeManager::requestSpatialIndex提交：在请求线程里复制边/面几何体的
+// 顶点和图元（快照），工作线程在快照上构建线段BVH和KdTree，完成后排队回到主线程，
+// 由GeoNodeManager在场景写锁内换入；构建期间对象又被重建则丢弃结果，下次拾取重新请求。
+// 图元数低于阈值的几何体不建索引，拾取时直接逐图元求交。
+class SpatialIndexBuilder
+{
+public:
+    static SpatialIndexBuilder& getInstance();
+
+    // 低于此数量时逐图元求交比建索引更划算
+    static const unsigned int MIN_INDEXED_TRIANGLES = 512;
+    static const unsigned int MIN_INDEXED_SEGMENTS = 128;
+
+    // 提交构建请求（任意线程），两个快照可以有一个为空
+    void submit(GeoNodeManager* owner, uint64_t generation,
+                osg::ref_ptr<osg::Geometry> edgeSnapshot, osg::ref_ptr<osg::Geometry> faceSnapshot);
+
+    // 对象销毁时丢弃它尚未换入的请求（主线程）
+    void cancel(GeoNodeManager* owner);
+
+    // 换入已完成的索引（主线程）。有事件循环时自动排队调用；无界面程序可在等待后手动调用
+    void processFinished();
+
+    // 等待队列中和正在构建的请求全部完成
+    void waitForIdle();
+
+    size_t getPendingCount() const;
+
+    // 复制顶点数组和图元，供工作线程在不受主线程修改影响的副本上建索引
+    static osg::ref_ptr<osg::Geometry> snapshot(const osg::Geometry* geometry);
+    static unsigned int countTriangles(const osg::Geometry* geometry);
+
+private:
+    SpatialIndexBuilder();
+    ~SpatialIndexBuilder();
+    SpatialIndexBuilder(const SpatialIndexBuilder&) = delete;
+    SpatialIndexBuilder& operator=(const SpatialIndexBuilder&) = delete;
+
+    struct Job
+    {
+        GeoNodeManager* owner = nullptr;
+        uint64_t generation = 0;
+        osg::ref_ptr<osg::Geometry> edgeSnapshot;
+        osg::ref_ptr<osg::Geometry> faceSnapshot;
+        osg::ref_ptr<EdgeSegmentBVH> edgeBVH;
+        osg::ref_ptr<osg::KdTree> faceKdTree;
+        bool cancelled = false;
+    };
+
+    void startWorkers();
+    void workerLoop();
+    static void build(Job& job);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;      // 有新请求或停止
+    std::condition_variable m_idleCondition;  // 队列清空
+    std::deque<std::shared_ptr<Job>> m_queue;
+    std::vector<std::shared_ptr<Job>> m_running;
+    std::vector<std::shared_ptr<Job>> m_finished;
+    std::vector<std::thread> m_workers;
+    bool m_stopRequested;
+    bool m_processPosted;  // 已排队等待主线程换入
+};
@@ -0,0 +1,109 @@
+﻿#include "StateSetCache.h"
+
+StateSetCache& StateSetCache::getInstance()
+{
+    static StateSetCache instance;
+    return instance;
+}
+
+StateSetCache::StateSetCache()
+{
+    m_blendFunc = new osg::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    m_blendFunc->setDataVariance(osg::Object::STATIC);
+}
+
+osg::StateSet* StateSetCache::get(const RenderStateKey& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    osg::ref_ptr<osg::StateSet>& stateSet = m_stateSets[key];
+    if (!stateSet.valid()) {
+        stateSet = createStateSet(key);
+    }
+    return stateSet.get();
+}
+
+size_t StateSetCache::getStateSetCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stateSets.size();
+}
+
+osg::ref_ptr<osg::StateSet> StateSetCache::createStateSet(const RenderStateKey& key)
+{
+    osg::ref_ptr<osg::StateSet> stateSet = new osg::StateSet();
+    stateSet->setAttributeAndModes(getMaterial(key.color), osg::StateAttribute::ON);
+
+    if (key.pointSize > 0.0f) {
+        stateSet->setAttributeAndModes(getPoint(key.pointSize), osg::StateAttribute::ON);
+    }
+    if (key.lineWidth > 0.0f) {
+        stateSet->setAttributeAndModes(getLineWidth(key.lineWidth), osg::StateAttribute::ON);
+    }
+
+    if (key.primitive == RenderStateKey::Primitive_Points) {
+        stateSet->setMode(GL_POINT_SMOOTH, osg::StateAttribute::ON);
+    } else if (key.primitive == RenderStateKey::Primitive_Lines) {
+        stateSet->setMode(GL_LINE_SMOOTH, osg::StateAttribute::ON);
+        if (key.stipplePattern != 0) {
+            stateSet->setAttributeAndModes(getLineStipple(key.stippleFactor, key.stipplePattern), osg::StateAttribute::ON);
+        } else {
+            stateSet->setMode(GL_LINE_STIPPLE, osg::StateAttribute::OFF);
+        }
+    }
+
+    if (!key.lighting) {
+        stateSet->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+    }
+
+    // 处理透明度
+    if (key.color.a() < 1.0f) {
+        stateSet->setAttributeAndModes(m_blendFunc.get(), osg::StateAttribute::ON);
+        stateSet->setMode(GL_BLEND, osg::StateAttribute::ON);
+        stateSet->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+    }
+
+    stateSet->setDataVariance(osg::Object::STATIC);
+    return stateSet;
+}
+
+osg::Material* StateSetCache::getMaterial(const osg::Vec4& color)
+{
+    osg::ref_ptr<osg::Material>& material = m_materials[color];
+    if (!material.valid()) {
+        material = new osg::Material();
+        material->setDiffuse(osg::Material::FRONT_AND_BACK, color);
+        material->setAmbient(osg::Material::FRONT_AND_BACK, color * 0.3f);
+        material->setDataVariance(osg::Object::STATIC);
+    }
+    return material.get();
+}
+
+osg::Point* StateSetCache::getPoint(float size)
+{
+    osg::ref_ptr<osg::Point>& point = m_points[size];
+    if (!point.valid()) {
+        point = new osg::Point(size);
+        point->setDataVariance(osg::Object::STATIC);
+    }
+    return point.get();
+}
+
+osg::LineWidth* StateSetCache::getLineWidth(float width)
+{
+    osg::ref_ptr<osg::LineWidth>& lineWidth = m_lineWidths[width];
+    if (!lineWidth.valid()) {
+        lineWidth = new osg::LineWidth(width);
+        lineWidth->setDataVariance(osg::Object::STATIC);
+    }
+    return lineWidth.get();
+}
+
+osg::LineStipple* StateSetCache::getLineStipple(int factor, unsigned short pattern)
+{
+    osg::ref_ptr<osg::LineStipple>& stipple = m_lineStipples[std::make_pair(factor, pattern)];
+    if (!stipple.valid()) {
+        stipple = new osg::LineStipple(factor, pattern);
+        stipple->setDataVariance(osg::Object::STATIC);
+    }
+    return stipple.get();
+}
@@ -0,0 +1,76 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <osg/BlendFunc>
+#include <osg/LineStipple>
+#include <osg/LineWidth>
+#include <osg/Material>
+#include <osg/Point>
+#include <osg/StateSet>
+#include <osg/Vec4>
+#include <osg/ref_ptr>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+// 渲染状态组合：颜色（alpha<1时自动开启混合并进入透明渲染队列）、线宽、线型、点大小、光照
+struct RenderStateKey
+{
+    enum Primitive
+    {
+        Primitive_Points,   // 开启点平滑
+        Primitive_Lines,    // 开启线平滑
+        Primitive_Surface
+    };
+
+    Primitive primitive = Primitive_Surface;
+    osg::Vec4 color = osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    float pointSize = 0.0f;                // 0表示不设置
+    float lineWidth = 0.0f;                // 0表示不设置
+    unsigned short stipplePattern = 0;     // 0表示实线（显式关闭点画）
+    int stippleFactor = 1;
+    bool lighting = true;
+
+    bool operator<(const RenderStateKey& other) const
+    {
+        return std::tie(primitive, color, pointSize, lineWidth, stipplePattern, stippleFactor, lighting)
+             < std::tie(other.primitive, other.color, other.pointSize, other.lineWidth, other.stipplePattern, other.stippleFactor, other.lighting);
+    }
+};
+
+// 享元StateSet缓存
+// 相同组合返回同一个StateSet，StateSet内的Material/Point/LineWidth/LineStipple/BlendFunc
+// 也按值共享。返回的StateSet不可修改：参数变化时换用另一个组合的StateSet，
+// 这样OSG状态图中相同状态的对象共用一个状态节点，不会产生重复的GL状态切换。
+// 条目只增不删，可在工作线程中调用。
+class StateSetCache
+{
+public:
+    static StateSetCache& getInstance();
+
+    osg::StateSet* get(const RenderStateKey& key);
+
+    size_t getStateSetCount() const;
+
+private:
+    StateSetCache();
+    StateSetCache(const StateSetCache&) = delete;
+    StateSetCache& operator=(const StateSetCache&) = delete;
+
+    osg::ref_ptr<osg::StateSet> createStateSet(const RenderStateKey& key);
+
+    // 以下属性按值共享，调用方已持有m_mutex
+    osg::Material* getMaterial(const osg::Vec4& color);
+    osg::Point* getPoint(float size);
+    osg::LineWidth* getLineWidth(float width);
+    osg::LineStipple* getLineStipple(int factor, unsigned short pattern);
+
+    mutable std::mutex m_mutex;
+    std::map<RenderStateKey, osg::ref_ptr<osg::StateSet>> m_stateSets;
+
+    std::map<osg::Vec4, osg::ref_ptr<osg::Material>> m_materials;
+    std::map<float, osg::ref_ptr<osg::Point>> m_points;
+    std::map<float, osg::ref_ptr<osg::LineWidth>> m_lineWidths;
+    std::map<std::pair<int, unsigned short>, osg::ref_ptr<osg::LineStipple>> m_lineStipples;
+    osg::ref_ptr<osg::BlendFunc> m_blendFunc;
+};
@@ -0,0 +1,130 @@
+﻿#include "AsyncPickingService.h"
+#include "../../util/LogManager.h"
+#include "../../util/Tracer.h"
+#include <QMetaType>
+
+// ============================================================================
+// AsyncPickingService Implementation
+// ============================================================================
+
+AsyncPickingService::AsyncPickingService(QObject* parent)
+    : QThread(parent)
+{
+    qRegisterMetaType<PickResult>("PickResult");
+}
+
+AsyncPickingService::~AsyncPickingService()
+{
+    shutdown();
+}
+
+bool AsyncPickingService::initialize(osg::Camera* camera, osg::Group* sceneRoot, const SceneBVH* sceneBVH, SceneLock* sceneLock)
+{
+    if (!camera || !sceneRoot || !sceneLock) {
+        LOG_ERROR("异步拾取服务初始化参数无效", "拾取");
+        return false;
+    }
+    
+    m_pickingSystem = new GeometryPickingSystem();
+    if (!m_pickingSystem->initialize(camera, sceneRoot)) {
+        m_pickingSystem = nullptr;
+        return false;
+    }
+    m_pickingSystem->setConfig(getConfig());
+    m_pickingSystem->setSceneBVH(sceneBVH);
+    m_sceneLock = sceneLock;
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopRequested = false;
+        m_hasPendingRequest = false;
+    }
+    
+    start();
+    LOG_SUCCESS("异步拾取服务已启动", "拾取");
+    return true;
+}
+
+void AsyncPickingService::shutdown()
+{
+    if (!isRunning()) return;
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopRequested = true;
+        m_hasPendingRequest = false;
+        m_condition.wakeAll();
+    }
+    
+    wait();
+    
+    if (m_pickingSystem) {
+        m_pickingSystem->shutdown();
+        m_pickingSystem = nullptr;
+    }
+    
+    LOG_INFO(QString("异步拾取服务已停止，丢弃过期请求%1个").arg(m_droppedRequestCount.load()), "拾取");
+}
+
+quint64 AsyncPickingService::requestPick(int mouseX, int mouseY, const PickCameraState& cameraState)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    // 上一个请求还没被取走，说明已经过期，直接覆盖
+    if (m_hasPendingRequest) {
+        ++m_droppedRequestCount;
+    }
+    
+    m_pendingRequest.requestId = ++m_nextRequestId;
+    m_pendingRequest.mouseX = mouseX;
+    m_pendingRequest.mouseY = mouseY;
+    m_pendingRequest.cameraState = cameraState;
+    m_hasPendingRequest = true;
+    
+    m_condition.wakeOne();
+    return m_pendingRequest.requestId;
+}
+
+void AsyncPickingService::setConfig(const PickConfig& config)
+{
+    QMutexLocker locker(&m_mutex);
+    m_config = config;
+}
+
+PickConfig AsyncPickingService::getConfig() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_config;
+}
+
+void AsyncPickingService::run()
+{
+    Tracer::getInstance()->setCurrentThreadName("拾取线程");
+
+    while (true) {
+        AsyncPickRequest request;
+        PickConfig config;
+        
+        // 等待新请求
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_hasPendingRequest && !m_stopRequested) {
+                m_condition.wait(&m_mutex);
+            }
+            if (m_stopRequested) break;
+            
+            request = m_pendingRequest;
+            m_pendingRequest.cameraState = PickCameraState();
+            m_hasPendingRequest = false;
+            config = m_config;
+        }
+        
+        // 遍历期间持有场景读锁，主线程修改场景时会等待本次拾取结束。
+        // 结果也在锁内发出并释放，保证Geo3D的最后一个引用不会在工作线程中释放。
+        QReadLocker sceneLocker(m_sceneLock);
+        m_pickingSystem->setConfig(config);
+        PickResult result = m_pickingSystem->pickGeometry(request.mouseX, request.mouseY, request.cameraState);
+        emit pickingFinished(result, request.requestId);
+        result.reset();
+    }
+}
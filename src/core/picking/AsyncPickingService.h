@@ -0,0 +1,70 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include "GeometryPickingSystem.h"
+#include "PickingTypes.h"
+#include "../SceneLock.h"
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <osg/Group>
+#include <atomic>
+
+// 异步拾取请求（主线程采集的鼠标位置 + 相机快照）
+struct AsyncPickRequest
+{
+    quint64 requestId = 0;
+    int mouseX = 0;
+    int mouseY = 0;
+    PickCameraState cameraState;
+};
+
+// 异步拾取服务 - 在后台线程执行悬停拾取
+// 只保留最新的一个请求（latest-wins），尚未执行的旧请求直接被覆盖丢弃；
+// 结果通过pickingFinished信号排队回到主线程。
+class AsyncPickingService : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit AsyncPickingService(QObject* parent = nullptr);
+    ~AsyncPickingService();
+    
+    // 初始化：后台线程使用独立的拾取系统实例，与主线程共享同一场景根节点；
+    // 每次遍历持有sceneLock的读锁，主线程修改该场景的子图时持有写锁
+    bool initialize(osg::Camera* camera, osg::Group* sceneRoot, const SceneBVH* sceneBVH, SceneLock* sceneLock);
+    void shutdown();
+    
+    // 提交拾取请求（主线程调用，不阻塞），返回请求ID
+    quint64 requestPick(int mouseX, int mouseY, const PickCameraState& cameraState);
+    
+    // 配置
+    void setConfig(const PickConfig& config);
+    PickConfig getConfig() const;
+    
+    // 统计信息
+    quint64 getLatestRequestId() const { return m_nextRequestId.load(); }
+    quint64 getDroppedRequestCount() const { return m_droppedRequestCount.load(); }
+
+signals:
+    void pickingFinished(const PickResult& result, quint64 requestId);
+
+protected:
+    void run() override;
+
+private:
+    // 后台拾取系统（只在工作线程中使用）
+    osg::ref_ptr<GeometryPickingSystem> m_pickingSystem;
+    SceneLock* m_sceneLock = nullptr;
+    
+    // 待处理请求（只保留最新的一个）
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    AsyncPickRequest m_pendingRequest;
+    bool m_hasPendingRequest = false;
+    bool m_stopRequested = false;
+    PickConfig m_config;
+    
+    std::atomic<quint64> m_nextRequestId{ 0 };
+    std::atomic<quint64> m_droppedRequestCount{ 0 };
+};
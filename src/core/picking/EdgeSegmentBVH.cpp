@@ -0,0 +1,418 @@
+﻿#include "EdgeSegmentBVH.h"
+#include "../../util/MathUtils.h"
+#include "../../util/Tracer.h"
+#include <osg/PrimitiveSet>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    const uint32_t kMaxLeafSegments = 4;
+
+    bool readVertex(const osg::Array* array, unsigned int index, osg::Vec3f& vertex)
+    {
+        if (!array || index >= array->getNumElements()) return false;
+
+        switch (array->getType()) {
+            case osg::Array::Vec3ArrayType:
+                vertex = (*static_cast<const osg::Vec3Array*>(array))[index];
+                return true;
+            case osg::Array::Vec3dArrayType:
+                vertex = osg::Vec3f((*static_cast<const osg::Vec3dArray*>(array))[index]);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // 把线性函数d(t) >= 0的部分收窄到[t0, t1]，d(0) = da, d(1) = db
+    bool clipParameter(double da, double db, double& t0, double& t1)
+    {
+        if (da < 0.0 && db < 0.0) return false;
+        if (da < 0.0) {
+            t0 = std::max(t0, da / (da - db));
+        } else if (db < 0.0) {
+            t1 = std::min(t1, da / (da - db));
+        }
+        return t0 <= t1;
+    }
+
+    osg::Vec3d clipToWindow(const osg::Vec4d& clip, const osg::Matrixd& windowMatrix)
+    {
+        const double invW = 1.0 / clip.w();
+        return osg::Vec3d(clip.x() * invW, clip.y() * invW, clip.z() * invW) * windowMatrix;
+    }
+
+    // 线段先按近/远裁剪面裁剪，再在屏幕上求离(x, y)最近的点，最后换算回三维参数
+    bool projectToWindow(const osg::Vec3d& start, const osg::Vec3d& end,
+                         const osg::Matrixd& localToClip, const osg::Matrixd& windowMatrix,
+                         double x, double y, EdgeSegmentBVH::Hit& hit)
+    {
+        const osg::Vec4d clipStart = osg::Vec4d(start, 1.0) * localToClip;
+        const osg::Vec4d clipEnd = osg::Vec4d(end, 1.0) * localToClip;
+
+        // 近裁剪面 z >= -w，远裁剪面 z <= w
+        double t0 = 0.0;
+        double t1 = 1.0;
+        if (!clipParameter(clipStart.z() + clipStart.w(), clipEnd.z() + clipEnd.w(), t0, t1)) return false;
+        if (!clipParameter(clipStart.w() - clipStart.z(), clipEnd.w() - clipEnd.z(), t0, t1)) return false;
+
+        const osg::Vec4d clip0 = clipStart + (clipEnd - clipStart) * t0;
+        const osg::Vec4d clip1 = clipStart + (clipEnd - clipStart) * t1;
+        if (clip0.w() <= 0.0 || clip1.w() <= 0.0) return false;
+
+        const osg::Vec3d screen0 = clipToWindow(clip0, windowMatrix);
+        const osg::Vec3d screen1 = clipToWindow(clip1, windowMatrix);
+
+        const double dx = screen1.x() - screen0.x();
+        const double dy = screen1.y() - screen0.y();
+        const double length2 = dx * dx + dy * dy;
+        double s = 0.0;
+        if (length2 > 0.0) {
+            s = ((x - screen0.x()) * dx + (y - screen0.y()) * dy) / length2;
+            s = std::max(0.0, std::min(1.0, s));
+        }
+
+        const double px = screen0.x() + s * dx;
+        const double py = screen0.y() + s * dy;
+        hit.pixelDistance = std::sqrt((x - px) * (x - px) + (y - py) * (y - py));
+        hit.depth = screen0.z() + s * (screen1.z() - screen0.z());
+
+        // 屏幕上的线性参数s对应三维参数需做透视校正：u = s*w0 / ((1-s)*w1 + s*w0)
+        const double denominator = (1.0 - s) * clip1.w() + s * clip0.w();
+        const double u = denominator > 0.0 ? s * clip0.w() / denominator : s;
+        hit.parameter = t0 + u * (t1 - t0);
+        hit.localPoint = start + (end - start) * hit.parameter;
+        return true;
+    }
+
+    // 查询线段与一条线段的最近点，距离不超过tolerance时填写hit（segmentIndex由调用方填写）
+    bool closestApproach(const osg::Vec3d& start, const osg::Vec3d& end, const osg::Vec3d& segmentStart, const osg::Vec3d& segmentEnd,
+                         double tolerance, EdgeSegmentBVH::RayHit& hit)
+    {
+        double rayParameter = 0.0;
+        double parameter = 0.0;
+        const double distance2 = MathUtils::closestPointsBetweenSegments(
+            glm::dvec3(start.x(), start.y(), start.z()), glm::dvec3(end.x(), end.y(), end.z()),
+            glm::dvec3(segmentStart.x(), segmentStart.y(), segmentStart.z()), glm::dvec3(segmentEnd.x(), segmentEnd.y(), segmentEnd.z()),
+            rayParameter, parameter);
+        if (distance2 > tolerance * tolerance) return false;
+
+        hit.parameter = parameter;
+        hit.rayParameter = rayParameter;
+        hit.distance = std::sqrt(distance2);
+        hit.localPoint = segmentStart + (segmentEnd - segmentStart) * parameter;
+        return true;
+    }
+
+    // 查询线段是否穿过外扩tolerance的包围盒，只看参数[0, tMax]部分
+    bool segmentNearBox(const osg::Vec3d& start, const osg::Vec3d& end, const osg::BoundingBox& box, double tolerance, double tMax)
+    {
+        double t0 = 0.0;
+        double t1 = tMax;
+        const osg::Vec3d direction = end - start;
+        for (int axis = 0; axis < 3; ++axis) {
+            const double minimum = box._min[axis] - tolerance;
+            const double maximum = box._max[axis] + tolerance;
+            if (direction[axis] == 0.0) {
+                if (start[axis] < minimum || start[axis] > maximum) return false;
+                continue;
+            }
+            double tNear = (minimum - start[axis]) / direction[axis];
+            double tFar = (maximum - start[axis]) / direction[axis];
+            if (tNear > tFar) std::swap(tNear, tFar);
+            t0 = std::max(t0, tNear);
+            t1 = std::min(t1, tFar);
+            if (t0 > t1) return false;
+        }
+        return true;
+    }
+
+    // 按线图元顺序遍历线段，visit(a, b)收到两端顶点下标；非线图元不计入线段编号
+    template <typename Visitor>
+    void forEachSegment(const osg::Geometry* geometry, Visitor visit)
+    {
+        for (unsigned int p = 0; p < geometry->getNumPrimitiveSets(); ++p) {
+            const osg::PrimitiveSet* primitive = geometry->getPrimitiveSet(p);
+            const unsigned int count = primitive->getNumIndices();
+
+            switch (primitive->getMode()) {
+                case osg::PrimitiveSet::LINES:
+                    for (unsigned int i = 0; i + 1 < count; i += 2) {
+                        visit(primitive->index(i), primitive->index(i + 1));
+                    }
+                    break;
+                case osg::PrimitiveSet::LINE_STRIP:
+                case osg::PrimitiveSet::LINE_LOOP:
+                    for (unsigned int i = 0; i + 1 < count; ++i) {
+                        visit(primitive->index(i), primitive->index(i + 1));
+                    }
+                    if (primitive->getMode() == osg::PrimitiveSet::LINE_LOOP && count > 2) {
+                        visit(primitive->index(count - 1), primitive->index(0));
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+osg::ref_ptr<EdgeSegmentBVH> EdgeSegmentBVH::build(const osg::Geometry* geometry)
+{
+    if (!geometry || !geometry->getVertexArray()) return nullptr;
+
+    TRACE_ZONE("EdgeSegmentBVH::build", "空间索引");
+
+    osg::ref_ptr<EdgeSegmentBVH> bvh = new EdgeSegmentBVH();
+    const osg::Array* vertices = geometry->getVertexArray();
+    uint32_t segmentIndex = 0;
+
+    forEachSegment(geometry, [&](unsigned int a, unsigned int b) {
+        Segment segment;
+        segment.index = segmentIndex++;
+        if (readVertex(vertices, a, segment.start) && readVertex(vertices, b, segment.end)) {
+            bvh->m_segments.push_back(segment);
+        }
+    });
+
+    if (bvh->m_segments.empty()) return nullptr;
+
+    bvh->m_nodes.reserve(2 * bvh->m_segments.size() / kMaxLeafSegments + 1);
+    bvh->buildNode(0, static_cast<uint32_t>(bvh->m_segments.size()));
+    return bvh;
+}
+
+void EdgeSegmentBVH::buildNode(uint32_t first, uint32_t count)
+{
+    const uint32_t nodeIndex = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back(Node());
+
+    osg::BoundingBox box;
+    osg::BoundingBox centroids;
+    for (uint32_t i = first; i < first + count; ++i) {
+        box.expandBy(m_segments[i].start);
+        box.expandBy(m_segments[i].end);
+        centroids.expandBy((m_segments[i].start + m_segments[i].end) * 0.5f);
+    }
+    m_nodes[nodeIndex].box = box;
+
+    const osg::Vec3f extent = centroids._max - centroids._min;
+    if (count <= kMaxLeafSegments || extent.length2() == 0.0f) {
+        m_nodes[nodeIndex].first = first;
+        m_nodes[nodeIndex].count = count;
+        return;
+    }
+
+    // 质心包围盒的最长轴上按中位数对半分
+    int axis = 0;
+    if (extent.y() > extent[axis]) axis = 1;
+    if (extent.z() > extent[axis]) axis = 2;
+
+    const uint32_t half = count / 2;
+    std::nth_element(m_segments.begin() + first, m_segments.begin() + first + half, m_segments.begin() + first + count,
+        [axis](const Segment& a, const Segment& b) {
+            return a.start[axis] + a.end[axis] < b.start[axis] + b.end[axis];
+        });
+
+    buildNode(first, half);
+    m_nodes[nodeIndex].rightChild = static_cast<uint32_t>(m_nodes.size());
+    buildNode(first + half, count - half);
+}
+
+bool EdgeSegmentBVH::pickClosest(const osg::Matrixd& localToClip, const osg::Matrixd& windowMatrix,
+                                 double x, double y, double radius, Hit& hit) const
+{
+    if (m_nodes.empty()) return false;
+
+    bool found = false;
+    double searchRadius = radius;
+
+    uint32_t stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const Node& node = m_nodes[stack[--stackSize]];
+        if (!overlapsWindow(node.box, localToClip, windowMatrix, x, y, searchRadius)) continue;
+
+        if (node.count == 0) {
+            const uint32_t left = static_cast<uint32_t>(&node - m_nodes.data()) + 1;
+            if (stackSize + 2 > 64) continue;  // 中位数划分的树深度约为log2(n/4)，不会到这里
+            stack[stackSize++] = node.rightChild;
+            stack[stackSize++] = left;
+            continue;
+        }
+
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            const Segment& segment = m_segments[i];
+            Hit candidate;
+            if (!projectToWindow(osg::Vec3d(segment.start), osg::Vec3d(segment.end), localToClip, windowMatrix, x, y, candidate)) continue;
+            if (candidate.pixelDistance > radius) continue;
+
+            candidate.segmentIndex = static_cast<int>(segment.index);
+            if (!found || isCloser(candidate, hit)) {
+                hit = candidate;
+                found = true;
+                // 之后只需找屏幕距离不超过当前最近+1像素的线段
+                searchRadius = std::min(radius, hit.pixelDistance + 1.0);
+            }
+        }
+    }
+    return found;
+}
+
+bool EdgeSegmentBVH::intersectSegment(const osg::Vec3d& start, const osg::Vec3d& end, double tolerance, RayHit& hit) const
+{
+    if (m_nodes.empty()) return false;
+
+    bool found = false;
+
+    uint32_t stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const Node& node = m_nodes[stack[--stackSize]];
+        // 已有命中时只需看查询线段上更靠前的部分
+        if (!segmentNearBox(start, end, node.box, tolerance, found ? hit.rayParameter : 1.0)) continue;
+
+        if (node.count == 0) {
+            const uint32_t left = static_cast<uint32_t>(&node - m_nodes.data()) + 1;
+            if (stackSize + 2 > 64) continue;
+            stack[stackSize++] = node.rightChild;
+            stack[stackSize++] = left;
+            continue;
+        }
+
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            const Segment& segment = m_segments[i];
+            RayHit candidate;
+            if (!closestApproach(start, end, osg::Vec3d(segment.start), osg::Vec3d(segment.end), tolerance, candidate)) continue;
+
+            candidate.segmentIndex = static_cast<int>(segment.index);
+            if (!found || candidate.rayParameter < hit.rayParameter) {
+                hit = candidate;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+bool EdgeSegmentBVH::intersectSegment(const osg::Geometry* geometry, const osg::Vec3d& start, const osg::Vec3d& end,
+                                      double tolerance, RayHit& hit)
+{
+    if (!geometry || !geometry->getVertexArray()) return false;
+
+    const osg::Array* vertices = geometry->getVertexArray();
+    bool found = false;
+    int segmentIndex = 0;
+
+    forEachSegment(geometry, [&](unsigned int a, unsigned int b) {
+        const int index = segmentIndex++;
+        osg::Vec3f segmentStart, segmentEnd;
+        if (!readVertex(vertices, a, segmentStart) || !readVertex(vertices, b, segmentEnd)) return;
+
+        RayHit candidate;
+        if (!closestApproach(start, end, osg::Vec3d(segmentStart), osg::Vec3d(segmentEnd), tolerance, candidate)) return;
+
+        candidate.segmentIndex = index;
+        if (!found || candidate.rayParameter < hit.rayParameter) {
+            hit = candidate;
+            found = true;
+        }
+    });
+    return found;
+}
+
+size_t EdgeSegmentBVH::countSegments(const osg::Geometry* geometry)
+{
+    if (!geometry) return 0;
+
+    size_t count = 0;
+    forEachSegment(geometry, [&count](unsigned int, unsigned int) { ++count; });
+    return count;
+}
+
+bool EdgeSegmentBVH::pickClosest(const osg::Geometry* geometry, const osg::Matrixd& localToClip, const osg::Matrixd& windowMatrix,
+                                 double x, double y, double radius, Hit& hit)
+{
+    if (!geometry || !geometry->getVertexArray()) return false;
+
+    const osg::Array* vertices = geometry->getVertexArray();
+    bool found = false;
+    int segmentIndex = 0;
+
+    forEachSegment(geometry, [&](unsigned int a, unsigned int b) {
+        const int index = segmentIndex++;
+        osg::Vec3f start, end;
+        if (!readVertex(vertices, a, start) || !readVertex(vertices, b, end)) return;
+
+        Hit candidate;
+        if (!projectToWindow(osg::Vec3d(start), osg::Vec3d(end), localToClip, windowMatrix, x, y, candidate)) return;
+        if (candidate.pixelDistance > radius) return;
+
+        candidate.segmentIndex = index;
+        if (!found || isCloser(candidate, hit)) {
+            hit = candidate;
+            found = true;
+        }
+    });
+    return found;
+}
+
+void EdgeSegmentBVH::collectSegments(const osg::Geometry* geometry, std::vector<osg::Vec3f>& points)
+{
+    if (!geometry || !geometry->getVertexArray()) return;
+
+    const osg::Array* vertices = geometry->getVertexArray();
+    forEachSegment(geometry, [&](unsigned int a, unsigned int b) {
+        osg::Vec3f start, end;
+        if (readVertex(vertices, a, start) && readVertex(vertices, b, end)) {
+            points.push_back(start);
+            points.push_back(end);
+        }
+    });
+}
+
+bool EdgeSegmentBVH::projectSegment(const osg::Vec3d& start, const osg::Vec3d& end,
+                                    const osg::Matrixd& localToClip, const osg::Matrixd& windowMatrix,
+                                    double x, double y, Hit& hit)
+{
+    return projectToWindow(start, end, localToClip, windowMatrix, x, y, hit);
+}
+
+bool EdgeSegmentBVH::overlapsWindow(const osg::BoundingBox& box, const osg::Matrixd& localToClip, const osg::Matrixd& windowMatrix,
+                                    double x, double y, double radius) const
+{
+    double minX = DBL_MAX, minY = DBL_MAX, maxX = -DBL_MAX, maxY = -DBL_MAX;
+    bool allNear = true;
+    bool allFar = true;
+
+    for (unsigned int corner = 0; corner < 8; ++corner) {
+        const osg::Vec4d clip = osg::Vec4d(osg::Vec3d(box.corner(corner)), 1.0) * localToClip;
+        if (clip.w() <= 0.0) return true;  // 跨过相机平面，无法投影，保守地进入
+
+        allNear = allNear && clip.z() < -clip.w();
+        allFar = allFar && clip.z() > clip.w();
+
+        const osg::Vec3d window = clipToWindow(clip, windowMatrix);
+        minX = std::min(minX, window.x());
+        minY = std::min(minY, window.y());
+        maxX = std::max(maxX, window.x());
+        maxY = std::max(maxY, window.y());
+    }
+
+    if (allNear || allFar) return false;
+    return x + radius >= minX && x - radius <= maxX && y + radius >= minY && y - radius <= maxY;
+}
+
+bool EdgeSegmentBVH::isCloser(const Hit& a, const Hit& b)
+{
+    if (std::abs(a.pixelDistance - b.pixelDistance) > 1.0) {
+        return a.pixelDistance < b.pixelDistance;
+    }
+    return a.depth < b.depth;
+}
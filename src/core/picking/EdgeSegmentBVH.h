@@ -0,0 +1,104 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <osg/BoundingBox>
+#include <osg/Geometry>
+#include <osg/Matrixd>
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <cstdint>
+#include <vector>
+
+// 边几何体的线段BVH
+// osg::KdTree只处理三角形，对边几何体不起作用，多面体拾取器仍要逐条测试密集圆弧、
+// 贝塞尔曲线和球面线框的每一段。这里把LINES/LINE_STRIP/LINE_LOOP拆成线段，
+// 按质心在最长轴上对半划分建树（叶子最多4条线段），查询时把节点包围盒投影到窗口，
+// 只进入覆盖拾取窗口的节点，在像素空间求离鼠标最近的线段。
+// 坐标为几何体局部坐标，由SpatialIndexBuilder在后台构建，建好后只读。
+class EdgeSegmentBVH : public osg::Referenced
+{
+public:
+    struct Hit
+    {
+        int segmentIndex = -1;        // 按线图元顺序的线段编号
+        double parameter = 0.0;       // 线段上的参数位置（0为起点，1为终点）
+        osg::Vec3d localPoint;        // 线段上离鼠标最近的点（局部坐标）
+        double pixelDistance = 0.0;   // 到鼠标的屏幕距离（像素）
+        double depth = 1.0;           // 窗口深度，0为近平面
+    };
+
+    // 从线图元提取线段并建树，没有线段时返回空
+    static osg::ref_ptr<EdgeSegmentBVH> build(const osg::Geometry* geometry);
+
+    // 窗口坐标(x, y)周围radius像素内屏幕距离最近的线段（相差不到1像素时取深度近的）
+    // localToClip: 局部坐标 -> 裁剪坐标；windowMatrix: NDC -> 窗口坐标（Viewport::computeWindowMatrix）
+    bool pickClosest(const osg::Matrixd& localToClip, const osg::Matrixd& windowMatrix,
+                     double x, double y, double radius, Hit& hit) const;
+
+    // 不建树，逐条线段测试（线段数低于建索引阈值或索引尚未建好时使用），结果与上面一致
+    static bool pickClosest(const osg::Geometry* geometry, const osg::Matrixd& localToClip, const osg::Matrixd& windowMatrix,
+                            double x, double y, double radius, Hit& hit);
+
+    // 三维邻近查询的结果（用于批量射线查询，坐标为局部坐标）
+    struct RayHit
+    {
+        int segmentIndex = -1;        // 按线图元顺序的线段编号
+        double parameter = 0.0;       // 线段上的参数位置
+        double rayParameter = 0.0;    // 查询线段上的参数位置（0为start，1为end）
+        double distance = 0.0;        // 两条线段的最近距离
+        osg::Vec3d localPoint;        // 线段上离查询线段最近的点
+    };
+
+    // 与查询线段(start, end)距离不超过tolerance的线段中，沿查询线段最先到达的一条
+    bool intersectSegment(const osg::Vec3d& start, const osg::Vec3d& end, double tolerance, RayHit& hit) const;
+
+    // 不建树，逐条线段测试，结果与上面一致
+    static bool intersectSegment(const osg::Geometry* geometry, const osg::Vec3d& start, const osg::Vec3d& end,
+                                 double tolerance, RayHit& hit);
+
+    // 线图元包含的线段数
+    static size_t countSegments(const osg::Geometry* geometry);
+    
+    // 按线段编号顺序取出所有线段，points中每两个点为一条线段
+    static void collectSegments(const osg::Geometry* geometry, std::vector<osg::Vec3f>& points);
+    
+    // 单条线段：近/远裁剪后在屏幕上求离(x, y)最近的点（不限距离，由调用方比较pixelDistance）
+    static bool projectSegment(const osg::Vec3d& start, const osg::Vec3d& end,
+                               const osg::Matrixd& localToClip, const osg::Matrixd& windowMatrix,
+                               double x, double y, Hit& hit);
+
+    size_t getSegmentCount() const { return m_segments.size(); }
+    size_t getNodeCount() const { return m_nodes.size(); }
+
+    // 屏幕距离优先、深度其次的比较（供跨几何体选取最近结果）
+    static bool isCloser(const Hit& a, const Hit& b);
+
+protected:
+    ~EdgeSegmentBVH() = default;
+
+private:
+    EdgeSegmentBVH() = default;
+
+    struct Segment
+    {
+        osg::Vec3f start;
+        osg::Vec3f end;
+        uint32_t index;
+    };
+
+    // 先序存放：左孩子紧跟在父节点之后，右孩子为rightChild；count > 0为叶子
+    struct Node
+    {
+        osg::BoundingBox box;
+        uint32_t first = 0;
+        uint32_t count = 0;
+        uint32_t rightChild = 0;
+    };
+
+    void buildNode(uint32_t first, uint32_t count);
+    bool overlapsWindow(const osg::BoundingBox& box, const osg::Matrixd& localToClip, const osg::Matrixd& windowMatrix,
+                        double x, double y, double radius) const;
+
+    std::vector<Segment> m_segments;
+    std::vector<Node> m_nodes;
+};
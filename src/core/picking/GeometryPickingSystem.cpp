@@ -1,7 +1,12 @@
 ﻿#include "GeometryPickingSystem.h"
+#include "ScreenVertexGrid.h"
+#include "EdgeSegmentBVH.h"
 #include "../GeometryBase.h"
 #include "../managers/GeoNodeManager.h"
+#include "../world/SceneBVH.h"
+#include "../world/PerformanceMonitor.h"
 #include "../../util/LogManager.h"
+#include "../../util/Tracer.h"
 #include <osg/Timer>
 #include <osgViewer/Viewer>
 #include <osgGA/GUIEventAdapter>
@@ -45,6 +50,7 @@ void GeometryPickingSystem::shutdown()
     
     m_camera = nullptr;
     m_sceneRoot = nullptr;
+    m_vertexGrid.reset();
     m_initialized = false;
     
     LOG_INFO("拾取系统已关闭", "拾取");
@@ -57,27 +63,399 @@ PickResult GeometryPickingSystem::pickGeometry(int mouseX, int mouseY)
         return PickResult();
     }
     
+    return pickGeometry(mouseX, mouseY, captureCameraState());
+}
+
+PickCameraState GeometryPickingSystem::captureCameraState() const
+{
+    PickCameraState state;
+    if (!m_camera || !m_camera->getViewport()) return state;
+    
+    state.viewport = new osg::Viewport(*m_camera->getViewport());
+    state.projectionMatrix = m_camera->getProjectionMatrix();
+    state.viewMatrix = m_camera->getViewMatrix();
+    return state;
+}
+
+PickResult GeometryPickingSystem::pickGeometry(int mouseX, int mouseY, const PickCameraState& cameraState)
+{
+    TRACE_ZONE("GeometryPickingSystem::pickGeometry", "拾取");
+    PickLatencyScope pickLatency;
+
+    if (!m_initialized) {
+        LOG_ERROR("拾取系统未初始化", "拾取");
+        return PickResult();
+    }
+    
+    if (!cameraState.isValid()) {
+        return PickResult();
+    }
+    
     // 清空之前的结果
     m_singleResults.clear();
+    m_cameraState = cameraState;
     
 
     /**
         因为正在绘制的几何的临时点一直跟踪鼠标，所有要避免临时点以及刚画的线、面不被一直选中而干扰其他几何的选择。
         只能妥协暂时不加入选中当前在绘制的节点。
     */
+    // 0. BVH粗筛，拾取锥体外的对象不参与遍历
+    m_useCandidates = collectCandidateNodes(mouseX, mouseY, cameraState);
+    if (m_useCandidates && m_candidateNodes.empty()) {
+        PickResult result;
+        result.screenX = mouseX;
+        result.screenY = mouseY;
+        return result;
+    }
+    
+    // 1~3. 面/顶点/边拾取
+    if (m_config.useHybridTraversal) {
+        pickWithHybridTraversal(mouseX, mouseY, cameraState);
+    } else {
+        pickWithSeparateTraversals(mouseX, mouseY, cameraState);
+    }
+    if (m_config.enableVertexPicking && m_config.useVertexGrid) {
+        pickVerticesWithGrid(mouseX, mouseY, cameraState);
+    }
+    
+    // 4. 比较距离和优先级，选择最佳结果
+    PickResult result = selectBestSingleResult();
+    result.screenX = mouseX;
+    result.screenY = mouseY;
+    
+    // 交点不再需要，及时释放对场景Drawable的引用
+    m_singleResults.clear();
+    m_candidateNodes.clear();
+    
+    // 调用回调
+    if (result.hasResult && m_pickingCallback) {
+        m_pickingCallback(result);
+    }
+    
+    return result;
+}
+
+// ============= 单次遍历混合拾取 =============
+
+namespace
+{
+    // 线段与包围盒求交（slab法），坐标均为几何体局部坐标
+    bool segmentIntersectsBox(const osg::Vec3d& start, const osg::Vec3d& end, const osg::BoundingBox& box)
+    {
+        if (!box.valid()) return false;
+        
+        double t0 = 0.0;
+        double t1 = 1.0;
+        const osg::Vec3d direction = end - start;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (direction[axis] == 0.0) {
+                if (start[axis] < box._min[axis] || start[axis] > box._max[axis]) return false;
+                continue;
+            }
+            double tNear = (box._min[axis] - start[axis]) / direction[axis];
+            double tFar = (box._max[axis] - start[axis]) / direction[axis];
+            if (tNear > tFar) std::swap(tNear, tFar);
+            t0 = std::max(t0, tNear);
+            t1 = std::min(t1, tFar);
+            if (t0 > t1) return false;
+        }
+        return true;
+    }
+    
+    // 射线穿过面几何体的包围盒时请求后台构建KdTree，建好前由射线拾取器逐三角形求交
+    void requestFaceIndex(osgUtil::Intersector* intersector, osg::Drawable& drawable)
+    {
+        if ((drawable.getNodeMask() & NODE_MASK_FACE) == 0) return;
+        
+        Geo3D* geo = dynamic_cast<Geo3D*>(drawable.getUserData());
+        if (!geo || !geo->mm_node()->needsSpatialIndex()) return;
+        
+        osgUtil::LineSegmentIntersector* ray = dynamic_cast<osgUtil::LineSegmentIntersector*>(intersector);
+        if (!ray || !segmentIntersectsBox(ray->getStart(), ray->getEnd(), drawable.getBoundingBox())) return;
+        
+        geo->mm_node()->requestSpatialIndex();
+    }
+    
+    // 相机快照访问器
+    // 与IntersectionVisitor::apply(osg::Camera&)压入矩阵的方式相同，只是矩阵取自快照，
+    // 场景根节点直接遍历，不需要挂在相机下面，也不会读取渲染中的相机。
+    class CameraSnapshotVisitor : public osgUtil::IntersectionVisitor
+    {
+    public:
+        explicit CameraSnapshotVisitor(osgUtil::Intersector* intersector)
+            : osgUtil::IntersectionVisitor(intersector)
+        {
+        }
+        
+        // candidates非空时只遍历粗筛得到的候选节点（均为sceneRoot的直接子节点，无额外变换）
+        void traverseScene(const PickCameraState& cameraState, osg::Node& sceneRoot,
+                           const std::vector<osg::Node*>* candidates = nullptr)
+        {
+            pushWindowMatrix(cameraState.viewport.get());
+            pushProjectionMatrix(new osg::RefMatrix(cameraState.projectionMatrix));
+            pushViewMatrix(new osg::RefMatrix(cameraState.viewMatrix));
+            pushModelMatrix(new osg::RefMatrix());
+            
+            // 把窗口坐标系下的拾取器变换到场景坐标系
+            push_clone();
+            if (candidates) {
+                for (osg::Node* node : *candidates) {
+                    node->accept(*this);
+                }
+            } else {
+                sceneRoot.accept(*this);
+            }
+            pop_clone();
+            
+            popModelMatrix();
+            popViewMatrix();
+            popProjectionMatrix();
+            popWindowMatrix();
+        }
+        
+        void apply(osg::Drawable& drawable) override
+        {
+            requestFaceIndex(_intersectorStack.back().get(), drawable);
+            intersect(&drawable);
+        }
+    };
+    
+    // 混合拾取访问器
+    // 场景只遍历一次，每个Drawable按自身NodeMask只交给对应的拾取器求交，
+    // 避免IntersectorGroup默认行为下多边形拾取器去测试面几何体（或射线去测试点/线）。
+    // IntersectorGroup在进入相机/变换时按顺序clone子拾取器，所以子拾取器下标与m_masks一一对应。
+    class HybridIntersectionVisitor : public CameraSnapshotVisitor
+    {
+    public:
+        HybridIntersectionVisitor(osgUtil::IntersectorGroup* group, const std::vector<unsigned int>& masks)
+            : CameraSnapshotVisitor(group)
+            , m_masks(masks)
+        {
+        }
+        
+        void apply(osg::Drawable& drawable) override
+        {
+            osgUtil::IntersectorGroup* group = dynamic_cast<osgUtil::IntersectorGroup*>(_intersectorStack.back().get());
+            if (!group) {
+                CameraSnapshotVisitor::apply(drawable);
+                return;
+            }
+            
+            const unsigned int nodeMask = drawable.getNodeMask();
+            osgUtil::IntersectorGroup::Intersectors& intersectors = group->getIntersectors();
+            for (size_t i = 0; i < intersectors.size() && i < m_masks.size(); ++i) {
+                osgUtil::Intersector* intersector = intersectors[i].get();
+                if (intersector->disabled() || (nodeMask & m_masks[i]) == 0) continue;
+                requestFaceIndex(intersector, drawable);
+                intersector->intersect(*this, &drawable);
+            }
+        }
+        
+    private:
+        std::vector<unsigned int> m_masks;
+    };
+    
+    // 线段BVH拾取器
+    // 与多面体拾取器一样由访问器按NodeMask分派到边几何体，但不逐线段求交，
+    // 而是查该几何体的EdgeSegmentBVH，在像素空间找离鼠标最近的线段（各克隆共用一个最近结果）。
+    // 索引尚未建好（或线段数低于阈值不建索引）时逐条线段测试，并请求后台构建。
+    class EdgeSegmentIntersector : public osgUtil::Intersector
+    {
+    public:
+        struct Nearest
+        {
+            bool valid = false;
+            EdgeSegmentBVH::Hit hit;
+            osg::Vec3d worldPoint;
+            Geo3D* geometry = nullptr;
+            osg::ref_ptr<osg::Drawable> drawable;
+        };
+        
+        EdgeSegmentIntersector(double x, double y, double radius)
+            : osgUtil::Intersector(osgUtil::Intersector::WINDOW)
+            , m_x(x)
+            , m_y(y)
+            , m_radius(radius)
+        {
+            m_polytope.setToBoundingBox(osg::BoundingBox(x - radius, y - radius, 0.0, x + radius, y + radius, 1.0));
+        }
+        
+        // 与PolytopeIntersector::clone相同：把窗口坐标系下的拾取锥体变换到当前节点的局部坐标系
+        osgUtil::Intersector* clone(osgUtil::IntersectionVisitor& iv) override
+        {
+            osg::Matrixd matrix;
+            if (iv.getWindowMatrix()) matrix.preMult(*iv.getWindowMatrix());
+            if (iv.getProjectionMatrix()) matrix.preMult(*iv.getProjectionMatrix());
+            if (iv.getViewMatrix()) matrix.preMult(*iv.getViewMatrix());
+            if (iv.getModelMatrix()) matrix.preMult(*iv.getModelMatrix());
+            
+            EdgeSegmentIntersector* intersector = new EdgeSegmentIntersector(m_x, m_y, m_radius);
+            intersector->m_polytope.setAndTransformProvidingInverse(m_polytope, matrix);
+            intersector->m_parent = this;
+            return intersector;
+        }
+        
+        // 包围球在拾取锥体外的子树不再进入
+        bool enter(const osg::Node& node) override
+        {
+            if (disabled()) return false;
+            return !node.isCullingActive() || m_polytope.contains(node.getBound());
+        }
+        void leave() override {}
+        
+        void intersect(osgUtil::IntersectionVisitor& iv, osg::Drawable* drawable) override
+        {
+            Geo3D* geo = dynamic_cast<Geo3D*>(drawable->getUserData());
+            osg::Geometry* geometry = drawable->asGeometry();
+            if (!geo || !geometry) return;
+            
+            // 不是该对象的边几何体（外部节点等）时没有索引，直接逐条测试
+            const EdgeSegmentBVH* bvh = nullptr;
+            if (geo->mm_node()->getEdgeGeometry().get() == geometry) {
+                bvh = geo->mm_node()->getEdgeSegmentBVH();
+                if (!bvh && geo->mm_node()->needsSpatialIndex()) {
+                    geo->mm_node()->requestSpatialIndex();
+                }
+            }
+            
+            osg::Matrixd modelMatrix = iv.getModelMatrix() ? osg::Matrixd(*iv.getModelMatrix()) : osg::Matrixd();
+            osg::Matrixd localToClip = modelMatrix;
+            if (iv.getViewMatrix()) localToClip.postMult(*iv.getViewMatrix());
+            if (iv.getProjectionMatrix()) localToClip.postMult(*iv.getProjectionMatrix());
+            osg::Matrixd windowMatrix = iv.getWindowMatrix() ? osg::Matrixd(*iv.getWindowMatrix()) : osg::Matrixd();
+            
+            // 已有结果时只需在其附近继续找
+            Nearest& best = nearest();
+            double radius = best.valid ? std::min(m_radius, best.hit.pixelDistance + 1.0) : m_radius;
+            
+            EdgeSegmentBVH::Hit hit;
+            const bool found = bvh ? bvh->pickClosest(localToClip, windowMatrix, m_x, m_y, radius, hit)
+                                   : EdgeSegmentBVH::pickClosest(geometry, localToClip, windowMatrix, m_x, m_y, radius, hit);
+            if (!found) return;
+            if (best.valid && !EdgeSegmentBVH::isCloser(hit, best.hit)) return;
+            
+            best.valid = true;
+            best.hit = hit;
+            best.worldPoint = hit.localPoint * modelMatrix;
+            best.geometry = geo;
+            best.drawable = drawable;
+        }
+        
+        void reset() override
+        {
+            osgUtil::Intersector::reset();
+            m_nearest = Nearest();
+        }
+        
+        bool containsIntersections() override { return nearest().valid; }
+        
+        const Nearest& getNearest() { return nearest(); }
+        
+    private:
+        Nearest& nearest() { return m_parent ? m_parent->nearest() : m_nearest; }
+        
+        double m_x;
+        double m_y;
+        double m_radius;
+        osg::Polytope m_polytope;  // 拾取锥体（克隆后为局部坐标系）
+        EdgeSegmentIntersector* m_parent = nullptr;
+        Nearest m_nearest;
+    };
+    
+    PickResult makeEdgeSegmentResult(const EdgeSegmentIntersector::Nearest& nearest, const PickCameraState& cameraState)
+    {
+        PickResult result;
+        result.hasResult = true;
+        result.geometry = nearest.geometry;
+        result.featureType = PickFeatureType::EDGE;
+        result.worldPosition = glm::dvec3(nearest.worldPoint.x(), nearest.worldPoint.y(), nearest.worldPoint.z());
+        
+        // 计算距离
+        osg::Vec3d cameraPos = osg::Matrixd::inverse(cameraState.viewMatrix).getTrans();
+        result.distance = (nearest.worldPoint - cameraPos).length();
+        
+        result.segmentIndex = nearest.hit.segmentIndex;
+        result.segmentParameter = nearest.hit.parameter;
+        result.osgGeometry = nearest.drawable.valid() ? nearest.drawable->asGeometry() : nullptr;
+        result.osgPrimitiveIndex = nearest.hit.segmentIndex;
+        return result;
+    }
+}
+
+void GeometryPickingSystem::pickWithHybridTraversal(int mouseX, int mouseY, const PickCameraState& cameraState)
+{
+    osg::ref_ptr<osgUtil::IntersectorGroup> group = new osgUtil::IntersectorGroup();
+    std::vector<unsigned int> masks;
+    
+    osg::ref_ptr<osgUtil::LineSegmentIntersector> faceIntersector;
+    osg::ref_ptr<osgUtil::PolytopeIntersector> vertexIntersector;
+    osg::ref_ptr<osgUtil::PolytopeIntersector> edgeIntersector;
+    osg::ref_ptr<EdgeSegmentIntersector> segmentIntersector;
+    
+    if (m_config.enableFacePicking) {
+        faceIntersector = createFaceIntersector(mouseX, mouseY);
+        group->addIntersector(faceIntersector.get());
+        masks.push_back(NODE_MASK_FACE);
+    }
+    if (usePolytopeVertexPicking()) {
+        vertexIntersector = createPolytopeIntersector(mouseX, mouseY);
+        group->addIntersector(vertexIntersector.get());
+        masks.push_back(NODE_MASK_VERTEX | NODE_MASK_CONTROL_POINTS);
+    }
+    if (m_config.enableEdgePicking) {
+        if (m_config.useEdgeSegmentBVH) {
+            segmentIntersector = new EdgeSegmentIntersector(mouseX, mouseY, m_config.cylinderRadius);
+            group->addIntersector(segmentIntersector.get());
+        } else {
+            edgeIntersector = createPolytopeIntersector(mouseX, mouseY);
+            group->addIntersector(edgeIntersector.get());
+        }
+        masks.push_back(NODE_MASK_EDGE);
+    }
+    
+    if (masks.empty()) return;
+    
+    unsigned int traversalMask = 0;
+    for (unsigned int mask : masks) traversalMask |= mask;
+    
+    osg::ref_ptr<HybridIntersectionVisitor> visitor = new HybridIntersectionVisitor(group.get(), masks);
+    visitor->setTraversalMask(traversalMask);
+    visitor->traverseScene(cameraState, *m_sceneRoot, m_useCandidates ? &m_candidateNodes : nullptr);
+    
+    // 收集结果（每类只有一个最近的）
+    if (faceIntersector.valid() && faceIntersector->containsIntersections()) {
+        m_singleResults.faceIntersection = faceIntersector->getFirstIntersection();
+        m_singleResults.hasFaceResult = true;
+    }
+    if (vertexIntersector.valid() && vertexIntersector->containsIntersections()) {
+        m_singleResults.vertexIntersection = vertexIntersector->getFirstIntersection();
+        m_singleResults.hasVertexResult = true;
+    }
+    if (edgeIntersector.valid() && edgeIntersector->containsIntersections()) {
+        m_singleResults.edgeIntersection = edgeIntersector->getFirstIntersection();
+        m_singleResults.hasEdgeResult = true;
+    }
+    if (segmentIntersector.valid() && segmentIntersector->containsIntersections()) {
+        m_singleResults.segmentEdgeResult = makeEdgeSegmentResult(segmentIntersector->getNearest(), cameraState);
+        m_singleResults.hasSegmentEdgeResult = true;
+    }
+}
+
+// ============= 三次独立遍历拾取 =============
+
+void GeometryPickingSystem::pickWithSeparateTraversals(int mouseX, int mouseY, const PickCameraState& cameraState)
+{
     // 1. 面拾取 - 单独遍历
     if (m_config.enableFacePicking) {
-        osg::ref_ptr<osgUtil::LineSegmentIntersector> rayIntersector = 
-            new osgUtil::LineSegmentIntersector(osgUtil::Intersector::WINDOW, mouseX, mouseY);
-        rayIntersector->setPrecisionHint(osgUtil::Intersector::USE_DOUBLE_CALCULATIONS);
-        rayIntersector->setIntersectionLimit(osgUtil::Intersector::LIMIT_NEAREST);  // 只获取最近的交点
+        osg::ref_ptr<osgUtil::LineSegmentIntersector> rayIntersector = createFaceIntersector(mouseX, mouseY);
         
-        osg::ref_ptr<osgUtil::IntersectionVisitor> faceVisitor = 
-            new osgUtil::IntersectionVisitor(rayIntersector.get());
+        osg::ref_ptr<CameraSnapshotVisitor> faceVisitor = 
+            new CameraSnapshotVisitor(rayIntersector.get());
         faceVisitor->setTraversalMask(NODE_MASK_FACE);  // 只访问面几何体
         
         // 单独遍历面几何体
-        m_camera->accept(*faceVisitor);
+        faceVisitor->traverseScene(cameraState, *m_sceneRoot, m_useCandidates ? &m_candidateNodes : nullptr);
         
         // 收集面拾取结果（只有一个最近的）
         if (rayIntersector->containsIntersections()) {
@@ -87,21 +465,15 @@ PickResult GeometryPickingSystem::pickGeometry(int mouseX, int mouseY)
     }
     
     // 2. 顶点拾取 - 单独遍历
-    if (m_config.enableVertexPicking) {
-        double radius = m_config.cylinderRadius;
-        osg::ref_ptr<osgUtil::PolytopeIntersector> cylinderIntersector = 
-            new osgUtil::PolytopeIntersector(osgUtil::Intersector::WINDOW, 
-                                            mouseX - radius, mouseY - radius,
-                                            mouseX + radius, mouseY + radius);
-        cylinderIntersector->setPrecisionHint(osgUtil::Intersector::USE_DOUBLE_CALCULATIONS);
-        cylinderIntersector->setIntersectionLimit(osgUtil::Intersector::LIMIT_NEAREST);  // 只获取最近的交点
+    if (usePolytopeVertexPicking()) {
+        osg::ref_ptr<osgUtil::PolytopeIntersector> cylinderIntersector = createPolytopeIntersector(mouseX, mouseY);
         
-        osg::ref_ptr<osgUtil::IntersectionVisitor> vertexVisitor = 
-            new osgUtil::IntersectionVisitor(cylinderIntersector.get());
+        osg::ref_ptr<CameraSnapshotVisitor> vertexVisitor = 
+            new CameraSnapshotVisitor(cylinderIntersector.get());
         vertexVisitor->setTraversalMask(NODE_MASK_VERTEX|NODE_MASK_CONTROL_POINTS);  // 只访问顶点(和控制点)几何体
 
         // 单独遍历顶点几何体
-        m_camera->accept(*vertexVisitor);
+        vertexVisitor->traverseScene(cameraState, *m_sceneRoot, m_useCandidates ? &m_candidateNodes : nullptr);
         
         // 收集顶点拾取结果（只有一个最近的）
         if (cylinderIntersector->containsIntersections()) {
@@ -110,22 +482,32 @@ PickResult GeometryPickingSystem::pickGeometry(int mouseX, int mouseY)
         }
     }
     
-    // 3. 边拾取 - 单独遍历
-    if (m_config.enableEdgePicking) {
-        double radius = m_config.cylinderRadius;
-        osg::ref_ptr<osgUtil::PolytopeIntersector> cylinderIntersector = 
-            new osgUtil::PolytopeIntersector(osgUtil::Intersector::WINDOW, 
-                                            mouseX - radius, mouseY - radius,
-                                            mouseX + radius, mouseY + radius);
-        cylinderIntersector->setPrecisionHint(osgUtil::Intersector::USE_DOUBLE_CALCULATIONS);
-        cylinderIntersector->setIntersectionLimit(osgUtil::Intersector::LIMIT_NEAREST);  // 只获取最近的交点
+    // 3. 边拾取 - 单独遍历（线段BVH）
+    if (m_config.enableEdgePicking && m_config.useEdgeSegmentBVH) {
+        osg::ref_ptr<EdgeSegmentIntersector> segmentIntersector =
+            new EdgeSegmentIntersector(mouseX, mouseY, m_config.cylinderRadius);
         
-        osg::ref_ptr<osgUtil::IntersectionVisitor> edgeVisitor = 
-            new osgUtil::IntersectionVisitor(cylinderIntersector.get());
+        osg::ref_ptr<CameraSnapshotVisitor> edgeVisitor = 
+            new CameraSnapshotVisitor(segmentIntersector.get());
+        edgeVisitor->setTraversalMask(NODE_MASK_EDGE);  // 只访问边几何体
+        edgeVisitor->traverseScene(cameraState, *m_sceneRoot, m_useCandidates ? &m_candidateNodes : nullptr);
+        
+        if (segmentIntersector->containsIntersections()) {
+            m_singleResults.segmentEdgeResult = makeEdgeSegmentResult(segmentIntersector->getNearest(), cameraState);
+            m_singleResults.hasSegmentEdgeResult = true;
+        }
+    }
+    
+    // 3. 边拾取 - 单独遍历（多面体拾取器）
+    if (m_config.enableEdgePicking && !m_config.useEdgeSegmentBVH) {
+        osg::ref_ptr<osgUtil::PolytopeIntersector> cylinderIntersector = createPolytopeIntersector(mouseX, mouseY);
+        
+        osg::ref_ptr<CameraSnapshotVisitor> edgeVisitor = 
+            new CameraSnapshotVisitor(cylinderIntersector.get());
         edgeVisitor->setTraversalMask(NODE_MASK_EDGE);  // 只访问边几何体
         
         // 单独遍历边几何体
-        m_camera->accept(*edgeVisitor);
+        edgeVisitor->traverseScene(cameraState, *m_sceneRoot, m_useCandidates ? &m_candidateNodes : nullptr);
         
         // 收集边拾取结果（只有一个最近的）
         if (cylinderIntersector->containsIntersections()) {
@@ -133,18 +515,89 @@ PickResult GeometryPickingSystem::pickGeometry(int mouseX, int mouseY)
             m_singleResults.hasEdgeResult = true;
         }
     }
+}
+
+// ============= 屏幕空间网格顶点拾取 =============
+
+void GeometryPickingSystem::pickVerticesWithGrid(int mouseX, int mouseY, const PickCameraState& cameraState)
+{
+    if (!m_vertexGrid) {
+        m_vertexGrid.reset(new ScreenVertexGrid());
+    }
     
-    // 4. 比较距离和优先级，选择最佳结果
-    PickResult result = selectBestSingleResult();
-    result.screenX = mouseX;
-    result.screenY = mouseY;
+    // 相机和场景都没变时不做任何投影，只查鼠标周围的几个格子
+    m_vertexGrid->update(cameraState, m_sceneRoot.get(), NODE_MASK_VERTEX | NODE_MASK_CONTROL_POINTS, m_config.cylinderRadius);
     
-    // 调用回调
-    if (result.hasResult && m_pickingCallback) {
-        m_pickingCallback(result);
-    }
+    ScreenVertexGrid::Hit hit;
+    if (!m_vertexGrid->findNearest(mouseX, mouseY, m_config.cylinderRadius, hit)) return;
     
-    return result;
+    PickResult& result = m_singleResults.gridVertexResult;
+    result.hasResult = true;
+    result.geometry = hit.geometry;
+    result.featureType = PickFeatureType::VERTEX;
+    result.worldPosition = hit.worldPosition;
+    
+    // 计算距离
+    osg::Vec3d cameraPos = osg::Matrixd::inverse(cameraState.viewMatrix).getTrans();
+    result.distance = glm::length(hit.worldPosition - glm::dvec3(cameraPos.x(), cameraPos.y(), cameraPos.z()));
+    
+    // 点图元逐个绘制，图元索引即顶点索引
+    result.osgGeometry = hit.osgGeometry;
+    result.osgPrimitiveIndex = static_cast<int>(hit.vertexIndex);
+    
+    m_singleResults.hasGridVertexResult = true;
+}
+
+bool GeometryPickingSystem::collectCandidateNodes(int mouseX, int mouseY, const PickCameraState& cameraState)
+{
+    m_candidateGeometries.clear();
+    m_candidateNodes.clear();
+    
+    if (!m_sceneBVH) return false;
+    
+    // 子节点与BVH登记不一致时退回全场景遍历
+    if (m_sceneBVH->getProxyCount() != static_cast<int>(m_sceneRoot->getNumChildren())) return false;
+    
+    // 拾取窗口（覆盖射线和多边形拾取器的范围）在窗口坐标系下的锥体，变换到场景坐标系
+    double radius = std::max(m_config.cylinderRadius, 1.0);
+    osg::Polytope pickVolume;
+    pickVolume.setToBoundingBox(osg::BoundingBox(mouseX - radius, mouseY - radius, 0.0,
+                                                 mouseX + radius, mouseY + radius, 1.0));
+    osg::Matrixd VPW = cameraState.viewMatrix * cameraState.projectionMatrix *
+                       cameraState.viewport->computeWindowMatrix();
+    pickVolume.transformProvidingInverse(VPW);
+    
+    m_sceneBVH->query(pickVolume, m_candidateGeometries);
+    
+    m_candidateNodes.reserve(m_candidateGeometries.size());
+    for (Geo3D* geo : m_candidateGeometries) {
+        osg::Node* node = geo->mm_node()->getOSGNode().get();
+        if (node) {
+            m_candidateNodes.push_back(node);
+        }
+    }
+    return true;
+}
+
+osgUtil::LineSegmentIntersector* GeometryPickingSystem::createFaceIntersector(int mouseX, int mouseY) const
+{
+    osgUtil::LineSegmentIntersector* intersector = 
+        new osgUtil::LineSegmentIntersector(osgUtil::Intersector::WINDOW, mouseX, mouseY);
+    intersector->setPrecisionHint(osgUtil::Intersector::USE_DOUBLE_CALCULATIONS);
+    intersector->setIntersectionLimit(osgUtil::Intersector::LIMIT_NEAREST);  // 只获取最近的交点
+    return intersector;
+}
+
+osgUtil::PolytopeIntersector* GeometryPickingSystem::createPolytopeIntersector(int mouseX, int mouseY) const
+{
+    double radius = m_config.cylinderRadius;
+    osgUtil::PolytopeIntersector* intersector = 
+        new osgUtil::PolytopeIntersector(osgUtil::Intersector::WINDOW, 
+                                        mouseX - radius, mouseY - radius,
+                                        mouseX + radius, mouseY + radius);
+    intersector->setPrecisionHint(osgUtil::Intersector::USE_DOUBLE_CALCULATIONS);
+    intersector->setIntersectionLimit(osgUtil::Intersector::LIMIT_NEAREST);  // 只获取最近的交点
+    return intersector;
 }
 
 Geo3D::Ptr GeometryPickingSystem::findGeometryFromNodePath(const osg::NodePath& nodePath)
@@ -186,6 +639,13 @@ PickResult GeometryPickingSystem::selectBestSingleResult()
         }
     }
     
+    if (m_singleResults.hasGridVertexResult) {
+        candidates.push_back(m_singleResults.gridVertexResult);
+    }
+    if (m_singleResults.hasSegmentEdgeResult) {
+        candidates.push_back(m_singleResults.segmentEdgeResult);
+    }
+    
     // 分析边拾取结果
     if (m_singleResults.hasEdgeResult) {
         PickResult edgeResult = analyzePolytopeIntersection(m_singleResults.edgeIntersection, PickFeatureType::EDGE);
@@ -232,7 +692,7 @@ PickResult GeometryPickingSystem::analyzeFaceIntersection(const osgUtil::LineSeg
                                    intersection.getWorldIntersectNormal().z());
     
     // 计算距离
-    osg::Vec3 cameraPos = m_camera->getInverseViewMatrix().getTrans();
+    osg::Vec3 cameraPos = osg::Matrixd::inverse(m_cameraState.viewMatrix).getTrans();
     result.distance = (intersection.getWorldIntersectPoint() - cameraPos).length();
     
     // 获取图元索引
@@ -267,7 +727,7 @@ PickResult GeometryPickingSystem::analyzePolytopeIntersection(const osgUtil::Pol
                                    intersection.localIntersectionPoint.z());
     
     // 计算距离
-    osg::Vec3 cameraPos = m_camera->getInverseViewMatrix().getTrans();
+    osg::Vec3 cameraPos = osg::Matrixd::inverse(m_cameraState.viewMatrix).getTrans();
     result.distance = (intersection.localIntersectionPoint - cameraPos).length();
     
     // 提取OSG几何体信息
@@ -5,6 +5,8 @@
 #include "PickingTypes.h"
 #include <osg/Camera>
 #include <osg/Group>
+#include <osg/Viewport>
+#include <osg/Matrixd>
 #include <osgUtil/LineSegmentIntersector>
 #include <osgUtil/PolytopeIntersector>
 #include <osgUtil/IntersectionVisitor>
@@ -12,14 +14,21 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <functional>
+#include <memory>
 #include "../GeometryBase.h"
 
+class SceneBVH;
+class ScreenVertexGrid;
+
 // 简化的拾取配置
 struct PickConfig {
     double cylinderRadius = 10.0;     // 圆柱形拾取半径（像素）
     bool enableVertexPicking = true;  // 启用顶点拾取
     bool enableEdgePicking = true;    // 启用边拾取  
     bool enableFacePicking = true;    // 启用面拾取
+    bool useHybridTraversal = true;   // 单次遍历混合拾取（false时退回三次独立遍历）
+    bool useVertexGrid = true;        // 顶点/控制点查屏幕空间网格（false时与边一样走多面体拾取器）
+    bool useEdgeSegmentBVH = true;    // 边查线段BVH、取像素距离最近的线段（false时走多面体拾取器）
 };
 
 // 单个拾取结果存储结构（每次只有一个最近的结果）
@@ -27,18 +36,39 @@ struct SinglePickingResults {
     bool hasFaceResult = false;
     bool hasVertexResult = false;
     bool hasEdgeResult = false;
+    bool hasGridVertexResult = false;
+    bool hasSegmentEdgeResult = false;
     
     osgUtil::LineSegmentIntersector::Intersection faceIntersection;
     osgUtil::PolytopeIntersector::Intersection vertexIntersection;
     osgUtil::PolytopeIntersector::Intersection edgeIntersection;
+    PickResult gridVertexResult;  // 屏幕空间网格直接给出的顶点结果
+    PickResult segmentEdgeResult; // 线段BVH给出的边结果
     
     void clear() {
         hasFaceResult = false;
         hasVertexResult = false;
         hasEdgeResult = false;
+        hasGridVertexResult = false;
+        hasSegmentEdgeResult = false;
+        // 释放交点持有的Drawable引用
+        faceIntersection = osgUtil::LineSegmentIntersector::Intersection();
+        vertexIntersection = osgUtil::PolytopeIntersector::Intersection();
+        edgeIntersection = osgUtil::PolytopeIntersector::Intersection();
+        gridVertexResult.reset();
+        segmentEdgeResult.reset();
     }
 };
 
+// 相机状态快照 - 拾取只依赖快照中的矩阵，后台线程无需访问正在渲染的相机
+struct PickCameraState {
+    osg::ref_ptr<osg::Viewport> viewport;
+    osg::Matrixd projectionMatrix;
+    osg::Matrixd viewMatrix;
+    
+    bool isValid() const { return viewport.valid(); }
+};
+
 // 拾取系统 - 使用射线和几何拾取器
 class GeometryPickingSystem : public osg::Referenced
 {
@@ -54,9 +84,18 @@ public:
     void setConfig(const PickConfig& config) { m_config = config; }
     const PickConfig& getConfig() const { return m_config; }
     
+    // 场景BVH粗筛（为空时遍历整个场景根节点）
+    void setSceneBVH(const SceneBVH* sceneBVH) { m_sceneBVH = sceneBVH; }
+    
     // 主要拾取接口 - 使用IntersectorGroup进行混合拾取
     PickResult pickGeometry(int mouseX, int mouseY);
     
+    // 基于相机快照拾取（可在后台线程调用，每个线程使用独立的拾取系统实例）
+    PickResult pickGeometry(int mouseX, int mouseY, const PickCameraState& cameraState);
+    
+    // 采集当前相机的快照（主线程调用）
+    PickCameraState captureCameraState() const;
+    
     // 回调设置
     void setPickingCallback(std::function<void(const PickResult&)> callback);
     
@@ -67,6 +106,23 @@ public:
     glm::dvec2 worldToScreen(const glm::dvec3& worldPos);
 
 private:
+    // 单次遍历：IntersectorGroup + 按NodeMask分派的访问器，场景只走一遍
+    void pickWithHybridTraversal(int mouseX, int mouseY, const PickCameraState& cameraState);
+    
+    // 三次独立遍历：面/顶点/边各自一个IntersectionVisitor（旧实现，用于对比）
+    void pickWithSeparateTraversals(int mouseX, int mouseY, const PickCameraState& cameraState);
+    
+    // 顶点/控制点：查屏幕空间网格（相机或几何体变化后先重建）
+    void pickVerticesWithGrid(int mouseX, int mouseY, const PickCameraState& cameraState);
+    bool usePolytopeVertexPicking() const { return m_config.enableVertexPicking && !m_config.useVertexGrid; }
+    
+    // BVH粗筛：收集拾取锥体内的候选节点，返回false表示没有BVH需遍历整个场景
+    bool collectCandidateNodes(int mouseX, int mouseY, const PickCameraState& cameraState);
+    
+    // 创建各类拾取器
+    osgUtil::LineSegmentIntersector* createFaceIntersector(int mouseX, int mouseY) const;
+    osgUtil::PolytopeIntersector* createPolytopeIntersector(int mouseX, int mouseY) const;
+    
     // 选择最佳的单个结果 - 比较距离和优先级
     PickResult selectBestSingleResult();
     
@@ -95,6 +151,18 @@ private:
     
     // 单个拾取结果存储
     SinglePickingResults m_singleResults;
+    
+    // 本次拾取使用的相机快照（用于计算交点到相机的距离）
+    PickCameraState m_cameraState;
+    
+    // 场景BVH与本次粗筛得到的候选节点
+    const SceneBVH* m_sceneBVH = nullptr;
+    bool m_useCandidates = false;
+    std::vector<Geo3D*> m_candidateGeometries;
+    std::vector<osg::Node*> m_candidateNodes;
+    
+    // 本视图的屏幕空间顶点网格（首次使用时创建）
+    std::unique_ptr<ScreenVertexGrid> m_vertexGrid;
 };
 
 
@@ -0,0 +1,195 @@
+﻿#include "PickingBenchmark.h"
+#include "../GeometryBase.h"
+#include "../managers/GeoNodeManager.h"
+#include "../managers/GeoControlPointManager.h"
+#include "../managers/SpatialIndexBuilder.h"
+#include "../world/SceneBVH.h"
+#include "../../util/GeometryFactory.h"
+#include "../../util/LogManager.h"
+#include <osg/Timer>
+#include <cmath>
+#include <random>
+
+namespace
+{
+    const int kViewportWidth = 1280;
+    const int kViewportHeight = 720;
+    const double kGridSpacing = 2.0;   // 网格间距
+    const double kTriangleSize = 1.0;  // 三角形边长
+
+    bool isSameResult(const PickResult& a, const PickResult& b)
+    {
+        if (a.hasResult != b.hasResult) return false;
+        if (!a.hasResult) return true;
+        return a.geometry == b.geometry && a.featureType == b.featureType;
+    }
+}
+
+QString PickingBenchmarkResult::toString() const
+{
+    return QString("对象数=%1, 采样=%2, 场景构建=%3ms\n"
+                   "三次独立遍历: 总计%4ms, 平均%5ms\n"
+                   "单次遍历混合: 总计%6ms, 平均%7ms\n"
+                   "BVH粗筛+混合: 总计%8ms, 平均%9ms\n"
+                   "顶点网格+线段BVH: 总计%10ms, 平均%11ms\n"
+                   "加速比=%12x, 命中=%13, 结果不一致=%14")
+        .arg(objectCount)
+        .arg(sampleCount)
+        .arg(sceneBuildMs, 0, 'f', 1)
+        .arg(separateTotalMs, 0, 'f', 2)
+        .arg(separateAverageMs(), 0, 'f', 3)
+        .arg(hybridTotalMs, 0, 'f', 2)
+        .arg(hybridAverageMs(), 0, 'f', 3)
+        .arg(bvhTotalMs, 0, 'f', 2)
+        .arg(bvhAverageMs(), 0, 'f', 3)
+        .arg(vertexGridTotalMs, 0, 'f', 2)
+        .arg(vertexGridAverageMs(), 0, 'f', 3)
+        .arg(speedup(), 0, 'f', 2)
+        .arg(hitCount)
+        .arg(mismatchCount);
+}
+
+PickingBenchmarkResult PickingBenchmark::run(int objectCount, int sampleCount)
+{
+    PickingBenchmarkResult result;
+    result.objectCount = objectCount;
+    result.sampleCount = sampleCount;
+    
+    LOG_INFO(QString("开始拾取性能测试: 对象数=%1, 采样=%2").arg(objectCount).arg(sampleCount), "拾取");
+    
+    // 1. 构建场景
+    osg::Timer_t buildStart = osg::Timer::instance()->tick();
+    osg::ref_ptr<osg::Group> root = new osg::Group();
+    std::vector<Geo3D::Ptr> geometries;
+    buildScene(root.get(), objectCount, geometries);
+    result.sceneBuildMs = osg::Timer::instance()->delta_m(buildStart, osg::Timer::instance()->tick());
+    
+    osg::ref_ptr<osg::Camera> camera = createCamera(root->getBound(), kViewportWidth, kViewportHeight);
+    
+    osg::ref_ptr<GeometryPickingSystem> pickingSystem = new GeometryPickingSystem();
+    if (!pickingSystem->initialize(camera.get(), root.get())) {
+        LOG_ERROR("拾取性能测试: 拾取系统初始化失败", "拾取");
+        return result;
+    }
+    
+    // 2. 固定种子生成采样点，保证两种模式拾取同一组位置
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> xDist(0, kViewportWidth - 1);
+    std::uniform_int_distribution<int> yDist(0, kViewportHeight - 1);
+    std::vector<std::pair<int, int>> samples;
+    samples.reserve(sampleCount);
+    for (int i = 0; i < sampleCount; ++i) {
+        samples.emplace_back(xDist(rng), yDist(rng));
+    }
+    
+    // 空间索引在首次拾取时后台构建，先拾取一轮并等索引换入，避免第一种模式承担建索引的耗时
+    for (const auto& sample : samples) {
+        pickingSystem->pickGeometry(sample.first, sample.second);
+    }
+    SpatialIndexBuilder::getInstance().waitForIdle();
+    SpatialIndexBuilder::getInstance().processFinished();
+    
+    // 3. 分别计时
+    PickConfig config = pickingSystem->getConfig();
+    std::vector<PickResult> separateResults;
+    std::vector<PickResult> hybridResults;
+    separateResults.reserve(sampleCount);
+    hybridResults.reserve(sampleCount);
+    
+    config.useHybridTraversal = false;
+    config.useVertexGrid = false;
+    config.useEdgeSegmentBVH = false;
+    pickingSystem->setConfig(config);
+    osg::Timer_t start = osg::Timer::instance()->tick();
+    for (const auto& sample : samples) {
+        separateResults.push_back(pickingSystem->pickGeometry(sample.first, sample.second));
+    }
+    result.separateTotalMs = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick());
+    
+    config.useHybridTraversal = true;
+    pickingSystem->setConfig(config);
+    start = osg::Timer::instance()->tick();
+    for (const auto& sample : samples) {
+        hybridResults.push_back(pickingSystem->pickGeometry(sample.first, sample.second));
+    }
+    result.hybridTotalMs = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick());
+    
+    SceneBVH sceneBVH;
+    for (const auto& geo : geometries) {
+        sceneBVH.insert(geo.get(), geo->mm_node()->getBoundingBox());
+    }
+    pickingSystem->setSceneBVH(&sceneBVH);
+    std::vector<PickResult> bvhResults;
+    bvhResults.reserve(sampleCount);
+    start = osg::Timer::instance()->tick();
+    for (const auto& sample : samples) {
+        bvhResults.push_back(pickingSystem->pickGeometry(sample.first, sample.second));
+    }
+    result.bvhTotalMs = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick());
+    pickingSystem->setSceneBVH(nullptr);
+    
+    config.useVertexGrid = true;
+    config.useEdgeSegmentBVH = true;
+    pickingSystem->setConfig(config);
+    std::vector<PickResult> gridResults;
+    gridResults.reserve(sampleCount);
+    start = osg::Timer::instance()->tick();
+    for (const auto& sample : samples) {
+        gridResults.push_back(pickingSystem->pickGeometry(sample.first, sample.second));
+    }
+    result.vertexGridTotalMs = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick());
+    
+    // 4. 校验各模式结果一致
+    for (int i = 0; i < sampleCount; ++i) {
+        if (hybridResults[i].hasResult) ++result.hitCount;
+        if (!isSameResult(separateResults[i], hybridResults[i])
+            || !isSameResult(separateResults[i], bvhResults[i])
+            || !isSameResult(separateResults[i], gridResults[i])) ++result.mismatchCount;
+    }
+    
+    pickingSystem->shutdown();
+    
+    LOG_SUCCESS(QString("拾取性能测试完成: %1").arg(result.toString()), "拾取");
+    return result;
+}
+
+void PickingBenchmark::buildScene(osg::Group* root, int objectCount, std::vector<Geo3D::Ptr>& geometries)
+{
+    int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(objectCount))));
+    geometries.reserve(objectCount);
+    
+    for (int i = 0; i < objectCount; ++i) {
+        double x = (i % columns) * kGridSpacing;
+        double y = (i / columns) * kGridSpacing;
+        
+        Geo3D::Ptr geo = GeometryFactory::createGeometry(Geo_Triangle3D);
+        if (!geo) continue;
+        
+        // 三个控制点后自动完成绘制，节点掩码切换为可拾取
+        auto controlPointManager = geo->mm_controlPoint();
+        controlPointManager->addControlPoint(Point3D(x, y, 0.0));
+        controlPointManager->addControlPoint(Point3D(x + kTriangleSize, y, 0.0));
+        controlPointManager->addControlPoint(Point3D(x, y + kTriangleSize, 0.0));
+        
+        root->addChild(geo->mm_node()->getOSGNode().get());
+        geometries.push_back(geo);
+    }
+}
+
+osg::ref_ptr<osg::Camera> PickingBenchmark::createCamera(const osg::BoundingSphere& bound, int width, int height)
+{
+    osg::ref_ptr<osg::Camera> camera = new osg::Camera();
+    camera->setReferenceFrame(osg::Transform::ABSOLUTE_RF);
+    camera->setViewport(0, 0, width, height);
+    
+    const double fovy = 45.0;
+    camera->setProjectionMatrixAsPerspective(fovy, static_cast<double>(width) / height, 0.1, 100000.0);
+    
+    // 从正上方俯视，保证整个网格在视口内
+    double radius = bound.valid() ? bound.radius() : 1.0;
+    double distance = radius / std::sin(osg::DegreesToRadians(fovy * 0.5));
+    osg::Vec3d center = bound.valid() ? osg::Vec3d(bound.center()) : osg::Vec3d();
+    camera->setViewMatrixAsLookAt(center + osg::Vec3d(0.0, 0.0, distance), center, osg::Vec3d(0.0, 1.0, 0.0));
+    
+    return camera;
+}
@@ -0,0 +1,47 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include "../Common3D.h"
+#include "GeometryPickingSystem.h"
+#include <osg/Camera>
+#include <osg/Group>
+#include <vector>
+
+// 拾取性能测试结果
+struct PickingBenchmarkResult
+{
+    int objectCount = 0;            // 场景对象数
+    int sampleCount = 0;            // 拾取采样次数
+    double sceneBuildMs = 0.0;      // 场景构建耗时
+    double separateTotalMs = 0.0;   // 三次独立遍历总耗时
+    double hybridTotalMs = 0.0;     // 单次遍历混合拾取总耗时
+    double bvhTotalMs = 0.0;        // 场景BVH粗筛 + 单次遍历总耗时
+    double vertexGridTotalMs = 0.0; // 单次遍历 + 屏幕空间顶点网格 + 边线段BVH总耗时（含首次建网格）
+    int hitCount = 0;               // 命中次数（混合模式）
+    int mismatchCount = 0;          // 两种模式结果不一致的次数
+    
+    double separateAverageMs() const { return sampleCount > 0 ? separateTotalMs / sampleCount : 0.0; }
+    double hybridAverageMs() const { return sampleCount > 0 ? hybridTotalMs / sampleCount : 0.0; }
+    double bvhAverageMs() const { return sampleCount > 0 ? bvhTotalMs / sampleCount : 0.0; }
+    double vertexGridAverageMs() const { return sampleCount > 0 ? vertexGridTotalMs / sampleCount : 0.0; }
+    double speedup() const { return hybridTotalMs > 0.0 ? separateTotalMs / hybridTotalMs : 0.0; }
+    
+    QString toString() const;
+};
+
+// 拾取性能测试 - 构建合成场景，对比三次独立遍历、单次遍历混合拾取、BVH粗筛以及顶点网格/线段BVH
+class PickingBenchmark
+{
+public:
+    // 在objectCount个三角形组成的网格场景上，分别用两种模式拾取sampleCount个屏幕位置
+    static PickingBenchmarkResult run(int objectCount = 10000, int sampleCount = 200);
+    
+private:
+    PickingBenchmark() = delete;  // 禁止实例化
+    
+    // 构建合成场景（三角形网格，每个对象都有顶点/边/面几何体）
+    static void buildScene(osg::Group* root, int objectCount, std::vector<Geo3D::Ptr>& geometries);
+    
+    // 创建覆盖整个场景的离屏相机
+    static osg::ref_ptr<osg::Camera> createCamera(const osg::BoundingSphere& bound, int width, int height);
+};
@@ -29,7 +29,7 @@ struct IndicatorConfig
         , color(1.0, 1.0, 0.0, 1.0)     // 黄色
         , lineWidth(3.0)                    // 线宽
         , animationSpeed(2.0)
-        , enableAnimation(true)
+        , enableAnimation(false)            // 脉冲动画尚未实现，开启后按需渲染会持续刷新
         , fadeTime(0.3)
     {}
 };
@@ -65,6 +65,7 @@ public:
     
     // 状态查询
     bool isVisible() const { return m_isVisible; }
+    bool isAnimating() const { return m_isVisible && m_config.enableAnimation; }
 
 private:
     // 创建指示器几何体
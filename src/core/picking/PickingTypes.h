@@ -4,6 +4,7 @@
 #include <glm/glm.hpp>
 #include <osg/Geometry>
 #include <osg/ref_ptr>
+#include <QMetaType>
 #include "../GeometryBase.h"
 
 // 拾取特征类型
@@ -14,6 +15,17 @@ enum class PickFeatureType {
     FACE = 3       // 面
 };
 
+// 捕捉类型（数值越小优先级越高，同一捕捉半径内先比类型再比屏幕距离）
+enum class SnapType {
+    NONE = 0,
+    ENDPOINT = 1,      // 端点（顶点、折线两端）
+    CENTER = 2,        // 圆心、球心
+    INTERSECTION = 3,  // 边与边的交点
+    MIDPOINT = 4,      // 直边中点
+    NEAREST = 5,       // 边上离光标最近的点
+    GRID = 6           // 坐标网格交点
+};
+
 // 拾取结果
 struct PickResult {
     bool hasResult = false;
@@ -27,6 +39,8 @@ struct PickResult {
     // 特征信息
     PickFeatureType featureType = PickFeatureType::NONE;
     int primitiveIndex = -1;    // 图元索引（顶点/边/面）
+    int segmentIndex = -1;      // 边拾取：边几何体中的第几条线段（按线图元顺序）
+    double segmentParameter = 0.0;  // 边拾取：拾取点在线段上的参数位置（0为起点，1为终点）
     
     // OSG几何体信息
     osg::ref_ptr<osg::Geometry> osgGeometry = nullptr;  // OSG几何体节点
@@ -35,6 +49,7 @@ struct PickResult {
     // 捕捉信息
     bool isSnapped = false;
     glm::dvec3 snapPosition{0.0};
+    SnapType snapType = SnapType::NONE;
     
     // 构造函数
     PickResult() = default;
@@ -50,13 +65,19 @@ struct PickResult {
         screenY = 0;
         featureType = PickFeatureType::NONE;
         primitiveIndex = -1;
+        segmentIndex = -1;
+        segmentParameter = 0.0;
         osgGeometry = nullptr;
         osgPrimitiveIndex = -1;
         isSnapped = false;
         snapPosition = glm::dvec3(0.0);
+        snapType = SnapType::NONE;
     }
 }; 
 
+// 跨线程信号传递拾取结果
+Q_DECLARE_METATYPE(PickResult)
+
 
 
 
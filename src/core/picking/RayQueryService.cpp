@@ -0,0 +1,372 @@
+﻿#include "RayQueryService.h"
+#include "../managers/GeoNodeManager.h"
+#include "../managers/SpatialIndexBuilder.h"
+#include "../../util/Tracer.h"
+#include <osg/KdTree>
+#include <osgUtil/LineSegmentIntersector>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <thread>
+
+namespace
+{
+    const size_t kRaysPerChunk = 64;  // 工作线程每次领取的线段数
+
+    glm::dvec3 toGlm(const osg::Vec3d& v) { return glm::dvec3(v.x(), v.y(), v.z()); }
+
+    // 命中点沿线段相差不到容差时按特征优先级（顶点 > 边 > 面）比较，否则取靠前的
+    bool isBetterHit(const PickResult& candidate, double candidateParameter,
+                     const PickResult& best, double bestParameter, double toleranceParameter)
+    {
+        if (!best.hasResult) return true;
+        if (std::abs(candidateParameter - bestParameter) <= toleranceParameter &&
+            candidate.featureType != best.featureType) {
+            return candidate.featureType < best.featureType;
+        }
+        return candidateParameter < bestParameter;
+    }
+}
+
+RayQueryService::RayQueryService()
+    : m_sceneBVH(nullptr)
+    , m_sceneLock(nullptr)
+    , m_lastSnapshotSize(0)
+    , m_lastThreadCount(0)
+{
+}
+
+// ============= 批量查询 =============
+
+void RayQueryService::query(const std::vector<Geo3D::Ptr>& geometries, const std::vector<RayQuery>& rays,
+                            std::vector<PickResult>& results)
+{
+    TRACE_ZONE("RayQueryService::query", "拾取");
+
+    results.assign(rays.size(), PickResult());
+    if (rays.empty()) return;
+
+    // 只在采集快照时持有读锁，求交只读快照，不阻塞主线程的重建、增删对象和索引换入
+    {
+        QReadLocker sceneLocker(m_sceneLock);
+        captureSnapshot(geometries);
+    }
+    m_lastSnapshotSize = m_snapshots.size();
+    if (m_snapshots.empty()) {
+        m_lastThreadCount = 0;
+        return;
+    }
+
+    const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t requestedThreads = m_config.threadCount > 0 ? static_cast<size_t>(m_config.threadCount) : hardwareThreads;
+    const size_t chunkCount = (rays.size() + kRaysPerChunk - 1) / kRaysPerChunk;
+    const int threadCount = static_cast<int>(std::max<size_t>(1, std::min(requestedThreads, chunkCount)));
+    m_lastThreadCount = threadCount;
+
+    // 工作线程从共享下标按块领取线段，结果写回各自槽位，保持输入顺序
+    std::atomic<size_t> nextRay(0);
+    auto worker = [&]() {
+        Workspace workspace;
+        for (size_t first = nextRay.fetch_add(kRaysPerChunk); first < rays.size(); first = nextRay.fetch_add(kRaysPerChunk)) {
+            const size_t last = std::min(first + kRaysPerChunk, rays.size());
+            for (size_t i = first; i < last; ++i) {
+                results[i] = queryRay(rays[i], workspace);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+
+    // 快照只在本批内有效，及时释放对象引用
+    m_snapshots.clear();
+    m_snapshotIndices.clear();
+    m_sceneBVHSnapshot.clear();
+}
+
+// ============= 快照 =============
+
+void RayQueryService::captureSnapshot(const std::vector<Geo3D::Ptr>& geometries)
+{
+    TRACE_ZONE("RayQueryService::captureSnapshot", "拾取");
+
+    m_snapshots.clear();
+    m_snapshotIndices.clear();
+    m_snapshots.reserve(geometries.size());
+
+    if (m_sceneBVH) {
+        m_sceneBVHSnapshot = *m_sceneBVH;
+    }
+
+    const double tolerance = m_config.featureTolerance;
+    const bool wantEdges = m_config.hitEdges && tolerance > 0.0;
+    const bool wantVertices = m_config.hitVertices && tolerance > 0.0;
+
+    for (const Geo3D::Ptr& geo : geometries) {
+        GeoNodeManager* nodeManager = geo.valid() ? geo->mm_node() : nullptr;
+        if (!nodeManager) continue;
+
+        // 隐藏或绘制中（NODE_MASK_NOSELECT）的对象不参与
+        osg::Group* node = nodeManager->getOSGNode().get();
+        if (!node || (node->getNodeMask() & NODE_MASK_ALL_VISIBLE) == 0) continue;
+
+        GeometrySnapshot snapshot;
+        snapshot.geometry = geo;
+        snapshot.worldBox = nodeManager->getBoundingBox();
+        if (!snapshot.worldBox.valid()) continue;
+
+        if (nodeManager->getTransformNode().valid()) {
+            snapshot.matrix = nodeManager->getTransformNode()->getMatrix();
+        }
+        if (!snapshot.inverse.invert(snapshot.matrix)) continue;
+
+        // 图元多的对象第一次参与查询时提交后台建索引（与拾取相同），本批仍逐图元求交
+        if (nodeManager->needsSpatialIndex()) {
+            nodeManager->requestSpatialIndex();
+        }
+
+        osg::Geometry* face = nodeManager->getFaceGeometry().get();
+        if (m_config.hitFaces && face && (face->getNodeMask() & NODE_MASK_FACE)) {
+            snapshot.faceMatrix = nodeManager->getFaceWorldMatrix();
+            if (snapshot.faceInverse.invert(snapshot.faceMatrix)) {
+                snapshot.face = face;
+                snapshot.faceTarget = captureFaceTarget(nodeManager, face);
+                if (snapshot.faceTarget.valid()) {
+                    snapshot.faceTarget->getBoundingBox();  // 包围盒惰性计算，先在调用线程算好，工作线程只读
+                } else {
+                    snapshot.face = nullptr;
+                }
+            }
+        }
+
+        osg::Geometry* edge = nodeManager->getEdgeGeometry().get();
+        if (wantEdges && edge && (edge->getNodeMask() & NODE_MASK_EDGE)) {
+            snapshot.edgeMatrix = nodeManager->getEdgeWorldMatrix();
+            if (snapshot.edgeInverse.invert(snapshot.edgeMatrix)) {
+                // 线段BVH建好后不再改动，没有BVH时复制边几何体
+                snapshot.edge = edge;
+                snapshot.edgeBVH = nodeManager->getEdgeSegmentBVH();
+                if (!snapshot.edgeBVH.valid()) {
+                    snapshot.edgeCopy = SpatialIndexBuilder::snapshot(edge);
+                    if (!snapshot.edgeCopy.valid()) snapshot.edge = nullptr;
+                }
+
+                const osg::Vec3d edgeScale = snapshot.edgeInverse.getScale();
+                snapshot.edgeLocalTolerance = tolerance * std::max(edgeScale.x(), std::max(edgeScale.y(), edgeScale.z()));
+            }
+        }
+
+        osg::Geometry* vertex = nodeManager->getVertexGeometry().get();
+        if (wantVertices && vertex && (vertex->getNodeMask() & NODE_MASK_VERTEX)) {
+            if (const osg::Vec3Array* vertices = dynamic_cast<const osg::Vec3Array*>(vertex->getVertexArray())) {
+                snapshot.vertex = vertex;
+                snapshot.vertices.assign(vertices->begin(), vertices->end());
+            }
+        }
+
+        if (!snapshot.face.valid() && !snapshot.edge.valid() && snapshot.vertices.empty()) continue;
+
+        // 容差按逆变换的最大缩放换算到局部坐标
+        const osg::Vec3d scale = snapshot.inverse.getScale();
+        snapshot.localTolerance = tolerance * std::max(scale.x(), std::max(scale.y(), scale.z()));
+
+        m_snapshotIndices[geo.get()] = m_snapshots.size();
+        m_snapshots.push_back(std::move(snapshot));
+    }
+}
+
+osg::ref_ptr<osg::Geometry> RayQueryService::captureFaceTarget(GeoNodeManager* nodeManager, osg::Geometry* face) const
+{
+    // 单位网格原型被所有引用它的对象共享，不会原地修改
+    if (UnitMesh* mesh = nodeManager->getFaceUnitMesh()) {
+        return mesh->prototype;
+    }
+
+    // KdTree引用的是建索引时复制的顶点数组，挂到只带包围盒的代理上，不复制几何体
+    if (osg::KdTree* kdTree = dynamic_cast<osg::KdTree*>(face->getShape())) {
+        osg::ref_ptr<osg::Geometry> proxy = new osg::Geometry();
+        proxy->setInitialBound(face->getBoundingBox());
+        proxy->setShape(kdTree);
+        return proxy;
+    }
+
+    // 图元少或索引尚未建好：复制顶点和图元
+    return SpatialIndexBuilder::snapshot(face);
+}
+
+// ============= 单条线段 =============
+
+PickResult RayQueryService::queryRay(const RayQuery& ray, Workspace& workspace) const
+{
+    PickResult best;
+
+    const osg::Vec3d start(ray.start.x, ray.start.y, ray.start.z);
+    const osg::Vec3d end(ray.end.x, ray.end.y, ray.end.z);
+    const double length = (end - start).length();
+    if (length <= 0.0) return best;
+
+    const double tolerance = (m_config.hitEdges || m_config.hitVertices) ? m_config.featureTolerance : 0.0;
+    const double toleranceParameter = tolerance / length;
+
+    // 1. 粗筛：与外扩容差后的包围盒相交的对象，按进入包围盒的先后排序
+    workspace.entries.clear();
+    const osg::Vec3 expand(tolerance, tolerance, tolerance);
+    auto addEntry = [&](size_t index) {
+        const osg::BoundingBox& box = m_snapshots[index].worldBox;
+        double tEnter = 0.0;
+        if (SceneBVH::intersectSegment(osg::BoundingBox(box._min - expand, box._max + expand), start, end, tEnter)) {
+            workspace.entries.emplace_back(tEnter, index);
+        }
+    };
+
+    if (m_sceneBVH) {
+        workspace.candidates.clear();
+        m_sceneBVHSnapshot.query(start, end, tolerance, workspace.candidates);
+        for (Geo3D* geo : workspace.candidates) {
+            auto it = m_snapshotIndices.find(geo);
+            if (it != m_snapshotIndices.end()) {
+                addEntry(it->second);
+            }
+        }
+    } else {
+        for (size_t i = 0; i < m_snapshots.size(); ++i) {
+            addEntry(i);
+        }
+    }
+    std::sort(workspace.entries.begin(), workspace.entries.end());
+
+    // 2. 由近到远逐个对象求交
+    double bestParameter = DBL_MAX;
+    auto consider = [&](const PickResult& candidate, double parameter) {
+        if (isBetterHit(candidate, parameter, best, bestParameter, toleranceParameter)) {
+            best = candidate;
+            bestParameter = parameter;
+        }
+    };
+
+    for (const auto& entry : workspace.entries) {
+        // 之后的对象进入得更晚，不可能比当前结果更靠前
+        if (best.hasResult && entry.first > bestParameter + toleranceParameter) break;
+
+        const GeometrySnapshot& snapshot = m_snapshots[entry.second];
+        PickResult candidate;
+        double parameter = 0.0;
+        if (!snapshot.vertices.empty() && intersectVertex(snapshot, start, end, candidate, parameter)) {
+            consider(candidate, parameter);
+        }
+        if (snapshot.edge.valid() && intersectEdge(snapshot, start, end, candidate, parameter)) {
+            consider(candidate, parameter);
+        }
+        if (snapshot.face.valid() && intersectFace(snapshot, start, end, workspace, candidate, parameter)) {
+            consider(candidate, parameter);
+        }
+    }
+
+    if (best.hasResult) {
+        best.distance = bestParameter * length;
+    }
+    return best;
+}
+
+bool RayQueryService::intersectFace(const GeometrySnapshot& snapshot, const osg::Vec3d& start, const osg::Vec3d& end,
+                                    Workspace& workspace, PickResult& result, double& rayParameter) const
+{
+    // 仿射变换不改变线段参数，局部坐标下的ratio即场景坐标下的参数
+    osg::ref_ptr<osgUtil::LineSegmentIntersector> intersector = new osgUtil::LineSegmentIntersector(
+        osgUtil::Intersector::MODEL, start * snapshot.faceInverse, end * snapshot.faceInverse);
+    intersector->setIntersectionLimit(osgUtil::Intersector::LIMIT_NEAREST);
+
+    // 面几何体挂着KdTree（自身的或单位网格原型的）时由LineSegmentIntersector直接走KdTree
+    workspace.visitor.setIntersector(intersector.get());
+    snapshot.faceTarget->accept(workspace.visitor);
+    workspace.visitor.setIntersector(nullptr);
+    if (!intersector->containsIntersections()) return false;
+
+    const osgUtil::LineSegmentIntersector::Intersection& intersection = intersector->getFirstIntersection();
+    rayParameter = intersection.ratio;
+
+    // 法线按逆矩阵的转置变换
+    osg::Vec3d normal = osg::Matrixd::transform3x3(snapshot.faceInverse, osg::Vec3d(intersection.getLocalIntersectNormal()));
+    normal.normalize();
+
+    result = PickResult();
+    result.hasResult = true;
+    result.geometry = snapshot.geometry;
+    result.worldPosition = toGlm(start + (end - start) * rayParameter);
+    result.surfaceNormal = toGlm(normal);
+    result.featureType = PickFeatureType::FACE;
+    result.primitiveIndex = static_cast<int>(intersection.primitiveIndex);
+    result.osgGeometry = snapshot.face;
+    result.osgPrimitiveIndex = static_cast<int>(intersection.primitiveIndex);
+    return true;
+}
+
+bool RayQueryService::intersectEdge(const GeometrySnapshot& snapshot, const osg::Vec3d& start, const osg::Vec3d& end,
+                                    PickResult& result, double& rayParameter) const
+{
+    const osg::Vec3d localStart = start * snapshot.edgeInverse;
+    const osg::Vec3d localEnd = end * snapshot.edgeInverse;
+
+    // 线段BVH建好前逐条线段测试
+    EdgeSegmentBVH::RayHit hit;
+    const bool found = snapshot.edgeBVH.valid()
+        ? snapshot.edgeBVH->intersectSegment(localStart, localEnd, snapshot.edgeLocalTolerance, hit)
+        : EdgeSegmentBVH::intersectSegment(snapshot.edgeCopy.get(), localStart, localEnd, snapshot.edgeLocalTolerance, hit);
+    if (!found) return false;
+
+    rayParameter = hit.rayParameter;
+
+    result = PickResult();
+    result.hasResult = true;
+    result.geometry = snapshot.geometry;
+    result.worldPosition = toGlm(hit.localPoint * snapshot.edgeMatrix);
+    result.featureType = PickFeatureType::EDGE;
+    result.primitiveIndex = hit.segmentIndex;
+    result.segmentIndex = hit.segmentIndex;
+    result.segmentParameter = hit.parameter;
+    result.osgGeometry = snapshot.edge;
+    result.osgPrimitiveIndex = hit.segmentIndex;
+    return true;
+}
+
+bool RayQueryService::intersectVertex(const GeometrySnapshot& snapshot, const osg::Vec3d& start, const osg::Vec3d& end,
+                                      PickResult& result, double& rayParameter) const
+{
+    const osg::Vec3d localStart = start * snapshot.inverse;
+    const osg::Vec3d direction = end * snapshot.inverse - localStart;
+    const double length2 = direction.length2();
+    const double tolerance2 = snapshot.localTolerance * snapshot.localTolerance;
+
+    int bestIndex = -1;
+    double bestParameter = DBL_MAX;
+    for (size_t i = 0; i < snapshot.vertices.size(); ++i) {
+        const osg::Vec3d vertex(snapshot.vertices[i]);
+        double parameter = length2 > 0.0 ? ((vertex - localStart) * direction) / length2 : 0.0;
+        parameter = std::max(0.0, std::min(1.0, parameter));
+
+        if ((localStart + direction * parameter - vertex).length2() > tolerance2) continue;
+        if (parameter < bestParameter) {
+            bestParameter = parameter;
+            bestIndex = static_cast<int>(i);
+        }
+    }
+    if (bestIndex < 0) return false;
+
+    rayParameter = bestParameter;
+
+    result = PickResult();
+    result.hasResult = true;
+    result.geometry = snapshot.geometry;
+    result.worldPosition = toGlm(osg::Vec3d(snapshot.vertices[bestIndex]) * snapshot.matrix);
+    result.featureType = PickFeatureType::VERTEX;
+    result.primitiveIndex = bestIndex;
+    result.osgGeometry = snapshot.vertex;
+    result.osgPrimitiveIndex = bestIndex;
+    return true;
+}
@@ -0,0 +1,133 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include "PickingTypes.h"
+#include "EdgeSegmentBVH.h"
+#include "../SceneLock.h"
+#include "../world/SceneBVH.h"
+#include <osg/Geometry>
+#include <osg/Matrixd>
+#include <osg/BoundingBox>
+#include <osgUtil/IntersectionVisitor>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+class GeoNodeManager;
+
+// 批量射线查询的一条线段（场景坐标系）
+struct RayQuery
+{
+    glm::dvec3 start{0.0};
+    glm::dvec3 end{0.0};
+
+    RayQuery() = default;
+    RayQuery(const glm::dvec3& segmentStart, const glm::dvec3& segmentEnd) : start(segmentStart), end(segmentEnd) {}
+
+    // 射线：从origin沿direction方向最远maxDistance
+    static RayQuery fromRay(const glm::dvec3& origin, const glm::dvec3& direction, double maxDistance)
+    {
+        return RayQuery(origin, origin + glm::normalize(direction) * maxDistance);
+    }
+};
+
+// 批量射线查询配置
+struct RayQueryConfig
+{
+    bool hitFaces = true;
+    bool hitEdges = false;          // 边和顶点没有面积，需要featureTolerance > 0
+    bool hitVertices = false;
+    double featureTolerance = 0.0;  // 线段到边/顶点的距离不超过此值时命中（场景单位）
+    int threadCount = 0;            // 0表示按CPU核数
+};
+
+// 批量射线查询
+// 供测量、通视分析和脚本采样一次查询成千上万条线段：每条返回沿线段最先命中的对象、特征类型、
+// 位置和法线（PickResult，distance为命中处沿线段到起点的距离，顶点/边命中时法线为零）。
+// 调用线程只在采集快照时持有场景读锁：复制场景BVH、可见对象的包围盒和变换矩阵，求交数据只引用
+// 之后不会再改动的对象（单位网格原型、已建好的KdTree和线段BVH），没有索引的面/边和顶点当场复制，
+// 尚未建索引的大对象顺便提交后台构建。随后释放读锁，工作线程从共享下标按块领取线段，只读快照求交，
+// 结果按输入顺序写回；求交期间主线程可以照常重建、增删对象和换入索引，结果反映采集时的场景。
+class RayQueryService
+{
+public:
+    RayQueryService();
+    ~RayQueryService() = default;
+
+    void setConfig(const RayQueryConfig& config) { m_config = config; }
+    const RayQueryConfig& getConfig() const { return m_config; }
+
+    // 场景BVH粗筛（为空时逐对象比较包围盒）
+    void setSceneBVH(const SceneBVH* sceneBVH) { m_sceneBVH = sceneBVH; }
+    
+    // 场景读写锁（为空时不加锁）
+    void setSceneLock(SceneLock* sceneLock) { m_sceneLock = sceneLock; }
+
+    // 批量查询，results与rays一一对应（未命中时hasResult为false）
+    void query(const std::vector<Geo3D::Ptr>& geometries, const std::vector<RayQuery>& rays,
+               std::vector<PickResult>& results);
+
+    // 上一批的统计
+    size_t getLastSnapshotSize() const { return m_lastSnapshotSize; }
+    int getLastThreadCount() const { return m_lastThreadCount; }
+
+private:
+    // 一个对象的只读快照
+    struct GeometrySnapshot
+    {
+        Geo3D::Ptr geometry;
+        osg::BoundingBox worldBox;
+
+        // 面：引用单位网格时为单位网格坐标。face是对象自己的几何体，只写进结果；
+        // 求交用faceTarget（单位网格原型、挂着已建KdTree的代理或复制的几何体）
+        osg::ref_ptr<osg::Geometry> face;
+        osg::ref_ptr<osg::Geometry> faceTarget;
+        osg::Matrixd faceMatrix;
+        osg::Matrixd faceInverse;
+
+        // 边：引用单位网格时为单位网格坐标，线段BVH随单位网格共享，没有BVH时求交用复制的edgeCopy
+        osg::ref_ptr<osg::Geometry> edge;
+        osg::ref_ptr<osg::Geometry> edgeCopy;
+        osg::ref_ptr<EdgeSegmentBVH> edgeBVH;
+        osg::Matrixd edgeMatrix;
+        osg::Matrixd edgeInverse;
+        double edgeLocalTolerance = 0.0;  // featureTolerance换算到边的局部坐标
+
+        // 点：在对象的变换节点下，坐标复制出来
+        osg::ref_ptr<osg::Geometry> vertex;
+        std::vector<osg::Vec3> vertices;
+        osg::Matrixd matrix;
+        osg::Matrixd inverse;
+        double localTolerance = 0.0;  // featureTolerance换算到局部坐标
+    };
+
+    // 每个工作线程复用的缓冲
+    struct Workspace
+    {
+        std::vector<Geo3D*> candidates;
+        std::vector<std::pair<double, size_t>> entries;  // 进入包围盒的线段参数, 快照下标
+        osgUtil::IntersectionVisitor visitor;
+    };
+
+    void captureSnapshot(const std::vector<Geo3D::Ptr>& geometries);
+    osg::ref_ptr<osg::Geometry> captureFaceTarget(GeoNodeManager* nodeManager, osg::Geometry* face) const;
+    PickResult queryRay(const RayQuery& ray, Workspace& workspace) const;
+    bool intersectFace(const GeometrySnapshot& snapshot, const osg::Vec3d& start, const osg::Vec3d& end,
+                       Workspace& workspace, PickResult& result, double& rayParameter) const;
+    bool intersectEdge(const GeometrySnapshot& snapshot, const osg::Vec3d& start, const osg::Vec3d& end,
+                       PickResult& result, double& rayParameter) const;
+    bool intersectVertex(const GeometrySnapshot& snapshot, const osg::Vec3d& start, const osg::Vec3d& end,
+                         PickResult& result, double& rayParameter) const;
+
+    RayQueryConfig m_config;
+    const SceneBVH* m_sceneBVH;
+    SceneLock* m_sceneLock;
+
+    // 本批快照（查询结束后释放对象引用），场景BVH在读锁内复制一份供工作线程粗筛
+    SceneBVH m_sceneBVHSnapshot;
+    std::vector<GeometrySnapshot> m_snapshots;
+    std::unordered_map<Geo3D*, size_t> m_snapshotIndices;
+
+    size_t m_lastSnapshotSize;
+    int m_lastThreadCount;
+};
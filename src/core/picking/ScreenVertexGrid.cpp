@@ -0,0 +1,340 @@
+﻿#include "ScreenVertexGrid.h"
+#include "GeometryPickingSystem.h"
+#include "../GeometryBase.h"
+#include "../managers/GeoNodeManager.h"
+#include "../../util/Tracer.h"
+#include <osg/NodeVisitor>
+#include <osg/Transform>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <thread>
+
+namespace
+{
+    const double kMinCellSize = 8.0;                  // 格子最小边长（像素）
+    const size_t kMinVerticesPerThread = 16384;       // 顶点少于此数时不值得开线程
+
+    // 收集按NodeMask可见的几何体及其到场景根节点的变换
+    class PickableGeometryCollector : public osg::NodeVisitor
+    {
+    public:
+        typedef std::function<void(osg::Geometry&, Geo3D*, const osg::Matrixd&)> Callback;
+
+        PickableGeometryCollector(unsigned int traversalMask, const Callback& callback)
+            : osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ACTIVE_CHILDREN)
+            , m_callback(callback)
+        {
+            setTraversalMask(traversalMask);
+            m_matrices.push_back(osg::Matrixd());
+        }
+
+        void apply(osg::Transform& transform) override
+        {
+            osg::Matrixd matrix = m_matrices.back();
+            transform.computeLocalToWorldMatrix(matrix, this);
+            m_matrices.push_back(matrix);
+            traverse(transform);
+            m_matrices.pop_back();
+        }
+
+        void apply(osg::Drawable& drawable) override
+        {
+            osg::Geometry* geometry = drawable.asGeometry();
+            if (geometry) {
+                m_callback(*geometry, findOwner(), m_matrices.back());
+            }
+        }
+
+    private:
+        // 与GeometryPickingSystem::findGeometryFromNodePath相同：沿节点路径向上找用户数据
+        Geo3D* findOwner() const
+        {
+            for (auto it = _nodePath.rbegin(); it != _nodePath.rend(); ++it) {
+                if (Geo3D* geometry = dynamic_cast<Geo3D*>((*it)->getUserData())) {
+                    return geometry;
+                }
+            }
+            return nullptr;
+        }
+
+        Callback m_callback;
+        std::vector<osg::Matrixd> m_matrices;
+    };
+
+    // 第0段在当前线程执行，其余各开一个线程
+    template<typename Func>
+    void runParallel(int threadCount, Func func)
+    {
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threadCount; ++i) {
+            workers.emplace_back(func, i);
+        }
+        func(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+}
+
+ScreenVertexGrid::ScreenVertexGrid()
+    : m_viewport{ 0.0, 0.0, 0.0, 0.0 }
+    , m_sceneVersion(0)
+    , m_traversalMask(0)
+    , m_valid(false)
+    , m_cellSize(kMinCellSize)
+    , m_originX(0.0)
+    , m_originY(0.0)
+    , m_columns(0)
+    , m_rows(0)
+    , m_rebuildCount(0)
+{
+}
+
+void ScreenVertexGrid::update(const PickCameraState& cameraState, osg::Group* sceneRoot, unsigned int traversalMask, double pickRadius)
+{
+    if (!cameraState.isValid() || !sceneRoot) {
+        clear();
+        return;
+    }
+
+    const double cellSize = std::max(2.0 * pickRadius, kMinCellSize);
+    if (isUpToDate(cameraState, sceneRoot, traversalMask, cellSize)) return;
+
+    TRACE_ZONE("ScreenVertexGrid::rebuild", "拾取");
+
+    // 先记录版本再收集，收集之后发生的修改会让下一次拾取重建
+    m_sceneVersion = GeoNodeManager::getSceneGeometryVersion();
+    m_viewMatrix = cameraState.viewMatrix;
+    m_projectionMatrix = cameraState.projectionMatrix;
+    m_viewport[0] = cameraState.viewport->x();
+    m_viewport[1] = cameraState.viewport->y();
+    m_viewport[2] = cameraState.viewport->width();
+    m_viewport[3] = cameraState.viewport->height();
+    m_traversalMask = traversalMask;
+    m_cellSize = cellSize;
+
+    m_sceneRoot = sceneRoot;
+    m_children.clear();
+    m_children.reserve(sceneRoot->getNumChildren());
+    for (unsigned int i = 0; i < sceneRoot->getNumChildren(); ++i) {
+        m_children.push_back(sceneRoot->getChild(i));
+    }
+
+    collectSources(sceneRoot, traversalMask);
+    rebuild(cameraState);
+
+    m_valid = true;
+    ++m_rebuildCount;
+}
+
+bool ScreenVertexGrid::isUpToDate(const PickCameraState& cameraState, osg::Group* sceneRoot, unsigned int traversalMask, double cellSize) const
+{
+    if (!m_valid) return false;
+
+    const osg::Viewport* viewport = cameraState.viewport.get();
+    if (viewport->x() != m_viewport[0] || viewport->y() != m_viewport[1] ||
+        viewport->width() != m_viewport[2] || viewport->height() != m_viewport[3]) return false;
+    if (cellSize != m_cellSize || traversalMask != m_traversalMask) return false;
+    if (cameraState.viewMatrix != m_viewMatrix || cameraState.projectionMatrix != m_projectionMatrix) return false;
+    if (GeoNodeManager::getSceneGeometryVersion() != m_sceneVersion) return false;
+
+    // 增删对象不经过几何体版本，逐个比较场景根的子节点
+    if (m_sceneRoot.get() != sceneRoot || m_children.size() != sceneRoot->getNumChildren()) return false;
+    for (unsigned int i = 0; i < sceneRoot->getNumChildren(); ++i) {
+        if (m_children[i].get() != sceneRoot->getChild(i)) return false;
+    }
+    return true;
+}
+
+void ScreenVertexGrid::collectSources(osg::Group* sceneRoot, unsigned int traversalMask)
+{
+    m_sources.clear();
+
+    PickableGeometryCollector collector(traversalMask, [this](osg::Geometry& geometry, Geo3D* owner, const osg::Matrixd& matrix) {
+        const osg::Array* array = geometry.getVertexArray();
+        osg::Vec3d probe;
+        if (!owner || !array || !readVertex(array, 0, probe)) return;  // 空数组或非Vec3/Vec3d顶点
+
+        Source source;
+        source.geometry = &geometry;
+        source.owner = owner;
+        source.localToWorld = matrix;
+        source.vertexCount = array->getNumElements();
+        m_sources.push_back(source);
+    });
+    sceneRoot->accept(collector);
+}
+
+void ScreenVertexGrid::rebuild(const PickCameraState& cameraState)
+{
+    const osg::Viewport* viewport = cameraState.viewport.get();
+
+    // 视口外扩一格，视口边缘的拾取窗口仍能找到视口外的顶点
+    m_originX = viewport->x() - m_cellSize;
+    m_originY = viewport->y() - m_cellSize;
+    m_columns = static_cast<int>(std::ceil(viewport->width() / m_cellSize)) + 2;
+    m_rows = static_cast<int>(std::ceil(viewport->height() / m_cellSize)) + 2;
+    const int cellCount = m_columns * m_rows;
+
+    // 按顶点数把几何体切成连续的几段，每个线程一段
+    size_t totalVertices = 0;
+    for (const Source& source : m_sources) {
+        totalVertices += source.vertexCount;
+    }
+    const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const int threadCount = static_cast<int>(std::max<size_t>(1, std::min(hardwareThreads, totalVertices / kMinVerticesPerThread)));
+
+    std::vector<size_t> segmentBegins(threadCount + 1, m_sources.size());
+    segmentBegins[0] = 0;
+    size_t accumulated = 0;
+    int segment = 1;
+    for (size_t i = 0; i < m_sources.size() && segment < threadCount; ++i) {
+        accumulated += m_sources[i].vertexCount;
+        while (segment < threadCount && accumulated >= totalVertices * segment / threadCount) {
+            segmentBegins[segment++] = i + 1;
+        }
+    }
+
+    // 1. 各线程投影自己那一段，同时统计每个格子的顶点数
+    const osg::Matrixd viewProjection = cameraState.viewMatrix * cameraState.projectionMatrix;
+    std::vector<std::vector<ProjectedVertex>> projected(threadCount);
+    std::vector<std::vector<uint32_t>> cellCursors(threadCount, std::vector<uint32_t>(cellCount, 0));
+
+    runParallel(threadCount, [&](int thread) {
+        std::vector<ProjectedVertex>& output = projected[thread];
+        std::vector<uint32_t>& counts = cellCursors[thread];
+
+        for (size_t s = segmentBegins[thread]; s < segmentBegins[thread + 1]; ++s) {
+            const Source& source = m_sources[s];
+            const osg::Array* array = source.geometry->getVertexArray();
+            const osg::Matrixd localToClip = source.localToWorld * viewProjection;
+
+            for (unsigned int v = 0; v < source.vertexCount; ++v) {
+                osg::Vec3d vertex;
+                if (!readVertex(array, v, vertex)) break;
+
+                const osg::Vec4d clip = osg::Vec4d(vertex, 1.0) * localToClip;
+                if (clip.w() <= 0.0) continue;  // 相机后方
+
+                const double invW = 1.0 / clip.w();
+                const double ndcZ = clip.z() * invW;
+                if (ndcZ < -1.0 || ndcZ > 1.0) continue;  // 近/远裁剪面之外
+
+                ProjectedVertex projectedVertex;
+                projectedVertex.x = static_cast<float>(viewport->x() + (clip.x() * invW + 1.0) * 0.5 * viewport->width());
+                projectedVertex.y = static_cast<float>(viewport->y() + (clip.y() * invW + 1.0) * 0.5 * viewport->height());
+                projectedVertex.depth = static_cast<float>((ndcZ + 1.0) * 0.5);
+                projectedVertex.source = static_cast<uint32_t>(s);
+                projectedVertex.vertex = v;
+
+                const int cell = cellIndex(projectedVertex.x, projectedVertex.y);
+                if (cell < 0) continue;
+
+                output.push_back(projectedVertex);
+                ++counts[cell];
+            }
+        }
+    });
+
+    // 2. 计数转换为各线程在每个格子里的写入位置（格子内按线程顺序排列）
+    m_cellStarts.assign(cellCount + 1, 0);
+    uint32_t offset = 0;
+    for (int cell = 0; cell < cellCount; ++cell) {
+        m_cellStarts[cell] = offset;
+        for (int thread = 0; thread < threadCount; ++thread) {
+            const uint32_t count = cellCursors[thread][cell];
+            cellCursors[thread][cell] = offset;
+            offset += count;
+        }
+    }
+    m_cellStarts[cellCount] = offset;
+
+    // 3. 各线程把自己的顶点写入对应位置，互不重叠
+    m_vertices.resize(offset);
+    runParallel(threadCount, [&](int thread) {
+        std::vector<uint32_t>& cursors = cellCursors[thread];
+        for (const ProjectedVertex& projectedVertex : projected[thread]) {
+            m_vertices[cursors[cellIndex(projectedVertex.x, projectedVertex.y)]++] = projectedVertex;
+        }
+    });
+}
+
+bool ScreenVertexGrid::findNearest(double x, double y, double radius, Hit& hit) const
+{
+    if (!m_valid || m_vertices.empty()) return false;
+
+    const int minColumn = std::max(0, static_cast<int>(std::floor((x - radius - m_originX) / m_cellSize)));
+    const int maxColumn = std::min(m_columns - 1, static_cast<int>(std::floor((x + radius - m_originX) / m_cellSize)));
+    const int minRow = std::max(0, static_cast<int>(std::floor((y - radius - m_originY) / m_cellSize)));
+    const int maxRow = std::min(m_rows - 1, static_cast<int>(std::floor((y + radius - m_originY) / m_cellSize)));
+
+    // 深度最近优先（与多面体拾取器LIMIT_NEAREST一致），深度相同时取离鼠标近的
+    const ProjectedVertex* best = nullptr;
+    double bestScreenDistance2 = 0.0;
+    for (int row = minRow; row <= maxRow; ++row) {
+        for (int column = minColumn; column <= maxColumn; ++column) {
+            const int cell = row * m_columns + column;
+            for (uint32_t i = m_cellStarts[cell]; i < m_cellStarts[cell + 1]; ++i) {
+                const ProjectedVertex& candidate = m_vertices[i];
+                const double dx = candidate.x - x;
+                const double dy = candidate.y - y;
+                if (std::abs(dx) > radius || std::abs(dy) > radius) continue;
+
+                const double screenDistance2 = dx * dx + dy * dy;
+                if (!best || candidate.depth < best->depth ||
+                    (candidate.depth == best->depth && screenDistance2 < bestScreenDistance2)) {
+                    best = &candidate;
+                    bestScreenDistance2 = screenDistance2;
+                }
+            }
+        }
+    }
+    if (!best) return false;
+
+    const Source& source = m_sources[best->source];
+    osg::Vec3d vertex;
+    if (!readVertex(source.geometry->getVertexArray(), best->vertex, vertex)) return false;
+    const osg::Vec3d world = vertex * source.localToWorld;
+
+    hit.geometry = source.owner;
+    hit.osgGeometry = source.geometry;
+    hit.vertexIndex = best->vertex;
+    hit.worldPosition = glm::dvec3(world.x(), world.y(), world.z());
+    hit.windowDepth = best->depth;
+    return true;
+}
+
+void ScreenVertexGrid::clear()
+{
+    m_valid = false;
+    m_sceneRoot = nullptr;
+    m_children.clear();
+    m_sources.clear();
+    m_cellStarts.clear();
+    m_vertices.clear();
+}
+
+int ScreenVertexGrid::cellIndex(float x, float y) const
+{
+    const int column = static_cast<int>(std::floor((x - m_originX) / m_cellSize));
+    const int row = static_cast<int>(std::floor((y - m_originY) / m_cellSize));
+    if (column < 0 || column >= m_columns || row < 0 || row >= m_rows) return -1;
+    return row * m_columns + column;
+}
+
+bool ScreenVertexGrid::readVertex(const osg::Array* array, unsigned int index, osg::Vec3d& vertex)
+{
+    if (!array || index >= array->getNumElements()) return false;
+
+    switch (array->getType()) {
+        case osg::Array::Vec3ArrayType:
+            vertex = osg::Vec3d((*static_cast<const osg::Vec3Array*>(array))[index]);
+            return true;
+        case osg::Array::Vec3dArrayType:
+            vertex = (*static_cast<const osg::Vec3dArray*>(array))[index];
+            return true;
+        default:
+            return false;
+    }
+}
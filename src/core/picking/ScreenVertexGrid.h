@@ -0,0 +1,95 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <osg/Array>
+#include <osg/Geometry>
+#include <osg/Group>
+#include <osg/Matrixd>
+#include <osg/observer_ptr>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// 前向声明
+class Geo3D;
+struct PickCameraState;
+
+// 屏幕空间顶点网格 - 悬停时的顶点/控制点拾取
+// 把场景中所有可拾取的顶点（按NodeMask）一次性投影到窗口坐标，按固定像素大小的格子分桶。
+// 拾取只查鼠标周围拾取半径覆盖的几个格子，不再每次移动鼠标都让多面体拾取器测试全部顶点。
+// 相机矩阵、视口、拾取半径、场景子节点或任一几何体版本（GeoNodeManager::getGeometryVersion）
+// 变化时整体重建；顶点较多时投影和分桶按线程分段并行。
+// 每个视图（拾取系统实例）持有一份，不跨线程共享。
+class ScreenVertexGrid
+{
+public:
+    struct Hit
+    {
+        Geo3D* geometry = nullptr;
+        osg::Geometry* osgGeometry = nullptr;
+        unsigned int vertexIndex = 0;
+        glm::dvec3 worldPosition{ 0.0 };
+        double windowDepth = 1.0;  // 0为近平面，1为远平面
+    };
+
+    ScreenVertexGrid();
+
+    // 相机和场景都没有变化时直接返回，否则重建
+    void update(const PickCameraState& cameraState, osg::Group* sceneRoot, unsigned int traversalMask, double pickRadius);
+
+    // 以(x, y)为中心、边长2*radius的拾取窗口内深度最近的顶点（与多面体拾取器的窗口一致）
+    bool findNearest(double x, double y, double radius, Hit& hit) const;
+
+    void clear();
+
+    size_t getVertexCount() const { return m_vertices.size(); }
+    int getRebuildCount() const { return m_rebuildCount; }
+
+private:
+    // 一个可拾取的顶点数组及其到场景坐标的变换
+    struct Source
+    {
+        osg::Geometry* geometry = nullptr;
+        Geo3D* owner = nullptr;
+        osg::Matrixd localToWorld;
+        unsigned int vertexCount = 0;
+    };
+
+    struct ProjectedVertex
+    {
+        float x;
+        float y;
+        float depth;
+        uint32_t source;
+        uint32_t vertex;
+    };
+
+    bool isUpToDate(const PickCameraState& cameraState, osg::Group* sceneRoot, unsigned int traversalMask, double cellSize) const;
+    void collectSources(osg::Group* sceneRoot, unsigned int traversalMask);
+    void rebuild(const PickCameraState& cameraState);
+    int cellIndex(float x, float y) const;
+
+    static bool readVertex(const osg::Array* array, unsigned int index, osg::Vec3d& vertex);
+
+    // 构建时的输入，用于判断是否过期
+    osg::Matrixd m_viewMatrix;
+    osg::Matrixd m_projectionMatrix;
+    double m_viewport[4];
+    osg::observer_ptr<osg::Group> m_sceneRoot;
+    std::vector<osg::observer_ptr<osg::Node>> m_children;
+    uint64_t m_sceneVersion;
+    unsigned int m_traversalMask;
+    bool m_valid;
+
+    // 网格：覆盖视口并向外扩一格，格子边长不小于拾取窗口
+    double m_cellSize;
+    double m_originX;
+    double m_originY;
+    int m_columns;
+    int m_rows;
+
+    std::vector<Source> m_sources;
+    std::vector<uint32_t> m_cellStarts;        // 格子i的顶点为[m_cellStarts[i], m_cellStarts[i + 1])
+    std::vector<ProjectedVertex> m_vertices;   // 按格子连续存放
+    int m_rebuildCount;
+};
@@ -0,0 +1,724 @@
+﻿#include "SnapEngine.h"
+#include "../GeometryBase.h"
+#include "../managers/GeoNodeManager.h"
+#include "../world/CoordinateSystem3D.h"
+#include "../../util/LogManager.h"
+#include "../../util/MathUtils.h"
+#include "../../util/Tracer.h"
+#include <unordered_set>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    const double kCellSizeFactor = 2.0;            // 格子边长 = 线段平均长度 × 此系数
+    const double kRehashRatio = 4.0;               // 平均长度偏离超过此倍数时重新分桶
+    const size_t kMaxSegmentCells = 64;            // 线段经过的格子超过此数量时单独存放
+    const int kMaxMarchSteps = 1024;               // 射线最多推进的步数（更远的特征在屏幕上已很小）
+    const size_t kMaxIntersectionSegments = 32;    // 求交点时只取屏幕距离最近的32条线段
+    const double kIntersectionPixels = 2.0;        // 两条边在世界中相距不到2像素视为相交
+
+    glm::dvec3 toGlm(const osg::Vec3d& v) { return glm::dvec3(v.x(), v.y(), v.z()); }
+    osg::Vec3d toOsg(const glm::dvec3& v) { return osg::Vec3d(v.x, v.y, v.z); }
+
+    // 类型优先；同一类型时屏幕距离优先、深度其次（与EdgeSegmentBVH::isCloser一致）
+    bool isBetter(const SnapResult& a, const SnapResult& b)
+    {
+        if (b.type == SnapType::NONE) return true;
+        if (a.type != b.type) return a.type < b.type;
+        if (std::abs(a.pixelDistance - b.pixelDistance) > 1.0) {
+            return a.pixelDistance < b.pixelDistance;
+        }
+        return a.depth < b.depth;
+    }
+}
+
+// ============= 构造函数 =============
+
+SnapEngine::SnapEngine()
+    : m_cellSize(0.0)
+    , m_boundsMin(DBL_MAX)
+    , m_boundsMax(-DBL_MAX)
+    , m_segmentLengthSum(0.0)
+    , m_queryStamp(0)
+{
+}
+
+// ============= 对象管理 =============
+
+void SnapEngine::insert(Geo3D* geo)
+{
+    if (!geo) return;
+
+    if (m_entries.emplace(geo, Entry()).second) {
+        m_dirtyGeometries.push_back(geo);
+    } else {
+        markDirty(geo);
+    }
+}
+
+void SnapEngine::markDirty(Geo3D* geo)
+{
+    auto it = m_entries.find(geo);
+    if (it == m_entries.end() || it->second.dirty) return;
+
+    it->second.dirty = true;
+    m_dirtyGeometries.push_back(geo);
+}
+
+void SnapEngine::remove(Geo3D* geo)
+{
+    auto it = m_entries.find(geo);
+    if (it == m_entries.end()) return;
+
+    removeFeatures(it->second);
+    m_entries.erase(it);
+}
+
+void SnapEngine::clear()
+{
+    m_points.clear();
+    m_freePoints.clear();
+    m_segments.clear();
+    m_freeSegments.clear();
+    m_oversizedSegments.clear();
+    m_cells.clear();
+    m_cellSize = 0.0;
+    m_boundsMin = glm::dvec3(DBL_MAX);
+    m_boundsMax = glm::dvec3(-DBL_MAX);
+    m_segmentLengthSum = 0.0;
+    m_entries.clear();
+    m_dirtyGeometries.clear();
+    m_pointStamps.clear();
+    m_segmentStamps.clear();
+    m_queryStamp = 0;
+}
+
+// ============= 特征维护 =============
+
+void SnapEngine::flushDirty()
+{
+    if (m_dirtyGeometries.empty()) return;
+
+    TRACE_ZONE("SnapEngine::flushDirty", "拾取");
+
+    for (Geo3D* geo : m_dirtyGeometries) {
+        auto it = m_entries.find(geo);
+        if (it == m_entries.end() || !it->second.dirty) continue;
+
+        Entry& entry = it->second;
+        entry.dirty = false;
+
+        // 清空再重建的信号可能来自未改变可拾取内容的操作，版本没变就不必重新提取
+        const uint64_t version = geo->mm_node() ? geo->mm_node()->getGeometryVersion() : 0;
+        if (entry.extracted && entry.version == version) continue;
+
+        removeFeatures(entry);
+        extractFeatures(geo, entry);
+        entry.version = version;
+        entry.extracted = true;
+    }
+    m_dirtyGeometries.clear();
+
+    updateCellSize();
+}
+
+void SnapEngine::extractFeatures(Geo3D* geo, Entry& entry)
+{
+    GeoNodeManager* nodeManager = geo->mm_node();
+    if (!nodeManager) return;
+
+    // 点/边几何体在变换节点下，特征统一换算到场景坐标
+    osg::Matrixd matrix;
+    if (nodeManager->getTransformNode().valid()) {
+        matrix = nodeManager->getTransformNode()->getMatrix();
+    }
+    auto toWorld = [&matrix](const osg::Vec3d& point) { return toGlm(point * matrix); };
+
+    // 边引用共享单位网格时还要经过边自己的变换节点
+    const osg::Matrixd edgeMatrix = nodeManager->getEdgeWorldMatrix();
+    auto edgeToWorld = [&edgeMatrix](const osg::Vec3d& point) { return toGlm(point * edgeMatrix); };
+
+    // 同一点在顶点几何体、边几何体和圆心计算中由不同代码得出，按包围盒尺度量化后比较
+    const double quantum = std::max(nodeManager->getBoundingBox().radius() * 1e-6, 1e-9);
+    auto quantize = [quantum](const glm::dvec3& point) {
+        return CellKey{ static_cast<int64_t>(std::llround(point.x / quantum)),
+                        static_cast<int64_t>(std::llround(point.y / quantum)),
+                        static_cast<int64_t>(std::llround(point.z / quantum)) };
+    };
+
+    // 圆心
+    std::vector<glm::dvec3> centers;
+    geo->getSnapCenters(centers);
+    std::unordered_set<CellKey, CellKeyHash> centerKeys;
+    for (const glm::dvec3& center : centers) {
+        const glm::dvec3 worldCenter = toWorld(toOsg(center));
+        if (centerKeys.insert(quantize(worldCenter)).second) {
+            entry.points.push_back(addPoint(worldCenter, geo, SnapType::CENTER));
+        }
+    }
+
+    // 端点：顶点几何体中的点和折线两端（圆心已单独登记）
+    std::vector<glm::dvec3> keyPoints;
+    if (osg::Geometry* vertexGeometry = nodeManager->getVertexGeometry().get()) {
+        if (const osg::Vec3Array* vertices = dynamic_cast<const osg::Vec3Array*>(vertexGeometry->getVertexArray())) {
+            for (const osg::Vec3& vertex : *vertices) {
+                keyPoints.push_back(toWorld(osg::Vec3d(vertex)));
+            }
+        }
+    }
+
+    osg::Geometry* edgeGeometry = nodeManager->getEdgeGeometry().get();
+    if (edgeGeometry) {
+        if (const osg::Vec3Array* vertices = dynamic_cast<const osg::Vec3Array*>(edgeGeometry->getVertexArray())) {
+            for (unsigned int i = 0; i < edgeGeometry->getNumPrimitiveSets(); ++i) {
+                const osg::PrimitiveSet* primitive = edgeGeometry->getPrimitiveSet(i);
+                const unsigned int count = primitive->getNumIndices();
+                if (primitive->getMode() != osg::PrimitiveSet::LINE_STRIP || count < 2) continue;
+
+                const unsigned int first = primitive->index(0);
+                const unsigned int last = primitive->index(count - 1);
+                if (first < vertices->size()) keyPoints.push_back(edgeToWorld(osg::Vec3d((*vertices)[first])));
+                if (last < vertices->size()) keyPoints.push_back(edgeToWorld(osg::Vec3d((*vertices)[last])));
+            }
+        }
+    }
+
+    std::unordered_set<CellKey, CellKeyHash> keyPointKeys;
+    for (const glm::dvec3& point : keyPoints) {
+        const CellKey key = quantize(point);
+        if (!keyPointKeys.insert(key).second || centerKeys.count(key)) continue;
+        entry.points.push_back(addPoint(point, geo, SnapType::ENDPOINT));
+    }
+
+    // 边：两端都是关键点的线段是真实的直边，登记中点；圆弧、圆周的细分线段没有中点
+    if (edgeGeometry) {
+        std::vector<osg::Vec3f> segmentPoints;
+        EdgeSegmentBVH::collectSegments(edgeGeometry, segmentPoints);
+        for (size_t i = 0; i + 1 < segmentPoints.size(); i += 2) {
+            const glm::dvec3 start = edgeToWorld(osg::Vec3d(segmentPoints[i]));
+            const glm::dvec3 end = edgeToWorld(osg::Vec3d(segmentPoints[i + 1]));
+            if (start == end) continue;
+
+            entry.segments.push_back(addSegment(start, end, geo));
+            if (keyPointKeys.count(quantize(start)) && keyPointKeys.count(quantize(end))) {
+                entry.points.push_back(addPoint((start + end) * 0.5, geo, SnapType::MIDPOINT));
+            }
+        }
+    }
+}
+
+void SnapEngine::removeFeatures(Entry& entry)
+{
+    for (uint32_t id : entry.points) {
+        if (m_cellSize > 0.0) unlinkPoint(id);
+        m_points[id].geometry = nullptr;
+        m_freePoints.push_back(id);
+    }
+    for (uint32_t id : entry.segments) {
+        if (m_cellSize > 0.0) unlinkSegment(id);
+        SegmentFeature& segment = m_segments[id];
+        m_segmentLengthSum -= glm::length(segment.end - segment.start);
+        segment.geometry = nullptr;
+        m_freeSegments.push_back(id);
+    }
+    entry.points.clear();
+    entry.segments.clear();
+
+    if (getSegmentCount() == 0) {
+        m_segmentLengthSum = 0.0;  // 避免累计的舍入误差
+    }
+}
+
+uint32_t SnapEngine::addPoint(const glm::dvec3& position, Geo3D* geo, SnapType type)
+{
+    uint32_t id;
+    if (!m_freePoints.empty()) {
+        id = m_freePoints.back();
+        m_freePoints.pop_back();
+    } else {
+        id = static_cast<uint32_t>(m_points.size());
+        m_points.push_back(PointFeature());
+        m_pointStamps.push_back(0);
+    }
+
+    PointFeature& point = m_points[id];
+    point.position = position;
+    point.geometry = geo;
+    point.type = type;
+
+    m_boundsMin = glm::min(m_boundsMin, position);
+    m_boundsMax = glm::max(m_boundsMax, position);
+    if (m_cellSize > 0.0) linkPoint(id);
+    return id;
+}
+
+uint32_t SnapEngine::addSegment(const glm::dvec3& start, const glm::dvec3& end, Geo3D* geo)
+{
+    uint32_t id;
+    if (!m_freeSegments.empty()) {
+        id = m_freeSegments.back();
+        m_freeSegments.pop_back();
+    } else {
+        id = static_cast<uint32_t>(m_segments.size());
+        m_segments.push_back(SegmentFeature());
+        m_segmentStamps.push_back(0);
+    }
+
+    SegmentFeature& segment = m_segments[id];
+    segment.start = start;
+    segment.end = end;
+    segment.geometry = geo;
+    segment.oversized = false;
+
+    m_segmentLengthSum += glm::length(end - start);
+    m_boundsMin = glm::min(m_boundsMin, glm::min(start, end));
+    m_boundsMax = glm::max(m_boundsMax, glm::max(start, end));
+    if (m_cellSize > 0.0) linkSegment(id);
+    return id;
+}
+
+void SnapEngine::linkPoint(uint32_t id)
+{
+    m_cells[cellOf(m_points[id].position)].points.push_back(id);
+}
+
+void SnapEngine::unlinkPoint(uint32_t id)
+{
+    auto it = m_cells.find(cellOf(m_points[id].position));
+    if (it == m_cells.end()) return;
+
+    eraseId(it->second.points, id);
+    if (it->second.points.empty() && it->second.segments.empty()) {
+        m_cells.erase(it);
+    }
+}
+
+void SnapEngine::linkSegment(uint32_t id)
+{
+    SegmentFeature& segment = m_segments[id];
+    if (!collectSegmentCells(segment.start, segment.end, m_cellScratch)) {
+        segment.oversized = true;
+        m_oversizedSegments.push_back(id);
+        return;
+    }
+
+    segment.oversized = false;
+    for (const CellKey& key : m_cellScratch) {
+        m_cells[key].segments.push_back(id);
+    }
+}
+
+void SnapEngine::unlinkSegment(uint32_t id)
+{
+    SegmentFeature& segment = m_segments[id];
+    if (segment.oversized) {
+        eraseId(m_oversizedSegments, id);
+        segment.oversized = false;
+        return;
+    }
+
+    // 格子边长不变时DDA结果与登记时相同
+    collectSegmentCells(segment.start, segment.end, m_cellScratch);
+    for (const CellKey& key : m_cellScratch) {
+        auto it = m_cells.find(key);
+        if (it == m_cells.end()) continue;
+
+        eraseId(it->second.segments, id);
+        if (it->second.points.empty() && it->second.segments.empty()) {
+            m_cells.erase(it);
+        }
+    }
+}
+
+void SnapEngine::updateCellSize()
+{
+    double target = 0.0;
+    if (getSegmentCount() > 0) {
+        target = m_segmentLengthSum / getSegmentCount() * kCellSizeFactor;
+    } else if (getPointCount() > 0) {
+        target = glm::length(m_boundsMax - m_boundsMin) / 64.0;
+    } else {
+        return;
+    }
+    if (!(target > 0.0)) target = 1.0;  // 只有一个点等退化情况
+
+    if (m_cellSize > 0.0 && target < m_cellSize * kRehashRatio && target > m_cellSize / kRehashRatio) {
+        return;
+    }
+    rehash(target);
+}
+
+void SnapEngine::rehash(double cellSize)
+{
+    TRACE_ZONE("SnapEngine::rehash", "拾取");
+
+    m_cells.clear();
+    m_oversizedSegments.clear();
+    m_cellSize = cellSize;
+
+    // 包围盒只在插入时扩张，这里顺便按现存特征收紧
+    m_boundsMin = glm::dvec3(DBL_MAX);
+    m_boundsMax = glm::dvec3(-DBL_MAX);
+    for (uint32_t id = 0; id < m_points.size(); ++id) {
+        if (!m_points[id].geometry) continue;
+        m_boundsMin = glm::min(m_boundsMin, m_points[id].position);
+        m_boundsMax = glm::max(m_boundsMax, m_points[id].position);
+        linkPoint(id);
+    }
+    for (uint32_t id = 0; id < m_segments.size(); ++id) {
+        const SegmentFeature& segment = m_segments[id];
+        if (!segment.geometry) continue;
+        m_boundsMin = glm::min(m_boundsMin, glm::min(segment.start, segment.end));
+        m_boundsMax = glm::max(m_boundsMax, glm::max(segment.start, segment.end));
+        linkSegment(id);
+    }
+
+    LOG_DEBUG(QString("捕捉索引重新分桶: 格子边长=%1, 点=%2, 线段=%3, 格子=%4")
+        .arg(m_cellSize).arg(getPointCount()).arg(getSegmentCount()).arg(m_cells.size()), "拾取");
+}
+
+// ============= 格子 =============
+
+SnapEngine::CellKey SnapEngine::cellOf(const glm::dvec3& point) const
+{
+    return CellKey{ static_cast<int64_t>(std::floor(point.x / m_cellSize)),
+                    static_cast<int64_t>(std::floor(point.y / m_cellSize)),
+                    static_cast<int64_t>(std::floor(point.z / m_cellSize)) };
+}
+
+bool SnapEngine::collectSegmentCells(const glm::dvec3& start, const glm::dvec3& end, std::vector<CellKey>& cells) const
+{
+    cells.clear();
+
+    CellKey cell = cellOf(start);
+    const CellKey last = cellOf(end);
+    cells.push_back(cell);
+
+    // 3D DDA：每次跨过最近的一个格子边界
+    const glm::dvec3 direction = end - start;
+    int64_t* coordinates[3] = { &cell.x, &cell.y, &cell.z };
+    int64_t step[3];
+    double tMax[3];
+    double tDelta[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        if (direction[axis] > 0.0) {
+            step[axis] = 1;
+            tMax[axis] = ((*coordinates[axis] + 1) * m_cellSize - start[axis]) / direction[axis];
+            tDelta[axis] = m_cellSize / direction[axis];
+        } else if (direction[axis] < 0.0) {
+            step[axis] = -1;
+            tMax[axis] = (*coordinates[axis] * m_cellSize - start[axis]) / direction[axis];
+            tDelta[axis] = -m_cellSize / direction[axis];
+        } else {
+            step[axis] = 0;
+            tMax[axis] = DBL_MAX;
+            tDelta[axis] = DBL_MAX;
+        }
+    }
+
+    while (!(cell == last)) {
+        const int axis = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+        if (tMax[axis] > 1.0) {
+            cells.push_back(last);  // 舍入误差导致提前越过终点
+            break;
+        }
+        *coordinates[axis] += step[axis];
+        tMax[axis] += tDelta[axis];
+        cells.push_back(cell);
+        if (cells.size() > kMaxSegmentCells) return false;
+    }
+    return true;
+}
+
+void SnapEngine::eraseId(std::vector<uint32_t>& ids, uint32_t id)
+{
+    auto it = std::find(ids.begin(), ids.end(), id);
+    if (it != ids.end()) {
+        *it = ids.back();
+        ids.pop_back();
+    }
+}
+
+// ============= 查询 =============
+
+bool SnapEngine::isSnappable(Geo3D* geo, const std::vector<Geo3D*>& excluded) const
+{
+    if (!geo || std::find(excluded.begin(), excluded.end(), geo) != excluded.end()) return false;
+
+    // 隐藏或绘制中（NODE_MASK_NOSELECT）的对象不参与
+    osg::Group* node = geo->mm_node() ? geo->mm_node()->getOSGNode().get() : nullptr;
+    return node && (node->getNodeMask() & NODE_MASK_ALL_VISIBLE) != 0;
+}
+
+void SnapEngine::nextQueryStamp()
+{
+    if (++m_queryStamp == 0) {
+        std::fill(m_pointStamps.begin(), m_pointStamps.end(), 0);
+        std::fill(m_segmentStamps.begin(), m_segmentStamps.end(), 0);
+        m_queryStamp = 1;
+    }
+}
+
+bool SnapEngine::snap(const PickCameraState& cameraState, double x, double y,
+                      const std::vector<Geo3D*>& excluded, SnapResult& result)
+{
+    TRACE_ZONE("SnapEngine::snap", "拾取");
+
+    result = SnapResult();
+    if (!m_config.enabled || !cameraState.isValid()) return false;
+
+    flushDirty();
+
+    const osg::Matrixd viewProjection = cameraState.viewMatrix * cameraState.projectionMatrix;
+    const osg::Matrixd windowMatrix = cameraState.viewport->computeWindowMatrix();
+    osg::Matrixd inverse;
+    if (!inverse.invert(viewProjection * windowMatrix)) return false;
+
+    // 光标射线（近平面到远平面），以及两端一个像素对应的世界长度
+    const glm::dvec3 rayStart = toGlm(osg::Vec3d(x, y, 0.0) * inverse);
+    const glm::dvec3 rayEnd = toGlm(osg::Vec3d(x, y, 1.0) * inverse);
+    const glm::dvec3 direction = rayEnd - rayStart;
+    const double nearPixel = glm::length(toGlm(osg::Vec3d(x + 1.0, y, 0.0) * inverse) - rayStart);
+    const double farPixel = glm::length(toGlm(osg::Vec3d(x + 1.0, y, 1.0) * inverse) - rayEnd);
+
+    // 一个像素对应的世界长度与到相机的距离成正比，沿射线参数线性变化（正交投影时为常数）
+    auto pixelSizeAt = [nearPixel, farPixel](double t) { return nearPixel + (farPixel - nearPixel) * t; };
+
+    SnapResult best;
+    auto consider = [&](SnapType type, const glm::dvec3& position, Geo3D* geo) {
+        const osg::Vec4d clip = osg::Vec4d(toOsg(position), 1.0) * viewProjection;
+        if (clip.w() <= 0.0) return;
+
+        const osg::Vec3d window = osg::Vec3d(clip.x() / clip.w(), clip.y() / clip.w(), clip.z() / clip.w()) * windowMatrix;
+        if (window.z() < 0.0 || window.z() > 1.0) return;
+
+        SnapResult candidate;
+        candidate.type = type;
+        candidate.position = position;
+        candidate.geometry = geo;
+        candidate.pixelDistance = std::sqrt((window.x() - x) * (window.x() - x) + (window.y() - y) * (window.y() - y));
+        candidate.depth = window.z();
+        if (candidate.pixelDistance > m_config.radius) return;
+
+        if (isBetter(candidate, best)) {
+            best = candidate;
+        }
+    };
+
+    auto isPointTypeEnabled = [this](SnapType type) {
+        switch (type) {
+            case SnapType::ENDPOINT: return m_config.snapEndpoints;
+            case SnapType::CENTER:   return m_config.snapCenters;
+            case SnapType::MIDPOINT: return m_config.snapMidpoints;
+            default:                 return false;
+        }
+    };
+
+    nextQueryStamp();
+    m_segmentHits.clear();
+    const bool wantSegments = m_config.snapNearest || m_config.snapIntersections;
+
+    auto visitSegment = [&](uint32_t id) {
+        if (m_segmentStamps[id] == m_queryStamp) return;
+        m_segmentStamps[id] = m_queryStamp;
+
+        const SegmentFeature& segment = m_segments[id];
+        if (!isSnappable(segment.geometry, excluded)) return;
+
+        SegmentHit segmentHit;
+        segmentHit.segment = id;
+        if (!EdgeSegmentBVH::projectSegment(toOsg(segment.start), toOsg(segment.end), viewProjection, windowMatrix,
+                                            x, y, segmentHit.hit)) return;
+        if (segmentHit.hit.pixelDistance > m_config.radius) return;
+        m_segmentHits.push_back(segmentHit);
+    };
+
+    // 1. 沿射线由近到远逐格推进
+    const double rayLength = glm::length(direction);
+    if (m_cellSize > 0.0 && rayLength > 0.0 && (getPointCount() > 0 || getSegmentCount() > 0)) {
+        if (wantSegments) {
+            for (uint32_t id : m_oversizedSegments) {
+                visitSegment(id);
+            }
+        }
+
+        // 射线裁剪到特征包围盒：先外扩一个格子求出远端，再按远端的捕捉半径外扩
+        auto clipRay = [&](double margin, double& tEnter, double& tExit) {
+            tEnter = 0.0;
+            tExit = 1.0;
+            for (int axis = 0; axis < 3; ++axis) {
+                const double minimum = m_boundsMin[axis] - margin;
+                const double maximum = m_boundsMax[axis] + margin;
+                if (direction[axis] == 0.0) {
+                    if (rayStart[axis] < minimum || rayStart[axis] > maximum) return false;
+                    continue;
+                }
+                double t0 = (minimum - rayStart[axis]) / direction[axis];
+                double t1 = (maximum - rayStart[axis]) / direction[axis];
+                if (t0 > t1) std::swap(t0, t1);
+                tEnter = std::max(tEnter, t0);
+                tExit = std::min(tExit, t1);
+                if (tEnter > tExit) return false;
+            }
+            return true;
+        };
+
+        double tEnter = 0.0;
+        double tExit = 1.0;
+        bool clipped = clipRay(m_cellSize, tEnter, tExit);
+        if (clipped) {
+            clipped = clipRay(m_cellSize + m_config.radius * pixelSizeAt(tExit), tEnter, tExit);
+        }
+
+        if (clipped) {
+            bool hasPrevious = false;
+            CellKey previousMin{ 0, 0, 0 };
+            CellKey previousMax{ 0, 0, 0 };
+            bool found = false;
+            double tStop = tExit;
+
+            auto visitCell = [&](const Cell& cell) {
+                for (uint32_t id : cell.points) {
+                    if (m_pointStamps[id] == m_queryStamp) continue;
+                    m_pointStamps[id] = m_queryStamp;
+
+                    const PointFeature& feature = m_points[id];
+                    if (!isPointTypeEnabled(feature.type) || !isSnappable(feature.geometry, excluded)) continue;
+                    consider(feature.type, feature.position, feature.geometry);
+                }
+                if (wantSegments) {
+                    for (uint32_t id : cell.segments) {
+                        visitSegment(id);
+                    }
+                }
+            };
+
+            double t = tEnter;
+            for (int stepIndex = 0; stepIndex < kMaxMarchSteps && t <= tStop; ++stepIndex) {
+                // 每步至少一个格子；缩得很远时捕捉半径覆盖多个格子，按半径跨步
+                const double tNext = t + std::max(m_cellSize, m_config.radius * pixelSizeAt(t)) / rayLength;
+                const glm::dvec3 point = rayStart + direction * ((t + tNext) * 0.5);
+
+                // 盒子覆盖本步的射线段及其远端的整个捕捉半径
+                const double reach = (tNext - t) * rayLength * 0.5 + m_config.radius * pixelSizeAt(tNext) + m_cellSize * 0.5;
+                const CellKey minCell = cellOf(point - glm::dvec3(reach));
+                const CellKey maxCell = cellOf(point + glm::dvec3(reach));
+
+                // 上一步已检查过的格子
+                auto isPrevious = [&](int64_t cx, int64_t cy, int64_t cz) {
+                    return hasPrevious &&
+                           cx >= previousMin.x && cx <= previousMax.x &&
+                           cy >= previousMin.y && cy <= previousMax.y &&
+                           cz >= previousMin.z && cz <= previousMax.z;
+                };
+
+                const double boxCells = (maxCell.x - minCell.x + 1.0) * (maxCell.y - minCell.y + 1.0) * (maxCell.z - minCell.z + 1.0);
+                if (boxCells > static_cast<double>(m_cells.size())) {
+                    // 盒子比非空格子还多时直接遍历非空格子
+                    for (const auto& pair : m_cells) {
+                        const CellKey& key = pair.first;
+                        if (key.x < minCell.x || key.x > maxCell.x ||
+                            key.y < minCell.y || key.y > maxCell.y ||
+                            key.z < minCell.z || key.z > maxCell.z) continue;
+                        if (isPrevious(key.x, key.y, key.z)) continue;
+                        visitCell(pair.second);
+                    }
+                } else {
+                    for (int64_t cx = minCell.x; cx <= maxCell.x; ++cx) {
+                        for (int64_t cy = minCell.y; cy <= maxCell.y; ++cy) {
+                            for (int64_t cz = minCell.z; cz <= maxCell.z; ++cz) {
+                                if (isPrevious(cx, cy, cz)) continue;
+
+                                auto it = m_cells.find(CellKey{ cx, cy, cz });
+                                if (it != m_cells.end()) visitCell(it->second);
+                            }
+                        }
+                    }
+                }
+
+                hasPrevious = true;
+                previousMin = minCell;
+                previousMax = maxCell;
+
+                // 找到候选后再推进一个捕捉半径的世界长度，身后半径内的高优先级特征（如边后面的端点）也参与比较
+                if (!found && (best.type != SnapType::NONE || !m_segmentHits.empty())) {
+                    found = true;
+                    tStop = std::min(tStop, tNext + m_config.radius * pixelSizeAt(tNext) / rayLength);
+                }
+                t = tNext;
+            }
+        }
+    }
+
+    // 2. 边与边的交点（只在屏幕距离最近的若干条线段之间求）
+    if (m_config.snapIntersections && m_segmentHits.size() >= 2) {
+        std::sort(m_segmentHits.begin(), m_segmentHits.end(), [](const SegmentHit& a, const SegmentHit& b) {
+            return a.hit.pixelDistance < b.hit.pixelDistance;
+        });
+        const size_t count = std::min(m_segmentHits.size(), kMaxIntersectionSegments);
+
+        for (size_t i = 0; i < count; ++i) {
+            const SegmentFeature& a = m_segments[m_segmentHits[i].segment];
+            for (size_t j = i + 1; j < count; ++j) {
+                const SegmentFeature& b = m_segments[m_segmentHits[j].segment];
+
+                double s = 0.0;
+                double t = 0.0;
+                const double distance2 = MathUtils::closestPointsBetweenSegments(a.start, a.end, b.start, b.end, s, t);
+                const glm::dvec3 point = ((a.start + (a.end - a.start) * s) + (b.start + (b.end - b.start) * t)) * 0.5;
+
+                const double rayT = glm::dot(point - rayStart, direction) / (rayLength * rayLength);
+                const double tolerance = kIntersectionPixels * pixelSizeAt(glm::clamp(rayT, 0.0, 1.0));
+                const double tolerance2 = tolerance * tolerance;
+                if (distance2 > tolerance2) continue;
+
+                // 折线相邻线段在公共端点处相接，不算交点
+                auto atEndpoint = [&point, tolerance2](const SegmentFeature& segment) {
+                    return glm::dot(point - segment.start, point - segment.start) <= tolerance2 ||
+                           glm::dot(point - segment.end, point - segment.end) <= tolerance2;
+                };
+                if (atEndpoint(a) && atEndpoint(b)) continue;
+
+                consider(SnapType::INTERSECTION, point, a.geometry);
+            }
+        }
+    }
+
+    // 3. 边上最近点
+    if (m_config.snapNearest && !m_segmentHits.empty()) {
+        const SegmentHit* nearest = &m_segmentHits.front();
+        for (const SegmentHit& segmentHit : m_segmentHits) {
+            if (EdgeSegmentBVH::isCloser(segmentHit.hit, nearest->hit)) nearest = &segmentHit;
+        }
+        consider(SnapType::NEAREST, toGlm(nearest->hit.localPoint), m_segments[nearest->segment].geometry);
+    }
+
+    // 4. 坐标网格：射线与可见网格平面的交点取整到网格间距
+    if (m_config.snapGrid) {
+        CoordinateSystem3D* coordinateSystem = CoordinateSystem3D::getInstance();
+        const double spacing = coordinateSystem->getGridSpacing();
+        if (coordinateSystem->isGridVisible() && spacing > 0.0) {
+            const GridPlane3D planes[3] = { GridPlane_XY3D, GridPlane_YZ3D, GridPlane_XZ3D };
+            const int normalAxes[3] = { 2, 0, 1 };
+            for (int i = 0; i < 3; ++i) {
+                const int axis = normalAxes[i];
+                if (!coordinateSystem->isGridPlaneVisible(planes[i]) || direction[axis] == 0.0) continue;
+
+                const double t = -rayStart[axis] / direction[axis];
+                if (t < 0.0 || t > 1.0) continue;
+
+                glm::dvec3 gridPoint = rayStart + direction * t;
+                for (int k = 0; k < 3; ++k) {
+                    gridPoint[k] = k == axis ? 0.0 : std::round(gridPoint[k] / spacing) * spacing;
+                }
+                consider(SnapType::GRID, gridPoint, nullptr);
+            }
+        }
+    }
+
+    if (best.type == SnapType::NONE) return false;
+    result = best;
+    return true;
+}
@@ -0,0 +1,175 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include "PickingTypes.h"
+#include "GeometryPickingSystem.h"
+#include "EdgeSegmentBVH.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// 前向声明
+class Geo3D;
+
+// 捕捉配置
+struct SnapConfig
+{
+    bool enabled = true;
+    bool snapEndpoints = true;
+    bool snapCenters = true;
+    bool snapIntersections = true;
+    bool snapMidpoints = true;
+    bool snapNearest = true;
+    bool snapGrid = true;       // 仅在坐标网格可见时生效
+    double radius = 10.0;       // 捕捉半径（像素）
+};
+
+// 捕捉结果
+struct SnapResult
+{
+    SnapType type = SnapType::NONE;
+    glm::dvec3 position{0.0};
+    Geo3D* geometry = nullptr;  // 网格捕捉时为空
+    double pixelDistance = 0.0;
+    double depth = 1.0;         // 窗口深度，0为近平面
+};
+
+// 捕捉引擎
+// 端点、直边中点和圆心按点，边按线段存入世界坐标的均匀空间哈希，线段按DDA登记到经过的每个格子
+// （经过格子过多的长线段单独存放，每次查询都测试）。对象变化时只标记为脏，下次查询前重新提取
+// 该对象的特征，其余对象不动。查询沿光标射线由近到远逐格推进，只检查射线周围捕捉半径覆盖的格子，
+// 在屏幕空间按类型优先级和像素距离选取；找到候选后再推进一个捕捉半径的世界长度即停止，优先捕捉前面的对象。
+// 每步至少一个格子，捕捉半径大于格子时按半径跨步，盒子格子数超过非空格子数时改为遍历非空格子。
+// 格子边长取线段平均长度的两倍，平均长度偏离超过4倍时整体重新分桶。只在主线程使用。
+class SnapEngine
+{
+public:
+    SnapEngine();
+    ~SnapEngine() = default;
+
+    // ============= 对象管理 =============
+    void insert(Geo3D* geo);
+    void markDirty(Geo3D* geo);  // 几何重建、变换或状态变化后调用，下次查询前重新提取
+    void remove(Geo3D* geo);
+    void clear();
+
+    // ============= 配置 =============
+    void setConfig(const SnapConfig& config) { m_config = config; }
+    const SnapConfig& getConfig() const { return m_config; }
+
+    // ============= 查询 =============
+    // 窗口坐标(x, y)附近的捕捉点（坐标约定与GeometryPickingSystem::pickGeometry相同），
+    // excluded中的对象（正在绘制或拖动的对象）不参与
+    bool snap(const PickCameraState& cameraState, double x, double y,
+              const std::vector<Geo3D*>& excluded, SnapResult& result);
+
+    size_t getPointCount() const { return m_points.size() - m_freePoints.size(); }
+    size_t getSegmentCount() const { return m_segments.size() - m_freeSegments.size(); }
+    size_t getCellCount() const { return m_cells.size(); }
+    double getCellSize() const { return m_cellSize; }
+
+private:
+    struct CellKey
+    {
+        int64_t x, y, z;
+        bool operator==(const CellKey& other) const { return x == other.x && y == other.y && z == other.z; }
+    };
+
+    struct CellKeyHash
+    {
+        size_t operator()(const CellKey& key) const
+        {
+            return static_cast<size_t>(key.x * 73856093LL ^ key.y * 19349663LL ^ key.z * 83492791LL);
+        }
+    };
+
+    struct PointFeature
+    {
+        glm::dvec3 position{0.0};
+        Geo3D* geometry = nullptr;   // 为空表示空闲
+        SnapType type = SnapType::NONE;
+    };
+
+    struct SegmentFeature
+    {
+        glm::dvec3 start{0.0};
+        glm::dvec3 end{0.0};
+        Geo3D* geometry = nullptr;   // 为空表示空闲
+        bool oversized = false;      // 经过格子过多，存放在m_oversizedSegments中
+    };
+
+    struct Cell
+    {
+        std::vector<uint32_t> points;
+        std::vector<uint32_t> segments;
+    };
+
+    // 每个对象登记的特征
+    struct Entry
+    {
+        std::vector<uint32_t> points;
+        std::vector<uint32_t> segments;
+        uint64_t version = 0;
+        bool dirty = true;
+        bool extracted = false;
+    };
+
+    // 查询中落在捕捉半径内的线段
+    struct SegmentHit
+    {
+        uint32_t segment;
+        EdgeSegmentBVH::Hit hit;
+    };
+
+    // ============= 特征维护 =============
+    void flushDirty();
+    void extractFeatures(Geo3D* geo, Entry& entry);
+    void removeFeatures(Entry& entry);
+    uint32_t addPoint(const glm::dvec3& position, Geo3D* geo, SnapType type);
+    uint32_t addSegment(const glm::dvec3& start, const glm::dvec3& end, Geo3D* geo);
+    void linkPoint(uint32_t id);
+    void unlinkPoint(uint32_t id);
+    void linkSegment(uint32_t id);
+    void unlinkSegment(uint32_t id);
+    void updateCellSize();
+    void rehash(double cellSize);
+
+    // ============= 格子 =============
+    CellKey cellOf(const glm::dvec3& point) const;
+    bool collectSegmentCells(const glm::dvec3& start, const glm::dvec3& end, std::vector<CellKey>& cells) const;  // 超过上限返回false
+    static void eraseId(std::vector<uint32_t>& ids, uint32_t id);
+
+    // ============= 查询 =============
+    bool isSnappable(Geo3D* geo, const std::vector<Geo3D*>& excluded) const;
+    void nextQueryStamp();
+
+    SnapConfig m_config;
+
+    // 特征池（空闲下标复用）
+    std::vector<PointFeature> m_points;
+    std::vector<uint32_t> m_freePoints;
+    std::vector<SegmentFeature> m_segments;
+    std::vector<uint32_t> m_freeSegments;
+    std::vector<uint32_t> m_oversizedSegments;
+
+    // 空间哈希
+    std::unordered_map<CellKey, Cell, CellKeyHash> m_cells;
+    double m_cellSize;  // 0表示尚未分桶
+    glm::dvec3 m_boundsMin;
+    glm::dvec3 m_boundsMax;
+    double m_segmentLengthSum;
+
+    // 对象 -> 特征
+    std::unordered_map<Geo3D*, Entry> m_entries;
+    std::vector<Geo3D*> m_dirtyGeometries;
+
+    // 查询去重（一个特征可能出现在多个格子里）
+    std::vector<uint32_t> m_pointStamps;
+    std::vector<uint32_t> m_segmentStamps;
+    uint32_t m_queryStamp;
+
+    // 复用的缓冲
+    std::vector<CellKey> m_cellScratch;
+    std::vector<SegmentHit> m_segmentHits;
+};
@@ -0,0 +1,565 @@
+﻿#include "GeoEntityStore.h"
+#include "../GeometryBase.h"
+#include "../managers/GeoControlPointManager.h"
+#include "../managers/GeoNodeManager.h"
+#include "../managers/GeoStateManager.h"
+#include "../../util/GeometryFactory.h"
+#include "../../util/LogManager.h"
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+
+namespace
+{
+    const uint32_t kInitialPointCapacity = 4;
+
+    BoundingBox3D toBoundingBox3D(const osg::BoundingBox& box)
+    {
+        if (!box.valid()) return BoundingBox3D();
+        return BoundingBox3D(glm::dvec3(box.xMin(), box.yMin(), box.zMin()),
+                             glm::dvec3(box.xMax(), box.yMax(), box.zMax()));
+    }
+
+    bool intersects(const BoundingBox3D& a, const BoundingBox3D& b)
+    {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x
+            && a.min.y <= b.max.y && a.max.y >= b.min.y
+            && a.min.z <= b.max.z && a.max.z >= b.min.z;
+    }
+}
+
+GeoEntityStore::GeoEntityStore()
+    : m_aliveCount(0)
+    , m_deadPoints(0)
+{
+}
+
+void GeoEntityStore::reserve(size_t entityCount, size_t pointCount)
+{
+    m_types.reserve(entityCount);
+    m_generations.reserve(entityCount);
+    m_states.reserve(entityCount);
+    m_styles.reserve(entityCount);
+    m_bounds.reserve(entityCount);
+    m_pointRanges.reserve(entityCount);
+    m_stageLayouts.reserve(entityCount);
+    m_facades.reserve(entityCount);
+    m_points.reserve(pointCount);
+}
+
+void GeoEntityStore::clear()
+{
+    m_types.clear();
+    m_generations.clear();
+    m_states.clear();
+    m_styles.clear();
+    m_bounds.clear();
+    m_pointRanges.clear();
+    m_stageLayouts.clear();
+    m_facades.clear();
+    m_freeSlots.clear();
+    m_points.clear();
+    m_aliveCount = 0;
+    m_deadPoints = 0;
+}
+
+// ============= 实体 =============
+
+GeoEntity GeoEntityStore::create(GeoType3D type, const GeoStyle* style)
+{
+    uint32_t index = allocateSlot(type, style);
+    return GeoEntity{ index, m_generations[index] };
+}
+
+GeoEntity GeoEntityStore::createFromStages(GeoType3D type, const std::vector<std::vector<Point3D>>& stages, const GeoStyle* style)
+{
+    GeoEntity entity = create(type, style);
+
+    // 与GeoControlPointManager::restoreStages相同的重放顺序
+    for (const auto& stagePoints : stages) {
+        int state = m_states[entity.index];
+        if (state & (GeoState_Complete3D | GeoState_Invalid3D)) break;
+
+        int stageIdx = m_stageLayouts[entity.index].count;
+        for (const Point3D& point : stagePoints) {
+            if (m_states[entity.index] & GeoState_Complete3D) break;
+            addControlPoint(entity, point);
+        }
+
+        if (!(m_states[entity.index] & GeoState_Complete3D) && m_stageLayouts[entity.index].count == stageIdx) {
+            nextStage(entity);
+        }
+    }
+    return entity;
+}
+
+void GeoEntityStore::destroy(GeoEntity entity)
+{
+    if (!isAlive(entity)) return;
+
+    releasePoints(entity.index);
+    m_states[entity.index] = 0;
+    m_stageLayouts[entity.index] = StageLayout();
+    m_bounds[entity.index] = BoundingBox3D();
+    m_styles[entity.index] = nullptr;
+    m_facades[entity.index] = nullptr;
+    ++m_generations[entity.index];
+    m_freeSlots.push_back(entity.index);
+    --m_aliveCount;
+}
+
+bool GeoEntityStore::isAlive(GeoEntity entity) const
+{
+    return entity.index < m_types.size()
+        && m_generations[entity.index] == entity.generation
+        && (m_states[entity.index] & FLAG_ALIVE);
+}
+
+void GeoEntityStore::setState(GeoEntity entity, int state)
+{
+    assert(isAlive(entity));
+    m_states[entity.index] = (m_states[entity.index] & ~STATE_MASK) | (state & STATE_MASK);
+}
+
+void GeoEntityStore::setStyle(GeoEntity entity, const GeoStyle* style)
+{
+    assert(isAlive(entity) && style);
+    m_styles[entity.index] = style;
+}
+
+void GeoEntityStore::setFacade(GeoEntity entity, Geo3D* geo)
+{
+    assert(isAlive(entity));
+    m_facades[entity.index] = geo;
+}
+
+std::vector<std::vector<Point3D>> GeoEntityStore::getStages(GeoEntity entity) const
+{
+    Stages stages;
+    gatherStages(entity.index, stages);
+    return stages;
+}
+
+// ============= 绘制系统 =============
+
+bool GeoEntityStore::addControlPoint(GeoEntity entity, const Point3D& point)
+{
+    assert(isAlive(entity));
+    const uint32_t index = entity.index;
+    if (m_states[index] & (GeoState_Complete3D | GeoState_Invalid3D)) return false;
+
+    const StageDescriptors& descriptors = getStageDescriptors(m_types[index]);
+    StageLayout& layout = m_stageLayouts[index];
+    const int stageIdx = layout.count - 1;
+    assert(stageIdx >= 0 && stageIdx < static_cast<int>(descriptors.size()));
+    const StageDescriptor& descriptor = descriptors[stageIdx];
+
+    glm::dvec3 position = point.position;
+    if (descriptor.constraint) {
+        gatherStages(index, m_scratchStages);
+        position = descriptor.constraint(point, m_scratchStages).position;
+    }
+
+    appendPoint(index, position);
+    ++layout.ends[stageIdx];
+    m_states[index] |= FLAG_BOUNDS_DIRTY;
+
+    if (static_cast<int>(layout.size(stageIdx)) == descriptor.maxControlPoints) {
+        nextStage(entity);
+    }
+    return true;
+}
+
+bool GeoEntityStore::nextStage(GeoEntity entity)
+{
+    assert(isAlive(entity));
+    const uint32_t index = entity.index;
+    const StageDescriptors& descriptors = getStageDescriptors(m_types[index]);
+    StageLayout& layout = m_stageLayouts[index];
+    const int stageIdx = layout.count - 1;
+
+    if (static_cast<int>(layout.size(stageIdx)) < descriptors[stageIdx].minControlPoints) {
+        m_states[index] |= GeoState_Invalid3D;
+        return false;
+    }
+
+    if (layout.count == descriptors.size()) {
+        m_states[index] |= GeoState_Complete3D;
+        return false;
+    }
+
+    assert(layout.count < MAX_STAGES);
+    layout.ends[layout.count] = layout.ends[stageIdx];
+    ++layout.count;
+    return true;
+}
+
+bool GeoEntityStore::setControlPoint(GeoEntity entity, int globalIndex, const Point3D& point)
+{
+    assert(isAlive(entity) && (m_states[entity.index] & GeoState_Complete3D) && "应该在绘制完成后调用");
+    const PointRange& range = m_pointRanges[entity.index];
+    if (globalIndex < 0 || static_cast<uint32_t>(globalIndex) >= range.count) return false;
+
+    glm::dvec3& target = m_points[range.offset + globalIndex];
+    if (target == point.position) return true;
+
+    target = point.position;
+    m_states[entity.index] |= FLAG_BOUNDS_DIRTY;
+    m_states[entity.index] &= ~FLAG_BOUNDS_EXACT;
+    return true;
+}
+
+bool GeoEntityStore::syncControlPoints(GeoEntity entity, Geo3D* geo)
+{
+    if (!geo || !isAlive(entity)) return false;
+
+    if (!gatherFacadeStages(geo, m_scratchStages)) return false;
+    assignStages(entity.index, m_scratchStages);
+
+    // 精确包围盒由外观重建网格后通过setBounds更新；还没有网格时按控制点重新估算
+    if (!(m_states[entity.index] & FLAG_BOUNDS_EXACT)) {
+        estimateBounds(entity.index);
+    }
+    return true;
+}
+
+// ============= 状态系统 =============
+
+void GeoEntityStore::setStateBits(GeoEntity entity, int bits)
+{
+    assert(isAlive(entity));
+    m_states[entity.index] |= (bits & STATE_MASK);
+}
+
+void GeoEntityStore::clearStateBits(GeoEntity entity, int bits)
+{
+    assert(isAlive(entity));
+    m_states[entity.index] &= ~(bits & STATE_MASK);
+}
+
+void GeoEntityStore::clearStateBitsAll(int bits)
+{
+    const int mask = ~(bits & STATE_MASK);
+    for (int& state : m_states) {
+        state &= mask;
+    }
+}
+
+size_t GeoEntityStore::countState(int bits) const
+{
+    const int required = (bits & STATE_MASK) | FLAG_ALIVE;
+    return static_cast<size_t>(std::count_if(m_states.begin(), m_states.end(),
+        [required](int state) { return (state & required) == required; }));
+}
+
+// ============= 包围盒系统 =============
+
+void GeoEntityStore::setBounds(GeoEntity entity, const BoundingBox3D& box)
+{
+    assert(isAlive(entity));
+    if (!box.isValid()) {
+        estimateBounds(entity.index);
+        return;
+    }
+    m_bounds[entity.index] = box;
+    m_states[entity.index] = (m_states[entity.index] & ~FLAG_BOUNDS_DIRTY) | FLAG_BOUNDS_EXACT;
+}
+
+void GeoEntityStore::updateBounds()
+{
+    for (uint32_t i = 0; i < m_states.size(); ++i) {
+        if ((m_states[i] & (FLAG_ALIVE | FLAG_BOUNDS_DIRTY)) == (FLAG_ALIVE | FLAG_BOUNDS_DIRTY)) {
+            estimateBounds(i);
+        }
+    }
+}
+
+void GeoEntityStore::queryBounds(const BoundingBox3D& box, std::vector<GeoEntity>& results) const
+{
+    for (uint32_t i = 0; i < m_bounds.size(); ++i) {
+        if ((m_states[i] & FLAG_ALIVE) && m_bounds[i].isValid() && intersects(m_bounds[i], box)) {
+            results.push_back(GeoEntity{ i, m_generations[i] });
+        }
+    }
+}
+
+BoundingBox3D GeoEntityStore::computeTotalBounds() const
+{
+    BoundingBox3D total;
+    for (uint32_t i = 0; i < m_bounds.size(); ++i) {
+        if ((m_states[i] & FLAG_ALIVE) && m_bounds[i].isValid()) {
+            total.expand(m_bounds[i]);
+        }
+    }
+    return total;
+}
+
+// ============= Geo3D外观 =============
+
+osg::ref_ptr<Geo3D> GeoEntityStore::materialize(GeoEntity entity) const
+{
+    if (!isAlive(entity)) return nullptr;
+
+    Geo3D::Ptr geo = GeometryFactory::createGeometry(m_types[entity.index]);
+    if (!geo) return nullptr;
+
+    geo->setParameters(m_styles[entity.index]->getParameters());
+
+    // 控制点已经过约束，重放时约束结果不变
+    Stages stages;
+    gatherStages(entity.index, stages);
+    if (m_states[entity.index] & GeoState_Complete3D) {
+        geo->mm_controlPoint()->restoreStages(stages);
+    } else {
+        // 未完成的对象停在最后一个阶段，继续交互绘制
+        for (size_t stageIdx = 0; stageIdx < stages.size(); ++stageIdx) {
+            for (const Point3D& point : stages[stageIdx]) {
+                geo->mm_controlPoint()->addControlPoint(point);
+            }
+            if (stageIdx + 1 < stages.size() && geo->mm_controlPoint()->getAllStageControlPoints().size() == stageIdx + 1) {
+                geo->mm_controlPoint()->nextStage();
+            }
+        }
+    }
+
+    if (m_states[entity.index] & GeoState_Selected3D) geo->mm_state()->setStateSelected();
+    return geo;
+}
+
+GeoEntity GeoEntityStore::capture(Geo3D* geo)
+{
+    if (!geo) return GeoEntity();
+
+    GeoEntity entity = create(geo->getGeoType(), geo->getStyle());
+    if (!captureInto(entity.index, geo)) {
+        destroy(entity);
+        return GeoEntity();
+    }
+    return entity;
+}
+
+bool GeoEntityStore::sync(GeoEntity entity, Geo3D* geo)
+{
+    if (!geo || !isAlive(entity)) return false;
+    return captureInto(entity.index, geo);
+}
+
+// ============= 维护 =============
+
+void GeoEntityStore::compact()
+{
+    if (m_deadPoints == 0) return;
+
+    size_t livePoints = m_points.size() - m_deadPoints;
+    std::vector<glm::dvec3> points;
+    points.reserve(livePoints);
+
+    for (uint32_t i = 0; i < m_pointRanges.size(); ++i) {
+        PointRange& range = m_pointRanges[i];
+        if (!(m_states[i] & FLAG_ALIVE) || range.capacity == 0) {
+            range = PointRange();
+            continue;
+        }
+        uint32_t offset = static_cast<uint32_t>(points.size());
+        points.insert(points.end(), m_points.begin() + range.offset, m_points.begin() + range.offset + range.count);
+        range.offset = offset;
+        range.capacity = range.count;
+    }
+
+    LOG_DEBUG(QString("实体点池压缩: %1 -> %2").arg(m_points.size()).arg(points.size()), "实体存储");
+    m_points.swap(points);
+    m_deadPoints = 0;
+}
+
+size_t GeoEntityStore::getMemoryUsage() const
+{
+    return m_types.capacity() * sizeof(GeoType3D)
+        + m_generations.capacity() * sizeof(uint32_t)
+        + m_states.capacity() * sizeof(int)
+        + m_styles.capacity() * sizeof(osg::ref_ptr<const GeoStyle>)
+        + m_bounds.capacity() * sizeof(BoundingBox3D)
+        + m_pointRanges.capacity() * sizeof(PointRange)
+        + m_stageLayouts.capacity() * sizeof(StageLayout)
+        + m_facades.capacity() * sizeof(Geo3D*)
+        + m_freeSlots.capacity() * sizeof(uint32_t)
+        + m_points.capacity() * sizeof(glm::dvec3);
+}
+
+const StageDescriptors& GeoEntityStore::getStageDescriptors(GeoType3D type)
+{
+    // 阶段描述是各几何类的静态数据，原型对象销毁后引用仍然有效
+    static std::mutex s_mutex;
+    static std::vector<const StageDescriptors*> s_descriptors(EndGeoType3D - BeginGeoType3D, nullptr);
+    static const StageDescriptors s_empty;
+
+    if (type <= BeginGeoType3D || type >= EndGeoType3D) return s_empty;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    const StageDescriptors*& descriptors = s_descriptors[type - BeginGeoType3D];
+    if (!descriptors) {
+        Geo3D::Ptr prototype = GeometryFactory::createGeometry(type);
+        descriptors = prototype ? &prototype->getStageDescriptors() : &s_empty;
+    }
+    return *descriptors;
+}
+
+// ============= 内部 =============
+
+uint32_t GeoEntityStore::allocateSlot(GeoType3D type, const GeoStyle* style)
+{
+    uint32_t index;
+    if (!m_freeSlots.empty()) {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        index = static_cast<uint32_t>(m_types.size());
+        m_types.push_back(type);
+        m_generations.push_back(0);
+        m_states.push_back(0);
+        m_styles.emplace_back();
+        m_bounds.emplace_back();
+        m_pointRanges.emplace_back();
+        m_stageLayouts.emplace_back();
+        m_facades.push_back(nullptr);
+    }
+
+    m_types[index] = type;
+    m_states[index] = FLAG_ALIVE | GeoState_Initialized3D;
+    if (style) {
+        m_styles[index] = style;
+    } else {
+        m_styles[index] = GeoStyleTable::getInstance().getDefaultStyle();
+    }
+    m_bounds[index] = BoundingBox3D();
+    m_pointRanges[index] = PointRange();
+    m_stageLayouts[index] = StageLayout();
+    m_stageLayouts[index].count = 1;  // 与控制点管理器一致，默认有一个空的阶段
+    ++m_aliveCount;
+    return index;
+}
+
+void GeoEntityStore::appendPoint(uint32_t index, const glm::dvec3& point)
+{
+    PointRange& range = m_pointRanges[index];
+    if (range.count == range.capacity) {
+        uint32_t capacity = std::max(kInitialPointCapacity, range.capacity * 2);
+        if (range.capacity > 0 && range.offset + range.capacity == m_points.size()) {
+            // 区间在池末尾，原地扩展
+            m_points.resize(range.offset + capacity);
+        } else {
+            // 搬到池末尾，旧区间成为空洞，由compact回收
+            uint32_t offset = static_cast<uint32_t>(m_points.size());
+            m_points.resize(offset + capacity);
+            std::copy(m_points.begin() + range.offset, m_points.begin() + range.offset + range.count, m_points.begin() + offset);
+            m_deadPoints += range.capacity;
+            range.offset = offset;
+        }
+        range.capacity = capacity;
+    }
+    m_points[range.offset + range.count] = point;
+    ++range.count;
+}
+
+void GeoEntityStore::releasePoints(uint32_t index)
+{
+    PointRange& range = m_pointRanges[index];
+    m_deadPoints += range.capacity;
+    range = PointRange();
+}
+
+void GeoEntityStore::gatherStages(uint32_t index, Stages& stages) const
+{
+    const StageLayout& layout = m_stageLayouts[index];
+    const glm::dvec3* points = m_points.data() + m_pointRanges[index].offset;
+
+    stages.resize(layout.count);
+    for (int stage = 0; stage < layout.count; ++stage) {
+        stages[stage].clear();
+        for (uint32_t i = layout.begin(stage); i < layout.ends[stage]; ++i) {
+            stages[stage].emplace_back(points[i]);
+        }
+    }
+}
+
+void GeoEntityStore::assignStages(uint32_t index, const Stages& stages)
+{
+    assert(!stages.empty() && stages.size() <= MAX_STAGES);
+
+    // 外观拖拽控制点时每帧都会写回，点数不超过已有容量时原地覆盖，不在点池中留下空洞
+    uint32_t total = 0;
+    for (const auto& stagePoints : stages) total += static_cast<uint32_t>(stagePoints.size());
+    PointRange& range = m_pointRanges[index];
+    if (total <= range.capacity) {
+        range.count = 0;
+    } else {
+        releasePoints(index);
+    }
+
+    StageLayout layout;
+    layout.count = static_cast<uint8_t>(stages.size());
+    uint32_t end = 0;
+    for (size_t stage = 0; stage < stages.size(); ++stage) {
+        for (const Point3D& point : stages[stage]) {
+            appendPoint(index, point.position);
+        }
+        end += static_cast<uint32_t>(stages[stage].size());
+        assert(end <= 0xFFFF);
+        layout.ends[stage] = static_cast<uint16_t>(end);
+    }
+    m_stageLayouts[index] = layout;
+}
+
+void GeoEntityStore::estimateBounds(uint32_t index)
+{
+    // 控制点包围盒按半对角线外扩：圆、球、圆柱等由截面上的点确定的形体会超出控制点范围。
+    // 只是估算值，生成网格后用setBounds替换为精确值
+    const PointRange& range = m_pointRanges[index];
+    BoundingBox3D box;
+    for (uint32_t i = 0; i < range.count; ++i) {
+        box.expand(m_points[range.offset + i]);
+    }
+    if (box.isValid()) {
+        glm::dvec3 padding(glm::length(box.size()) * 0.5);
+        box = BoundingBox3D(box.min - padding, box.max + padding);
+    }
+
+    m_bounds[index] = box;
+    m_states[index] &= ~(FLAG_BOUNDS_DIRTY | FLAG_BOUNDS_EXACT);
+}
+
+bool GeoEntityStore::gatherFacadeStages(Geo3D* geo, Stages& stages) const
+{
+    const StageDescriptors& descriptors = getStageDescriptors(geo->getGeoType());
+
+    stages = geo->mm_controlPoint()->getAllStageControlPoints();
+    if (!geo->mm_state()->isStateComplete() && !stages.empty() && !stages.back().empty()) {
+        stages.back().pop_back();  // 未完成时末尾是预览用的临时点
+    }
+    if (stages.empty() || stages.size() > descriptors.size() || stages.size() > MAX_STAGES) {
+        LOG_WARNING(QString("无法写入实体存储，类型: %1").arg(geoType3DToString(geo->getGeoType())), "实体存储");
+        return false;
+    }
+    return true;
+}
+
+bool GeoEntityStore::captureInto(uint32_t index, Geo3D* geo)
+{
+    GeoStateManager* state = geo->mm_state();
+
+    Stages stages;
+    if (!gatherFacadeStages(geo, stages)) return false;
+
+    m_types[index] = geo->getGeoType();
+    m_styles[index] = geo->getStyle();
+    assignStages(index, stages);
+    m_states[index] = FLAG_ALIVE | (state->getState() & STATE_MASK);
+
+    const osg::BoundingBox& box = geo->mm_node()->getBoundingBox();
+    if (box.valid()) {
+        m_bounds[index] = toBoundingBox3D(box);
+        m_states[index] |= FLAG_BOUNDS_EXACT;
+    } else {
+        estimateBounds(index);
+    }
+    return true;
+}
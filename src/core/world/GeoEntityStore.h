@@ -0,0 +1,178 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include "../Common3D.h"
+#include "../GeoStyleTable.h"
+#include "../managers/GeoControlPointManager.h"
+#include <osg/ref_ptr>
+#include <cstdint>
+#include <vector>
+
+// 前向声明
+class Geo3D;
+
+// 实体句柄：槽位下标 + 代数，实体销毁后槽位复用时代数加一，旧句柄随之失效
+struct GeoEntity
+{
+    static const uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool isNull() const { return index == INVALID_INDEX; }
+    bool operator==(const GeoEntity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const GeoEntity& other) const { return !(*this == other); }
+};
+
+// 面向数据的几何对象存储（百万级对象场景）
+// Geo3D是QObject + 四个管理器 + 七个场景图节点 + 完整参数，每个对象几KB、几十次分配。
+// 这里按组件拆成连续数组：类型、状态位、参数句柄（共享样式）、包围盒、控制点区间和阶段划分，
+// 所有实体的控制点放在同一个点池中。管理器的行为以"系统"的形式作用在这些数组上：
+//   绘制系统 - 对应GeoControlPointManager，使用同一套阶段描述和约束函数
+//   状态系统 - 对应GeoStateManager，按位批量设置/清除/统计
+//   包围盒系统 - 由控制点估算，生成网格后可写入精确值；按包围盒区域查询
+// SceneManager3D中的对象都绑定到场景的存储上：Geo3D作为外观，状态位和样式只保存在这里，
+// 控制点和包围盒变化时写回（见Geo3D::bindEntityStore）。
+// 未绑定外观的实体（如loadEntities读入的）需要编辑或显示时通过materialize生成Geo3D。
+// 非线程安全：写操作需在同一线程进行，无写入时可多线程只读。
+class GeoEntityStore
+{
+public:
+    static const int MAX_STAGES = 8;   // 现有几何体最多6个绘制阶段
+
+    GeoEntityStore();
+    ~GeoEntityStore() = default;
+
+    void reserve(size_t entityCount, size_t pointCount);
+    void clear();
+
+    // ============= 实体 =============
+    // 样式为空时使用默认样式
+    GeoEntity create(GeoType3D type, const GeoStyle* style = nullptr);
+
+    // 按阶段一次性写入控制点（读文件、批量生成），走与交互绘制相同的约束和阶段切换
+    GeoEntity createFromStages(GeoType3D type, const std::vector<std::vector<Point3D>>& stages, const GeoStyle* style = nullptr);
+
+    void destroy(GeoEntity entity);
+    bool isAlive(GeoEntity entity) const;
+    size_t size() const { return m_aliveCount; }
+    size_t getSlotCount() const { return m_types.size(); }  // 含已销毁待复用的槽位
+
+    // ============= 组件访问 =============
+    GeoType3D getType(GeoEntity entity) const { return m_types[entity.index]; }
+    int getState(GeoEntity entity) const { return m_states[entity.index] & STATE_MASK; }
+    void setState(GeoEntity entity, int state);  // 整体替换GeoState3D位，内部标记保留
+
+    // 参数句柄即样式表中的共享样式，实体持有引用，样式表清理时不会被回收
+    const GeoStyle* getStyle(GeoEntity entity) const { return m_styles[entity.index].get(); }
+    const GeoParameters3D& getParameters(GeoEntity entity) const { return m_styles[entity.index]->getParameters(); }
+    uint32_t getParameterHandle(GeoEntity entity) const { return m_styles[entity.index]->getId(); }
+    void setStyle(GeoEntity entity, const GeoStyle* style);
+
+    // 绑定的Geo3D外观（没有时为空）
+    Geo3D* getFacade(GeoEntity entity) const { return m_facades[entity.index]; }
+    void setFacade(GeoEntity entity, Geo3D* geo);
+    const BoundingBox3D& getBounds(GeoEntity entity) const { return m_bounds[entity.index]; }
+    bool isBoundsEstimated(GeoEntity entity) const { return (m_states[entity.index] & FLAG_BOUNDS_EXACT) == 0; }
+
+    int getStageCount(GeoEntity entity) const { return m_stageLayouts[entity.index].count; }
+    int getControlPointCount(GeoEntity entity) const { return static_cast<int>(m_pointRanges[entity.index].count); }
+    const glm::dvec3* getControlPoints(GeoEntity entity) const { return m_points.data() + m_pointRanges[entity.index].offset; }  // 按阶段连续存放
+    std::vector<std::vector<Point3D>> getStages(GeoEntity entity) const;
+
+    // ============= 绘制系统 =============
+    bool addControlPoint(GeoEntity entity, const Point3D& point);  // 达到阶段上限时自动进入下一阶段
+    bool nextStage(GeoEntity entity);                              // 点数不足时置为无效，最后阶段置为完成
+    bool setControlPoint(GeoEntity entity, int globalIndex, const Point3D& point);
+    bool syncControlPoints(GeoEntity entity, Geo3D* geo);         // 外观的控制点管理器修改后写回，区间够用时原地覆盖
+
+    // ============= 状态系统 =============
+    void setStateBits(GeoEntity entity, int bits);
+    void clearStateBits(GeoEntity entity, int bits);
+    void clearStateBitsAll(int bits);           // 如取消全部选中
+    size_t countState(int bits) const;          // 同时具有这些状态位的实体数
+
+    // ============= 包围盒系统 =============
+    void setBounds(GeoEntity entity, const BoundingBox3D& box);  // 精确包围盒（来自已生成的网格），无效时改为估算
+    void updateBounds();                                         // 重新估算控制点变化过的实体
+    void queryBounds(const BoundingBox3D& box, std::vector<GeoEntity>& results) const;
+    BoundingBox3D computeTotalBounds() const;                    // 所有存活实体包围盒的并集
+
+    // 遍历存活实体
+    template<typename Func>
+    void forEach(Func func) const
+    {
+        for (uint32_t i = 0; i < m_types.size(); ++i) {
+            if (m_states[i] & FLAG_ALIVE) func(GeoEntity{ i, m_generations[i] });
+        }
+    }
+
+    // ============= Geo3D外观 =============
+    osg::ref_ptr<Geo3D> materialize(GeoEntity entity) const;  // 生成完整的Geo3D供界面编辑和显示
+    GeoEntity capture(Geo3D* geo);                            // 把Geo3D写入存储
+    bool sync(GeoEntity entity, Geo3D* geo);                  // 把编辑后的Geo3D写回实体
+
+    // ============= 维护 =============
+    void compact();                                  // 回收点池中因增长和销毁留下的空洞
+    size_t getPointPoolSize() const { return m_points.size(); }
+    size_t getDeadPointCount() const { return m_deadPoints; }
+    size_t getMemoryUsage() const;                   // 各数组已分配容量的字节数
+
+    // 各几何类型的阶段描述（首次使用时由该类型的原型对象取得并缓存）
+    static const StageDescriptors& getStageDescriptors(GeoType3D type);
+
+private:
+    typedef std::vector<std::vector<Point3D>> Stages;
+
+    // 状态位低位与GeoState3D一致，高位为存储内部标记
+    static const int STATE_MASK = 0xFFFF;
+    static const int FLAG_ALIVE = 1 << 16;
+    static const int FLAG_BOUNDS_DIRTY = 1 << 17;
+    static const int FLAG_BOUNDS_EXACT = 1 << 18;
+
+    struct PointRange
+    {
+        uint32_t offset = 0;
+        uint32_t count = 0;
+        uint32_t capacity = 0;
+    };
+
+    // 阶段i的控制点为[ends[i-1], ends[i])，count为已开始的阶段数
+    struct StageLayout
+    {
+        uint16_t ends[MAX_STAGES] = {};
+        uint8_t count = 0;
+
+        uint32_t begin(int stage) const { return stage == 0 ? 0 : ends[stage - 1]; }
+        uint32_t size(int stage) const { return ends[stage] - begin(stage); }
+    };
+
+    uint32_t allocateSlot(GeoType3D type, const GeoStyle* style);
+    void appendPoint(uint32_t index, const glm::dvec3& point);
+    void releasePoints(uint32_t index);
+    void gatherStages(uint32_t index, Stages& stages) const;
+    void assignStages(uint32_t index, const Stages& stages);  // 原样写入，不再走约束
+    bool gatherFacadeStages(Geo3D* geo, Stages& stages) const; // 去掉绘制中的临时点，阶段数超出时返回false
+    void estimateBounds(uint32_t index);
+    bool captureInto(uint32_t index, Geo3D* geo);
+
+    // 组件数组（按槽位下标对齐）
+    std::vector<GeoType3D> m_types;
+    std::vector<uint32_t> m_generations;
+    std::vector<int> m_states;
+    std::vector<osg::ref_ptr<const GeoStyle>> m_styles;
+    std::vector<BoundingBox3D> m_bounds;
+    std::vector<PointRange> m_pointRanges;
+    std::vector<StageLayout> m_stageLayouts;
+    std::vector<Geo3D*> m_facades;
+
+    std::vector<uint32_t> m_freeSlots;
+    size_t m_aliveCount;
+
+    // 控制点池
+    std::vector<glm::dvec3> m_points;
+    size_t m_deadPoints;
+
+    // 约束函数需要按阶段组织的控制点，复用缓冲
+    mutable Stages m_scratchStages;
+};
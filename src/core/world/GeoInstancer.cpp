@@ -0,0 +1,503 @@
+﻿#include "GeoInstancer.h"
+#include "../GeometryBase.h"
+#include "../../util/LogManager.h"
+#include <osg/Program>
+#include <osg/Shader>
+#include <osg/VertexAttribDivisor>
+#include <osg/TriangleIndexFunctor>
+#include <osg/NodeCallback>
+
+namespace
+{
+    // 实例属性位置：避开顶点/法线/颜色等固定管线别名，批次之外由场景根节点恢复为逐顶点步进
+    const unsigned int INSTANCE_COLOR_LOCATION = 10;
+    const unsigned int INSTANCE_COLUMN_LOCATION = 11;  // 11、12、13三列
+
+    const char* s_instanceVertexShader =
+        "#version 120\n"
+        "attribute vec4 instanceColor;\n"
+        "attribute vec4 instanceColumn0;\n"
+        "attribute vec4 instanceColumn1;\n"
+        "attribute vec4 instanceColumn2;\n"
+        "varying vec4 vColor;\n"
+        "void main()\n"
+        "{\n"
+        "    vec4 localPos = vec4(gl_Vertex.xyz, 1.0);\n"
+        "    vec4 worldPos = vec4(dot(localPos, instanceColumn0), dot(localPos, instanceColumn1),\n"
+        "                         dot(localPos, instanceColumn2), 1.0);\n"
+        "    // 矩阵线性部分的行，法线按余子式矩阵变换（等价于逆转置，允许非均匀缩放）\n"
+        "    vec3 row0 = vec3(instanceColumn0.x, instanceColumn1.x, instanceColumn2.x);\n"
+        "    vec3 row1 = vec3(instanceColumn0.y, instanceColumn1.y, instanceColumn2.y);\n"
+        "    vec3 row2 = vec3(instanceColumn0.z, instanceColumn1.z, instanceColumn2.z);\n"
+        "    vec3 cof0 = cross(row1, row2);\n"
+        "    vec3 worldNormal = gl_Normal.x * cof0 + gl_Normal.y * cross(row2, row0) + gl_Normal.z * cross(row0, row1);\n"
+        "    worldNormal *= sign(dot(row0, cof0));\n"
+        "    vec3 normal = normalize(gl_NormalMatrix * worldNormal);\n"
+        "    vec4 eyePos = gl_ModelViewMatrix * worldPos;\n"
+        "    vec3 lightDir = gl_LightSource[0].position.w == 0.0\n"
+        "        ? normalize(gl_LightSource[0].position.xyz)\n"
+        "        : normalize(gl_LightSource[0].position.xyz - eyePos.xyz);\n"
+        "    float diffuse = max(dot(normal, lightDir), 0.0);\n"
+        "    vec3 ambient = (gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb) * instanceColor.rgb * 0.3;\n"
+        "    vColor = vec4(ambient + gl_LightSource[0].diffuse.rgb * instanceColor.rgb * diffuse, instanceColor.a);\n"
+        "    gl_Position = gl_ModelViewProjectionMatrix * worldPos;\n"
+        "}\n";
+
+    const char* s_instanceFragmentShader =
+        "#version 120\n"
+        "varying vec4 vColor;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_FragColor = vColor;\n"
+        "}\n";
+
+    // 被实例化对象的面几何体只跳过绘制，仍留在场景图中供求交器拾取
+    class SuppressDrawCallback : public osg::Drawable::CullCallback
+    {
+    public:
+        virtual bool cull(osg::NodeVisitor*, osg::Drawable*, osg::RenderInfo*) const override
+        {
+            return true;
+        }
+    };
+
+    // 批次的包围盒为所有实例包围盒的并集，单位网格自身的包围盒没有意义
+    class BatchBoundsCallback : public osg::Drawable::ComputeBoundingBoxCallback
+    {
+    public:
+        virtual osg::BoundingBox computeBound(const osg::Drawable&) const override
+        {
+            return bounds;
+        }
+
+        osg::BoundingBox bounds;
+    };
+
+    class InstancerUpdateCallback : public osg::NodeCallback
+    {
+    public:
+        explicit InstancerUpdateCallback(GeoInstancer* instancer) : m_instancer(instancer) {}
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv) override
+        {
+            m_instancer->sync();
+            traverse(node, nv);
+        }
+
+    private:
+        GeoInstancer* m_instancer;
+    };
+
+    struct TriangleCollector
+    {
+        std::vector<unsigned int>* indices = nullptr;
+
+        void operator()(unsigned int i1, unsigned int i2, unsigned int i3)
+        {
+            indices->push_back(i1);
+            indices->push_back(i2);
+            indices->push_back(i3);
+        }
+    };
+}
+
+// ============= 构造函数 =============
+
+GeoInstancer::GeoInstancer()
+    : m_rootNode(new osg::Group)
+    , m_suppressDrawCallback(new SuppressDrawCallback)
+    , m_updateCallback(new InstancerUpdateCallback(this))
+    , m_enabled(false)
+{
+    m_rootNode->setName("3D_INSTANCE_NODE");
+    setupBatchStateSet();
+}
+
+GeoInstancer::~GeoInstancer()
+{
+    untrackAll();
+    m_rootNode->setUpdateCallback(nullptr);
+}
+
+// ============= 初始化 =============
+
+void GeoInstancer::initialize(osg::Group* parentNode)
+{
+    if (!parentNode) return;
+
+    parentNode->addChild(m_rootNode.get());
+}
+
+void GeoInstancer::applyDefaultDivisors(osg::StateSet* stateSet)
+{
+    if (!stateSet) return;
+
+    // 属性步进是GL上下文状态，离开批次后需要由祖先节点的同类属性恢复
+    stateSet->setAttribute(new osg::VertexAttribDivisor(INSTANCE_COLOR_LOCATION, 0));
+    for (unsigned int i = 0; i < 3; ++i) {
+        stateSet->setAttribute(new osg::VertexAttribDivisor(INSTANCE_COLUMN_LOCATION + i, 0));
+    }
+}
+
+void GeoInstancer::setupBatchStateSet()
+{
+    osg::ref_ptr<osg::Program> program = new osg::Program;
+    program->setName("GeoInstancerProgram");
+    program->addShader(new osg::Shader(osg::Shader::VERTEX, s_instanceVertexShader));
+    program->addShader(new osg::Shader(osg::Shader::FRAGMENT, s_instanceFragmentShader));
+    program->addBindAttribLocation("instanceColor", INSTANCE_COLOR_LOCATION);
+    program->addBindAttribLocation("instanceColumn0", INSTANCE_COLUMN_LOCATION);
+    program->addBindAttribLocation("instanceColumn1", INSTANCE_COLUMN_LOCATION + 1);
+    program->addBindAttribLocation("instanceColumn2", INSTANCE_COLUMN_LOCATION + 2);
+
+    m_batchStateSet = new osg::StateSet;
+    m_batchStateSet->setAttributeAndModes(program.get(), osg::StateAttribute::ON);
+    m_batchStateSet->setAttribute(new osg::VertexAttribDivisor(INSTANCE_COLOR_LOCATION, 1));
+    for (unsigned int i = 0; i < 3; ++i) {
+        m_batchStateSet->setAttribute(new osg::VertexAttribDivisor(INSTANCE_COLUMN_LOCATION + i, 1));
+    }
+}
+
+// ============= 开关 =============
+
+void GeoInstancer::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) return;
+    m_enabled = enabled;
+
+    if (enabled) {
+        // 所有已跟踪对象重新评估归属
+        for (const auto& entry : m_connections) {
+            m_dirtyGeometries.insert(entry.first);
+        }
+        if (!m_dirtyGeometries.empty()) {
+            scheduleSync();
+        }
+    } else {
+        std::vector<Geo3D*> instanced;
+        instanced.reserve(m_slots.size());
+        for (const auto& slot : m_slots) {
+            instanced.push_back(slot.first);
+        }
+        for (Geo3D* geo : instanced) {
+            removeInstance(geo);
+        }
+        m_dirtyGeometries.clear();
+    }
+
+    LOG_INFO(QString("硬件实例化: %1").arg(enabled ? "启用" : "禁用"), "实例化");
+}
+
+// ============= 对象跟踪 =============
+
+void GeoInstancer::track(Geo3D* geo)
+{
+    if (!geo || m_connections.find(geo) != m_connections.end()) return;
+
+    GeoNodeManager* nodeManager = geo->mm_node();
+    GeoStateManager* stateManager = geo->mm_state();
+    if (!nodeManager || !stateManager) return;
+
+    // 几何重建、变换、样式和状态变化都可能改变批次归属或实例数据
+    auto markThis = [this, geo]() { markDirty(geo); };
+    std::vector<QMetaObject::Connection>& connections = m_connections[geo];
+    connections.push_back(QObject::connect(nodeManager, &GeoNodeManager::geometryChanged, markThis));
+    connections.push_back(QObject::connect(nodeManager, &GeoNodeManager::transformChanged, markThis));
+    connections.push_back(QObject::connect(nodeManager, &GeoNodeManager::boundingBoxChanged, markThis));
+    connections.push_back(QObject::connect(geo, &Geo3D::parametersChanged, markThis));
+    connections.push_back(QObject::connect(stateManager, &GeoStateManager::stateCompleted, markThis));
+    connections.push_back(QObject::connect(stateManager, &GeoStateManager::stateInvalidated, markThis));
+
+    markDirty(geo);
+}
+
+void GeoInstancer::untrack(Geo3D* geo)
+{
+    auto it = m_connections.find(geo);
+    if (it != m_connections.end()) {
+        for (const auto& connection : it->second) {
+            QObject::disconnect(connection);
+        }
+        m_connections.erase(it);
+    }
+    m_dirtyGeometries.erase(geo);
+    removeInstance(geo);
+}
+
+void GeoInstancer::untrackAll()
+{
+    while (!m_connections.empty()) {
+        untrack(m_connections.begin()->first);
+    }
+    // 未跟踪但仍在批次中的对象（理论上不存在）一并清理
+    while (!m_slots.empty()) {
+        removeInstance(m_slots.begin()->first);
+    }
+    m_dirtyGeometries.clear();
+}
+
+void GeoInstancer::markDirty(Geo3D* geo)
+{
+    if (!m_enabled || !geo) return;
+    m_dirtyGeometries.insert(geo);
+    scheduleSync();
+}
+
+void GeoInstancer::scheduleSync()
+{
+    // 挂接后场景需要更新遍历，查看器的按需渲染据此安排下一帧
+    if (m_rootNode->getUpdateCallback() != m_updateCallback.get()) {
+        m_rootNode->setUpdateCallback(m_updateCallback.get());
+    }
+}
+
+void GeoInstancer::sync()
+{
+    // 回调由m_updateCallback持有，在其执行期间摘除是安全的
+    m_rootNode->setUpdateCallback(nullptr);
+    if (m_dirtyGeometries.empty()) return;
+
+    for (Geo3D* geo : m_dirtyGeometries) {
+        refreshInstance(geo);
+    }
+    m_dirtyGeometries.clear();
+
+    for (auto& entry : m_batches) {
+        InstanceBatch* batch = entry.second.get();
+        if (batch->boundsDirty) {
+            updateBatchBounds(batch);
+        }
+    }
+}
+
+// ============= 实例查询 =============
+
+Geo3D* GeoInstancer::getInstanceGeometry(const osg::Drawable* batchDrawable, unsigned int instanceId) const
+{
+    for (const auto& entry : m_batches) {
+        const InstanceBatch* batch = entry.second.get();
+        if (batch->geometry.get() == batchDrawable) {
+            return instanceId < batch->instances.size() ? batch->instances[instanceId] : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+int GeoInstancer::getInstanceId(Geo3D* geo) const
+{
+    auto it = m_slots.find(geo);
+    return it != m_slots.end() ? static_cast<int>(it->second.index) : -1;
+}
+
+// ============= 私有函数：批次归属 =============
+
+bool GeoInstancer::computeBatchKey(Geo3D* geo, BatchKey& key) const
+{
+    if (!m_enabled || !geo) return false;
+
+    GeoNodeManager* nodeManager = geo->mm_node();
+    if (!nodeManager || !geo->mm_state() || !geo->mm_state()->isStateComplete()) return false;
+
+    // 只有面几何体引用共享单位网格的对象才能实例化
+    UnitMesh* mesh = nodeManager->getFaceUnitMesh();
+    if (!mesh) return false;
+
+    // 透明对象需要按深度排序，面被隐藏的对象不需要绘制，都留在逐对象路径
+    const GeoParameters3D& params = geo->getParameters();
+    if (!params.showFaces || params.fillType != Fill_Solid3D || params.fillColor.a < 1.0) return false;
+
+    osg::Geometry* faceGeometry = nodeManager->getFaceGeometry().get();
+    if (!faceGeometry || faceGeometry->getNodeMask() == NODE_MASK_NONE) return false;
+
+    key = BatchKey(static_cast<int>(geo->getGeoType()), static_cast<int>(params.subdivisionLevel),
+                   mesh, static_cast<int>(params.fillType));
+    return true;
+}
+
+void GeoInstancer::refreshInstance(Geo3D* geo)
+{
+    BatchKey key;
+    bool eligible = computeBatchKey(geo, key);
+
+    auto it = m_slots.find(geo);
+    if (it != m_slots.end() && (!eligible || it->second.batch->key != key)) {
+        removeInstance(geo);
+        it = m_slots.end();
+    }
+    if (!eligible) return;
+
+    if (it == m_slots.end()) {
+        addInstance(geo, key);
+    } else {
+        writeInstance(it->second.batch, it->second.index, geo);
+    }
+}
+
+void GeoInstancer::addInstance(Geo3D* geo, const BatchKey& key)
+{
+    InstanceBatch* batch = nullptr;
+    auto it = m_batches.find(key);
+    if (it != m_batches.end()) {
+        batch = it->second.get();
+    } else {
+        batch = createBatch(key, geo->mm_node()->getFaceUnitMesh());
+        if (!batch) return;
+    }
+
+    unsigned int index = static_cast<unsigned int>(batch->instances.size());
+    batch->instances.push_back(geo);
+    batch->colors->push_back(osg::Vec4());
+    for (int i = 0; i < 3; ++i) {
+        batch->columns[i]->push_back(osg::Vec4());
+    }
+    batch->triangles->setNumInstances(static_cast<int>(batch->instances.size()));
+
+    InstanceSlot& slot = m_slots[geo];
+    slot.batch = batch;
+    slot.index = index;
+    writeInstance(batch, index, geo);
+
+    // 对象自身的面改由批次绘制
+    osg::Geometry* faceGeometry = geo->mm_node()->getFaceGeometry().get();
+    if (!faceGeometry->getCullCallback()) {
+        faceGeometry->setCullCallback(m_suppressDrawCallback.get());
+    }
+}
+
+void GeoInstancer::removeInstance(Geo3D* geo)
+{
+    auto it = m_slots.find(geo);
+    if (it == m_slots.end()) return;
+
+    InstanceBatch* batch = it->second.batch;
+    unsigned int index = it->second.index;
+    m_slots.erase(it);
+
+    // 末尾实例搬到空出的位置，保持数组紧凑
+    unsigned int last = static_cast<unsigned int>(batch->instances.size() - 1);
+    if (index != last) {
+        Geo3D* moved = batch->instances[last];
+        batch->instances[index] = moved;
+        (*batch->colors)[index] = (*batch->colors)[last];
+        for (int i = 0; i < 3; ++i) {
+            (*batch->columns[i])[index] = (*batch->columns[i])[last];
+        }
+        m_slots[moved].index = index;
+    }
+    batch->instances.pop_back();
+    batch->colors->pop_back();
+    batch->colors->dirty();
+    for (int i = 0; i < 3; ++i) {
+        batch->columns[i]->pop_back();
+        batch->columns[i]->dirty();
+    }
+    batch->triangles->setNumInstances(static_cast<int>(batch->instances.size()));
+    batch->boundsDirty = true;
+
+    // 恢复对象自身的面绘制
+    if (geo->mm_node()) {
+        osg::Geometry* faceGeometry = geo->mm_node()->getFaceGeometry().get();
+        if (faceGeometry && faceGeometry->getCullCallback() == m_suppressDrawCallback.get()) {
+            faceGeometry->setCullCallback(nullptr);
+        }
+    }
+
+    if (batch->instances.empty()) {
+        destroyBatch(batch);
+    }
+}
+
+void GeoInstancer::writeInstance(InstanceBatch* batch, unsigned int index, Geo3D* geo)
+{
+    // OSG按行向量右乘矩阵，第j个世界坐标分量为 (x, y, z, 1) 与第j列的点积
+    osg::Matrixd matrix = geo->mm_node()->getFaceWorldMatrix();
+    for (int j = 0; j < 3; ++j) {
+        (*batch->columns[j])[index] = osg::Vec4(matrix(0, j), matrix(1, j), matrix(2, j), matrix(3, j));
+        batch->columns[j]->dirty();
+    }
+
+    const Color3D& color = geo->getParameters().fillColor;
+    (*batch->colors)[index] = osg::Vec4(color.r, color.g, color.b, color.a);
+    batch->colors->dirty();
+
+    batch->boundsDirty = true;
+}
+
+void GeoInstancer::updateBatchBounds(InstanceBatch* batch)
+{
+    osg::BoundingBox bounds;
+    for (Geo3D* geo : batch->instances) {
+        bounds.expandBy(geo->mm_node()->getBoundingBox());
+    }
+    batch->bounds = bounds;
+    batch->boundsDirty = false;
+
+    BatchBoundsCallback* callback = dynamic_cast<BatchBoundsCallback*>(batch->geometry->getComputeBoundingBoxCallback());
+    if (callback) {
+        callback->bounds = bounds;
+    }
+    batch->geometry->dirtyBound();
+}
+
+// ============= 私有函数：批次管理 =============
+
+GeoInstancer::InstanceBatch* GeoInstancer::createBatch(const BatchKey& key, UnitMesh* mesh)
+{
+    if (!mesh || !mesh->prototype.valid()) return nullptr;
+    osg::Geometry* prototype = mesh->prototype.get();
+
+    // 单位网格的扇形/条带/四边形统一转成一个三角形DrawElements
+    std::vector<unsigned int> indices;
+    osg::TriangleIndexFunctor<TriangleCollector> collector;
+    collector.indices = &indices;
+    prototype->accept(collector);
+    if (indices.empty()) return nullptr;
+
+    std::unique_ptr<InstanceBatch> batch(new InstanceBatch);
+    batch->key = key;
+    batch->mesh = mesh;
+    batch->triangles = new osg::DrawElementsUInt(osg::PrimitiveSet::TRIANGLES,
+        static_cast<unsigned int>(indices.size()), indices.data());
+
+    batch->colors = new osg::Vec4Array;
+    batch->colors->setDataVariance(osg::Object::DYNAMIC);
+    for (int i = 0; i < 3; ++i) {
+        batch->columns[i] = new osg::Vec4Array;
+        batch->columns[i]->setDataVariance(osg::Object::DYNAMIC);
+    }
+
+    // 顶点和法线直接引用单位网格的共享数组
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setName("3D_INSTANCE_BATCH");
+    geometry->setUseDisplayList(false);
+    geometry->setUseVertexBufferObjects(true);
+    geometry->setDataVariance(osg::Object::DYNAMIC);
+    geometry->setVertexArray(prototype->getVertexArray());
+    if (prototype->getNormalArray()) {
+        geometry->setNormalArray(prototype->getNormalArray(), osg::Array::BIND_PER_VERTEX);
+    }
+    geometry->addPrimitiveSet(batch->triangles.get());
+    geometry->setVertexAttribArray(INSTANCE_COLOR_LOCATION, batch->colors.get(), osg::Array::BIND_PER_VERTEX);
+    for (unsigned int i = 0; i < 3; ++i) {
+        geometry->setVertexAttribArray(INSTANCE_COLUMN_LOCATION + i, batch->columns[i].get(), osg::Array::BIND_PER_VERTEX);
+    }
+    geometry->setStateSet(m_batchStateSet.get());
+    geometry->setComputeBoundingBoxCallback(new BatchBoundsCallback);
+    batch->geometry = geometry;
+
+    m_rootNode->addChild(geometry.get());
+
+    InstanceBatch* result = batch.get();
+    m_batches[key] = std::move(batch);
+
+    LOG_DEBUG(QString("创建实例批次: 类型%1 细分%2 三角形%3")
+        .arg(std::get<0>(key)).arg(std::get<1>(key)).arg(indices.size() / 3), "实例化");
+    return result;
+}
+
+void GeoInstancer::destroyBatch(InstanceBatch* batch)
+{
+    BatchKey key = batch->key;
+    m_rootNode->removeChild(batch->geometry.get());
+    m_batches.erase(key);
+}
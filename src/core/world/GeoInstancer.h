@@ -0,0 +1,103 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include "../Common3D.h"
+#include "../geometry/UnitMeshCache.h"
+#include <osg/Group>
+#include <osg/Geometry>
+#include <osg/StateSet>
+#include <osg/BoundingBox>
+#include <QMetaObject>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// 前向声明
+class Geo3D;
+
+// 相同图元的硬件实例化
+// 已完成、面几何体引用同一单位网格（同类型、同细分级别）且样式兼容的对象归为一个批次，
+// 批次只有一个DrawElements，通过glDrawElementsInstanced一次绘制，
+// 每个实例的变换和颜色放在按实例步进的顶点属性数组中。
+// 对象自身的面几何体保留在场景中作为拾取代理（只跳过绘制），拾取仍经userData解析到Geo3D；
+// 实例编号（批次内下标）与Geo3D的映射由getInstanceGeometry/getInstanceId提供。
+// 对象的增删改只标记为脏，在更新遍历中增量调整所在批次。
+class GeoInstancer
+{
+public:
+    GeoInstancer();
+    ~GeoInstancer();
+    
+    // ============= 初始化 =============
+    void initialize(osg::Group* parentNode);  // 实例根节点挂到parentNode下
+    osg::Group* getRootNode() const { return m_rootNode.get(); }
+    static void applyDefaultDivisors(osg::StateSet* stateSet);  // 场景根节点上恢复为逐顶点步进
+    
+    // ============= 开关 =============
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+    
+    // ============= 对象跟踪 =============
+    void track(Geo3D* geo);
+    void untrack(Geo3D* geo);
+    void untrackAll();
+    void markDirty(Geo3D* geo);
+    void sync();  // 处理脏对象，由更新遍历调用（仅在有脏对象时挂接更新回调）
+    
+    // ============= 实例查询 =============
+    Geo3D* getInstanceGeometry(const osg::Drawable* batchDrawable, unsigned int instanceId) const;
+    int getInstanceId(Geo3D* geo) const;  // 未实例化时返回-1
+    bool isInstanced(Geo3D* geo) const { return m_slots.find(geo) != m_slots.end(); }
+    int getBatchCount() const { return static_cast<int>(m_batches.size()); }
+    int getInstanceCount() const { return static_cast<int>(m_slots.size()); }
+    
+private:
+    // 批次键：类型、细分级别、单位网格（含圆环比例）、填充方式
+    typedef std::tuple<int, int, const UnitMesh*, int> BatchKey;
+    
+    struct InstanceBatch
+    {
+        BatchKey key;
+        osg::ref_ptr<UnitMesh> mesh;
+        osg::ref_ptr<osg::Geometry> geometry;
+        osg::ref_ptr<osg::DrawElementsUInt> triangles;
+        osg::ref_ptr<osg::Vec4Array> colors;
+        osg::ref_ptr<osg::Vec4Array> columns[3];  // 仿射矩阵的三列（含平移分量）
+        std::vector<Geo3D*> instances;           // 实例编号 -> 几何体
+        osg::BoundingBox bounds;
+        bool boundsDirty = true;
+    };
+    
+    struct InstanceSlot
+    {
+        InstanceBatch* batch = nullptr;
+        unsigned int index = 0;
+    };
+    
+    bool computeBatchKey(Geo3D* geo, BatchKey& key) const;
+    void refreshInstance(Geo3D* geo);
+    void addInstance(Geo3D* geo, const BatchKey& key);
+    void removeInstance(Geo3D* geo);
+    void writeInstance(InstanceBatch* batch, unsigned int index, Geo3D* geo);
+    void updateBatchBounds(InstanceBatch* batch);
+    
+    InstanceBatch* createBatch(const BatchKey& key, UnitMesh* mesh);
+    void destroyBatch(InstanceBatch* batch);
+    void setupBatchStateSet();
+    void scheduleSync();
+    
+    // ============= 成员变量 =============
+    osg::ref_ptr<osg::Group> m_rootNode;
+    osg::ref_ptr<osg::StateSet> m_batchStateSet;       // 所有批次共享：实例化着色器和属性步进
+    osg::ref_ptr<osg::Callback> m_suppressDrawCallback; // 挂在被实例化对象的面几何体上
+    osg::ref_ptr<osg::Callback> m_updateCallback;       // 有脏对象时才挂到根节点，避免按需渲染下每帧都需要更新遍历
+    
+    bool m_enabled;
+    std::map<BatchKey, std::unique_ptr<InstanceBatch>> m_batches;
+    std::unordered_map<Geo3D*, InstanceSlot> m_slots;
+    std::unordered_set<Geo3D*> m_dirtyGeometries;
+    std::unordered_map<Geo3D*, std::vector<QMetaObject::Connection>> m_connections;
+};
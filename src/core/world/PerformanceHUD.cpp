@@ -0,0 +1,61 @@
+﻿#include "PerformanceHUD.h"
+#include "../Enums3D.h"
+#include <osg/Geode>
+#include <osg/StateSet>
+
+namespace
+{
+    const float kHudMargin = 10.0f;
+    const float kHudCharacterSize = 14.0f;
+}
+
+PerformanceHUD::PerformanceHUD()
+    : m_height(600)
+    , m_visible(false)
+{
+    m_camera = new osg::Camera;
+    m_camera->setReferenceFrame(osg::Transform::ABSOLUTE_RF);
+    m_camera->setViewMatrix(osg::Matrix::identity());
+    m_camera->setClearMask(GL_DEPTH_BUFFER_BIT);
+    m_camera->setRenderOrder(osg::Camera::POST_RENDER);
+    m_camera->setAllowEventFocus(false);
+    m_camera->setNodeMask(NODE_MASK_NONE);
+
+    m_text = new osgText::Text;
+    m_text->setCharacterSize(kHudCharacterSize);
+    m_text->setColor(osg::Vec4(0.1f, 0.1f, 0.1f, 1.0f));
+    m_text->setBackdropType(osgText::Text::OUTLINE);
+    m_text->setBackdropColor(osg::Vec4(1.0f, 1.0f, 1.0f, 0.8f));
+    m_text->setAlignment(osgText::Text::LEFT_TOP);
+    m_text->setDataVariance(osg::Object::DYNAMIC);
+
+    osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+    geode->addDrawable(m_text.get());
+
+    osg::StateSet* stateSet = geode->getOrCreateStateSet();
+    stateSet->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::PROTECTED);
+    stateSet->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
+
+    m_camera->addChild(geode.get());
+    setViewportSize(800, 600);
+}
+
+void PerformanceHUD::setViewportSize(int width, int height)
+{
+    if (width <= 0 || height <= 0) return;
+
+    m_height = height;
+    m_camera->setProjectionMatrixAsOrtho2D(0.0, width, 0.0, height);
+    m_text->setPosition(osg::Vec3(kHudMargin, m_height - kHudMargin, 0.0f));
+}
+
+void PerformanceHUD::setText(const QString& text)
+{
+    m_text->setText(text.toStdString());
+}
+
+void PerformanceHUD::setVisible(bool visible)
+{
+    m_visible = visible;
+    m_camera->setNodeMask(visible ? NODE_MASK_UI_OVERLAY : NODE_MASK_NONE);
+}
@@ -0,0 +1,35 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <osg/Camera>
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <osgText/Text>
+#include <QString>
+
+// 视口性能HUD - 后渲染的正交相机，左上角显示性能文本
+// 挂在场景根节点下，节点掩码为UI覆盖层，拾取遍历不会访问
+class PerformanceHUD : public osg::Referenced
+{
+public:
+    PerformanceHUD();
+
+    osg::Camera* getCamera() const { return m_camera.get(); }
+
+    // 视口大小变化时更新投影和文本位置
+    void setViewportSize(int width, int height);
+
+    void setText(const QString& text);
+
+    void setVisible(bool visible);
+    bool isVisible() const { return m_visible; }
+
+protected:
+    ~PerformanceHUD() override = default;
+
+private:
+    osg::ref_ptr<osg::Camera> m_camera;
+    osg::ref_ptr<osgText::Text> m_text;
+    int m_height;
+    bool m_visible;
+};
@@ -0,0 +1,278 @@
+﻿#include "PerformanceMonitor.h"
+#include "../managers/GeoNodeManager.h"
+#include <osg/Geometry>
+#include <osg/NodeVisitor>
+#include <osg/Stats>
+#include <osgViewer/Viewer>
+#include <algorithm>
+
+std::mutex PerformanceMonitor::s_pickMutex;
+int PerformanceMonitor::s_pickCount = 0;
+double PerformanceMonitor::s_pickTotalMs = 0.0;
+double PerformanceMonitor::s_pickMaxMs = 0.0;
+
+namespace
+{
+    const size_t kFrameSampleCapacity = 512;   // 约8秒的60Hz帧
+
+    // 统计几何体数组占用，共享数组只计一次
+    class GeometryMemoryVisitor : public osg::NodeVisitor
+    {
+    public:
+        explicit GeometryMemoryVisitor(std::unordered_set<const osg::BufferData*>& visited)
+            : osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN)
+            , m_visited(visited)
+            , m_bytes(0)
+        {
+            // 隐藏的控制点/包围盒同样占内存
+            setNodeMaskOverride(0xFFFFFFFF);
+        }
+
+        void apply(osg::Geometry& geometry) override
+        {
+            osg::Geometry::ArrayList arrays;
+            geometry.getArrayList(arrays);
+            for (const osg::ref_ptr<osg::Array>& array : arrays) {
+                add(array.get());
+            }
+
+            for (unsigned int i = 0; i < geometry.getNumPrimitiveSets(); ++i) {
+                osg::PrimitiveSet* primitiveSet = geometry.getPrimitiveSet(i);
+                if (primitiveSet) {
+                    add(primitiveSet->getDrawElements());
+                }
+            }
+        }
+
+        quint64 bytes() const { return m_bytes; }
+
+    private:
+        void add(const osg::BufferData* data)
+        {
+            if (data && m_visited.insert(data).second) {
+                m_bytes += data->getTotalDataSize();
+            }
+        }
+
+        std::unordered_set<const osg::BufferData*>& m_visited;
+        quint64 m_bytes;
+    };
+
+    bool averagedAttribute(const osg::Stats* stats, unsigned int first, unsigned int last,
+                           const std::string& name, double& value)
+    {
+        value = 0.0;
+        return stats && stats->getAveragedAttribute(first, last, name, value);
+    }
+}
+
+// ============= PerformanceSnapshot =============
+
+QString PerformanceSnapshot::toString() const
+{
+    return QString("帧率: %1 FPS\n"
+                   "帧耗时: 平均%2ms, P50 %3ms, P95 %4ms, P99 %5ms, 最大%6ms\n"
+                   "事件%7ms, 更新%8ms, 剔除%9ms, 绘制%10ms\n"
+                   "绘制调用%11, 三角形%12, 顶点%13\n"
+                   "拾取: %14次, 平均%15ms, 最大%16ms\n"
+                   "几何体: %17个, 几何内存%18MB")
+        .arg(fps, 0, 'f', 1)
+        .arg(frameAverageMs, 0, 'f', 2)
+        .arg(frameP50Ms, 0, 'f', 2)
+        .arg(frameP95Ms, 0, 'f', 2)
+        .arg(frameP99Ms, 0, 'f', 2)
+        .arg(frameMaxMs, 0, 'f', 2)
+        .arg(eventMs, 0, 'f', 2)
+        .arg(updateMs, 0, 'f', 2)
+        .arg(cullMs, 0, 'f', 2)
+        .arg(drawMs, 0, 'f', 2)
+        .arg(drawCalls, 0, 'f', 0)
+        .arg(triangles, 0, 'f', 0)
+        .arg(vertices, 0, 'f', 0)
+        .arg(pickCount)
+        .arg(pickAverageMs, 0, 'f', 2)
+        .arg(pickMaxMs, 0, 'f', 2)
+        .arg(geoCount)
+        .arg(geometryBytes / (1024.0 * 1024.0), 0, 'f', 2);
+}
+
+QString PerformanceSnapshot::toHudText() const
+{
+    return QString("FPS %1   frame %2 ms (p50 %3, p95 %4, p99 %5)\n"
+                   "update %6 ms   cull %7 ms   draw %8 ms\n"
+                   "draw calls %9   tris %10   verts %11\n"
+                   "pick %12 ms (max %13, n=%14)\n"
+                   "Geo3D %15   geometry %16 MB")
+        .arg(fps, 0, 'f', 1)
+        .arg(frameAverageMs, 0, 'f', 2)
+        .arg(frameP50Ms, 0, 'f', 2)
+        .arg(frameP95Ms, 0, 'f', 2)
+        .arg(frameP99Ms, 0, 'f', 2)
+        .arg(updateMs, 0, 'f', 2)
+        .arg(cullMs, 0, 'f', 2)
+        .arg(drawMs, 0, 'f', 2)
+        .arg(drawCalls, 0, 'f', 0)
+        .arg(triangles, 0, 'f', 0)
+        .arg(vertices, 0, 'f', 0)
+        .arg(pickAverageMs, 0, 'f', 2)
+        .arg(pickMaxMs, 0, 'f', 2)
+        .arg(pickCount)
+        .arg(geoCount)
+        .arg(geometryBytes / (1024.0 * 1024.0), 0, 'f', 2);
+}
+
+// ============= 构造与绑定 =============
+
+PerformanceMonitor::PerformanceMonitor()
+    : m_frameSamples(kFrameSampleCapacity, 0.0)
+    , m_frameSampleCursor(0)
+    , m_frameSampleCount(0)
+    , m_framesSinceSample(0)
+    , m_lastSampleTick(osg::Timer::instance()->tick())
+    , m_lastSampleFrameNumber(0)
+{
+}
+
+PerformanceMonitor::~PerformanceMonitor()
+{
+}
+
+void PerformanceMonitor::attach(osgViewer::Viewer* viewer)
+{
+    m_viewer = viewer;
+    if (!viewer) return;
+
+    // 只打开计时和场景统计，不启用GPU计时查询
+    if (osg::Stats* viewerStats = viewer->getViewerStats()) {
+        viewerStats->collectStats("event", true);
+        viewerStats->collectStats("update", true);
+    }
+    if (osg::Stats* cameraStats = viewer->getCamera()->getStats()) {
+        cameraStats->collectStats("rendering", true);
+        cameraStats->collectStats("scene", true);
+    }
+}
+
+// ============= 记录 =============
+
+void PerformanceMonitor::recordFrame(double frameMs)
+{
+    m_frameSamples[m_frameSampleCursor] = frameMs;
+    m_frameSampleCursor = (m_frameSampleCursor + 1) % m_frameSamples.size();
+    m_frameSampleCount = std::min(m_frameSampleCount + 1, m_frameSamples.size());
+    ++m_framesSinceSample;
+}
+
+void PerformanceMonitor::recordPickLatency(double pickMs)
+{
+    std::lock_guard<std::mutex> lock(s_pickMutex);
+    ++s_pickCount;
+    s_pickTotalMs += pickMs;
+    s_pickMaxMs = std::max(s_pickMaxMs, pickMs);
+}
+
+// ============= 采样 =============
+
+PerformanceSnapshot PerformanceMonitor::sample(const std::vector<Geo3D::Ptr>& geometries)
+{
+    PerformanceSnapshot snapshot;
+
+    // 帧率按实际出帧数计算，按需渲染时画面静止即为0
+    osg::Timer_t now = osg::Timer::instance()->tick();
+    double elapsedSeconds = osg::Timer::instance()->delta_s(m_lastSampleTick, now);
+    if (elapsedSeconds > 0.0) {
+        snapshot.fps = m_framesSinceSample / elapsedSeconds;
+    }
+    m_lastSampleTick = now;
+    m_framesSinceSample = 0;
+
+    // 帧耗时分位数取最近的样本
+    if (m_frameSampleCount > 0) {
+        std::vector<double> samples(m_frameSamples.begin(), m_frameSamples.begin() + m_frameSampleCount);
+        double total = 0.0;
+        for (double value : samples) total += value;
+        snapshot.frameAverageMs = total / samples.size();
+
+        auto percentile = [&samples](double p) {
+            size_t index = std::min(samples.size() - 1, static_cast<size_t>(samples.size() * p));
+            std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+            return samples[index];
+        };
+        snapshot.frameP50Ms = percentile(0.50);
+        snapshot.frameP95Ms = percentile(0.95);
+        snapshot.frameP99Ms = percentile(0.99);
+        snapshot.frameMaxMs = *std::max_element(samples.begin(), samples.end());
+    }
+
+    readViewerStats(snapshot);
+
+    // 拾取耗时按采样区间清零
+    {
+        std::lock_guard<std::mutex> lock(s_pickMutex);
+        snapshot.pickCount = s_pickCount;
+        snapshot.pickAverageMs = s_pickCount > 0 ? s_pickTotalMs / s_pickCount : 0.0;
+        snapshot.pickMaxMs = s_pickMaxMs;
+        s_pickCount = 0;
+        s_pickTotalMs = 0.0;
+        s_pickMaxMs = 0.0;
+    }
+
+    // 几何内存
+    std::unordered_set<const osg::BufferData*> visited;
+    for (const Geo3D::Ptr& geo : geometries) {
+        if (!geo) continue;
+        ++snapshot.geoCount;
+        osg::ref_ptr<osg::Node> node = geo->mm_node()->getOSGNode();
+        snapshot.geometryBytes += geometryMemory(node.get(), visited);
+    }
+
+    return snapshot;
+}
+
+quint64 PerformanceMonitor::geometryMemory(osg::Node* node, std::unordered_set<const osg::BufferData*>& visited)
+{
+    if (!node) return 0;
+
+    GeometryMemoryVisitor visitor(visited);
+    node->accept(visitor);
+    return visitor.bytes();
+}
+
+void PerformanceMonitor::readViewerStats(PerformanceSnapshot& snapshot)
+{
+    osg::ref_ptr<osgViewer::Viewer> viewer;
+    if (!m_viewer.lock(viewer)) return;
+
+    const osg::Stats* viewerStats = viewer->getViewerStats();
+    const osg::Stats* cameraStats = viewer->getCamera()->getStats();
+    if (!viewerStats) return;
+
+    // 只统计上次采样之后出的帧，静止时保留为0
+    unsigned int last = viewerStats->getLatestFrameNumber();
+    unsigned int first = std::max(m_lastSampleFrameNumber + 1, viewerStats->getEarliestFrameNumber());
+    if (m_lastSampleFrameNumber == last || first > last) return;
+    m_lastSampleFrameNumber = last;
+
+    double value = 0.0;
+    if (averagedAttribute(viewerStats, first, last, "Event traversal time taken", value)) snapshot.eventMs = value * 1000.0;
+    if (averagedAttribute(viewerStats, first, last, "Update traversal time taken", value)) snapshot.updateMs = value * 1000.0;
+    if (averagedAttribute(cameraStats, first, last, "Cull traversal time taken", value)) snapshot.cullMs = value * 1000.0;
+    if (averagedAttribute(cameraStats, first, last, "Draw traversal time taken", value)) snapshot.drawMs = value * 1000.0;
+
+    // 场景统计：每个图元集对应一次绘制调用
+    if (averagedAttribute(cameraStats, first, last, "Visible number of PrimitiveSets", value)) snapshot.drawCalls = value;
+    if (averagedAttribute(cameraStats, first, last, "Visible vertex count", value)) snapshot.vertices = value;
+
+    const char* triangleModes[] = { "GL_TRIANGLES", "GL_TRIANGLE_STRIP", "GL_TRIANGLE_FAN", "GL_POLYGON" };
+    for (const char* mode : triangleModes) {
+        if (averagedAttribute(cameraStats, first, last, std::string("Visible number of ") + mode, value)) {
+            snapshot.triangles += value;
+        }
+    }
+    const char* quadModes[] = { "GL_QUADS", "GL_QUAD_STRIP" };
+    for (const char* mode : quadModes) {
+        if (averagedAttribute(cameraStats, first, last, std::string("Visible number of ") + mode, value)) {
+            snapshot.triangles += value * 2.0;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include "../GeometryBase.h"
+#include <osg/BufferObject>
+#include <osg/Node>
+#include <osg/Timer>
+#include <osg/observer_ptr>
+#include <QString>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace osgViewer { class Viewer; }
+
+// 性能采样结果（时间单位毫秒）
+struct PerformanceSnapshot
+{
+    // 帧
+    double fps = 0.0;                  // 采样区间内实际出帧数/秒（按需渲染时静止画面为0）
+    double frameAverageMs = 0.0;       // viewer->frame()耗时
+    double frameP50Ms = 0.0;
+    double frameP95Ms = 0.0;
+    double frameP99Ms = 0.0;
+    double frameMaxMs = 0.0;
+
+    // osgViewer统计（采样区间内平均）
+    double eventMs = 0.0;
+    double updateMs = 0.0;
+    double cullMs = 0.0;
+    double drawMs = 0.0;
+    double drawCalls = 0.0;            // 可见图元集数量
+    double triangles = 0.0;
+    double vertices = 0.0;
+
+    // 拾取
+    int pickCount = 0;
+    double pickAverageMs = 0.0;
+    double pickMaxMs = 0.0;
+
+    // 场景
+    int geoCount = 0;
+    quint64 geometryBytes = 0;         // 顶点/法线/颜色/纹理/索引数组占用（共享数组只计一次）
+
+    QString toString() const;          // 状态栏提示用的完整文本
+    QString toHudText() const;         // 视口HUD文本（默认字体只含ASCII字符）
+};
+
+// 性能监视器 - 记录每帧耗时和拾取耗时，按需汇总osgViewer统计和场景内存
+// 汇总在调用方的低频定时器中进行，平时每帧只记录一个耗时
+class PerformanceMonitor
+{
+public:
+    PerformanceMonitor();
+    ~PerformanceMonitor();
+
+    // 绑定查看器并打开需要的统计项
+    void attach(osgViewer::Viewer* viewer);
+
+    // 记录一帧viewer->frame()耗时
+    void recordFrame(double frameMs);
+
+    // 记录一次拾取耗时（可在拾取线程调用）
+    static void recordPickLatency(double pickMs);
+
+    // 汇总自上次采样以来的数据
+    PerformanceSnapshot sample(const std::vector<Geo3D::Ptr>& geometries);
+
+    // 统计几何体数组占用的字节数，visited用于跳过共享数组
+    static quint64 geometryMemory(osg::Node* node, std::unordered_set<const osg::BufferData*>& visited);
+
+private:
+    void readViewerStats(PerformanceSnapshot& snapshot);
+
+    osg::observer_ptr<osgViewer::Viewer> m_viewer;
+
+    // 帧耗时环形缓冲
+    std::vector<double> m_frameSamples;
+    size_t m_frameSampleCursor;
+    size_t m_frameSampleCount;
+    int m_framesSinceSample;
+    osg::Timer_t m_lastSampleTick;
+    unsigned int m_lastSampleFrameNumber;
+
+    // 拾取耗时（跨线程写入）
+    static std::mutex s_pickMutex;
+    static int s_pickCount;
+    static double s_pickTotalMs;
+    static double s_pickMaxMs;
+};
+
+// 作用域拾取计时 - 析构时记录一次拾取耗时
+class PickLatencyScope
+{
+public:
+    PickLatencyScope() : m_start(osg::Timer::instance()->tick()) {}
+    ~PickLatencyScope()
+    {
+        PerformanceMonitor::recordPickLatency(osg::Timer::instance()->delta_m(m_start, osg::Timer::instance()->tick()));
+    }
+
+private:
+    osg::Timer_t m_start;
+};
@@ -0,0 +1,519 @@
+﻿#include "SceneBVH.h"
+#include "../GeometryBase.h"
+#include "../managers/GeoNodeManager.h"
+#include <osgUtil/CullVisitor>
+#include <algorithm>
+
+// ============= 构造函数 =============
+
+SceneBVH::SceneBVH()
+{
+    m_nodes.reserve(64);
+}
+
+// ============= 对象管理 =============
+
+void SceneBVH::insert(Geo3D* geo, const osg::BoundingBox& box)
+{
+    if (!geo) return;
+    
+    if (contains(geo)) {
+        update(geo, box);
+        return;
+    }
+    
+    int leaf = NULL_NODE;
+    if (box.valid()) {
+        leaf = allocateNode();
+        m_nodes[leaf].box = fatten(box);
+        m_nodes[leaf].geometry = geo;
+        m_nodes[leaf].height = 0;
+        insertLeaf(leaf);
+        ++m_leafCount;
+    }
+    m_proxies[geo] = leaf;
+}
+
+void SceneBVH::update(Geo3D* geo, const osg::BoundingBox& box)
+{
+    auto it = m_proxies.find(geo);
+    if (it == m_proxies.end()) {
+        insert(geo, box);
+        return;
+    }
+    
+    int leaf = it->second;
+    
+    // 包围盒失效（几何被清空）：移出树
+    if (!box.valid()) {
+        if (leaf != NULL_NODE) {
+            removeLeaf(leaf);
+            freeNode(leaf);
+            --m_leafCount;
+            it->second = NULL_NODE;
+        }
+        return;
+    }
+    
+    // 仍在扩张包围盒内，树不需要变化
+    if (leaf != NULL_NODE && contains(m_nodes[leaf].box, box)) {
+        return;
+    }
+    
+    if (leaf != NULL_NODE) {
+        removeLeaf(leaf);
+    } else {
+        leaf = allocateNode();
+        m_nodes[leaf].geometry = geo;
+        m_nodes[leaf].height = 0;
+        ++m_leafCount;
+        it->second = leaf;
+    }
+    
+    m_nodes[leaf].box = fatten(box);
+    insertLeaf(leaf);
+}
+
+void SceneBVH::remove(Geo3D* geo)
+{
+    auto it = m_proxies.find(geo);
+    if (it == m_proxies.end()) return;
+    
+    if (it->second != NULL_NODE) {
+        removeLeaf(it->second);
+        freeNode(it->second);
+        --m_leafCount;
+    }
+    m_proxies.erase(it);
+}
+
+void SceneBVH::clear()
+{
+    m_nodes.clear();
+    m_root = NULL_NODE;
+    m_freeList = NULL_NODE;
+    m_leafCount = 0;
+    m_proxies.clear();
+}
+
+int SceneBVH::getHeight() const
+{
+    return m_root == NULL_NODE ? 0 : m_nodes[m_root].height;
+}
+
+// ============= 查询 =============
+
+void SceneBVH::query(const osg::Polytope& polytope, std::vector<Geo3D*>& results) const
+{
+    if (m_root == NULL_NODE) return;
+    
+    // Polytope的测试接口不是const，复制一份
+    osg::Polytope frustum = polytope;
+    
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(m_root);
+    
+    while (!stack.empty()) {
+        int nodeId = stack.back();
+        stack.pop_back();
+        
+        const Node& node = m_nodes[nodeId];
+        if (!frustum.contains(node.box)) continue;
+        
+        if (node.isLeaf()) {
+            results.push_back(node.geometry);
+        } else if (frustum.containsAllOf(node.box)) {
+            // 整棵子树都在多面体内，不再逐个测试
+            collectLeaves(nodeId, results);
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void SceneBVH::query(const osg::BoundingBox& box, std::vector<Geo3D*>& results) const
+{
+    if (m_root == NULL_NODE || !box.valid()) return;
+    
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(m_root);
+    
+    while (!stack.empty()) {
+        int nodeId = stack.back();
+        stack.pop_back();
+        
+        const Node& node = m_nodes[nodeId];
+        if (!node.box.intersects(box)) continue;
+        
+        if (node.isLeaf()) {
+            results.push_back(node.geometry);
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void SceneBVH::query(const osg::Vec3d& start, const osg::Vec3d& end, double margin, std::vector<Geo3D*>& results) const
+{
+    if (m_root == NULL_NODE) return;
+    
+    const osg::Vec3 expand(margin, margin, margin);
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(m_root);
+    
+    while (!stack.empty()) {
+        int nodeId = stack.back();
+        stack.pop_back();
+        
+        const Node& node = m_nodes[nodeId];
+        double tEnter = 0.0;
+        if (!intersectSegment(osg::BoundingBox(node.box._min - expand, node.box._max + expand), start, end, tEnter)) continue;
+        
+        if (node.isLeaf()) {
+            results.push_back(node.geometry);
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+bool SceneBVH::intersectSegment(const osg::BoundingBox& box, const osg::Vec3d& start, const osg::Vec3d& end, double& tEnter)
+{
+    if (!box.valid()) return false;
+    
+    double t0 = 0.0;
+    double t1 = 1.0;
+    const osg::Vec3d direction = end - start;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (direction[axis] == 0.0) {
+            if (start[axis] < box._min[axis] || start[axis] > box._max[axis]) return false;
+            continue;
+        }
+        double tNear = (box._min[axis] - start[axis]) / direction[axis];
+        double tFar = (box._max[axis] - start[axis]) / direction[axis];
+        if (tNear > tFar) std::swap(tNear, tFar);
+        t0 = std::max(t0, tNear);
+        t1 = std::min(t1, tFar);
+        if (t0 > t1) return false;
+    }
+    
+    tEnter = t0;
+    return true;
+}
+
+void SceneBVH::collectLeaves(int nodeId, std::vector<Geo3D*>& results) const
+{
+    std::vector<int> stack;
+    stack.push_back(nodeId);
+    
+    while (!stack.empty()) {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+        
+        if (node.isLeaf()) {
+            results.push_back(node.geometry);
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+// ============= 节点池 =============
+
+int SceneBVH::allocateNode()
+{
+    if (m_freeList == NULL_NODE) {
+        m_nodes.emplace_back();
+        return static_cast<int>(m_nodes.size()) - 1;
+    }
+    
+    int nodeId = m_freeList;
+    m_freeList = m_nodes[nodeId].parent;
+    m_nodes[nodeId] = Node();
+    return nodeId;
+}
+
+void SceneBVH::freeNode(int nodeId)
+{
+    m_nodes[nodeId] = Node();
+    m_nodes[nodeId].parent = m_freeList;
+    m_freeList = nodeId;
+}
+
+// ============= 树结构维护 =============
+
+void SceneBVH::insertLeaf(int leaf)
+{
+    if (m_root == NULL_NODE) {
+        m_root = leaf;
+        m_nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+    
+    // 1. 按表面积代价自顶向下寻找最佳兄弟节点
+    const osg::BoundingBox leafBox = m_nodes[leaf].box;
+    int index = m_root;
+    while (!m_nodes[index].isLeaf()) {
+        const Node& node = m_nodes[index];
+        
+        float area = surfaceArea(node.box);
+        float combinedArea = surfaceArea(merge(node.box, leafBox));
+        
+        // 在当前节点处新建父节点的代价
+        float cost = 2.0f * combinedArea;
+        // 继续下降时祖先包围盒增大的代价
+        float inheritanceCost = 2.0f * (combinedArea - area);
+        
+        auto descendCost = [&](int childId) {
+            const Node& child = m_nodes[childId];
+            float mergedArea = surfaceArea(merge(leafBox, child.box));
+            return child.isLeaf() ? mergedArea + inheritanceCost
+                                  : (mergedArea - surfaceArea(child.box)) + inheritanceCost;
+        };
+        
+        float cost1 = descendCost(node.child1);
+        float cost2 = descendCost(node.child2);
+        
+        if (cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+    
+    // 2. 新建父节点，挂上兄弟节点和新叶子
+    int sibling = index;
+    int oldParent = m_nodes[sibling].parent;
+    int newParent = allocateNode();
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].box = merge(leafBox, m_nodes[sibling].box);
+    m_nodes[newParent].height = m_nodes[sibling].height + 1;
+    
+    if (oldParent != NULL_NODE) {
+        if (m_nodes[oldParent].child1 == sibling) {
+            m_nodes[oldParent].child1 = newParent;
+        } else {
+            m_nodes[oldParent].child2 = newParent;
+        }
+    } else {
+        m_root = newParent;
+    }
+    
+    m_nodes[newParent].child1 = sibling;
+    m_nodes[newParent].child2 = leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+    
+    // 3. 向上修正包围盒和高度
+    refitAncestors(m_nodes[leaf].parent);
+}
+
+void SceneBVH::removeLeaf(int leaf)
+{
+    if (leaf == m_root) {
+        m_root = NULL_NODE;
+        return;
+    }
+    
+    int parent = m_nodes[leaf].parent;
+    int grandParent = m_nodes[parent].parent;
+    int sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+    
+    if (grandParent != NULL_NODE) {
+        // 用兄弟节点替换父节点
+        if (m_nodes[grandParent].child1 == parent) {
+            m_nodes[grandParent].child1 = sibling;
+        } else {
+            m_nodes[grandParent].child2 = sibling;
+        }
+        m_nodes[sibling].parent = grandParent;
+        freeNode(parent);
+        
+        refitAncestors(grandParent);
+    } else {
+        m_root = sibling;
+        m_nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+    }
+    
+    m_nodes[leaf].parent = NULL_NODE;
+}
+
+void SceneBVH::refitAncestors(int nodeId)
+{
+    while (nodeId != NULL_NODE) {
+        nodeId = balance(nodeId);
+        
+        Node& node = m_nodes[nodeId];
+        const Node& child1 = m_nodes[node.child1];
+        const Node& child2 = m_nodes[node.child2];
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.box = merge(child1.box, child2.box);
+        
+        nodeId = node.parent;
+    }
+}
+
+int SceneBVH::balance(int iA)
+{
+    Node& A = m_nodes[iA];
+    if (A.isLeaf() || A.height < 2) {
+        return iA;
+    }
+    
+    int iB = A.child1;
+    int iC = A.child2;
+    Node& B = m_nodes[iB];
+    Node& C = m_nodes[iC];
+    
+    int balanceFactor = C.height - B.height;
+    
+    // C上提
+    if (balanceFactor > 1) {
+        int iF = C.child1;
+        int iG = C.child2;
+        Node& F = m_nodes[iF];
+        Node& G = m_nodes[iG];
+        
+        // A与C交换
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        
+        if (C.parent != NULL_NODE) {
+            if (m_nodes[C.parent].child1 == iA) {
+                m_nodes[C.parent].child1 = iC;
+            } else {
+                m_nodes[C.parent].child2 = iC;
+            }
+        } else {
+            m_root = iC;
+        }
+        
+        // 旋转
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.box = merge(B.box, G.box);
+            C.box = merge(A.box, F.box);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        } else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.box = merge(B.box, F.box);
+            C.box = merge(A.box, G.box);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        
+        return iC;
+    }
+    
+    // B上提
+    if (balanceFactor < -1) {
+        int iD = B.child1;
+        int iE = B.child2;
+        Node& D = m_nodes[iD];
+        Node& E = m_nodes[iE];
+        
+        // A与B交换
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        
+        if (B.parent != NULL_NODE) {
+            if (m_nodes[B.parent].child1 == iA) {
+                m_nodes[B.parent].child1 = iB;
+            } else {
+                m_nodes[B.parent].child2 = iB;
+            }
+        } else {
+            m_root = iB;
+        }
+        
+        // 旋转
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.box = merge(C.box, E.box);
+            B.box = merge(A.box, D.box);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        } else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.box = merge(C.box, D.box);
+            B.box = merge(A.box, E.box);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        
+        return iB;
+    }
+    
+    return iA;
+}
+
+// ============= 包围盒工具 =============
+
+osg::BoundingBox SceneBVH::fatten(const osg::BoundingBox& box)
+{
+    // 按尺寸的10%扩张，退化包围盒（单点、平面）至少扩张一个最小值
+    const float minMargin = 0.01f;
+    float margin = std::max(box.radius() * 0.1f, minMargin);
+    osg::Vec3 extent(margin, margin, margin);
+    return osg::BoundingBox(box._min - extent, box._max + extent);
+}
+
+osg::BoundingBox SceneBVH::merge(const osg::BoundingBox& a, const osg::BoundingBox& b)
+{
+    osg::BoundingBox result = a;
+    result.expandBy(b);
+    return result;
+}
+
+float SceneBVH::surfaceArea(const osg::BoundingBox& box)
+{
+    osg::Vec3 d = box._max - box._min;
+    return 2.0f * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+}
+
+bool SceneBVH::contains(const osg::BoundingBox& outer, const osg::BoundingBox& inner)
+{
+    return outer._min.x() <= inner._min.x() && outer._min.y() <= inner._min.y() && outer._min.z() <= inner._min.z()
+        && outer._max.x() >= inner._max.x() && outer._max.y() >= inner._max.y() && outer._max.z() >= inner._max.z();
+}
+
+// ============= SceneBVHCullCallback =============
+
+void SceneBVHCullCallback::operator()(osg::Node* node, osg::NodeVisitor* nv)
+{
+    osgUtil::CullVisitor* cv = dynamic_cast<osgUtil::CullVisitor*>(nv);
+    osg::Group* group = node ? node->asGroup() : nullptr;
+    
+    // 子节点与BVH登记不一致时（例如有未经场景管理器添加的节点）退回普通遍历
+    if (!cv || !group || !m_bvh || m_bvh->getProxyCount() != static_cast<int>(group->getNumChildren())) {
+        traverse(node, nv);
+        return;
+    }
+    
+    // 视锥体位于当前节点的局部坐标系，几何体根节点不带变换，与BVH的坐标一致
+    m_visibleGeometries.clear();
+    m_bvh->query(cv->getCurrentCullingSet().getFrustum(), m_visibleGeometries);
+    
+    for (Geo3D* geo : m_visibleGeometries) {
+        osg::Node* child = geo->mm_node()->getOSGNode().get();
+        if (child) {
+            child->accept(*nv);
+        }
+    }
+}
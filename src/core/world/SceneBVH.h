@@ -0,0 +1,103 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <osg/BoundingBox>
+#include <osg/Polytope>
+#include <osg/NodeCallback>
+#include <unordered_map>
+#include <vector>
+
+// 前向声明
+class Geo3D;
+
+// 场景动态AABB树（BVH）
+// 以Geo3D为键，叶子存放扩张后的包围盒（fat AABB）。几何体包围盒变化时，
+// 只要新包围盒仍在扩张包围盒内就不需要改动树；超出时移除后重新插入，
+// 插入按表面积代价选择兄弟节点，并通过AVL式旋转保持平衡。
+class SceneBVH
+{
+public:
+    SceneBVH();
+    ~SceneBVH() = default;
+    
+    // ============= 对象管理 =============
+    void insert(Geo3D* geo, const osg::BoundingBox& box);
+    void update(Geo3D* geo, const osg::BoundingBox& box);  // 包围盒变化（几何重建/变换）
+    void remove(Geo3D* geo);
+    void clear();
+    
+    bool contains(Geo3D* geo) const { return m_proxies.find(geo) != m_proxies.end(); }
+    int getProxyCount() const { return static_cast<int>(m_proxies.size()); }
+    int getLeafCount() const { return m_leafCount; }
+    int getHeight() const;
+    bool empty() const { return m_root == NULL_NODE; }
+    
+    // ============= 查询 =============
+    // 与多面体（视锥体、拾取锥体）相交的对象
+    void query(const osg::Polytope& polytope, std::vector<Geo3D*>& results) const;
+    
+    // 与包围盒相交的对象
+    void query(const osg::BoundingBox& box, std::vector<Geo3D*>& results) const;
+    
+    // 包围盒外扩margin后与线段(start, end)相交的对象（批量射线查询）
+    void query(const osg::Vec3d& start, const osg::Vec3d& end, double margin, std::vector<Geo3D*>& results) const;
+    
+    // 线段与包围盒求交（slab法），tEnter为进入包围盒时的线段参数
+    static bool intersectSegment(const osg::BoundingBox& box, const osg::Vec3d& start, const osg::Vec3d& end, double& tEnter);
+    
+private:
+    static const int NULL_NODE = -1;
+    
+    struct Node
+    {
+        osg::BoundingBox box;        // 扩张后的包围盒
+        Geo3D* geometry = nullptr;   // 叶子对应的几何体
+        int parent = NULL_NODE;      // 父节点（空闲时作为空闲链表的next）
+        int child1 = NULL_NODE;
+        int child2 = NULL_NODE;
+        int height = -1;             // 叶子为0，空闲节点为-1
+        
+        bool isLeaf() const { return child1 == NULL_NODE; }
+    };
+    
+    // 节点池
+    int allocateNode();
+    void freeNode(int nodeId);
+    
+    // 树结构维护
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int nodeId);
+    void refitAncestors(int nodeId);
+    
+    // 包围盒工具
+    static osg::BoundingBox fatten(const osg::BoundingBox& box);
+    static osg::BoundingBox merge(const osg::BoundingBox& a, const osg::BoundingBox& b);
+    static float surfaceArea(const osg::BoundingBox& box);
+    static bool contains(const osg::BoundingBox& outer, const osg::BoundingBox& inner);
+    
+    // 遍历子树的所有叶子
+    void collectLeaves(int nodeId, std::vector<Geo3D*>& results) const;
+    
+    std::vector<Node> m_nodes;
+    int m_root = NULL_NODE;
+    int m_freeList = NULL_NODE;
+    int m_leafCount = 0;
+    
+    // Geo3D -> 叶子节点（包围盒无效的对象不进树，记为NULL_NODE）
+    std::unordered_map<Geo3D*, int> m_proxies;
+};
+
+// 基于场景BVH的裁剪回调
+// 挂在几何体根节点（m_geometryNode）上：用BVH查询视锥体内的对象，只遍历这些子节点。
+class SceneBVHCullCallback : public osg::NodeCallback
+{
+public:
+    explicit SceneBVHCullCallback(const SceneBVH* bvh) : m_bvh(bvh) {}
+    
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv) override;
+    
+private:
+    const SceneBVH* m_bvh;
+    std::vector<Geo3D*> m_visibleGeometries;  // 复用的查询缓冲
+};
@@ -27,6 +27,7 @@ SceneManager3D::SceneManager3D()
     , m_pickingIndicatorNode(new osg::Group)
     , m_skyboxNode(new osg::Group)
     , m_selectedGeometry(nullptr)
+    , m_geoInstancer(std::make_unique<GeoInstancer>())
     , m_isDrawing(false)
     , m_currentDrawingGeometry(nullptr)
     , m_isDraggingControlPoint(false)
@@ -38,20 +39,43 @@ SceneManager3D::SceneManager3D()
     , m_coordinateSystemRenderer(std::make_unique<CoordinateSystemRenderer>())
     , m_coordinateSystemEnabled(true)
 {
+    m_rayQueryService.setSceneBVH(&m_sceneBVH);
+    m_rayQueryService.setSceneLock(&m_sceneLock);
+    
     LOG_INFO("场景管理器初始化", "场景管理器");
 }
 
 SceneManager3D::~SceneManager3D()
 {
+    // 先停止后台拾取线程，避免其继续访问场景
+    if (m_asyncPickingService) {
+        m_asyncPickingService->shutdown();
+        m_asyncPickingService.reset();
+    }
+    
     // 清理几何拾取系统
     if (m_geometryPickingSystem) {
         m_geometryPickingSystem->shutdown();
         m_geometryPickingSystem = nullptr;
     }
     
-    // 清理几何体
+    // 断开几何体变化监听
+    for (auto& entry : m_geometryConnections) {
+        for (const auto& connection : entry.second) {
+            QObject::disconnect(connection);
+        }
+    }
+    m_geometryConnections.clear();
+    m_geoInstancer->untrackAll();
+    
+    // 清理几何体（外部仍持有的对象不再引用本场景的锁和实体存储）
+    for (const auto& geo : m_geometries) {
+        geo->setSceneLock(nullptr);
+        geo->bindEntityStore(nullptr);
+    }
     m_geometries.clear();
     m_selectedGeometries.clear();
+    m_entityStore.clear();
     
     LOG_INFO("场景管理器析构", "场景管理器");
 }
@@ -96,6 +120,13 @@ void SceneManager3D::setupSceneGraph()
     m_pickingIndicatorNode->setName("3D_PICKING_INDICATOR_NODE");
     m_skyboxNode->setName("3D_SKYBOX_NODE");
     
+    // 几何体根节点用BVH裁剪，只遍历视锥体内的对象
+    m_geometryNode->setCullCallback(new SceneBVHCullCallback(&m_sceneBVH));
+    
+    // 实例批次放在几何体根节点之外，不参与拾取；与几何体根节点共享显示模式状态
+    m_geoInstancer->initialize(m_sceneNode.get());
+    m_geoInstancer->getRootNode()->setStateSet(m_geometryNode->getOrCreateStateSet());
+    
     LOG_INFO("场景图层次结构设置完成", "场景管理器");
 }
 
@@ -122,6 +153,9 @@ void SceneManager3D::setupRenderingStates()
     alphaBlend->setFunction(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::ONE_MINUS_SRC_ALPHA);
     rootStateSet->setAttributeAndModes(alphaBlend, osg::StateAttribute::ON);
     
+    // 实例属性的步进在批次外恢复为逐顶点
+    GeoInstancer::applyDefaultDivisors(rootStateSet);
+    
     LOG_INFO("渲染状态设置完成", "场景管理器");
 }
 
@@ -168,6 +202,14 @@ void SceneManager3D::setupPickingSystem(osgViewer::Viewer* viewer)
     osg::Camera* camera = viewer->getCamera();
     if (camera) {
         m_geometryPickingSystem->initialize(camera, m_geometryNode.get());
+        m_geometryPickingSystem->setSceneBVH(&m_sceneBVH);
+        
+        // 悬停拾取放到后台线程
+        m_asyncPickingService = std::make_unique<AsyncPickingService>();
+        m_asyncPickingService->setConfig(m_geometryPickingSystem->getConfig());
+        if (!m_asyncPickingService->initialize(camera, m_geometryNode.get(), &m_sceneBVH, &m_sceneLock)) {
+            m_asyncPickingService.reset();
+        }
     }
     
     LOG_INFO("拾取系统设置完成", "场景管理器");
@@ -203,14 +245,20 @@ void SceneManager3D::addGeometry(Geo3D::Ptr geo)
 {
     if (!geo) return;
     
-    // 添加到几何体列表
+    QWriteLocker sceneLocker(&m_sceneLock);
+    
+    // 添加到几何体列表，之后对象修改自身子图时持有本场景的写锁
     m_geometries.push_back(geo);
+    geo->setSceneLock(&m_sceneLock);
+    geo->bindEntityStore(&m_entityStore);
     
     // 添加到场景图
     if (geo->mm_node()) {
         osg::Node* geoOSGNode = geo->mm_node()->getOSGNode();
         if (geoOSGNode) {
             m_geometryNode->addChild(geoOSGNode);
+            trackGeometry(geo.get());
+            m_geoInstancer->track(geo.get());
             LOG_INFO(QString("添加几何体到场景: %1").arg(geoType3DToString(geo->getGeoType())), "场景管理器");
         } else {
             LOG_WARNING(QString("几何体没有有效的OSG节点: %1").arg(geoType3DToString(geo->getGeoType())), "场景管理器");
@@ -222,6 +270,8 @@ void SceneManager3D::removeGeometry(Geo3D::Ptr geo)
 {
     if (!geo) return;
     
+    QWriteLocker sceneLocker(&m_sceneLock);
+    
     // 从几何体列表中移除
     auto it = std::find_if(m_geometries.begin(), m_geometries.end(),
         [geo](const osg::ref_ptr<Geo3D>& ptr) { return ptr.get() == geo; });
@@ -234,11 +284,15 @@ void SceneManager3D::removeGeometry(Geo3D::Ptr geo)
                 m_geometryNode->removeChild(geoOSGNode);
             }
         }
+        untrackGeometry(geo.get());
+        m_geoInstancer->untrack(geo.get());
         
         // 从选择列表中移除
         removeFromSelection(geo);
         
-        // 从几何体列表中移除
+        // 从几何体列表中移除，节点已离开场景图，不再需要加锁
+        geo->setSceneLock(nullptr);
+        geo->bindEntityStore(nullptr);
         m_geometries.erase(it);
         
         LOG_INFO(QString("从场景移除几何体: %1").arg(geoType3DToString(geo->getGeoType())), "场景管理器");
@@ -247,18 +301,109 @@ void SceneManager3D::removeGeometry(Geo3D::Ptr geo)
 
 void SceneManager3D::removeAllGeometries()
 {
+    QWriteLocker sceneLocker(&m_sceneLock);
+    
     // 清空选择
     clearSelection();
     
     // 从场景图中移除所有几何体
     m_geometryNode->removeChildren(0, m_geometryNode->getNumChildren());
     
+    for (auto& entry : m_geometryConnections) {
+        for (const auto& connection : entry.second) {
+            QObject::disconnect(connection);
+        }
+    }
+    m_geometryConnections.clear();
+    m_sceneBVH.clear();
+    m_snapEngine.clear();
+    m_geoInstancer->untrackAll();
+    
     // 清空几何体列表
+    for (const auto& geo : m_geometries) {
+        geo->setSceneLock(nullptr);
+        geo->bindEntityStore(nullptr);
+    }
     m_geometries.clear();
+    m_entityStore.clear();
+    
+    requestRedraw();
     
     LOG_INFO("清空所有几何体", "场景管理器");
 }
 
+void SceneManager3D::trackGeometry(Geo3D* geo)
+{
+    GeoNodeManager* nodeManager = geo->mm_node();
+    m_sceneBVH.insert(geo, nodeManager->getBoundingBox());
+    m_snapEngine.insert(geo);
+    
+    std::vector<QMetaObject::Connection>& connections = m_geometryConnections[geo];
+    
+    // 几何重建或变换导致包围盒变化时刷新BVH（在几何体的写锁内同步调用）
+    connections.push_back(QObject::connect(nodeManager, &GeoNodeManager::boundingBoxChanged,
+        [this, geo]() {
+            m_sceneBVH.update(geo, geo->mm_node()->getBoundingBox());
+        }));
+    
+    // 几何重建或变换后捕捉特征失效，下次查询前重新提取（可见性在查询时判断）
+    auto snapDirty = [this, geo]() { m_snapEngine.markDirty(geo); };
+    connections.push_back(QObject::connect(nodeManager, &GeoNodeManager::geometryChanged, snapDirty));
+    connections.push_back(QObject::connect(nodeManager, &GeoNodeManager::transformChanged, snapDirty));
+    
+    // 几何、变换、样式和状态变化都需要重绘一帧
+    auto redraw = [this]() { requestRedraw(); };
+    connections.push_back(QObject::connect(nodeManager, &GeoNodeManager::geometryChanged, redraw));
+    connections.push_back(QObject::connect(nodeManager, &GeoNodeManager::transformChanged, redraw));
+    connections.push_back(QObject::connect(geo, &Geo3D::parametersChanged, redraw));
+    if (GeoStateManager* stateManager = geo->mm_state()) {
+        connections.push_back(QObject::connect(stateManager, &GeoStateManager::stateCompleted, redraw));
+        connections.push_back(QObject::connect(stateManager, &GeoStateManager::stateInvalidated, redraw));
+        connections.push_back(QObject::connect(stateManager, &GeoStateManager::stateSelected, redraw));
+        connections.push_back(QObject::connect(stateManager, &GeoStateManager::stateDeselected, redraw));
+    }
+    
+    requestRedraw();
+}
+
+void SceneManager3D::untrackGeometry(Geo3D* geo)
+{
+    auto it = m_geometryConnections.find(geo);
+    if (it != m_geometryConnections.end()) {
+        for (const auto& connection : it->second) {
+            QObject::disconnect(connection);
+        }
+        m_geometryConnections.erase(it);
+    }
+    m_sceneBVH.remove(geo);
+    m_snapEngine.remove(geo);
+    
+    requestRedraw();
+}
+
+void SceneManager3D::setRedrawCallback(std::function<void()> callback)
+{
+    m_redrawCallback = callback;
+}
+
+void SceneManager3D::requestRedraw() const
+{
+    if (m_redrawCallback) {
+        m_redrawCallback();
+    }
+}
+
+bool SceneManager3D::isAnimating() const
+{
+    return m_pickingIndicator && m_pickingIndicator->isAnimating();
+}
+
+void SceneManager3D::setInstancingEnabled(bool enabled)
+{
+    m_geoInstancer->setEnabled(enabled);
+    requestRedraw();
+}
+
 // ========================================= 选择管理 =========================================
 
 void SceneManager3D::setSelectedGeometry(Geo3D::Ptr geo)
@@ -297,7 +442,7 @@ void SceneManager3D::addToSelection(Geo3D::Ptr geo)
     
     LOG_INFO(QString("添加到选择: 对象类型=%1, 总选择数=%2")
         .arg(geoType3DToString(geo->getGeoType()))
-        .arg(m_selectedGeometries.size()), "场景管理器");
+        .arg(getSelectionCount()), "场景管理器");
 }
 
 void SceneManager3D::removeFromSelection(Geo3D::Ptr geo)
@@ -320,7 +465,7 @@ void SceneManager3D::removeFromSelection(Geo3D::Ptr geo)
         
         LOG_INFO(QString("从选择中移除: 对象类型=%1, 剩余选择数=%2")
             .arg(geoType3DToString(geo->getGeoType()))
-            .arg(m_selectedGeometries.size()), "场景管理器");
+            .arg(getSelectionCount()), "场景管理器");
     }
 }
 
@@ -341,6 +486,10 @@ void SceneManager3D::clearSelection()
 
 bool SceneManager3D::isSelected(Geo3D::Ptr geo) const
 {
+    // 场景中的对象直接读实体存储的选中位
+    if (geo && geo->getEntityStore() == &m_entityStore) {
+        return (m_entityStore.getState(geo->getEntity()) & GeoState_Selected3D) != 0;
+    }
     return std::find(m_selectedGeometries.begin(), m_selectedGeometries.end(), geo) != m_selectedGeometries.end();
 }
 
@@ -353,7 +502,55 @@ PickResult SceneManager3D::performPicking(int mouseX, int mouseY)
         return PickResult();
     }
     
-    return m_geometryPickingSystem->pickGeometry(mouseX, mouseY);
+    PickResult result = m_geometryPickingSystem->pickGeometry(mouseX, mouseY);
+    
+    SnapResult snapResult;
+    if (snapPoint(mouseX, mouseY, snapResult)) {
+        result.isSnapped = true;
+        result.snapPosition = snapResult.position;
+        result.snapType = snapResult.type;
+    }
+    return result;
+}
+
+bool SceneManager3D::snapPoint(int mouseX, int mouseY, SnapResult& result)
+{
+    if (!m_geometryPickingSystem) {
+        return false;
+    }
+    
+    PickCameraState cameraState = m_geometryPickingSystem->captureCameraState();
+    if (!cameraState.isValid()) {
+        return false;
+    }
+    
+    std::vector<Geo3D*> excluded;
+    if (m_currentDrawingGeometry.valid()) excluded.push_back(m_currentDrawingGeometry.get());
+    if (m_draggingGeometry.valid()) excluded.push_back(m_draggingGeometry.get());
+    
+    QReadLocker sceneLocker(&m_sceneLock);
+    return m_snapEngine.snap(cameraState, mouseX, mouseY, excluded, result);
+}
+
+void SceneManager3D::castRays(const std::vector<RayQuery>& rays, std::vector<PickResult>& results)
+{
+    m_rayQueryService.query(m_geometries, rays, results);
+}
+
+bool SceneManager3D::requestAsyncPicking(int mouseX, int mouseY)
+{
+    if (!m_asyncPickingService || !m_geometryPickingSystem) {
+        return false;
+    }
+    
+    // 相机矩阵在主线程采集，后台线程只使用快照
+    PickCameraState cameraState = m_geometryPickingSystem->captureCameraState();
+    if (!cameraState.isValid()) {
+        return false;
+    }
+    
+    m_asyncPickingService->requestPick(mouseX, mouseY, cameraState);
+    return true;
 }
 
 // ========================================= 显示模式 =========================================
@@ -370,6 +567,8 @@ void SceneManager3D::setWireframeMode(bool wireframe)
         stateSet->removeAttribute(osg::StateAttribute::POLYGONMODE);
     }
     
+    requestRedraw();
+    
     LOG_INFO(QString("设置线框模式: %1").arg(wireframe ? "开启" : "关闭"), "场景管理器");
 }
 
@@ -385,6 +584,8 @@ void SceneManager3D::setShadedMode(bool shaded)
         stateSet->removeAttribute(osg::StateAttribute::POLYGONMODE);
     }
     
+    requestRedraw();
+    
     LOG_INFO(QString("设置着色模式: %1").arg(shaded ? "开启" : "关闭"), "场景管理器");
 }
 
@@ -400,6 +601,8 @@ void SceneManager3D::setPointMode(bool point)
         stateSet->removeAttribute(osg::StateAttribute::POLYGONMODE);
     }
     
+    requestRedraw();
+    
     LOG_INFO(QString("设置点模式: %1").arg(point ? "开启" : "关闭"), "场景管理器");
 }
 
@@ -417,6 +620,8 @@ void SceneManager3D::enableSkybox(bool enabled)
         }
     }
     
+    requestRedraw();
+    
     LOG_INFO(QString("天空盒: %1").arg(enabled ? "启用" : "禁用"), "场景管理器");
 }
 
@@ -458,6 +663,8 @@ void SceneManager3D::refreshSkybox()
         
         LOG_INFO("刷新天空盒", "场景管理器");
     }
+    
+    requestRedraw();
 }
 
 // ========================================= 坐标系管理 =========================================
@@ -478,6 +685,8 @@ void SceneManager3D::enableCoordinateSystem(bool enabled)
         }
     }
     
+    requestRedraw();
+    
     LOG_INFO(QString("坐标系: %1").arg(enabled ? "启用" : "禁用"), "场景管理器");
 }
 
@@ -499,6 +708,8 @@ void SceneManager3D::refreshCoordinateSystem()
         
         LOG_INFO("刷新坐标系", "场景管理器");
     }
+    
+    requestRedraw();
 }
 
 // ========================================= 相机操作 =========================================
@@ -3,16 +3,26 @@
 
 #include "../Common3D.h"
 #include "../GeometryBase.h"
+#include "../SceneLock.h"
 #include "Skybox.h"
 #include "CoordinateSystem3D.h"
 #include "CoordinateSystemRenderer.h"
+#include "SceneBVH.h"
+#include "GeoInstancer.h"
+#include "GeoEntityStore.h"
 #include "../camera/CameraController.h"
 #include "../picking/PickingIndicator.h"
 #include "../picking/GeometryPickingSystem.h"
+#include "../picking/AsyncPickingService.h"
+#include "../picking/SnapEngine.h"
+#include "../picking/RayQueryService.h"
 #include <osg/Group>
 #include <osg/LightSource>
 #include <memory>
 #include <vector>
+#include <functional>
+#include <unordered_map>
+#include <QMetaObject>
 #include "../GeometryBase.h"
 
 class osgViewer::Viewer;
@@ -32,6 +42,20 @@ public:
     void removeGeometry(Geo3D::Ptr geo);
     void removeAllGeometries();
     const std::vector<Geo3D::Ptr>& getAllGeometries() const { return m_geometries; }
+    const SceneBVH& getSceneBVH() const { return m_sceneBVH; }
+    SceneLock& getSceneLock() { return m_sceneLock; }  // 本场景的读写锁，加入场景的对象修改子图时持有写锁
+    const GeoEntityStore& getEntityStore() const { return m_entityStore; }  // 场景对象的状态、样式、控制点和包围盒
+    BoundingBox3D getSceneBounds() const { return m_entityStore.computeTotalBounds(); }
+    
+    // 硬件实例化（相同类型、细分级别和样式的已完成对象合批绘制面）
+    void setInstancingEnabled(bool enabled);
+    bool isInstancingEnabled() const { return m_geoInstancer->isEnabled(); }
+    GeoInstancer* getGeoInstancer() const { return m_geoInstancer.get(); }
+    
+    // 按需渲染：场景内容变化时通过回调请求重绘，isAnimating()为真时视图需要持续刷新
+    void setRedrawCallback(std::function<void()> callback);
+    void requestRedraw() const;
+    bool isAnimating() const;
     
     // 选择管理
     void setSelectedGeometry(Geo3D::Ptr geo);
@@ -41,12 +65,22 @@ public:
     Geo3D::Ptr getSelectedGeometry() const { return m_selectedGeometry; }
     const std::vector<Geo3D::Ptr>& getSelectedGeometries() const { return m_selectedGeometries; }
     bool isSelected(Geo3D::Ptr geo) const;
-    int getSelectionCount() const { return static_cast<int>(m_selectedGeometries.size()); }
+    int getSelectionCount() const { return static_cast<int>(m_entityStore.countState(GeoState_Selected3D)); }
     
     // 拾取系统
     PickResult performPicking(int mouseX, int mouseY);
+    bool requestAsyncPicking(int mouseX, int mouseY);  // 悬停拾取，结果由AsyncPickingService::pickingFinished返回
+    AsyncPickingService* getAsyncPickingService() const { return m_asyncPickingService.get(); }
     PickingIndicator* getPickingIndicator() const { return m_pickingIndicator.get(); }
     
+    // 捕捉（正在绘制和拖动的对象不参与）
+    bool snapPoint(int mouseX, int mouseY, SnapResult& result);
+    SnapEngine& getSnapEngine() { return m_snapEngine; }
+    
+    // 批量射线查询（场景坐标系的线段，多线程求交，results与rays一一对应）
+    void castRays(const std::vector<RayQuery>& rays, std::vector<PickResult>& results);
+    RayQueryService& getRayQueryService() { return m_rayQueryService; }
+    
     // 显示模式
     void setWireframeMode(bool wireframe);
     void setShadedMode(bool shaded);
@@ -97,6 +131,10 @@ private:
     void setupCoordinateSystem();
     void setupRenderingStates();
     
+    // 场景BVH维护与重绘通知
+    void trackGeometry(Geo3D* geo);
+    void untrackGeometry(Geo3D* geo);
+    
 private:
     // 场景图节点
     osg::ref_ptr<osg::Group> m_rootNode;
@@ -106,11 +144,23 @@ private:
     osg::ref_ptr<osg::Group> m_pickingIndicatorNode;
     osg::ref_ptr<osg::Group> m_skyboxNode;
     
-    // 几何体管理
+    // 几何体管理（读写锁最先构造、最后析构，后台拾取线程先于它停止）
+    SceneLock m_sceneLock;
     std::vector<Geo3D::Ptr> m_geometries;
+    GeoEntityStore m_entityStore;  // 场景对象绑定到这里，Geo3D作为外观
     Geo3D::Ptr m_selectedGeometry;
     std::vector<Geo3D::Ptr> m_selectedGeometries;
     
+    // 场景BVH（裁剪与拾取粗筛）
+    SceneBVH m_sceneBVH;
+    std::unordered_map<Geo3D*, std::vector<QMetaObject::Connection>> m_geometryConnections;
+    
+    // 按需渲染
+    std::function<void()> m_redrawCallback;
+    
+    // 硬件实例化
+    std::unique_ptr<GeoInstancer> m_geoInstancer;
+    
     // 绘制状态
     bool m_isDrawing;
     Geo3D::Ptr m_currentDrawingGeometry;
@@ -123,6 +173,9 @@ private:
     // 拾取系统
     osg::ref_ptr<PickingIndicator> m_pickingIndicator;
     osg::ref_ptr<GeometryPickingSystem> m_geometryPickingSystem;
+    std::unique_ptr<AsyncPickingService> m_asyncPickingService;
+    SnapEngine m_snapEngine;
+    RayQueryService m_rayQueryService;
     
     // 天空盒
     std::unique_ptr<Skybox> m_skybox;
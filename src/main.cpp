@@ -11,9 +11,17 @@
 #include "ui/MainWindow.h"
 #include "core/Common3D.h"
 #include "util/LogManager.h"
+#include "util/BatchProcessor.h"
 
 int main(int argc, char *argv[])
 {
+    // 批处理模式不创建窗口，可在无图形环境的夜间任务中运行
+    if (BatchProcessor::isBatchCommand(argc, argv)) {
+        QCoreApplication batchApp(argc, argv);
+        batchApp.setApplicationName("OSG 3D Drawing Board");
+        return BatchProcessor::runCommandLine(batchApp.arguments());
+    }
+
     QApplication app(argc, argv);
     
     // 设置应用程序基本信息
@@ -0,0 +1,341 @@
+﻿#include "LogListModel.h"
+#include <QBrush>
+#include <QColor>
+#include <QFileInfo>
+#include <algorithm>
+
+namespace
+{
+    const int kDefaultCapacity = 10000;
+    const int kLevelCount = 5;
+}
+
+// ============= 构造 =============
+
+LogListModel::LogListModel(QObject* parent)
+    : QAbstractListModel(parent)
+    , m_entries(kDefaultCapacity)
+    , m_entryCategories(kDefaultCapacity, 0)
+    , m_firstSeq(0)
+    , m_nextSeq(0)
+    , m_levelMask(allLevelsMask())
+    , m_showTimestamp(true)
+    , m_showCategory(true)
+{
+}
+
+// ============= QAbstractListModel =============
+
+int LogListModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) return 0;
+    return static_cast<int>(m_visible.size());
+}
+
+QVariant LogListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= rowCount()) {
+        return QVariant();
+    }
+
+    // 只有视图请求的可见行才会走到这里，格式化按需进行
+    const LogEntry& logEntry = entryAt(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return formatEntry(logEntry);
+    case Qt::ForegroundRole:
+        return QBrush(levelColor(logEntry.level));
+    default:
+        return QVariant();
+    }
+}
+
+// ============= 数据 =============
+
+void LogListModel::appendBatch(const std::vector<LogEntry>& batch)
+{
+    if (batch.empty()) return;
+
+    // 一批超过容量时只保留最后capacity条
+    const size_t cap = m_entries.size();
+    const size_t begin = batch.size() > cap ? batch.size() - cap : 0;
+    const quint64 incoming = static_cast<quint64>(batch.size() - begin);
+
+    const quint64 stored = m_nextSeq - m_firstSeq;
+    if (stored + incoming > cap) {
+        evictOldest(stored + incoming - cap);
+    }
+
+    QStringList newCategories;
+    std::vector<quint64> accepted;
+    accepted.reserve(static_cast<size_t>(incoming));
+    for (size_t i = begin; i < batch.size(); ++i) {
+        quint64 seq = storeEntry(batch[i], newCategories);
+        if (accepts(seq)) {
+            accepted.push_back(seq);
+        }
+    }
+
+    if (!accepted.empty()) {
+        int first = rowCount();
+        beginInsertRows(QModelIndex(), first, first + static_cast<int>(accepted.size()) - 1);
+        m_visible.insert(m_visible.end(), accepted.begin(), accepted.end());
+        endInsertRows();
+    }
+
+    if (!newCategories.isEmpty()) {
+        emit categoriesAdded(newCategories);
+    }
+}
+
+void LogListModel::clear()
+{
+    beginResetModel();
+    resetStorage(m_entries.size());
+    m_categoryIds.clear();
+    m_categoryNames.clear();
+    m_categoryIndex.clear();
+    m_categoryMatches.clear();
+    endResetModel();
+}
+
+void LogListModel::setCapacity(int capacity)
+{
+    capacity = std::max(capacity, 1);
+    if (static_cast<size_t>(capacity) == m_entries.size()) return;
+
+    // 按新容量保留最近的日志，分类表不变
+    std::vector<LogEntry> kept = allEntries();
+    size_t begin = kept.size() > static_cast<size_t>(capacity) ? kept.size() - capacity : 0;
+
+    beginResetModel();
+    resetStorage(static_cast<size_t>(capacity));
+    for (std::deque<quint64>& index : m_categoryIndex) {
+        index.clear();
+    }
+    QStringList newCategories;
+    for (size_t i = begin; i < kept.size(); ++i) {
+        storeEntry(kept[i], newCategories);
+    }
+    collectVisible();
+    endResetModel();
+}
+
+std::vector<LogEntry> LogListModel::allEntries() const
+{
+    std::vector<LogEntry> result;
+    result.reserve(static_cast<size_t>(m_nextSeq - m_firstSeq));
+    for (quint64 seq = m_firstSeq; seq < m_nextSeq; ++seq) {
+        result.push_back(entry(seq));
+    }
+    return result;
+}
+
+// ============= 过滤 =============
+
+void LogListModel::setFilter(int levelMask, const QStringList& keywords)
+{
+    m_levelMask = levelMask & allLevelsMask();
+    m_keywords = keywords;
+
+    // 关键词只和分类表比较一次，之后按分类索引取日志
+    for (int id = 0; id < m_categoryNames.size(); ++id) {
+        m_categoryMatches[id] = matchKeywords(m_categoryNames[id]) ? 1 : 0;
+    }
+
+    beginResetModel();
+    collectVisible();
+    endResetModel();
+}
+
+// ============= 显示选项 =============
+
+void LogListModel::setDisplayOptions(bool showTimestamp, bool showCategory)
+{
+    if (showTimestamp == m_showTimestamp && showCategory == m_showCategory) return;
+
+    m_showTimestamp = showTimestamp;
+    m_showCategory = showCategory;
+
+    // 文本是按需格式化的，通知视图重新取可见行即可
+    if (rowCount() > 0) {
+        emit dataChanged(index(0), index(rowCount() - 1), { Qt::DisplayRole });
+    }
+}
+
+QString LogListModel::formatEntry(const LogEntry& logEntry) const
+{
+    QString text;
+
+    // 时间戳
+    if (m_showTimestamp) {
+        text += logEntry.timestamp.toString("hh:mm:ss.zzz") + " ";
+    }
+
+    // 级别
+    text += "[" + levelText(logEntry.level) + "] ";
+
+    // 分类
+    if (m_showCategory && !logEntry.category.isEmpty()) {
+        text += "[" + logEntry.category + "] ";
+    }
+
+    // 位置信息
+    if (!logEntry.fileName.isEmpty() && logEntry.lineNumber > 0) {
+        QString fileName = QFileInfo(logEntry.fileName).fileName();
+        text += QString("(%1:%2) ").arg(fileName).arg(logEntry.lineNumber);
+    }
+
+    // 函数名
+    if (!logEntry.functionName.isEmpty()) {
+        text += logEntry.functionName + " ";
+    }
+
+    // 消息
+    text += logEntry.message;
+
+    return text;
+}
+
+// ============= 内部实现 =============
+
+quint64 LogListModel::storeEntry(const LogEntry& logEntry, QStringList& newCategories)
+{
+    quint64 seq = m_nextSeq++;
+    size_t slot = static_cast<size_t>(seq % m_entries.size());
+    int id = categoryId(logEntry.category, newCategories);
+
+    m_entries[slot] = logEntry;
+    m_entryCategories[slot] = id;
+    m_levelIndex[static_cast<int>(logEntry.level)].push_back(seq);
+    m_categoryIndex[id].push_back(seq);
+    return seq;
+}
+
+int LogListModel::categoryId(const QString& category, QStringList& newCategories)
+{
+    QHash<QString, int>::const_iterator it = m_categoryIds.constFind(category);
+    if (it != m_categoryIds.constEnd()) {
+        return it.value();
+    }
+
+    int id = m_categoryNames.size();
+    m_categoryIds.insert(category, id);
+    m_categoryNames.append(category);
+    m_categoryIndex.emplace_back();
+    m_categoryMatches.push_back(matchKeywords(category) ? 1 : 0);
+    if (!category.isEmpty()) {
+        newCategories.append(category);
+    }
+    return id;
+}
+
+bool LogListModel::matchKeywords(const QString& category) const
+{
+    for (const QString& keyword : m_keywords) {
+        if (category.contains(keyword, Qt::CaseInsensitive)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LogListModel::accepts(quint64 seq) const
+{
+    if (!(m_levelMask & levelBit(entry(seq).level))) return false;
+    return m_keywords.isEmpty() || m_categoryMatches[entryCategory(seq)];
+}
+
+void LogListModel::evictOldest(quint64 count)
+{
+    const quint64 newFirst = m_firstSeq + count;
+
+    // 被淘汰的序号一定位于各索引的最前面
+    for (quint64 seq = m_firstSeq; seq < newFirst; ++seq) {
+        m_levelIndex[static_cast<int>(entry(seq).level)].pop_front();
+        m_categoryIndex[entryCategory(seq)].pop_front();
+    }
+
+    int removed = 0;
+    while (removed < rowCount() && m_visible[removed] < newFirst) {
+        ++removed;
+    }
+    if (removed > 0) {
+        beginRemoveRows(QModelIndex(), 0, removed - 1);
+        m_visible.erase(m_visible.begin(), m_visible.begin() + removed);
+        m_firstSeq = newFirst;
+        endRemoveRows();
+    } else {
+        m_firstSeq = newFirst;
+    }
+}
+
+void LogListModel::collectVisible()
+{
+    m_visible.clear();
+
+    if (m_keywords.isEmpty() && m_levelMask == allLevelsMask()) {
+        for (quint64 seq = m_firstSeq; seq < m_nextSeq; ++seq) {
+            m_visible.push_back(seq);
+        }
+        return;
+    }
+
+    // 从匹配的分类（或选中的级别）索引收集序号，再排回时间顺序
+    std::vector<quint64> seqs;
+    if (m_keywords.isEmpty()) {
+        for (int level = 0; level < kLevelCount; ++level) {
+            if (m_levelMask & (1 << level)) {
+                seqs.insert(seqs.end(), m_levelIndex[level].begin(), m_levelIndex[level].end());
+            }
+        }
+    } else {
+        for (int id = 0; id < m_categoryNames.size(); ++id) {
+            if (!m_categoryMatches[id]) continue;
+            for (quint64 seq : m_categoryIndex[id]) {
+                if (m_levelMask & levelBit(entry(seq).level)) {
+                    seqs.push_back(seq);
+                }
+            }
+        }
+    }
+
+    std::sort(seqs.begin(), seqs.end());
+    m_visible.assign(seqs.begin(), seqs.end());
+}
+
+void LogListModel::resetStorage(size_t capacity)
+{
+    m_entries.assign(capacity, LogEntry());
+    m_entryCategories.assign(capacity, 0);
+    m_firstSeq = 0;
+    m_nextSeq = 0;
+    for (std::deque<quint64>& index : m_levelIndex) {
+        index.clear();
+    }
+    m_visible.clear();
+}
+
+QString LogListModel::levelText(LogLevel level)
+{
+    switch (level) {
+    case LogLevel::Debug:   return "DEBUG";
+    case LogLevel::Info:    return "INFO";
+    case LogLevel::Warning: return "WARN";
+    case LogLevel::Error:   return "ERROR";
+    case LogLevel::Success: return "SUCCESS";
+    }
+    return "UNKNOWN";
+}
+
+QColor LogListModel::levelColor(LogLevel level)
+{
+    switch (level) {
+    case LogLevel::Debug:   return QColor(128, 128, 128);
+    case LogLevel::Info:    return QColor(0, 0, 0);
+    case LogLevel::Warning: return QColor(255, 165, 0);
+    case LogLevel::Error:   return QColor(255, 0, 0);
+    case LogLevel::Success: return QColor(0, 128, 0);
+    }
+    return QColor(0, 0, 0);
+}
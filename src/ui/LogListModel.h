@@ -0,0 +1,81 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <QAbstractListModel>
+#include <QColor>
+#include <QHash>
+#include <QStringList>
+#include <deque>
+#include <vector>
+#include "../util/LogManager.h"
+
+// 日志列表模型 - 环形缓冲保存最近的日志，配合QListView只格式化可见行
+// 过滤结果按序号维护，新日志和淘汰日志增量更新；过滤条件变化时从级别/分类索引合并，不逐条重扫
+class LogListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit LogListModel(QObject* parent = nullptr);
+
+    // QAbstractListModel
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    // 数据
+    void appendBatch(const std::vector<LogEntry>& batch);  // 追加一批日志，超出容量时淘汰最旧的
+    void clear();
+    void setCapacity(int capacity);
+    int capacity() const { return static_cast<int>(m_entries.size()); }
+    int totalCount() const { return static_cast<int>(m_nextSeq - m_firstSeq); }
+    const LogEntry& entryAt(int row) const { return entry(m_visible[row]); }
+    std::vector<LogEntry> allEntries() const;
+    QStringList categories() const { return m_categoryNames; }
+
+    // 过滤：levelMask按LogLevel取位，keywords为空时不按分类过滤（任一关键词包含于分类即匹配）
+    void setFilter(int levelMask, const QStringList& keywords);
+    static int levelBit(LogLevel level) { return 1 << static_cast<int>(level); }
+    static int allLevelsMask() { return 0x1F; }
+
+    // 显示选项
+    void setDisplayOptions(bool showTimestamp, bool showCategory);
+    QString formatEntry(const LogEntry& logEntry) const;
+
+signals:
+    void categoriesAdded(const QStringList& categories);
+
+private:
+    const LogEntry& entry(quint64 seq) const { return m_entries[seq % m_entries.size()]; }
+    int entryCategory(quint64 seq) const { return m_entryCategories[seq % m_entries.size()]; }
+    quint64 storeEntry(const LogEntry& logEntry, QStringList& newCategories);
+    int categoryId(const QString& category, QStringList& newCategories);
+    bool matchKeywords(const QString& category) const;
+    bool accepts(quint64 seq) const;
+    void evictOldest(quint64 count);
+    void collectVisible();
+    void resetStorage(size_t capacity);
+    static QString levelText(LogLevel level);
+    static QColor levelColor(LogLevel level);
+
+    // 环形缓冲（序号单调递增，下标为序号对容量取模）
+    std::vector<LogEntry> m_entries;
+    std::vector<int> m_entryCategories;
+    quint64 m_firstSeq;
+    quint64 m_nextSeq;
+
+    // 增量索引（各自按序号递增）
+    std::deque<quint64> m_levelIndex[5];
+    std::vector<std::deque<quint64>> m_categoryIndex;
+    QHash<QString, int> m_categoryIds;
+    QStringList m_categoryNames;
+
+    // 过滤条件与结果
+    int m_levelMask;
+    QStringList m_keywords;
+    std::vector<char> m_categoryMatches;
+    std::deque<quint64> m_visible;
+
+    // 显示选项
+    bool m_showTimestamp;
+    bool m_showCategory;
+};
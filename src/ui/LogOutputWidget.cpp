@@ -5,28 +5,27 @@
 #include <QClipboard>
 #include <QFileDialog>
 #include <QMessageBox>
-#include <QDebug>
 #include <QRegularExpression>
 #include <QMenu>
 #include <QAction>
-#include <QFileInfo>
+#include <QFile>
 #include <QTimer>
-#include <QThread>
-// 使用Qt信号槽机制确保线程安全
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QPushButton>
+#include <algorithm>
 
 // ==================== LogOutputWidget 实现 ====================
 
 LogOutputWidget::LogOutputWidget(QWidget* parent)
     : QWidget(parent)
-    , m_maxDisplayLines(1000)
+    , m_listView(nullptr)
+    , m_model(nullptr)
+    , m_flushTimer(nullptr)
     , m_autoScroll(true)
     , m_showTimestamp(true)
     , m_showCategory(true)
-    , m_needsFullRefresh(false)
     , m_isFiltering(false)
 {
     // 初始化过滤级别为全部
@@ -36,13 +35,21 @@ LogOutputWidget::LogOutputWidget(QWidget* parent)
     m_selectedFilterLevels.insert(LogLevel::Error);
     m_selectedFilterLevels.insert(LogLevel::Success);
     
+    m_model = new LogListModel(this);
+    connect(m_model, &LogListModel::categoriesAdded, this, &LogOutputWidget::onCategoriesAdded);
+
+    // 日志按帧批量刷新，避免大量日志逐条插入阻塞UI
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FLUSH_INTERVAL_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &LogOutputWidget::flushPendingLogs);
+
     setupUI();
-    setupTextFormats();
     
     // 连接日志管理器信号
     LogManager* logManager = LogManager::getInstance();
     connect(logManager, &LogManager::logAdded, this, &LogOutputWidget::addLogEntry);
-    connect(logManager, &LogManager::logsCleared, this, &LogOutputWidget::clearLogs);
+    connect(logManager, &LogManager::logsCleared, this, &LogOutputWidget::onLogsCleared);
 }
 
 LogOutputWidget::~LogOutputWidget()
@@ -59,16 +66,19 @@ void LogOutputWidget::setupUI()
     setupToolbar();
     mainLayout->addWidget(m_toolBar);
     
-    // 创建文本编辑器 - 使用QPlainTextEdit提升性能
-    m_textEdit = new QPlainTextEdit(this);
-    m_textEdit->setReadOnly(true);
-    m_textEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
-    m_textEdit->setFont(QFont("Consolas", 9));
-    m_textEdit->setContextMenuPolicy(Qt::CustomContextMenu);
-    connect(m_textEdit, &QPlainTextEdit::customContextMenuRequested,
+    // 创建日志列表 - 行高一致，视图只向模型请求可见行
+    m_listView = new QListView(this);
+    m_listView->setModel(m_model);
+    m_listView->setUniformItemSizes(true);
+    m_listView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_listView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_listView->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    m_listView->setFont(QFont("Consolas", 9));
+    m_listView->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(m_listView, &QListView::customContextMenuRequested,
             this, &LogOutputWidget::showContextMenu);
     
-    mainLayout->addWidget(m_textEdit);
+    mainLayout->addWidget(m_listView);
     
     setLayout(mainLayout);
 }
@@ -156,28 +166,15 @@ void LogOutputWidget::setupToolbar()
     m_filterLevelCombo->setCurrentIndex(0);
 }
 
-void LogOutputWidget::setupTextFormats()
-{
-    // 设置各种日志级别的颜色
-    m_debugFormat.setForeground(QColor(128, 128, 128));    // 灰色
-    m_infoFormat.setForeground(QColor(0, 0, 0));           // 黑色
-    m_warningFormat.setForeground(QColor(255, 165, 0));    // 橙色
-    m_errorFormat.setForeground(QColor(255, 0, 0));        // 红色
-    m_successFormat.setForeground(QColor(0, 128, 0));      // 绿色
-    
-    // 时间戳和分类格式
-    m_timestampFormat.setForeground(QColor(100, 100, 100));
-    m_categoryFormat.setForeground(QColor(0, 0, 255));
-}
-
 void LogOutputWidget::setMaxDisplayLines(int lines)
 {
-    m_maxDisplayLines = lines;
+    flushPendingLogs();
+    m_model->setCapacity(lines);
 }
 
 int LogOutputWidget::getMaxDisplayLines() const
 {
-    return m_maxDisplayLines;
+    return m_model->capacity();
 }
 
 void LogOutputWidget::setAutoScroll(bool enabled)
@@ -215,345 +212,109 @@ bool LogOutputWidget::isShowCategoryEnabled() const
 
 void LogOutputWidget::addLogEntry(const LogEntry& entry)
 {
-    qDebug() << "LogOutputWidget::addLogEntry - 接收到日志:" << entry.message;
-    
-    // 添加日志到本地存储
-    m_allLogs.append(entry);
-    
-    // 更新分类集合
-    if (!entry.category.isEmpty())
+    m_pendingLogs.push_back(entry);
+    if (!m_flushTimer->isActive())
     {
-        m_categories.insert(entry.category);
-    }
-    
-    // 检查是否应该显示
-    if (shouldDisplayLog(entry))
-    {
-        m_filteredLogs.append(entry);
-        // 直接插入UI
-        addLogToTextEdit(entry);
-        limitDisplayLines();
-    }
-    
-    // 更新过滤选项（异步，避免阻塞UI）
-    QTimer::singleShot(0, this, &LogOutputWidget::updateFilterOptions);
-}
-
-bool LogOutputWidget::shouldDisplayLog(const LogEntry& entry) const
-{
-    // 级别过滤
-    if (!m_selectedFilterLevels.isEmpty() && !m_selectedFilterLevels.contains(entry.level))
-    {
-        return false;
-    }
-    
-    // 分类过滤
-    if (!m_currentFilterCategory.isEmpty())
-    {
-        QStringList keywords = m_currentFilterCategory.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-        if (keywords.isEmpty())
-        {
-            return true; // 如果没有有效关键词，显示所有
-        }
-        
-        bool matchesAnyKeyword = false;
-        
-        for (const QString& keyword : keywords)
-        {
-            if (!keyword.isEmpty() && entry.category.contains(keyword, Qt::CaseInsensitive))
-            {
-                matchesAnyKeyword = true;
-                break;
-            }
-        }
-        
-        if (!matchesAnyKeyword)
-        {
-            return false;
-        }
-    }
-    
-    return true;
-}
-
-void LogOutputWidget::applyFilters()
-{
-    // 清空之前的过滤结果
-    m_filteredLogs.clear();
-    
-    // 如果日志数量很大，使用分批处理避免卡死
-    const int BATCH_SIZE = 1000;
-    int totalLogs = m_allLogs.size();
-    
-    if (totalLogs > BATCH_SIZE)
-    {
-        // 分批处理大量日志
-        for (int i = 0; i < totalLogs; i += BATCH_SIZE)
-        {
-            int endIndex = qMin(i + BATCH_SIZE, totalLogs);
-            
-            for (int j = i; j < endIndex; ++j)
-            {
-                const LogEntry& entry = m_allLogs[j];
-                if (shouldDisplayLog(entry))
-                {
-                    m_filteredLogs.append(entry);
-                }
-            }
-            
-            // 让出CPU时间，避免卡死UI
-            if (i + BATCH_SIZE < totalLogs)
-            {
-                QThread::msleep(1);
-                QApplication::processEvents();
-            }
-        }
-    }
-    else
-    {
-        // 小量日志直接处理
-        for (const LogEntry& entry : m_allLogs)
-        {
-            if (shouldDisplayLog(entry))
-            {
-                m_filteredLogs.append(entry);
-            }
-        }
+        m_flushTimer->start();
     }
 }
 
-void LogOutputWidget::addLogsToTextEdit(const QList<LogEntry>& logs)
+void LogOutputWidget::flushPendingLogs()
 {
-    if (!m_textEdit || logs.isEmpty()) return;
-    
-    qDebug() << "LogOutputWidget::addLogsToTextEdit - 开始添加日志到UI，数量:" << logs.size();
-    
-    // 准备批量文本插入 - 优化版本
-    QStringList textLines;
-    textLines.reserve(logs.size()); // 预分配内存
-    
-    for (const LogEntry& entry : logs)
-    {
-        QString logText = formatLogText(entry);
-        textLines.append(logText);
-    }
-    
-    // 使用QTextDocument的批量操作提高性能
-    QTextDocument* document = m_textEdit->document();
-    QTextCursor cursor = m_textEdit->textCursor();
-    cursor.movePosition(QTextCursor::End);
-    
-    // 批量插入文本 - 使用单个insertText操作
-    QString allText = textLines.join("\n") + "\n";
-    cursor.insertText(allText);
-    
-    // 自动滚动 - 只在需要时执行
-    if (m_autoScroll)
-    {
-        QScrollBar* scrollBar = m_textEdit->verticalScrollBar();
-        if (scrollBar && scrollBar->maximum() > scrollBar->value())
-        {
-            scrollBar->setValue(scrollBar->maximum());
-        }
-    }
-    
-    qDebug() << "LogOutputWidget::addLogsToTextEdit - 完成添加日志到UI";
-}
+    m_flushTimer->stop();
+    if (m_pendingLogs.empty()) return;
 
-void LogOutputWidget::addLogToTextEdit(const LogEntry& entry)
-{
-    if (!m_textEdit) return;
-    
-    QString logText = formatLogText(entry);
-    
-    // 设置颜色格式
-    QTextCharFormat format;
-    switch (entry.level)
-    {
-        case LogLevel::Debug:   format = m_debugFormat; break;
-        case LogLevel::Info:    format = m_infoFormat; break;
-        case LogLevel::Warning: format = m_warningFormat; break;
-        case LogLevel::Error:   format = m_errorFormat; break;
-        case LogLevel::Success: format = m_successFormat; break;
-    }
-    
-    // 插入文本
-    QTextCursor cursor = m_textEdit->textCursor();
-    cursor.movePosition(QTextCursor::End);
-    cursor.insertText(logText + "\n", format);
+    std::vector<LogEntry> batch;
+    batch.swap(m_pendingLogs);
+    m_model->appendBatch(batch);
     
     // 自动滚动
     if (m_autoScroll)
     {
-        m_textEdit->verticalScrollBar()->setValue(m_textEdit->verticalScrollBar()->maximum());
+        m_listView->scrollToBottom();
     }
 }
 
-QString LogOutputWidget::formatLogText(const LogEntry& entry)
+void LogOutputWidget::onCategoriesAdded(const QStringList& categories)
 {
-    QString text;
-    
-    // 时间戳
-    if (m_showTimestamp)
-    {
-        text += entry.timestamp.toString("hh:mm:ss.zzz") + " ";
-    }
-    
-    // 级别
-    text += "[" + getLogLevelText(entry.level) + "] ";
-    
-    // 分类
-    if (m_showCategory && !entry.category.isEmpty())
-    {
-        text += "[" + entry.category + "] ";
-    }
+    // 只追加新分类，不重建下拉框，避免打断正在编辑的过滤文本
+    QString currentText = m_filterCategoryCombo->currentText();
+    bool wasFiltering = m_isFiltering;
+    m_isFiltering = true;
     
-    // 位置信息
-    if (!entry.fileName.isEmpty() && entry.lineNumber > 0)
+    for (const QString& category : categories)
     {
-        QString fileName = QFileInfo(entry.fileName).fileName();
-        text += QString("(%1:%2) ").arg(fileName).arg(entry.lineNumber);
+        m_filterCategoryCombo->addItem(category, category);
     }
     
-    // 函数名
-    if (!entry.functionName.isEmpty())
+    if (m_filterCategoryCombo->currentText() != currentText)
     {
-        text += entry.functionName + " ";
+        m_filterCategoryCombo->setCurrentText(currentText);
     }
-    
-    // 消息
-    text += entry.message;
-    
-    return text;
+    m_isFiltering = wasFiltering;
 }
 
-QColor LogOutputWidget::getLogLevelColor(LogLevel level)
+void LogOutputWidget::applyFilters()
 {
-    switch (level)
+    int levelMask = 0;
+    for (LogLevel level : m_selectedFilterLevels)
     {
-        case LogLevel::Debug:   return QColor(128, 128, 128);
-        case LogLevel::Info:    return QColor(0, 0, 0);
-        case LogLevel::Warning: return QColor(255, 165, 0);
-        case LogLevel::Error:   return QColor(255, 0, 0);
-        case LogLevel::Success: return QColor(0, 128, 0);
-        default:                return QColor(0, 0, 0);
+        levelMask |= LogListModel::levelBit(level);
     }
-}
-
-QString LogOutputWidget::getLogLevelText(LogLevel level)
-{
-    switch (level)
+    if (m_selectedFilterLevels.isEmpty())
     {
-        case LogLevel::Debug:   return "DEBUG";
-        case LogLevel::Info:    return "INFO";
-        case LogLevel::Warning: return "WARN";
-        case LogLevel::Error:   return "ERROR";
-        case LogLevel::Success: return "SUCCESS";
-        default:                return "UNKNOWN";
+        levelMask = LogListModel::allLevelsMask();
     }
-}
-
-void LogOutputWidget::updateFilterOptions()
-{
-    // 更新分类下拉框选项
-    QString currentText = m_filterCategoryCombo->currentText();
-    m_filterCategoryCombo->clear();
-    m_filterCategoryCombo->addItem("全部", "");
     
-    // 添加所有可用的分类
-    for (const QString& category : m_categories)
-    {
-        if (!category.isEmpty())
-        {
-            m_filterCategoryCombo->addItem(category, category);
-        }
-    }
+    // 多关键词用空格分隔，分类包含任一关键词即匹配
+    QStringList keywords = m_currentFilterCategory.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
     
-    // 恢复当前选中的文本
-    int index = m_filterCategoryCombo->findText(currentText);
-    if (index >= 0)
-    {
-        m_filterCategoryCombo->setCurrentIndex(index);
-    }
-    else
-    {
-        m_filterCategoryCombo->setCurrentText(currentText);
-    }
+    flushPendingLogs();
+    m_model->setFilter(levelMask, keywords);
 }
 
 void LogOutputWidget::refreshDisplay()
 {
-    m_needsFullRefresh = true;
-    m_textEdit->clear();
-    
-    // 应用过滤器并显示过滤后的日志
     applyFilters();
     
-    // 批量添加到UI
-    if (!m_filteredLogs.isEmpty())
-    {
-        addLogsToTextEdit(m_filteredLogs);
-    }
-}
-
-void LogOutputWidget::limitDisplayLines()
-{
-    QTextDocument* doc = m_textEdit->document();
-    if (doc->lineCount() > m_maxDisplayLines)
+    if (m_autoScroll)
     {
-        QTextCursor cursor = m_textEdit->textCursor();
-        cursor.movePosition(QTextCursor::Start);
-        cursor.movePosition(QTextCursor::Down, QTextCursor::KeepAnchor, 
-                          doc->lineCount() - m_maxDisplayLines);
-        cursor.removeSelectedText();
+        m_listView->scrollToBottom();
     }
 }
 
 void LogOutputWidget::clearLogs()
 {
-    m_textEdit->clear();
-    
-    // 清空所有日志数据
-    m_allLogs.clear();
-    m_filteredLogs.clear();
-    m_categories.clear();
-    
-    // 通知LogManager清空全局日志
+    // 通知LogManager清空全局日志，本地显示在logsCleared信号中清空
     LogManager* logManager = LogManager::getInstance();
     if (logManager)
     {
         logManager->clearLogs();
     }
     
+    onLogsCleared();
+}
+
+void LogOutputWidget::onLogsCleared()
+{
+    m_flushTimer->stop();
+    m_pendingLogs.clear();
+    m_model->clear();
+    
     // 重置过滤选项
+    bool wasFiltering = m_isFiltering;
+    m_isFiltering = true;
+    QString currentText = m_filterCategoryCombo->currentText();
     m_filterCategoryCombo->clear();
     m_filterCategoryCombo->addItem("全部", "");
+    m_filterCategoryCombo->setCurrentText(currentText);
+    m_isFiltering = wasFiltering;
 }
 
 void LogOutputWidget::exportLogs(const QString& filename)
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        QMessageBox::warning(this, "导出失败", "无法创建文件: " + filename);
-        return;
-    }
-    
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
-    
-    // 导出过滤后的日志或所有日志
-    QList<LogEntry> logsToExport = m_filteredLogs.isEmpty() ? m_allLogs : m_filteredLogs;
-    
-    for (const LogEntry& entry : logsToExport)
-    {
-        stream << formatLogText(entry) << "\n";
-    }
-    
-    file.close();
-    
-    QString message = QString("日志已导出到: %1\n共导出 %2 条日志").arg(filename).arg(logsToExport.size());
-    QMessageBox::information(this, "导出成功", message);
+    // 有筛选结果时导出筛选结果，否则导出全部
+    exportLogsWithOptions(filename, m_model->rowCount() > 0);
 }
 
 void LogOutputWidget::exportLogs()
@@ -569,22 +330,25 @@ void LogOutputWidget::exportLogs()
 
 void LogOutputWidget::copySelectedText()
 {
-    if (m_textEdit)
+    QModelIndexList selected = m_listView->selectionModel()->selectedRows();
+    if (selected.isEmpty()) return;
+    
+    // 按显示顺序复制
+    std::sort(selected.begin(), selected.end(),
+              [](const QModelIndex& a, const QModelIndex& b) { return a.row() < b.row(); });
+    
+    QStringList lines;
+    lines.reserve(selected.size());
+    for (const QModelIndex& index : selected)
     {
-        QString selectedText = m_textEdit->textCursor().selectedText();
-        if (!selectedText.isEmpty())
-        {
-            QApplication::clipboard()->setText(selectedText);
-        }
+        lines.append(m_model->formatEntry(m_model->entryAt(index.row())));
     }
+    QApplication::clipboard()->setText(lines.join("\n"));
 }
 
 void LogOutputWidget::selectAllText()
 {
-    if (m_textEdit)
-    {
-        m_textEdit->selectAll();
-    }
+    m_listView->selectAll();
 }
 
 // 槽函数实现
@@ -628,12 +392,10 @@ void LogOutputWidget::onFilterLevelChanged()
     
     // 更新过滤器
     m_selectedFilterLevels = selectedLevels;
-    m_currentFilterCategory = m_filterCategoryCombo->currentText();
+    QString categoryText = m_filterCategoryCombo->currentText();
+    m_currentFilterCategory = (categoryText == "全部") ? QString() : categoryText.trimmed();
     
     // 应用过滤器
-    applyFilters();
-    
-    // 刷新显示
     refreshDisplay();
     
     m_isFiltering = false;
@@ -659,9 +421,6 @@ void LogOutputWidget::onFilterCategoryChanged(const QString& category)
     m_currentFilterCategory = filterCategory;
     
     // 应用过滤器
-    applyFilters();
-    
-    // 刷新显示
     refreshDisplay();
     
     m_isFiltering = false;
@@ -675,16 +434,39 @@ void LogOutputWidget::onAutoScrollToggled(bool checked)
 void LogOutputWidget::onShowTimestampToggled(bool checked)
 {
     m_showTimestamp = checked;
-    refreshDisplay();
+    m_model->setDisplayOptions(m_showTimestamp, m_showCategory);
 }
 
 void LogOutputWidget::onShowCategoryToggled(bool checked)
 {
     m_showCategory = checked;
-    refreshDisplay();
+    m_model->setDisplayOptions(m_showTimestamp, m_showCategory);
 }
 
 void LogOutputWidget::exportLogsWithOptions(const QString& filename, bool exportFiltered)
+{
+    flushPendingLogs();
+    
+    // 根据选项导出日志
+    std::vector<LogEntry> logsToExport;
+    if (exportFiltered && m_model->rowCount() > 0)
+    {
+        logsToExport.reserve(m_model->rowCount());
+        for (int row = 0; row < m_model->rowCount(); ++row)
+        {
+            logsToExport.push_back(m_model->entryAt(row));
+        }
+    }
+    else
+    {
+        exportFiltered = false;
+        logsToExport = m_model->allEntries();
+    }
+    
+    writeLogs(filename, logsToExport, exportFiltered ? "筛选结果" : "所有日志");
+}
+
+void LogOutputWidget::writeLogs(const QString& filename, const std::vector<LogEntry>& logs, const QString& rangeText)
 {
     QFile file(filename);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
@@ -696,33 +478,18 @@ void LogOutputWidget::exportLogsWithOptions(const QString& filename, bool export
     QTextStream stream(&file);
     stream.setCodec("UTF-8");
     
-    // 根据选项导出日志
-    QList<LogEntry> logsToExport;
-    
-    if (exportFiltered && !m_filteredLogs.isEmpty())
-    {
-        logsToExport = m_filteredLogs;
-    }
-    else
-    {
-        logsToExport = m_allLogs;
-    }
-    
-    for (const LogEntry& entry : logsToExport)
+    for (const LogEntry& entry : logs)
     {
-        stream << formatLogText(entry) << "\n";
+        stream << m_model->formatEntry(entry) << "\n";
     }
     
     file.close();
     
-    QString rangeText = exportFiltered ? "筛选结果" : "所有日志";
     QString message = QString("日志已导出到: %1\n导出范围: %2\n共导出 %3 条日志")
-                     .arg(filename).arg(rangeText).arg(logsToExport.size());
+                     .arg(filename).arg(rangeText).arg(logs.size());
     QMessageBox::information(this, "导出成功", message);
 }
 
-
-
 void LogOutputWidget::showContextMenu(const QPoint& pos)
 {
     QMenu menu(this);
@@ -738,6 +505,6 @@ void LogOutputWidget::showContextMenu(const QPoint& pos)
     connect(clearAction, SIGNAL(triggered()), this, SLOT(clearLogs()));
     connect(exportAction, SIGNAL(triggered()), this, SLOT(exportLogs()));
     
-    menu.exec(mapToGlobal(pos));
+    menu.exec(m_listView->viewport()->mapToGlobal(pos));
 } 
 
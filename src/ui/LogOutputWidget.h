@@ -2,7 +2,7 @@
 #pragma execution_character_set("utf-8")
 
 #include <QWidget>
-#include <QPlainTextEdit>
+#include <QListView>
 #include <QToolBar>
 #include <QAction>
 #include <QComboBox>
@@ -12,22 +12,17 @@
 #include <QHBoxLayout>
 #include <QPushButton>
 #include <QMenu>
-#include <QScrollBar>
-#include <QTextCursor>
-#include <QTextCharFormat>
 #include <QColor>
 #include <QFont>
-#include <QDateTime>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QApplication>
 #include <QClipboard>
 #include <QSet>
-#include <QThread>
-#include <QQueue>
 #include <QTimer>
-#include <list>
+#include <vector>
 #include "../util/LogManager.h"
+#include "LogListModel.h"
 
 // 为LogLevel提供qHash函数
 inline uint qHash(LogLevel level, uint seed = 0)
@@ -35,7 +30,7 @@ inline uint qHash(LogLevel level, uint seed = 0)
     return qHash(static_cast<int>(level), seed);
 }
 
-// 日志输出栏组件
+// 日志输出栏组件 - 日志先进入待显示队列，每帧一次批量交给LogListModel，列表只绘制可见行
 class LogOutputWidget : public QWidget
 {
     Q_OBJECT
@@ -44,7 +39,7 @@ public:
     explicit LogOutputWidget(QWidget* parent = nullptr);
     ~LogOutputWidget();
 
-    // 设置最大显示行数
+    // 设置最大显示行数（环形缓冲容量）
     void setMaxDisplayLines(int lines);
     int getMaxDisplayLines() const;
 
@@ -60,32 +55,41 @@ public:
     void setShowCategory(bool enabled);
     bool isShowCategoryEnabled() const;
 
-    // 清空日志
-    void clearLogs();
-
     // 导出日志
     void exportLogs(const QString& filename);
     void exportLogsWithOptions(const QString& filename, bool exportFiltered);
 
-    // 复制选中内容
-    void copySelectedText();
-
-    // 全选文本
-    void selectAllText();
-
 public slots:
-    // 添加日志条目
+    // 添加日志条目（进入待显示队列，下一帧批量显示）
     void addLogEntry(const LogEntry& entry);
     
     // 刷新显示
     void refreshDisplay();
 
+    // 清空日志（同时清空LogManager中的日志）
+    void clearLogs();
+
+    // 复制选中内容
+    void copySelectedText();
+
+    // 全选文本
+    void selectAllText();
+
 private slots:
+    // 将待显示队列批量交给模型
+    void flushPendingLogs();
+
+    // LogManager清空后同步清空本地显示
+    void onLogsCleared();
+
     // 过滤级别改变
     void onFilterLevelChanged();
     
     // 过滤分类改变
     void onFilterCategoryChanged(const QString& category);
+
+    // 模型出现新分类
+    void onCategoriesAdded(const QStringList& categories);
     
     // 自动滚动切换
     void onAutoScrollToggled(bool checked);
@@ -101,8 +105,6 @@ private slots:
     
     // 导出日志（无参数版本）
     void exportLogs();
-    
-    // 已移除定时刷新相关声明
 
 private:
     // 初始化UI
@@ -110,40 +112,17 @@ private:
     
     // 初始化工具栏
     void setupToolbar();
-    
-    // 设置文本格式
-    void setupTextFormats();
-    
-    // 添加日志到文本编辑器
-    void addLogToTextEdit(const LogEntry& entry);
-    
-    // 批量添加日志到文本编辑器
-    void addLogsToTextEdit(const QList<LogEntry>& logs);
-    
-    // 格式化日志文本
-    QString formatLogText(const LogEntry& entry);
-    
-    // 获取日志级别颜色
-    QColor getLogLevelColor(LogLevel level);
-    
-    // 获取日志级别文本
-    QString getLogLevelText(LogLevel level);
-    
-    // 更新过滤选项
-    void updateFilterOptions();
-    
-    // 限制显示行数
-    void limitDisplayLines();
-    
-    // 应用过滤条件
+
+    // 将当前过滤条件应用到模型
     void applyFilters();
-    
-    // 检查是否应该显示日志
-    bool shouldDisplayLog(const LogEntry& entry) const;
+
+    // 导出指定日志
+    void writeLogs(const QString& filename, const std::vector<LogEntry>& logs, const QString& rangeText);
 
 private:
     // UI组件
-    QPlainTextEdit* m_textEdit;      // 使用QPlainTextEdit提升性能
+    QListView* m_listView;           // 虚拟化列表，只格式化和绘制可见行
+    LogListModel* m_model;
     
     QToolBar* m_toolBar;
     QComboBox* m_filterLevelCombo;   // 级别过滤下拉框
@@ -155,40 +134,21 @@ private:
     QPushButton* m_exportButton;
     QPushButton* m_copyButton;
     
-    // 日志数据
-    QList<LogEntry> m_allLogs;
-    QList<LogEntry> m_filteredLogs;
-    QSet<QString> m_categories;
+    // 待显示日志（按帧批量刷新）
+    std::vector<LogEntry> m_pendingLogs;
+    QTimer* m_flushTimer;
     
     // 过滤条件
     QSet<LogLevel> m_selectedFilterLevels;
     QString m_currentFilterCategory;
     
     // 显示设置
-    int m_maxDisplayLines;
     bool m_autoScroll;
     bool m_showTimestamp;
     bool m_showCategory;
     
-    // 文本格式
-    QTextCharFormat m_debugFormat;
-    QTextCharFormat m_infoFormat;
-    QTextCharFormat m_warningFormat;
-    QTextCharFormat m_errorFormat;
-    QTextCharFormat m_successFormat;
-    QTextCharFormat m_timestampFormat;
-    QTextCharFormat m_categoryFormat;
-    
-    // UI更新控制已移除定时刷新相关成员
-    bool m_needsFullRefresh;
-    
-    // 线程安全 - 使用Qt信号槽机制，无需显式锁
-    
     // 筛选状态控制
     bool m_isFiltering;
-    
-    // 更新频率控制 - 简化参数
-    // static const int UI_UPDATE_INTERVAL = 100; // 已移除定时刷新
-    // static const int MAX_UI_BATCH_SIZE = 50;   // 已移除定时刷新
-}; 
 
+    static const int FLUSH_INTERVAL_MS = 16;  // 约一帧
+};
@@ -1,6 +1,9 @@
 ﻿#include "MainWindow.h"
 #include "../core/GeometryBase.h"
 #include "../core/picking/PickingIndicator.h"
+#include "../core/picking/PickingBenchmark.h"
+#include "../util/LogBenchmark.h"
+#include "../util/Tracer.h"
 #include <QTimer>
 #include <QSplitter>
 #include <QVBoxLayout>
@@ -18,6 +21,7 @@
 #include <QCheckBox>
 #include <QSlider>
 #include <QKeyEvent>
+#include <algorithm>
 #include "PropertyEditor3D.h"
 #include "ToolPanel3D.h"
 #include "PropertyEditor3D.h"
@@ -35,9 +39,6 @@ MainWindow::MainWindow(QWidget* parent)
     setWindowTitle("3D Drawing Board");
     setWindowIcon(QIcon(":/icons/app.png"));
     
-    // 设置全局状态栏
-    GlobalStatusBar3D = statusBar();
-    
     setupUI();
     createMenus();
     createToolBars();
@@ -270,6 +271,28 @@ void MainWindow::createMenus()
     pickingSystemAction->setShortcut(Qt::CTRL + Qt::Key_P);
     connect(pickingSystemAction, &QAction::triggered, this, &MainWindow::onPickingSystemSettings);
     
+    // 拾取性能测试
+    QAction* pickingBenchmarkAction = m_viewMenu->addAction(tr("拾取性能测试(&B)"));
+    connect(pickingBenchmarkAction, &QAction::triggered, this, &MainWindow::onPickingBenchmark);
+    
+    // 日志队列性能测试
+    QAction* logBenchmarkAction = m_viewMenu->addAction(tr("日志性能测试(&L)"));
+    connect(logBenchmarkAction, &QAction::triggered, this, &MainWindow::onLogBenchmark);
+    
+    // 视口性能HUD
+    QAction* performanceHUDAction = m_viewMenu->addAction(tr("性能HUD(&U)"));
+    performanceHUDAction->setCheckable(true);
+    connect(performanceHUDAction, &QAction::toggled, this, [this](bool checked) {
+        if (m_osgWidget) {
+            m_osgWidget->setPerformanceHUDVisible(checked);
+        }
+    });
+    
+    // 性能追踪（停止时导出Chrome/Perfetto轨迹）
+    QAction* tracingAction = m_viewMenu->addAction(tr("性能追踪(&T)"));
+    tracingAction->setCheckable(true);
+    connect(tracingAction, &QAction::toggled, this, &MainWindow::onToggleTracing);
+    
     // 帮助菜单
     m_helpMenu = menuBar()->addMenu(tr("帮助(&H)"));
     
@@ -602,8 +625,7 @@ void MainWindow::updateObjectCount()
 {
     if (m_statusBar3D && m_osgWidget)
     {
-        const auto& allGeos = m_osgWidget->getSceneManager()->getAllGeometries();
-        int count = static_cast<int>(allGeos.size());
+        int count = static_cast<int>(m_osgWidget->getSceneManager()->getEntityStore().size());
         m_statusBar3D->updateObjectCount(count);
     }
 }
@@ -1226,6 +1248,75 @@ void MainWindow::onPickingSystemSettings()
     LOG_INFO("拾取指示器使用简化的固定配置", "拾取系统");
 }
 
+void MainWindow::onPickingBenchmark()
+{
+    int ret = QMessageBox::question(this, tr("拾取性能测试"), 
+        tr("将在离屏场景中创建10000个对象，对比三次独立遍历与单次遍历混合拾取的耗时。\n"
+           "测试可能需要较长时间，是否继续？"),
+        QMessageBox::Yes | QMessageBox::No);
+    if (ret != QMessageBox::Yes) return;
+    
+    updateStatusBar("正在进行拾取性能测试...");
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    PickingBenchmarkResult result = PickingBenchmark::run(10000, 200);
+    QApplication::restoreOverrideCursor();
+    
+    QMessageBox::information(this, tr("拾取性能测试"), result.toString());
+    updateStatusBar(QString("拾取性能测试完成，加速比 %1x").arg(result.speedup(), 0, 'f', 2));
+}
+
+void MainWindow::onLogBenchmark()
+{
+    updateStatusBar("正在进行日志性能测试...");
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    
+    // 4个生产者各写入10万条，分别测试三种溢出策略
+    QStringList reports;
+    double bestThroughput = 0.0;
+    const LogOverflowPolicy policies[] = { LogOverflowPolicy::DropOldest, LogOverflowPolicy::Block, LogOverflowPolicy::DropNewest };
+    for (LogOverflowPolicy policy : policies) {
+        LogBenchmarkResult result = LogBenchmark::run(4, 100000, policy, 8192);
+        reports << result.toString();
+        bestThroughput = std::max(bestThroughput, result.entriesPerSecond());
+        LOG_INFO(QString("日志性能测试: %1").arg(result.toString()), "日志");
+    }
+    
+    QApplication::restoreOverrideCursor();
+    
+    QMessageBox::information(this, tr("日志性能测试"), reports.join("\n\n"));
+    updateStatusBar(QString("日志性能测试完成，最高吞吐 %1 条/秒").arg(bestThroughput, 0, 'f', 0));
+}
+
+void MainWindow::onToggleTracing(bool enabled)
+{
+    Tracer* tracer = Tracer::getInstance();
+    if (enabled) {
+        tracer->start();
+        updateStatusBar("性能追踪已开始，再次点击停止并导出");
+        LOG_INFO("性能追踪已开始", "性能追踪");
+        return;
+    }
+    
+    tracer->stop();
+    QString defaultName = QString("trace_%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+    QString fileName = QFileDialog::getSaveFileName(this, tr("导出性能追踪"), defaultName,
+                                                    tr("Chrome Trace (*.json)"));
+    if (fileName.isEmpty()) {
+        updateStatusBar("性能追踪已停止，未导出");
+        return;
+    }
+    
+    if (tracer->exportChromeJson(fileName)) {
+        QString message = QString("已导出 %1 个事件到 %2（丢弃 %3 个），可在 chrome://tracing 或 ui.perfetto.dev 中打开")
+            .arg(tracer->getEventCount()).arg(fileName).arg(tracer->getDroppedCount());
+        updateStatusBar("性能追踪已导出");
+        LOG_SUCCESS(message, "性能追踪");
+    } else {
+        QMessageBox::warning(this, tr("导出失败"), tr("无法写入文件: %1").arg(fileName));
+        LOG_ERROR(QString("性能追踪导出失败: %1").arg(fileName), "性能追踪");
+    }
+}
+
 void MainWindow::onClearScene()
 {
     if (!m_osgWidget) return;
@@ -1305,6 +1396,14 @@ void MainWindow::onDisplaySettings()
     displayModeLayout->addWidget(shadedCheck);
     displayModeLayout->addWidget(pointModeCheck);
     
+    QCheckBox* instancingCheck = new QCheckBox(tr("硬件实例化（合批绘制相同图元）"), displayModeGroup);
+    instancingCheck->setChecked(m_osgWidget ? m_osgWidget->getSceneManager()->isInstancingEnabled() : false);
+    displayModeLayout->addWidget(instancingCheck);
+    
+    QCheckBox* continuousRenderingCheck = new QCheckBox(tr("连续渲染（每16ms刷新，关闭时按需重绘）"), displayModeGroup);
+    continuousRenderingCheck->setChecked(m_osgWidget ? m_osgWidget->isContinuousRendering() : false);
+    displayModeLayout->addWidget(continuousRenderingCheck);
+    
     // 背景设置
     QGroupBox* backgroundGroup = new QGroupBox(tr("背景设置"), &dialog);
     QVBoxLayout* backgroundLayout = new QVBoxLayout(backgroundGroup);
@@ -1370,6 +1469,18 @@ void MainWindow::onDisplaySettings()
         }
     });
     
+    connect(instancingCheck, &QCheckBox::toggled, [this](bool enabled) {
+        if (m_osgWidget) {
+            m_osgWidget->getSceneManager()->setInstancingEnabled(enabled);
+        }
+    });
+    
+    connect(continuousRenderingCheck, &QCheckBox::toggled, [this](bool enabled) {
+        if (m_osgWidget) {
+            m_osgWidget->setContinuousRendering(enabled);
+        }
+    });
+    
     // 连接天空盒信号
     connect(skyboxCheck, &QCheckBox::toggled, [this](bool enabled) {
         if (m_osgWidget) {
@@ -121,6 +121,13 @@ private slots:
     
     // 拾取系统相关
     void onPickingSystemSettings();
+    void onPickingBenchmark();
+    
+    // 日志系统相关
+    void onLogBenchmark();
+    
+    // 性能追踪
+    void onToggleTracing(bool enabled);
     
     // 实用工具相关
     void onClearScene();
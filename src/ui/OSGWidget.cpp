@@ -3,6 +3,7 @@
 #include "../core/GeometryBase.h"
 #include "../core/world/CoordinateSystem3D.h"
 #include "../util/LogManager.h"
+#include "../util/Tracer.h"
 #include "../util/GeometryFactory.h"
 
 #include <osgViewer/Viewer>
@@ -31,6 +32,7 @@ OSGWidget::OSGWidget(QWidget* parent)
     : osgQOpenGLWidget(parent)
     , m_sceneManager(std::make_unique<SceneManager3D>())
     , m_cameraController(std::make_unique<CameraController>())
+    , m_performanceMonitor(std::make_unique<PerformanceMonitor>())
     , m_lastDrawMode(DrawPoint3D)
     , m_lastMouseWorldPos(0.0)
     , m_shouldPassMouseToOSG(true)
@@ -55,8 +57,9 @@ OSGWidget::OSGWidget(QWidget* parent)
     // 连接初始化完成信号
     connect(this, &osgQOpenGLWidget::initialized, this, &OSGWidget::initializeScene);
     
-    // 启动渲染循环 (60 FPS)
-    m_updateTimer->start(16);
+    // 相机变化时重绘；渲染循环按需启动，见updateRenderLoop
+    connect(m_cameraController.get(), &CameraController::cameraChanged, this, &OSGWidget::requestRedraw);
+    m_updateTimer->setInterval(16);
     
     // 发送初始相机速度
     emit cameraSpeedChanged(m_initialSpeed);
@@ -71,6 +74,10 @@ OSGWidget::~OSGWidget()
         m_updateTimer->stop();
     }
     
+    if (m_sceneManager) {
+        m_sceneManager->setRedrawCallback(nullptr);
+    }
+    
     LOG_INFO("OSGWidget窗口控制销毁", "窗口控制");
 }
 
@@ -99,6 +106,22 @@ void OSGWidget::initializeScene()
     // 配置事件处理
     setupEventHandlers();
     
+    // 后台悬停拾取结果排队回到主线程
+    if (AsyncPickingService* pickingService = m_sceneManager->getAsyncPickingService()) {
+        connect(pickingService, &AsyncPickingService::pickingFinished,
+                this, &OSGWidget::onAsyncPickingResult, Qt::QueuedConnection);
+    }
+    
+    // 性能统计与视口HUD（HUD默认隐藏）
+    m_performanceMonitor->attach(viewer);
+    m_performanceHUD = new PerformanceHUD;
+    m_performanceHUD->setViewportSize(width(), height());
+    m_sceneManager->getRootNode()->addChild(m_performanceHUD->getCamera());
+    
+    // 几何体变化时请求重绘
+    m_sceneManager->setRedrawCallback([this]() { requestRedraw(); });
+    setContinuousRendering(m_continuousRendering);
+    
     LOG_SUCCESS("OSGWidget场景初始化完成", "窗口控制");
 }
 
@@ -160,7 +183,90 @@ void OSGWidget::paintEvent(QPaintEvent* event)
     // 确保OSG渲染循环运行
     osgViewer::Viewer* viewer = getOsgViewer();
     if (viewer) {
+        TRACE_ZONE("Viewer::frame", "渲染");
+        osg::Timer_t frameStart = osg::Timer::instance()->tick();
         viewer->frame();
+        m_performanceMonitor->recordFrame(osg::Timer::instance()->delta_m(frameStart, osg::Timer::instance()->tick()));
+    }
+    
+    // 根据本帧之后是否仍有动画决定是否继续计时刷新
+    updateRenderLoop();
+}
+
+void OSGWidget::requestRedraw()
+{
+    update();
+}
+
+PerformanceSnapshot OSGWidget::samplePerformance()
+{
+    PerformanceSnapshot snapshot = m_performanceMonitor->sample(m_sceneManager->getAllGeometries());
+    
+    // HUD刷新本身会多出一帧，只在HUD可见时才请求
+    if (m_performanceHUD.valid() && m_performanceHUD->isVisible()) {
+        m_performanceHUD->setText(snapshot.toHudText());
+        requestRedraw();
+    }
+    return snapshot;
+}
+
+void OSGWidget::setPerformanceHUDVisible(bool visible)
+{
+    if (!m_performanceHUD.valid()) return;
+    
+    m_performanceHUD->setVisible(visible);
+    requestRedraw();
+}
+
+bool OSGWidget::isPerformanceHUDVisible() const
+{
+    return m_performanceHUD.valid() && m_performanceHUD->isVisible();
+}
+
+void OSGWidget::setContinuousRendering(bool continuous)
+{
+    m_continuousRendering = continuous;
+    
+    // 按需模式下osgQOpenGL的内部刷新也只在查看器确实需要时出帧
+    if (osgViewer::Viewer* viewer = getOsgViewer()) {
+        viewer->setRunFrameScheme(continuous ? osgViewer::ViewerBase::CONTINUOUS
+                                             : osgViewer::ViewerBase::ON_DEMAND);
+    }
+    
+    updateRenderLoop();
+    requestRedraw();
+    
+    LOG_INFO(QString("渲染模式: %1").arg(continuous ? "连续渲染" : "按需渲染"), "窗口控制");
+}
+
+bool OSGWidget::needsContinuousFrames()
+{
+    if (m_continuousRendering) return true;
+    
+    // 键盘移动：按住移动键期间速度计数器非零
+    if (m_speedCounter > 0 || (m_cameraController && m_cameraController->isMoving())) return true;
+    
+    // 拾取指示器动画
+    if (m_sceneManager && m_sceneManager->isAnimating()) return true;
+    
+    // 操控器惯性旋转等请求持续更新，或场景中有待处理的更新回调
+    osgViewer::Viewer* viewer = getOsgViewer();
+    if (viewer) {
+        if (viewer->getRequestContinousUpdate()) return true;
+        osg::Node* sceneData = viewer->getSceneData();
+        if (sceneData && sceneData->getNumChildrenRequiringUpdateTraversal() > 0) return true;
+    }
+    
+    return false;
+}
+
+void OSGWidget::updateRenderLoop()
+{
+    bool needed = needsContinuousFrames();
+    if (needed && !m_updateTimer->isActive()) {
+        m_updateTimer->start();
+    } else if (!needed && m_updateTimer->isActive()) {
+        m_updateTimer->stop();
     }
 }
 
@@ -185,8 +291,14 @@ void OSGWidget::resizeEvent(QResizeEvent* event)
         }
     }
     
+    if (m_performanceHUD.valid()) {
+        m_performanceHUD->setViewportSize(width(), height());
+    }
+    
     // 使缓存无效
     m_mousePosCacheValid = false;
+    
+    requestRedraw();
 }
 
 // ========================================= 鼠标事件控制 - 处理后传给OSG =========================================
@@ -200,6 +312,8 @@ void OSGWidget::mousePressEvent(QMouseEvent* event)
     if (m_shouldPassMouseToOSG) {
         osgQOpenGLWidget::mousePressEvent(event);
     }
+    
+    requestRedraw();
 }
 
 void OSGWidget::mouseMoveEvent(QMouseEvent* event)
@@ -211,6 +325,11 @@ void OSGWidget::mouseMoveEvent(QMouseEvent* event)
     if (m_shouldPassMouseToOSG) {
         osgQOpenGLWidget::mouseMoveEvent(event);
     }
+    
+    // 拖动时需要出帧让OSG操控器处理事件；悬停只在拾取结果返回后重绘
+    if (event->buttons() != Qt::NoButton) {
+        requestRedraw();
+    }
 }
 
 void OSGWidget::mouseReleaseEvent(QMouseEvent* event)
@@ -222,6 +341,8 @@ void OSGWidget::mouseReleaseEvent(QMouseEvent* event)
     if (m_shouldPassMouseToOSG) {
         osgQOpenGLWidget::mouseReleaseEvent(event);
     }
+    
+    requestRedraw();
 }
 
 void OSGWidget::wheelEvent(QWheelEvent* event)
@@ -231,6 +352,8 @@ void OSGWidget::wheelEvent(QWheelEvent* event)
     
     // 直接传递给OSG处理缩放
     osgQOpenGLWidget::wheelEvent(event);
+    
+    requestRedraw();
 }
 
 void OSGWidget::mouseDoubleClickEvent(QMouseEvent* event)
@@ -283,6 +406,7 @@ void OSGWidget::handleMousePress(QMouseEvent* event)
             // 左键点击添加控制点
             if (m_sceneManager->getCurrentDrawingGeometry())
             {
+                worldPos = applySnap(event->x(), event->y(), worldPos);
                 auto geo = m_sceneManager->getCurrentDrawingGeometry();
                 auto controlPointManager = geo->mm_controlPoint();
                 if (controlPointManager)
@@ -348,9 +472,18 @@ void OSGWidget::handleMouseMove(QMouseEvent* event)
     emit mousePositionChanged(worldPos);
     emit screenPositionChanged(event->x(), event->y());
     
-    // 始终执行拾取，不管什么模式
-    PickResult result = m_sceneManager->performPicking(event->x(), event->y());
-    emit simplePickingResult(result);
+    // 始终执行拾取，不管什么模式（悬停拾取在后台线程执行，结果见onAsyncPickingResult）
+    if (!m_sceneManager->requestAsyncPicking(event->x(), event->y())) {
+        PickResult result = m_sceneManager->performPicking(event->x(), event->y());
+        emit simplePickingResult(result);
+        requestRedraw();
+    }
+    
+    // 绘制和拖动控制点时吸附到捕捉点
+    if ((GlobalDrawMode3D != DrawSelect3D && m_sceneManager->isDrawing()) || m_sceneManager->isDraggingControlPoint())
+    {
+        worldPos = applySnap(event->x(), event->y(), worldPos);
+    }
     
     // 处理按键状态下的操作
     if (event->buttons() & Qt::LeftButton)
@@ -397,6 +530,7 @@ void OSGWidget::keyPressEvent(QKeyEvent* event)
     handleKeyPress(event);
     
     // 不调用基类的keyPressEvent，实现完全自定义控制
+    requestRedraw();
 }
 
 void OSGWidget::keyReleaseEvent(QKeyEvent* event)
@@ -405,6 +539,7 @@ void OSGWidget::keyReleaseEvent(QKeyEvent* event)
     handleKeyRelease(event);
     
     // 不调用基类的keyReleaseEvent，实现完全自定义控制
+    requestRedraw();
 }
 
 // ========================================= 键盘事件处理实现 =========================================
@@ -699,6 +834,16 @@ glm::dvec3 OSGWidget::screenToWorld(int x, int y, double depth)
     return result;
 }
 
+glm::dvec3 OSGWidget::applySnap(int x, int y, const glm::dvec3& worldPos)
+{
+    // 与screenToWorld相同，窗口坐标原点在左下角
+    SnapResult snapResult;
+    if (!m_sceneManager || !m_sceneManager->snapPoint(x, height() - y, snapResult)) {
+        return worldPos;
+    }
+    return snapResult.position;
+}
+
 void OSGWidget::completeCurrentDrawing()
 {
     if (!m_sceneManager || !m_sceneManager->isDrawing()) return;
@@ -789,6 +934,16 @@ void OSGWidget::onSimplePickingResult(const PickResult& result)
     }
 }
 
+void OSGWidget::onAsyncPickingResult(const PickResult& result, quint64 requestId)
+{
+    // 结果按请求顺序返回，旧请求的结果不再覆盖新结果
+    if (requestId <= m_lastAsyncPickingId) return;
+    m_lastAsyncPickingId = requestId;
+    
+    emit simplePickingResult(result);
+    requestRedraw();
+}
+
 // ========================================= 右键菜单槽函数 =========================================
 
 void OSGWidget::onDeleteSelectedObjects()
@@ -920,31 +1075,13 @@ void OSGWidget::onFitAll()
 {
     if (!m_cameraController || !m_sceneManager) return;
     
-    // 计算所有几何体的包围盒
-    const auto& geometries = m_sceneManager->getAllGeometries();
-    if (geometries.empty())
-    {
-        onResetCamera();
-        return;
-    }
-    
-    osg::BoundingSphere combinedBounds;
-    for (const auto& geo : geometries)
-    {
-        if (geo && geo->mm_node() && geo->mm_node()->getOSGNode())
-        {
-            osg::BoundingSphere geoBounds = geo->mm_node()->getOSGNode()->getBound();
-            if (geoBounds.valid())
-            {
-                combinedBounds.expandBy(geoBounds);
-            }
-        }
-    }
+    // 所有几何体的包围盒（场景实体存储中已按对象维护）
+    BoundingBox3D sceneBounds = m_sceneManager->getSceneBounds();
+    double radius = sceneBounds.isValid() ? glm::length(sceneBounds.size()) * 0.5 : 0.0;
     
-    if (combinedBounds.valid() && combinedBounds.radius() > 0)
+    if (radius > 0)
     {
-        osg::Vec3d center = combinedBounds.center();
-        double radius = combinedBounds.radius();
+        osg::Vec3d center(sceneBounds.center().x, sceneBounds.center().y, sceneBounds.center().z);
         double distance = radius * 2.5; // 留一些边距
         
         osg::Vec3d eye = center + osg::Vec3d(distance, distance, distance);
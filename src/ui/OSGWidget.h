@@ -4,6 +4,8 @@
 #include "../core/Common3D.h"
 #include "../core/camera/CameraController.h"
 #include "../core/world/SceneManager3D.h"
+#include "../core/world/PerformanceMonitor.h"
+#include "../core/world/PerformanceHUD.h"
 #include <osgQOpenGL/osgQOpenGLWidget>
 #include <osg/ref_ptr>
 #include <QTimer>
@@ -30,6 +32,19 @@ public:
     // 管理器访问
     SceneManager3D* getSceneManager() const { return m_sceneManager.get(); }
     CameraController* getCameraController() const { return m_cameraController.get(); }
+    
+    // 渲染模式：默认按需渲染，连续模式恢复固定16ms刷新
+    void setContinuousRendering(bool continuous);
+    bool isContinuousRendering() const { return m_continuousRendering; }
+    
+    // 性能采样（由状态栏低频定时调用），HUD可见时同时刷新HUD文本
+    PerformanceSnapshot samplePerformance();
+    void setPerformanceHUDVisible(bool visible);
+    bool isPerformanceHUDVisible() const;
+
+public slots:
+    // 请求重绘一帧（多次请求在同一事件循环内合并）
+    void requestRedraw();
 
 signals:
     void geoSelected(osg::ref_ptr<Geo3D> geo);
@@ -62,6 +77,9 @@ private slots:
     void onResetCamera();
     void onFitAll();
     void onCenterObjectToView();
+    
+    // 后台悬停拾取结果（排队连接，回到主线程）
+    void onAsyncPickingResult(const PickResult& result, quint64 requestId);
 
 private:
     // 初始化和设置
@@ -83,6 +101,7 @@ private:
     
     // 绘制辅助函数
     glm::dvec3 screenToWorld(int x, int y, double depth = 0.0);
+    glm::dvec3 applySnap(int x, int y, const glm::dvec3& worldPos);  // 绘制/拖动控制点时吸附到捕捉点
     void completeCurrentDrawing();
     void cancelCurrentDrawing();
     void onSimplePickingResult(const PickResult& result);
@@ -90,6 +109,10 @@ private:
     // 事件传递控制
     void setMousePassToOSG(bool shouldPass);
     
+    // 渲染循环控制
+    bool needsContinuousFrames();
+    void updateRenderLoop();
+    
 private:
     // 核心系统
     std::unique_ptr<SceneManager3D> m_sceneManager;
@@ -107,13 +130,21 @@ private:
     QDateTime m_lastMouseCalculation;
     static const int MOUSE_CACHE_DURATION = 16;
     
+    // 异步悬停拾取
+    quint64 m_lastAsyncPickingId = 0;
+    
     // 右键菜单
     QPoint m_lastContextMenuPos;
     osg::ref_ptr<Geo3D> m_contextMenuGeo;
     int m_contextMenuPointIndex;
     
-    // 渲染循环
+    // 性能统计
+    std::unique_ptr<PerformanceMonitor> m_performanceMonitor;
+    osg::ref_ptr<PerformanceHUD> m_performanceHUD;
+    
+    // 渲染循环（按需模式下只在动画或键盘移动期间运行）
     QTimer* m_updateTimer;
+    bool m_continuousRendering = false;
     
     // 键盘移动加速控制变量
     double m_initialSpeed = 0.1;        // 起始速度
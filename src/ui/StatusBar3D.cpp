@@ -19,6 +19,7 @@ StatusBar3D::StatusBar3D(QWidget* parent)
     , m_manipulatorLabel(nullptr)
     , m_fpsLabel(nullptr)
     , m_memoryLabel(nullptr)
+    , m_performanceLabel(nullptr)
     , m_temporaryMessageLabel(nullptr)
     , m_performanceTimer(nullptr)
     , m_mainLayout(nullptr)
@@ -83,11 +84,14 @@ void StatusBar3D::setupUI()
     m_manipulatorLabel = new QLabel(tr("操作器: 轨道"));
     m_manipulatorLabel->setMinimumWidth(100);
     
-    m_fpsLabel = new QLabel(tr("FPS: 60"));
+    m_fpsLabel = new QLabel(tr("FPS: 0"));
     m_fpsLabel->setMinimumWidth(80);
     
-    m_memoryLabel = new QLabel(tr("内存: 0MB"));
-    m_memoryLabel->setMinimumWidth(100);
+    m_memoryLabel = new QLabel(tr("几何内存: 0MB"));
+    m_memoryLabel->setMinimumWidth(120);
+    
+    m_performanceLabel = new QLabel(tr("帧: -"));
+    m_performanceLabel->setMinimumWidth(260);
     
     m_temporaryMessageLabel = new QLabel(tr("就绪"));
     m_temporaryMessageLabel->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
@@ -112,6 +116,7 @@ void StatusBar3D::setupUI()
     m_separator8 = createSeparator();
     m_separator9 = createSeparator();
     m_separator10 = createSeparator();
+    m_separator11 = createSeparator();
     
     // 添加组件到布局
     m_mainLayout->addWidget(m_screenCoordLabel);
@@ -134,12 +139,14 @@ void StatusBar3D::setupUI()
     m_mainLayout->addWidget(m_separator9);
     m_mainLayout->addWidget(m_memoryLabel);
     m_mainLayout->addWidget(m_separator10);
+    m_mainLayout->addWidget(m_performanceLabel);
+    m_mainLayout->addWidget(m_separator11);
     m_mainLayout->addStretch();
     m_mainLayout->addWidget(m_temporaryMessageLabel);
     
     // 创建定时器
     m_performanceTimer = new QTimer(this);
-    m_performanceTimer->setInterval(1000);
+    m_performanceTimer->setInterval(500);
     m_performanceTimer->start();
     
     m_messageTimer = new QTimer(this);
@@ -225,7 +232,24 @@ void StatusBar3D::updateFPS(double fps)
 void StatusBar3D::updateMemoryUsage(double mb)
 {
     if (m_memoryLabel) {
-        m_memoryLabel->setText(tr("内存: %1MB").arg(mb, 0, 'f', 1));
+        m_memoryLabel->setText(tr("几何内存: %1MB").arg(mb, 0, 'f', 1));
+    }
+}
+
+void StatusBar3D::updatePerformance(const PerformanceSnapshot& snapshot)
+{
+    updateFPS(snapshot.fps);
+    updateMemoryUsage(snapshot.geometryBytes / (1024.0 * 1024.0));
+    
+    if (m_performanceLabel) {
+        m_performanceLabel->setText(tr("帧: P95 %1ms 剔除%2 绘制%3 | 调用%4 三角形%5 | 拾取%6ms")
+            .arg(snapshot.frameP95Ms, 0, 'f', 1)
+            .arg(snapshot.cullMs, 0, 'f', 1)
+            .arg(snapshot.drawMs, 0, 'f', 1)
+            .arg(snapshot.drawCalls, 0, 'f', 0)
+            .arg(snapshot.triangles, 0, 'f', 0)
+            .arg(snapshot.pickAverageMs, 0, 'f', 1));
+        m_performanceLabel->setToolTip(snapshot.toString());
     }
 }
 
@@ -239,9 +263,9 @@ void StatusBar3D::showTemporaryMessage(const QString& message, int duration)
 
 void StatusBar3D::updatePerformanceInfo()
 {
-    // 简化实现：固定FPS和内存值
-    updateFPS(60.0);
-    updateMemoryUsage(512.0);
+    if (!m_osgWidget) return;
+    
+    updatePerformance(m_osgWidget->samplePerformance());
 } 
 
 
@@ -10,6 +10,7 @@
 
 // 前向声明
 class OSGWidget;
+struct PerformanceSnapshot;
 
 // 3D状态栏类
 class StatusBar3D : public QWidget
@@ -50,14 +51,17 @@ public:
     // 更新FPS
     void updateFPS(double fps);
     
-    // 更新内存使用
+    // 更新内存使用（几何数组占用）
     void updateMemoryUsage(double mb);
     
+    // 更新性能面板（帧耗时分位、绘制统计、拾取耗时，详细数据放在提示中）
+    void updatePerformance(const PerformanceSnapshot& snapshot);
+    
     // 显示临时消息（不会覆盖固定内容）
     void showTemporaryMessage(const QString& message, int duration = 3000);
 
 private slots:
-    // 定时更新FPS和内存使用
+    // 定时采样性能数据（固定低频，避免采样本身影响测量）
     void updatePerformanceInfo();
 
 private:
@@ -79,7 +83,8 @@ private:
     QLabel* m_projectionModeLabel;   // 投影模式
     QLabel* m_manipulatorLabel;      // 操作器类型
     QLabel* m_fpsLabel;              // FPS
-    QLabel* m_memoryLabel;           // 内存使用
+    QLabel* m_memoryLabel;           // 几何内存
+    QLabel* m_performanceLabel;      // 帧耗时/绘制/拾取
     
     // 临时消息标签（右侧）
     QLabel* m_temporaryMessageLabel;
@@ -101,6 +106,7 @@ private:
     QFrame* m_separator8;
     QFrame* m_separator9;
     QFrame* m_separator10;
+    QFrame* m_separator11;
     
     // 临时消息定时器
     QTimer* m_messageTimer;
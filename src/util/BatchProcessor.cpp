@@ -0,0 +1,497 @@
+﻿#include "BatchProcessor.h"
+#include "GeoOsgbIO.h"
+#include "LogManager.h"
+#include "Tracer.h"
+#include "../core/managers/GeoControlPointManager.h"
+#include "../core/managers/GeoNodeManager.h"
+#include "../core/managers/GeoStateManager.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+#include <osg/GraphicsContext>
+#include <osg/Image>
+#include <osg/MatrixTransform>
+#include <osg/Timer>
+#include <osgDB/ReadFile>
+#include <osgDB/Registry>
+#include <osgDB/WriteFile>
+#include <osgUtil/Optimizer>
+#include <osgViewer/Viewer>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+std::mutex BatchProcessor::s_renderMutex;
+
+namespace
+{
+    const int kMaxReportedIssues = 5;   // 每个文件最多列出的校验问题
+
+    std::mutex s_outputMutex;
+
+    QTextStream& out()
+    {
+        static QTextStream stream(stdout);
+        return stream;
+    }
+
+    bool hasDrawableContent(const osg::Geometry* geometry)
+    {
+        return geometry && geometry->getVertexArray()
+            && geometry->getVertexArray()->getNumElements() > 0
+            && geometry->getNumPrimitiveSets() > 0;
+    }
+
+    bool isFinite(const Point3D& point)
+    {
+        return std::isfinite(point.x()) && std::isfinite(point.y()) && std::isfinite(point.z());
+    }
+
+    // 拷贝一份几何体挂到静态变换下，导出和优化都不影响原对象以及共享的单位网格
+    void addExportGeometry(osg::Group* scene, const osg::Geometry* geometry, const osg::Matrixd& matrix)
+    {
+        osg::ref_ptr<osg::Geometry> copy = new osg::Geometry(*geometry,
+            osg::CopyOp::DEEP_COPY_ARRAYS | osg::CopyOp::DEEP_COPY_PRIMITIVES);
+        copy->setShape(nullptr);    // KdTree对导出无用
+        copy->setNodeMask(~0u);
+
+        osg::ref_ptr<osg::MatrixTransform> transform = new osg::MatrixTransform(matrix);
+        transform->setDataVariance(osg::Object::STATIC);
+        transform->addChild(copy.get());
+        scene->addChild(transform.get());
+    }
+
+    int parseSubdivision(const QString& text, bool& ok)
+    {
+        ok = true;
+        const QString value = text.trimmed().toLower();
+        if (value == "low") return Subdivision_Low3D;
+        if (value == "medium") return Subdivision_Medium3D;
+        if (value == "high") return Subdivision_High3D;
+        if (value == "ultra") return Subdivision_Ultra3D;
+
+        int number = value.toInt(&ok);
+        if (ok && (number == Subdivision_Low3D || number == Subdivision_Medium3D
+                   || number == Subdivision_High3D || number == Subdivision_Ultra3D)) {
+            return number;
+        }
+        ok = false;
+        return 0;
+    }
+}
+
+// ============= 结果 =============
+
+QString BatchFileResult::toString() const
+{
+    QString text = QString("%1 %2").arg(success ? "完成" : "失败").arg(inputPath);
+    if (!outputPath.isEmpty()) text += QString(" -> %1").arg(outputPath);
+    text += QString(" (%1个对象").arg(geoCount);
+    if (invalidCount > 0) text += QString(", %1个未通过校验").arg(invalidCount);
+    text += QString(", %1ms)").arg(elapsedMs, 0, 'f', 1);
+    if (!message.isEmpty()) text += "\n    " + message;
+    return text;
+}
+
+QString BatchSummary::toString() const
+{
+    return QString("批处理结束: 共%1个文件, 成功%2, 失败%3, %4个线程, 耗时%5s")
+        .arg(files.size())
+        .arg(succeeded)
+        .arg(failed)
+        .arg(jobs)
+        .arg(elapsedMs / 1000.0, 0, 'f', 2);
+}
+
+// ============= 命令行 =============
+
+bool BatchProcessor::isBatchCommand(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--batch") == 0) return true;
+    }
+    return false;
+}
+
+int BatchProcessor::runCommandLine(const QStringList& arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("3Drawing 批处理：读取osgb场景，重新生成、校验并导出");
+    parser.addHelpOption();
+
+    QCommandLineOption batchOption("batch", "以批处理模式运行，不启动界面");
+    QCommandLineOption formatOption("format", "输出格式：osgb（默认，可再编辑）、osgt/obj/stl/ply等osgDB支持的模型格式，或png/jpg/bmp离屏渲染图片", "ext", "osgb");
+    QCommandLineOption outputOption("output-dir", "输出目录，默认写到输入文件旁边", "dir");
+    QCommandLineOption subdivisionOption("subdivision", "按保存的控制点以该细分级别重新生成几何：low/medium/high/ultra", "level");
+    QCommandLineOption optimizeOption("optimize", "导出模型前合并几何、共享状态并优化索引和顶点缓存");
+    QCommandLineOption validateOption("validate", "只校验不输出，有对象未通过时返回非零");
+    QCommandLineOption recursiveOption("recursive", "递归搜索输入目录");
+    QCommandLineOption jobsOption("jobs", "工作线程数，默认按CPU核数", "n", "0");
+    QCommandLineOption sizeOption("size", "渲染图片尺寸，如1920x1080", "WxH", "1920x1080");
+    QCommandLineOption verboseOption("verbose", "输出信息级日志");
+    parser.addOptions({ batchOption, formatOption, outputOption, subdivisionOption, optimizeOption,
+                        validateOption, recursiveOption, jobsOption, sizeOption, verboseOption });
+    parser.addPositionalArgument("inputs", "osgb文件或包含osgb文件的目录", "<文件或目录...>");
+
+    if (!parser.parse(arguments)) {
+        out() << parser.errorText() << Qt::endl;
+        return 2;
+    }
+    if (parser.isSet("help")) {
+        out() << parser.helpText() << Qt::endl;
+        return 0;
+    }
+
+    BatchOptions options;
+    options.inputs = parser.positionalArguments();
+    options.outputDir = parser.value(outputOption);
+    options.format = parser.value(formatOption).toLower();
+    options.optimize = parser.isSet(optimizeOption);
+    options.validateOnly = parser.isSet(validateOption);
+    options.recursive = parser.isSet(recursiveOption);
+    options.jobs = parser.value(jobsOption).toInt();
+
+    if (options.inputs.isEmpty()) {
+        out() << "没有指定输入文件或目录" << Qt::endl;
+        return 2;
+    }
+
+    if (parser.isSet(subdivisionOption)) {
+        bool ok = false;
+        options.subdivision = parseSubdivision(parser.value(subdivisionOption), ok);
+        if (!ok) {
+            out() << QString("无效的细分级别: %1").arg(parser.value(subdivisionOption)) << Qt::endl;
+            return 2;
+        }
+    }
+
+    const QStringList size = parser.value(sizeOption).toLower().split('x');
+    if (size.size() != 2 || size[0].toInt() <= 0 || size[1].toInt() <= 0) {
+        out() << QString("无效的图片尺寸: %1").arg(parser.value(sizeOption)) << Qt::endl;
+        return 2;
+    }
+    options.imageWidth = size[0].toInt();
+    options.imageHeight = size[1].toInt();
+
+    if (!options.validateOnly && !isImageFormat(options.format)
+        && !osgDB::Registry::instance()->getReaderWriterForExtension(options.format.toStdString())) {
+        out() << QString("没有可写出 %1 格式的OSG插件").arg(options.format) << Qt::endl;
+        return 2;
+    }
+
+    // 大批量处理时逐对象的信息级日志会淹没输出
+    LogManager::getInstance();
+    LogManager::setMinLevel(parser.isSet(verboseOption) ? LogLevel::Info : LogLevel::Warning);
+
+    BatchSummary summary = run(options);
+    out() << summary.toString() << Qt::endl;
+
+    if (summary.files.empty()) return 2;
+    return summary.failed > 0 ? 1 : 0;
+}
+
+bool BatchProcessor::isImageFormat(const QString& format)
+{
+    return format == "png" || format == "jpg" || format == "jpeg" || format == "bmp";
+}
+
+// ============= 执行 =============
+
+QStringList BatchProcessor::collectInputFiles(const BatchOptions& options)
+{
+    QStringList files;
+    for (const QString& input : options.inputs) {
+        QFileInfo info(input);
+        if (info.isDir()) {
+            QDirIterator it(input, QStringList() << "*.osgb", QDir::Files,
+                            options.recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+            QStringList found;
+            while (it.hasNext()) {
+                found << it.next();
+            }
+            found.sort();
+            files << found;
+        } else {
+            files << input;
+        }
+    }
+    files.removeDuplicates();
+    return files;
+}
+
+BatchSummary BatchProcessor::run(const BatchOptions& options)
+{
+    BatchSummary summary;
+    osg::Timer_t start = osg::Timer::instance()->tick();
+
+    const QStringList files = collectInputFiles(options);
+    if (files.isEmpty()) {
+        out() << "没有找到osgb文件" << Qt::endl;
+        return summary;
+    }
+
+    int jobs = options.jobs > 0 ? options.jobs : std::max(1, QThread::idealThreadCount());
+    jobs = std::min(jobs, files.size());
+    summary.jobs = jobs;
+    summary.files.resize(files.size());
+
+    // 工作线程从共享下标领取文件，结果写回各自槽位，保持输入顺序
+    std::atomic<int> nextIndex(0);
+    std::atomic<int> finishedCount(0);
+    auto worker = [&](int workerIndex) {
+        Tracer::getInstance()->setCurrentThreadName(QString("批处理线程%1").arg(workerIndex));
+        for (int index = nextIndex++; index < files.size(); index = nextIndex++) {
+            BatchFileResult result = processFile(files[index], options);
+            int finished = ++finishedCount;
+            {
+                std::lock_guard<std::mutex> lock(s_outputMutex);
+                out() << QString("[%1/%2] ").arg(finished).arg(files.size()) << result.toString() << Qt::endl;
+            }
+            summary.files[index] = result;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < jobs; ++i) {
+        workers.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+
+    for (const BatchFileResult& result : summary.files) {
+        result.success ? ++summary.succeeded : ++summary.failed;
+    }
+    summary.elapsedMs = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick());
+    return summary;
+}
+
+BatchFileResult BatchProcessor::processFile(const QString& inputPath, const BatchOptions& options)
+{
+    TRACE_ZONE("BatchProcessor::processFile", "批处理");
+
+    BatchFileResult result;
+    result.inputPath = inputPath;
+    osg::Timer_t start = osg::Timer::instance()->tick();
+
+    // 1. 读取，指定细分级别时按控制点重新走一遍绘制流程
+    GeoLoadOptions loadOptions;
+    loadOptions.rebuildFromControlPoints = options.subdivision > 0;
+    loadOptions.subdivisionOverride = options.subdivision;
+    std::vector<Geo3D::Ptr> geos = GeoOsgbIO::loadGeoList(inputPath, loadOptions);
+    result.geoCount = static_cast<int>(geos.size());
+
+    if (geos.empty()) {
+        result.message = "读取失败或文件中没有几何体";
+        result.elapsedMs = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick());
+        return result;
+    }
+
+    // 2. 校验
+    QStringList issues;
+    result.invalidCount = validate(geos, issues);
+    if (!issues.isEmpty()) {
+        result.message = issues.join("\n    ");
+    }
+
+    // 3. 输出
+    if (options.validateOnly) {
+        result.success = result.invalidCount == 0;
+    } else {
+        result.outputPath = outputPathFor(inputPath, options);
+        QDir().mkpath(QFileInfo(result.outputPath).absolutePath());
+
+        if (options.format == "osgb") {
+            result.success = GeoOsgbIO::saveGeoList(result.outputPath, geos);
+        } else if (isImageFormat(options.format)) {
+            result.success = renderImage(geos, result.outputPath, options.imageWidth, options.imageHeight);
+        } else {
+            result.success = exportMesh(geos, result.outputPath, options.optimize);
+        }
+
+        if (!result.success) {
+            QString error = QString("写出失败: %1").arg(result.outputPath);
+            result.message = result.message.isEmpty() ? error : error + "\n    " + result.message;
+        }
+    }
+
+    result.elapsedMs = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick());
+    return result;
+}
+
+QString BatchProcessor::outputPathFor(const QString& inputPath, const BatchOptions& options)
+{
+    QFileInfo input(inputPath);
+    QDir directory(options.outputDir.isEmpty() ? input.absolutePath() : options.outputDir);
+    QString outputPath = directory.absoluteFilePath(input.completeBaseName() + "." + options.format);
+
+    // 不覆盖输入文件
+    if (QFileInfo(outputPath).absoluteFilePath() == input.absoluteFilePath()) {
+        outputPath = directory.absoluteFilePath(input.completeBaseName() + ".batch." + options.format);
+    }
+    return outputPath;
+}
+
+// ============= 校验 =============
+
+int BatchProcessor::validate(const std::vector<Geo3D::Ptr>& geos, QStringList& issues)
+{
+    int invalidCount = 0;
+    for (size_t i = 0; i < geos.size(); ++i) {
+        const Geo3D::Ptr& geo = geos[i];
+        if (!geo) continue;
+
+        QStringList problems;
+        GeoNodeManager* nodeManager = geo->mm_node();
+
+        // 外部文件用未定义对象承载，没有控制点和绘制状态
+        if (geo->getGeoType() != Geo_Undefined3D) {
+            if (geo->mm_state()->isStateInvalid()) problems << "状态无效";
+
+            if (geo->mm_state()->isStateComplete()) {
+                for (const auto& stage : geo->mm_controlPoint()->getAllStageControlPoints()) {
+                    for (const Point3D& point : stage) {
+                        if (!isFinite(point)) {
+                            problems << "控制点含非法数值";
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (!nodeManager->getBoundingBox().valid()) problems << "包围盒无效";
+
+        if (!hasDrawableContent(nodeManager->getFaceGeometry().get())
+            && !hasDrawableContent(nodeManager->getEdgeGeometry().get())
+            && !hasDrawableContent(nodeManager->getVertexGeometry().get())) {
+            problems << "没有可绘制的几何";
+        }
+
+        if (!problems.isEmpty()) {
+            ++invalidCount;
+            if (issues.size() < kMaxReportedIssues) {
+                issues << QString("对象%1(%2): %3").arg(i).arg(geoType3DToString(geo->getGeoType())).arg(problems.join(", "));
+            }
+        }
+    }
+
+    if (invalidCount > kMaxReportedIssues) {
+        issues << QString("……另有%1个对象未通过校验").arg(invalidCount - kMaxReportedIssues);
+    }
+    return invalidCount;
+}
+
+// ============= 导出 =============
+
+bool BatchProcessor::exportMesh(const std::vector<Geo3D::Ptr>& geos, const QString& outputPath, bool optimize)
+{
+    TRACE_ZONE("BatchProcessor::exportMesh", "批处理");
+
+    osg::ref_ptr<osg::Group> scene = new osg::Group();
+    for (const Geo3D::Ptr& geo : geos) {
+        if (!geo) continue;
+        GeoNodeManager* nodeManager = geo->mm_node();
+
+        // 面和边几何体都可能引用单位网格，要用各自的变换×对象变换
+        if (hasDrawableContent(nodeManager->getFaceGeometry().get())) {
+            addExportGeometry(scene.get(), nodeManager->getFaceGeometry().get(), nodeManager->getFaceWorldMatrix());
+        } else if (hasDrawableContent(nodeManager->getEdgeGeometry().get())) {
+            addExportGeometry(scene.get(), nodeManager->getEdgeGeometry().get(), nodeManager->getEdgeWorldMatrix());
+        }
+    }
+
+    if (scene->getNumChildren() == 0) {
+        LOG_WARNING(QString("没有可导出的几何: %1").arg(outputPath), "批处理");
+        return false;
+    }
+
+    if (optimize) {
+        TRACE_ZONE("osgUtil::Optimizer", "批处理");
+        osgUtil::Optimizer optimizer;
+        optimizer.optimize(scene.get(),
+            osgUtil::Optimizer::FLATTEN_STATIC_TRANSFORMS |
+            osgUtil::Optimizer::REMOVE_REDUNDANT_NODES |
+            osgUtil::Optimizer::SHARE_DUPLICATE_STATE |
+            osgUtil::Optimizer::MERGE_GEOMETRY |
+            osgUtil::Optimizer::INDEX_MESH |
+            osgUtil::Optimizer::VERTEX_POSTTRANSFORM |
+            osgUtil::Optimizer::VERTEX_PRETRANSFORM);
+    }
+
+    TRACE_ZONE("osgDB::writeNodeFile", "批处理");
+    return osgDB::writeNodeFile(*scene, outputPath.toStdString());
+}
+
+bool BatchProcessor::renderImage(const std::vector<Geo3D::Ptr>& geos, const QString& outputPath, int width, int height)
+{
+    TRACE_ZONE("BatchProcessor::renderImage", "批处理");
+    std::lock_guard<std::mutex> lock(s_renderMutex);
+
+    osg::ref_ptr<osg::GraphicsContext::Traits> traits = new osg::GraphicsContext::Traits;
+    traits->x = 0;
+    traits->y = 0;
+    traits->width = width;
+    traits->height = height;
+    traits->red = 8;
+    traits->green = 8;
+    traits->blue = 8;
+    traits->alpha = 8;
+    traits->depth = 24;
+    traits->samples = 4;
+    traits->pbuffer = true;
+    traits->doubleBuffer = false;
+    traits->windowDecoration = false;
+
+    osg::ref_ptr<osg::GraphicsContext> context = osg::GraphicsContext::createGraphicsContext(traits.get());
+    if (!context.valid()) {
+        LOG_ERROR("无法创建离屏渲染上下文，当前OSG构建可能不支持无窗口pbuffer", "批处理");
+        return false;
+    }
+
+    osg::ref_ptr<osg::Group> root = new osg::Group();
+    for (const Geo3D::Ptr& geo : geos) {
+        if (geo) root->addChild(geo->mm_node()->getOSGNode().get());
+    }
+
+    osgViewer::Viewer viewer;
+    viewer.setThreadingModel(osgViewer::Viewer::SingleThreaded);
+    viewer.setSceneData(root.get());
+
+    osg::Camera* camera = viewer.getCamera();
+    camera->setGraphicsContext(context.get());
+    camera->setViewport(0, 0, width, height);
+    camera->setClearColor(osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f));
+    camera->setDrawBuffer(GL_FRONT);
+    camera->setReadBuffer(GL_FRONT);
+
+    // 斜俯视整个场景
+    const double fovy = 30.0;
+    osg::BoundingSphere bound = root->getBound();
+    double radius = bound.valid() && bound.radius() > 0.0 ? bound.radius() : 1.0;
+    double distance = radius / std::sin(osg::DegreesToRadians(fovy * 0.5));
+    osg::Vec3d center = bound.valid() ? osg::Vec3d(bound.center()) : osg::Vec3d();
+    osg::Vec3d direction(1.0, -1.0, 0.8);
+    direction.normalize();
+    camera->setProjectionMatrixAsPerspective(fovy, static_cast<double>(width) / height, distance * 0.01, distance * 4.0);
+    camera->setViewMatrixAsLookAt(center + direction * distance, center, osg::Vec3d(0.0, 0.0, 1.0));
+
+    osg::ref_ptr<osg::Image> image = new osg::Image();
+    image->allocateImage(width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+    camera->attach(osg::Camera::COLOR_BUFFER, image.get());
+
+    viewer.realize();
+    viewer.frame();
+
+    bool success = osgDB::writeImageFile(*image, outputPath.toStdString());
+
+    // 节点归几何体对象所有，关闭前从临时场景上摘下
+    viewer.setSceneData(nullptr);
+    root->removeChildren(0, root->getNumChildren());
+    return success;
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include "../core/GeometryBase.h"
+#include <QString>
+#include <QStringList>
+#include <mutex>
+#include <vector>
+
+// 批处理参数
+struct BatchOptions
+{
+    QStringList inputs;             // 输入文件或目录
+    QString outputDir;              // 输出目录，为空时写到输入文件旁边
+    QString format = "osgb";        // osgb保持可编辑；其他模型格式走osgDB导出；png/jpg/bmp为离屏渲染图片
+    int subdivision = 0;            // 按控制点重新生成几何时的细分级别，0表示沿用文件中的网格
+    bool optimize = false;          // 导出模型前执行osgUtil::Optimizer合并/索引/顶点缓存优化
+    bool validateOnly = false;      // 只校验不输出
+    bool recursive = false;         // 递归搜索输入目录
+    int jobs = 0;                   // 工作线程数，0表示按CPU核数
+    int imageWidth = 1920;
+    int imageHeight = 1080;
+};
+
+// 单个文件的处理结果
+struct BatchFileResult
+{
+    QString inputPath;
+    QString outputPath;
+    bool success = false;
+    int geoCount = 0;
+    int invalidCount = 0;           // 校验未通过的对象数
+    double elapsedMs = 0.0;
+    QString message;
+
+    QString toString() const;
+};
+
+// 整批结果
+struct BatchSummary
+{
+    std::vector<BatchFileResult> files;
+    int succeeded = 0;
+    int failed = 0;
+    int jobs = 0;
+    double elapsedMs = 0.0;
+
+    QString toString() const;
+};
+
+// 命令行批处理 - 不创建窗口，由工作线程池并行处理osgb场景：
+// 读取 -> （可选）按细分级别重新生成 -> 校验 -> 写出为osgb/其他模型格式/离屏渲染图片
+class BatchProcessor
+{
+public:
+    // 命令行中带--batch时走批处理，不启动界面
+    static bool isBatchCommand(int argc, char* argv[]);
+
+    // 解析命令行并执行，返回进程退出码（0全部成功，1有文件失败，2参数错误）
+    static int runCommandLine(const QStringList& arguments);
+
+    static BatchSummary run(const BatchOptions& options);
+    static BatchFileResult processFile(const QString& inputPath, const BatchOptions& options);
+
+    // 展开输入目录，只收集osgb文件
+    static QStringList collectInputFiles(const BatchOptions& options);
+
+    static bool isImageFormat(const QString& format);
+
+private:
+    BatchProcessor() = delete;  // 禁止实例化
+
+    static QString outputPathFor(const QString& inputPath, const BatchOptions& options);
+
+    // 返回校验未通过的对象数，问题描述追加到issues
+    static int validate(const std::vector<Geo3D::Ptr>& geos, QStringList& issues);
+
+    // 只导出可见的面（无面时导出边），烘焙变换后交给osgDB按扩展名写出
+    static bool exportMesh(const std::vector<Geo3D::Ptr>& geos, const QString& outputPath, bool optimize);
+
+    // pbuffer离屏渲染一帧并读回，需要支持无窗口上下文的OSG构建（如EGL）
+    static bool renderImage(const std::vector<Geo3D::Ptr>& geos, const QString& outputPath, int width, int height);
+
+    static std::mutex s_renderMutex;   // 离屏上下文串行创建和绘制，避免驱动多上下文并发问题
+};
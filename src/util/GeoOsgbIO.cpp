@@ -6,11 +6,16 @@
 #include <osg/UserDataContainer>
 #include <osg/ValueObject>
 #include <QDebug>
+#include <QStringList>
 #include "../core/geometry/UndefinedGeo3D.h"
 #include "../core/GeometryBase.h"
 #include "../core/Enums3D.h"
+#include "../core/managers/GeoControlPointManager.h"
+#include "../core/managers/GeoStateManager.h"
+#include "../core/world/GeoEntityStore.h"
 #include "../util/GeometryFactory.h"
 #include "LogManager.h"
+#include "Tracer.h"
 
 // 场景根节点标识名
 const std::string GeoOsgbIO::SCENE_ROOT_NAME = NodeTags3D::SCENE_ROOT;
@@ -21,6 +26,8 @@ const std::string GeoOsgbIO::SCENE_ROOT_NAME = NodeTags3D::SCENE_ROOT;
 
 bool GeoOsgbIO::saveGeoList(const QString& filePath, const std::vector<Geo3D::Ptr>& geoList)
 {
+    TRACE_ZONE("GeoOsgbIO::saveGeoList", "文件IO");
+
     if (geoList.empty()) {
         LOG_WARNING("保存的几何体列表为空", "文件IO");
         return false;
@@ -51,7 +58,11 @@ bool GeoOsgbIO::saveGeoList(const QString& filePath, const std::vector<Geo3D::Pt
 
     // 保存场景到文件
     std::string stdFilePath = filePath.toStdString();
-    bool success = osgDB::writeNodeFile(*sceneRoot, stdFilePath);
+    bool success = false;
+    {
+        TRACE_ZONE("osgDB::writeNodeFile", "文件IO");
+        success = osgDB::writeNodeFile(*sceneRoot, stdFilePath);
+    }
     
     if (success) {
         LOG_INFO(QString("成功保存 %1 个几何体到文件: %2").arg(geoList.size()).arg(filePath), "文件IO");
@@ -64,6 +75,13 @@ bool GeoOsgbIO::saveGeoList(const QString& filePath, const std::vector<Geo3D::Pt
 
 std::vector<Geo3D::Ptr> GeoOsgbIO::loadGeoList(const QString& filePath)
 {
+    return loadGeoList(filePath, GeoLoadOptions());
+}
+
+std::vector<Geo3D::Ptr> GeoOsgbIO::loadGeoList(const QString& filePath, const GeoLoadOptions& options)
+{
+    TRACE_ZONE("GeoOsgbIO::loadGeoList", "文件IO");
+
     std::vector<Geo3D::Ptr> result;
 
     // 检查OSG插件是否可用
@@ -74,7 +92,11 @@ std::vector<Geo3D::Ptr> GeoOsgbIO::loadGeoList(const QString& filePath)
 
     // 读取文件
     std::string stdFilePath = filePath.toStdString();
-    osg::ref_ptr<osg::Node> rootNode = osgDB::readNodeFile(stdFilePath);
+    osg::ref_ptr<osg::Node> rootNode;
+    {
+        TRACE_ZONE("osgDB::readNodeFile", "文件IO");
+        rootNode = osgDB::readNodeFile(stdFilePath);
+    }
     
     if (!rootNode.valid()) {
         LOG_ERROR(QString("无法读取文件: %1").arg(filePath), "文件IO");
@@ -94,10 +116,20 @@ std::vector<Geo3D::Ptr> GeoOsgbIO::loadGeoList(const QString& filePath)
             for (unsigned int i = 0; i < sceneGroup->getNumChildren(); ++i) {
                 osg::Node* childNode = sceneGroup->getChild(i);
                 if (childNode) {
+                    if (options.rebuildFromControlPoints) {
+                        Geo3D::Ptr rebuilt = rebuildGeoFromNode(childNode, options);
+                        if (rebuilt) {
+                            result.push_back(rebuilt);
+                            continue;
+                        }
+                    }
+                    
                     Geo3D::Ptr geo = loadGeoDataFromNode(childNode);
                     if (geo) {
                         // 将OSG节点设置给几何体
                         geo->mm_node()->setOSGNode(childNode);
+                        // 文件中每个对象各存了一份渲染状态，换成样式表中共享的
+                        geo->mm_render()->applyStyle(geo->getStyle());
                         result.push_back(geo);
                         LOG_INFO(QString("成功加载几何体: %1").arg(static_cast<int>(geo->getGeoType())), "文件IO");
                     }
@@ -127,16 +159,17 @@ void GeoOsgbIO::saveGeoDataToNode(osg::Node* node, Geo3D::Ptr geo)
 {
     if (!node || !geo) return;
 
-    // 获取或创建用户数据容器
-    osg::UserDataContainer* userData = node->getOrCreateUserDataContainer();
-    
+    // setUserValue会覆盖同名值，读进来的节点再次保存时不会留下旧数据
     // 保存几何体类型
-    userData->addUserObject(new osg::StringValueObject("GeoType", 
-        QString::number(static_cast<int>(geo->getGeoType())).toStdString()));
+    node->setUserValue("GeoType", QString::number(static_cast<int>(geo->getGeoType())).toStdString());
     
     // 保存序列化的几何体数据
-    userData->addUserObject(new osg::StringValueObject("GeoData", 
-        geo->serialize().toStdString()));
+    node->setUserValue("GeoData", geo->serialize().toStdString());
+    
+    // 保存控制点，读取时可按当前细分级别重新生成几何
+    if (geo->mm_state()->isStateComplete()) {
+        node->setUserValue("ControlPoints", serializeControlPoints(geo->mm_controlPoint()->getAllStageControlPoints()));
+    }
         
     LOG_INFO("几何体数据已保存到OSG节点", "文件IO");
 }
@@ -192,3 +225,108 @@ Geo3D::Ptr GeoOsgbIO::loadGeoDataFromNode(osg::Node* node)
 } 
 
 
+
+Geo3D::Ptr GeoOsgbIO::rebuildGeoFromNode(osg::Node* node, const GeoLoadOptions& options)
+{
+    std::string controlPointData;
+    if (!node || !node->getUserValue("ControlPoints", controlPointData)) return nullptr;
+
+    std::vector<std::vector<Point3D>> stages;
+    if (!parseControlPoints(controlPointData, stages)) {
+        LOG_WARNING("控制点数据格式错误，沿用文件中的网格", "文件IO");
+        return nullptr;
+    }
+
+    Geo3D::Ptr geo = loadGeoDataFromNode(node);
+    if (!geo) return nullptr;
+
+    if (options.subdivisionOverride > 0) {
+        GeoParameters3D params = geo->getParameters();
+        params.subdivisionLevel = static_cast<SubdivisionLevel3D>(options.subdivisionOverride);
+        geo->setParameters(params);
+    }
+
+    if (!geo->mm_controlPoint()->restoreStages(stages)) {
+        LOG_WARNING(QString("控制点重放未完成，沿用文件中的网格，类型: %1").arg(static_cast<int>(geo->getGeoType())), "文件IO");
+        return nullptr;
+    }
+    return geo;
+}
+
+std::string GeoOsgbIO::serializeControlPoints(const std::vector<std::vector<Point3D>>& stages)
+{
+    QStringList stageTexts;
+    for (const auto& stage : stages) {
+        QStringList pointTexts;
+        for (const Point3D& point : stage) {
+            pointTexts << QString("%1,%2,%3")
+                .arg(point.x(), 0, 'g', 17)
+                .arg(point.y(), 0, 'g', 17)
+                .arg(point.z(), 0, 'g', 17);
+        }
+        stageTexts << pointTexts.join(";");
+    }
+    return stageTexts.join("/").toStdString();
+}
+
+bool GeoOsgbIO::parseControlPoints(const std::string& data, std::vector<std::vector<Point3D>>& stages)
+{
+    stages.clear();
+    const QStringList stageTexts = QString::fromStdString(data).split("/");
+    for (const QString& stageText : stageTexts) {
+        std::vector<Point3D> stage;
+        for (const QString& pointText : stageText.split(";", Qt::SkipEmptyParts)) {
+            const QStringList coords = pointText.split(",");
+            if (coords.size() != 3) return false;
+
+            bool okX = false, okY = false, okZ = false;
+            Point3D point(coords[0].toDouble(&okX), coords[1].toDouble(&okY), coords[2].toDouble(&okZ));
+            if (!okX || !okY || !okZ) return false;
+            stage.push_back(point);
+        }
+        stages.push_back(stage);
+    }
+    return !stages.empty() && !stages.front().empty();
+}
+
+int GeoOsgbIO::loadEntities(const QString& filePath, GeoEntityStore& store)
+{
+    TRACE_ZONE("GeoOsgbIO::loadEntities", "文件IO");
+
+    osg::ref_ptr<osg::Node> rootNode = osgDB::readNodeFile(filePath.toStdString());
+    if (!rootNode.valid() || rootNode->getName() != SCENE_ROOT_NAME) {
+        LOG_ERROR(QString("不是可读入实体存储的场景文件: %1").arg(filePath), "文件IO");
+        return 0;
+    }
+
+    osg::Group* sceneGroup = rootNode->asGroup();
+    if (!sceneGroup) return 0;
+
+    int loaded = 0;
+    int skipped = 0;
+    std::vector<std::vector<Point3D>> stages;
+    for (unsigned int i = 0; i < sceneGroup->getNumChildren(); ++i) {
+        osg::Node* childNode = sceneGroup->getChild(i);
+        std::string typeData;
+        std::string controlPointData;
+        if (!childNode || !childNode->getUserValue("GeoType", typeData)
+            || !childNode->getUserValue("ControlPoints", controlPointData)
+            || !parseControlPoints(controlPointData, stages)) {
+            ++skipped;
+            continue;
+        }
+
+        GeoType3D type = static_cast<GeoType3D>(QString::fromStdString(typeData).toInt());
+        GeoEntity entity = store.createFromStages(type, stages);
+        if (!(store.getState(entity) & GeoState_Complete3D)) {
+            store.destroy(entity);
+            ++skipped;
+            continue;
+        }
+        ++loaded;
+    }
+    store.updateBounds();
+
+    LOG_INFO(QString("实体读取完成: %1个对象，跳过%2个").arg(loaded).arg(skipped), "文件IO");
+    return loaded;
+}
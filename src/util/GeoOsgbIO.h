@@ -6,12 +6,24 @@
 #include "../core/GeometryBase.h"
 
 // 前向声明
+class GeoEntityStore;
 namespace osg {
     class Group;
     class Node;
     template<class T> class ref_ptr;
 }
 
+// 读取选项
+struct GeoLoadOptions
+{
+    // 按文件中保存的控制点重新走绘制流程生成几何，而不是沿用文件里的网格；
+    // 没有控制点的旧文件和外部文件仍沿用网格
+    bool rebuildFromControlPoints = false;
+    
+    // 重建时使用的细分级别，0表示沿用对象自身参数
+    int subdivisionOverride = 0;
+};
+
 // OSGB文件保存与读取工具类
 class GeoOsgbIO
 {
@@ -21,6 +33,11 @@ public:
     
     // 从osgb文件加载Geo3D对象列表
     static std::vector<Geo3D::Ptr> loadGeoList(const QString& filePath);
+    static std::vector<Geo3D::Ptr> loadGeoList(const QString& filePath, const GeoLoadOptions& options);
+    
+    // 只按控制点把对象读入实体存储，不创建Geo3D和网格（大场景统计、筛选、批量编辑）；
+    // 返回读入的对象数，没有控制点的对象跳过
+    static int loadEntities(const QString& filePath, GeoEntityStore& store);
 
 private:
     // 场景根节点标识名
@@ -31,6 +48,13 @@ private:
     
     // 从OSG节点中读取Geo3D对象信息
     static Geo3D::Ptr loadGeoDataFromNode(osg::Node* node);
+    
+    // 按节点中保存的控制点重建对象，没有控制点或重放失败时返回空
+    static Geo3D::Ptr rebuildGeoFromNode(osg::Node* node, const GeoLoadOptions& options);
+    
+    // 控制点按阶段序列化：阶段之间用'/'分隔，点之间用';'分隔，坐标用','分隔
+    static std::string serializeControlPoints(const std::vector<std::vector<Point3D>>& stages);
+    static bool parseControlPoints(const std::string& data, std::vector<std::vector<Point3D>>& stages);
 }; 
 
 
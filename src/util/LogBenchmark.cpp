@@ -0,0 +1,137 @@
+﻿#include "LogBenchmark.h"
+#include "LogManager.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock BenchmarkClock;
+
+    const size_t kConsumerBatchSize = 256;
+}
+
+QString LogBenchmarkResult::toString() const
+{
+    return QString("策略=%1, 生产者=%2, 每线程=%3条, 队列容量=%4\n"
+                   "总耗时=%5ms, 吞吐=%6条/秒, 批次=%7\n"
+                   "消费=%8条, 丢弃=%9条\n"
+                   "生产者写入耗时: 平均%10ns, P99 %11ns, 最大%12ns")
+        .arg(LogBenchmark::policyName(policy))
+        .arg(producerCount)
+        .arg(entriesPerProducer)
+        .arg(queueCapacity)
+        .arg(totalMs, 0, 'f', 2)
+        .arg(entriesPerSecond(), 0, 'f', 0)
+        .arg(batchCount)
+        .arg(consumedCount)
+        .arg(droppedCount)
+        .arg(producerAverageNs, 0, 'f', 1)
+        .arg(producerP99Ns, 0, 'f', 1)
+        .arg(producerMaxNs, 0, 'f', 1);
+}
+
+QString LogBenchmark::policyName(LogOverflowPolicy policy)
+{
+    switch (policy) {
+    case LogOverflowPolicy::DropOldest: return "丢弃最旧";
+    case LogOverflowPolicy::Block:      return "阻塞等待";
+    case LogOverflowPolicy::DropNewest: return "丢弃最新";
+    }
+    return "未知";
+}
+
+LogBenchmarkResult LogBenchmark::run(int producerCount, int entriesPerProducer,
+                                     LogOverflowPolicy policy, int queueCapacity)
+{
+    LogBenchmarkResult result;
+    result.producerCount = std::max(producerCount, 1);
+    result.entriesPerProducer = std::max(entriesPerProducer, 0);
+    result.policy = policy;
+
+    LogRingBuffer<LogEntry> queue(static_cast<size_t>(std::max(queueCapacity, 2)));
+    queue.setOverflowPolicy(policy);
+    result.queueCapacity = static_cast<int>(queue.capacity());
+
+    std::atomic<bool> producersDone{ false };
+    std::atomic<int> readyCount{ 0 };
+    std::atomic<bool> start{ false };
+    std::vector<std::vector<double>> latencies(result.producerCount);
+
+    // 消费者：与LogWorkerThread相同的阻塞批量取出方式
+    std::thread consumer([&]() {
+        std::vector<LogEntry> batch;
+        batch.reserve(kConsumerBatchSize);
+        for (;;) {
+            batch.clear();
+            size_t count = queue.waitPopBatch(batch, kConsumerBatchSize, 50);
+            if (count > 0) {
+                result.consumedCount += count;
+                ++result.batchCount;
+            } else if (producersDone.load() && queue.empty()) {
+                break;
+            }
+        }
+    });
+
+    // 生产者：日志内容在计时前构造好，只测量入队耗时
+    std::vector<std::thread> producers;
+    producers.reserve(result.producerCount);
+    for (int p = 0; p < result.producerCount; ++p) {
+        producers.emplace_back([&, p]() {
+            std::vector<double>& samples = latencies[p];
+            samples.reserve(result.entriesPerProducer);
+            LogEntry prototype(LogLevel::Info, QString("benchmark message from producer %1").arg(p), "性能测试",
+                               __FILE__, __LINE__, __FUNCTION__);
+
+            ++readyCount;
+            while (!start.load()) {
+                std::this_thread::yield();
+            }
+
+            for (int i = 0; i < result.entriesPerProducer; ++i) {
+                LogEntry entry(prototype);
+                BenchmarkClock::time_point before = BenchmarkClock::now();
+                queue.push(std::move(entry));
+                BenchmarkClock::time_point after = BenchmarkClock::now();
+                samples.push_back(std::chrono::duration<double, std::nano>(after - before).count());
+            }
+        });
+    }
+
+    while (readyCount.load() < result.producerCount) {
+        std::this_thread::yield();
+    }
+
+    BenchmarkClock::time_point begin = BenchmarkClock::now();
+    start = true;
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    producersDone = true;
+    queue.wakeConsumer();
+    consumer.join();
+    result.totalMs = std::chrono::duration<double, std::milli>(BenchmarkClock::now() - begin).count();
+    result.droppedCount = queue.droppedCount();
+
+    // 合并各线程的写入耗时样本
+    std::vector<double> all;
+    all.reserve(result.totalCount());
+    for (const std::vector<double>& samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    if (!all.empty()) {
+        double sum = 0.0;
+        for (double value : all) sum += value;
+        result.producerAverageNs = sum / all.size();
+
+        size_t p99Index = std::min(all.size() - 1, static_cast<size_t>(all.size() * 0.99));
+        std::nth_element(all.begin(), all.begin() + p99Index, all.end());
+        result.producerP99Ns = all[p99Index];
+        result.producerMaxNs = *std::max_element(all.begin(), all.end());
+    }
+
+    return result;
+}
@@ -0,0 +1,40 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include "LogRingBuffer.h"
+#include <QString>
+
+// 日志队列性能测试结果
+struct LogBenchmarkResult
+{
+    int producerCount = 0;             // 生产者线程数
+    int entriesPerProducer = 0;        // 每个生产者写入条数
+    int queueCapacity = 0;             // 队列容量
+    LogOverflowPolicy policy = LogOverflowPolicy::DropOldest;
+    double totalMs = 0.0;              // 从开始写入到消费者取完的总耗时
+    quint64 consumedCount = 0;         // 消费者取出条数
+    quint64 droppedCount = 0;          // 按策略丢弃条数
+    int batchCount = 0;                // 消费者取批次数
+    double producerAverageNs = 0.0;    // 生产者单次写入平均耗时
+    double producerP99Ns = 0.0;        // 生产者单次写入99分位耗时
+    double producerMaxNs = 0.0;        // 生产者单次写入最大耗时
+
+    quint64 totalCount() const { return static_cast<quint64>(producerCount) * static_cast<quint64>(entriesPerProducer); }
+    double entriesPerSecond() const { return totalMs > 0.0 ? consumedCount * 1000.0 / totalMs : 0.0; }
+
+    QString toString() const;
+};
+
+// 日志队列性能测试 - 多个生产者线程并发写入LogEntry，单个消费者线程批量取出（不做格式化和输出）
+class LogBenchmark
+{
+public:
+    static LogBenchmarkResult run(int producerCount = 4, int entriesPerProducer = 100000,
+                                  LogOverflowPolicy policy = LogOverflowPolicy::DropOldest,
+                                  int queueCapacity = 8192);
+
+    static QString policyName(LogOverflowPolicy policy);
+
+private:
+    LogBenchmark() = delete;  // 禁止实例化
+};
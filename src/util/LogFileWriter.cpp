@@ -0,0 +1,181 @@
+﻿#include "LogFileWriter.h"
+#include "LogManager.h"
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+
+// ============= 构造与析构 =============
+
+LogFileWriter::LogFileWriter()
+    : m_flushBytes(64 * 1024)
+    , m_flushIntervalMs(1000)
+    , m_flushSeverity(severity(LogLevel::Error))
+    , m_maxFileBytes(0)
+    , m_rotationIntervalMinutes(0)
+    , m_maxRotatedFiles(0)
+{
+    m_sinceFlush.start();
+}
+
+LogFileWriter::~LogFileWriter()
+{
+    close();
+}
+
+// ============= 配置 =============
+
+void LogFileWriter::configure(const LogConfig& config)
+{
+    m_flushBytes = std::max(config.fileFlushBytes, 0);
+    m_flushIntervalMs = std::max(config.fileFlushIntervalMs, 0);
+    m_flushSeverity = severity(config.fileFlushLevel);
+    m_maxFileBytes = std::max<qint64>(config.maxFileBytes, 0);
+    m_rotationIntervalMinutes = std::max(config.rotationIntervalMinutes, 0);
+    m_maxRotatedFiles = std::max(config.maxRotatedFiles, 0);
+
+    if (config.logFilePath != m_filePath) {
+        close();
+        m_filePath = config.logFilePath;
+    }
+}
+
+// ============= 写入 =============
+
+void LogFileWriter::write(const QString& line, LogLevel level)
+{
+    m_buffer.append(line.toUtf8());
+    m_buffer.append('\n');
+
+    if (severity(level) >= m_flushSeverity) {
+        flush();
+    } else if (m_buffer.size() >= m_flushBytes) {
+        flush();
+    }
+}
+
+void LogFileWriter::flushIfDue()
+{
+    if (m_buffer.isEmpty()) return;
+
+    if (m_buffer.size() >= m_flushBytes || m_sinceFlush.elapsed() >= m_flushIntervalMs) {
+        flush();
+    }
+}
+
+void LogFileWriter::flush()
+{
+    m_sinceFlush.restart();
+    if (m_buffer.isEmpty() || m_filePath.isEmpty()) return;
+
+    if (needsRotation(m_buffer.size())) {
+        rotate();
+    }
+
+    if (!ensureOpen()) {
+        // 打不开文件时丢弃缓冲，避免无限增长
+        m_buffer.clear();
+        return;
+    }
+
+    m_file.write(m_buffer);
+    m_file.flush();
+    m_buffer.clear();
+}
+
+void LogFileWriter::close()
+{
+    flush();
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+// ============= 文件与轮转 =============
+
+bool LogFileWriter::ensureOpen()
+{
+    if (m_file.isOpen()) return true;
+    if (m_filePath.isEmpty()) return false;
+
+    QDir logDir(QFileInfo(m_filePath).absolutePath());
+    if (!logDir.exists()) {
+        logDir.mkpath(".");
+    }
+
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        return false;
+    }
+
+    // 按时间轮转从本次打开开始计时（续写已有文件时同样如此）
+    m_openedAt = QDateTime::currentDateTime();
+    return true;
+}
+
+bool LogFileWriter::needsRotation(qint64 pendingBytes) const
+{
+    if (!m_file.isOpen()) {
+        // 尚未打开时只按大小判断已有文件
+        if (m_maxFileBytes <= 0) return false;
+        QFileInfo info(m_filePath);
+        return info.exists() && info.size() > 0 && info.size() + pendingBytes > m_maxFileBytes;
+    }
+
+    qint64 currentSize = m_file.size();
+    if (m_maxFileBytes > 0 && currentSize > 0 && currentSize + pendingBytes > m_maxFileBytes) {
+        return true;
+    }
+
+    if (m_rotationIntervalMinutes > 0 && m_openedAt.isValid() &&
+        m_openedAt.secsTo(QDateTime::currentDateTime()) >= static_cast<qint64>(m_rotationIntervalMinutes) * 60) {
+        return currentSize > 0;
+    }
+
+    return false;
+}
+
+void LogFileWriter::rotate()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    if (m_maxRotatedFiles <= 0) {
+        // 不保留历史文件，直接清空
+        QFile::remove(m_filePath);
+        return;
+    }
+
+    // app.log -> app.1.log -> app.2.log ...，超出保留数量的最旧文件被删除
+    QFile::remove(rotatedFilePath(m_maxRotatedFiles));
+    for (int i = m_maxRotatedFiles - 1; i >= 1; --i) {
+        QString from = rotatedFilePath(i);
+        if (QFile::exists(from)) {
+            QFile::rename(from, rotatedFilePath(i + 1));
+        }
+    }
+    QFile::rename(m_filePath, rotatedFilePath(1));
+}
+
+QString LogFileWriter::rotatedFilePath(int index) const
+{
+    QFileInfo info(m_filePath);
+    QString suffix = info.suffix();
+    QString name = suffix.isEmpty()
+        ? QString("%1.%2").arg(info.completeBaseName()).arg(index)
+        : QString("%1.%2.%3").arg(info.completeBaseName()).arg(index).arg(suffix);
+    return info.absoluteDir().filePath(name);
+}
+
+int LogFileWriter::severity(LogLevel level)
+{
+    // 成功信息按普通信息处理，不触发立即写盘
+    switch (level) {
+    case LogLevel::Debug:   return 0;
+    case LogLevel::Info:    return 1;
+    case LogLevel::Success: return 1;
+    case LogLevel::Warning: return 2;
+    case LogLevel::Error:   return 3;
+    }
+    return 1;
+}
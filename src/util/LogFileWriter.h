@@ -0,0 +1,56 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+
+enum class LogLevel;
+struct LogConfig;
+
+// 日志文件写入器 - 文件保持打开，格式化后的行先进缓冲区，按大小/时间/级别阈值写盘，并负责按大小和时间轮转
+// 只在日志工作线程中使用，不做线程同步
+class LogFileWriter
+{
+public:
+    LogFileWriter();
+    ~LogFileWriter();
+
+    // 应用配置（路径变化时关闭旧文件，下次写入时打开新文件）
+    void configure(const LogConfig& config);
+
+    // 追加一行，达到级别阈值时立即写盘
+    void write(const QString& line, LogLevel level);
+
+    // 缓冲区超过大小阈值或距上次写盘超过时间阈值时写盘（工作线程空闲时也会调用）
+    void flushIfDue();
+
+    void flush();
+    void close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    QString filePath() const { return m_filePath; }
+
+private:
+    bool ensureOpen();
+    bool needsRotation(qint64 pendingBytes) const;
+    void rotate();
+    QString rotatedFilePath(int index) const;
+    static int severity(LogLevel level);
+
+    QFile m_file;
+    QString m_filePath;
+    QByteArray m_buffer;
+    QElapsedTimer m_sinceFlush;
+    QDateTime m_openedAt;
+
+    // 阈值（取自LogConfig）
+    int m_flushBytes;
+    int m_flushIntervalMs;
+    int m_flushSeverity;
+    qint64 m_maxFileBytes;
+    int m_rotationIntervalMinutes;
+    int m_maxRotatedFiles;
+};
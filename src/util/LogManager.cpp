@@ -1,8 +1,7 @@
 ﻿#include "LogManager.h"
+#include "Tracer.h"
 #include <QDebug>
 #include <QDir>
-#include <QFile>
-#include <QTextStream>
 #include <QCoreApplication>
 #include <QMetaObject>
 #include <QFileInfo>
@@ -10,8 +9,17 @@
 
 // ==================== LogWorkerThread 实现 ====================
 
+namespace
+{
+    const size_t kLogBatchSize = 256;           // 工作线程每批最多处理的日志条数
+    const unsigned long kLogWaitTimeoutMs = 200; // 队列为空时的最长休眠时间（兜底检查退出标志）
+}
+
 LogWorkerThread::LogWorkerThread(QObject* parent)
     : QThread(parent)
+    , m_logQueue(new LogRingBuffer<LogEntry>(static_cast<size_t>(LogConfig().queueCapacity)))
+    , m_activePushes(0)
+    , m_retiredDroppedCount(0)
     , m_running(false)
     , m_shouldExit(false)
 {
@@ -34,44 +42,55 @@ LogWorkerThread::LogWorkerThread(QObject* parent)
 
 LogWorkerThread::~LogWorkerThread()
 {
-    // 设置退出标志
-    m_shouldExit = true;
-    m_running = false;
+    // 设置退出标志并唤醒工作线程
+    requestExit();
     
     // 等待线程退出
     if (isRunning()) {
-        quit();
         if (!wait(3000)) {  // 等待3秒
             terminate();
             wait(1000);  // 再等待1秒
         }
     }
+    
+    delete m_logQueue.load();
 }
 
 void LogWorkerThread::addLog(const LogEntry& entry)
 {
-    // 快速过滤
-    if (!shouldAcceptLog(entry)) {
-        return;
-    }
-    
-    // 如果队列过满，丢弃旧的日志
-    if (m_logQueue.size() > m_config.maxLogCount * 2) {
-        while (m_logQueue.size() > m_config.maxLogCount) {
-            m_logQueue.pop();
-        }
-    }
-    
-    m_logQueue.push(entry);
+    // 队列满时按溢出策略处理
+    m_activePushes.fetch_add(1);
+    m_logQueue.load()->push(entry);
+    m_activePushes.fetch_sub(1);
+}
+
+void LogWorkerThread::addLog(LogEntry&& entry)
+{
+    m_activePushes.fetch_add(1);
+    m_logQueue.load()->push(std::move(entry));
+    m_activePushes.fetch_sub(1);
 }
 
 void LogWorkerThread::setConfig(const LogConfig& config)
 {
-    m_config = config;
+    {
+        QMutexLocker locker(&m_configMutex);
+        m_config = config;
+    }
+    
+    // 容量按2的幂取整，取整后不变时不重建
+    LogRingBuffer<LogEntry>* queue = m_logQueue.load();
+    size_t capacity = static_cast<size_t>(std::max(config.queueCapacity, 2));
+    size_t roundedCapacity = 2;
+    while (roundedCapacity < capacity) roundedCapacity <<= 1;
+    if (roundedCapacity != queue->capacity()) {
+        rebuildQueue(capacity);
+    }
+    m_logQueue.load()->setOverflowPolicy(config.overflowPolicy);
     
     // 更新日志目录
-    if (!m_config.logFilePath.isEmpty()) {
-        QDir logDir(QFileInfo(m_config.logFilePath).absolutePath());
+    if (!config.logFilePath.isEmpty()) {
+        QDir logDir(QFileInfo(config.logFilePath).absolutePath());
         if (!logDir.exists()) {
             logDir.mkpath(".");
         }
@@ -80,22 +99,28 @@ void LogWorkerThread::setConfig(const LogConfig& config)
 
 LogConfig LogWorkerThread::getConfig() const
 {
+    QMutexLocker locker(&m_configMutex);
     return m_config;
 }
 
 void LogWorkerThread::setConsoleOutput(bool enabled)
 {
+    QMutexLocker locker(&m_configMutex);
     m_config.enableConsoleOutput = enabled;
 }
 
 void LogWorkerThread::setFileOutput(bool enabled)
 {
+    QMutexLocker locker(&m_configMutex);
     m_config.enableFileOutput = enabled;
 }
 
 void LogWorkerThread::setLogFilePath(const QString& path)
 {
-    m_config.logFilePath = path;
+    {
+        QMutexLocker locker(&m_configMutex);
+        m_config.logFilePath = path;
+    }
     if (!path.isEmpty()) {
         QDir logDir(QFileInfo(path).absolutePath());
         if (!logDir.exists()) {
@@ -106,91 +131,176 @@ void LogWorkerThread::setLogFilePath(const QString& path)
 
 void LogWorkerThread::setMaxLogCount(int count)
 {
+    QMutexLocker locker(&m_configMutex);
     m_config.maxLogCount = count;
 }
 
+void LogWorkerThread::setOverflowPolicy(LogOverflowPolicy policy)
+{
+    {
+        QMutexLocker locker(&m_configMutex);
+        m_config.overflowPolicy = policy;
+    }
+    m_logQueue.load()->setOverflowPolicy(policy);
+}
+
 std::list<LogEntry> LogWorkerThread::getLogs() const
 {
+    QMutexLocker locker(&m_logsMutex);
     return m_logs;
 }
 
 void LogWorkerThread::clearLogs()
 {
-    m_logs.clear();
+    {
+        QMutexLocker locker(&m_logsMutex);
+        m_logs.clear();
+    }
     emit logsCleared();
 }
 
 int LogWorkerThread::getPendingLogCount() const
 {
-    return static_cast<int>(m_logQueue.size());
+    return static_cast<int>(m_logQueue.load()->size());
 }
 
 int LogWorkerThread::getCurrentLogCount() const
 {
+    QMutexLocker locker(&m_logsMutex);
     return static_cast<int>(m_logs.size());
 }
 
+quint64 LogWorkerThread::getDroppedLogCount() const
+{
+    return m_retiredDroppedCount.load() + m_logQueue.load()->droppedCount();
+}
+
 void LogWorkerThread::requestExit()
 {
     m_shouldExit = true;
+    m_logQueue.load()->wakeConsumer();
+}
+
+void LogWorkerThread::rebuildQueue(size_t capacity)
+{
+    TRACE_ZONE("LogWorkerThread::rebuildQueue", "日志");
+    
+    // 工作线程退出前会处理完旧队列中已有的日志
+    bool wasRunning = isRunning();
+    if (wasRunning) {
+        requestExit();
+        wait();
+    }
+    
+    // 之后的生产者进入新队列；换下前已取到旧队列的生产者写入的日志，由重启后的工作线程补处理
+    LogRingBuffer<LogEntry>* queue = new LogRingBuffer<LogEntry>(capacity);
+    queue->setOverflowPolicy(getConfig().overflowPolicy);
+    m_retiredQueues.emplace_back(m_logQueue.exchange(queue));
+    
+    if (wasRunning) {
+        m_shouldExit = false;
+        start();
+    }
+}
+
+void LogWorkerThread::drainRetiredQueues(std::vector<LogEntry>& batch)
+{
+    while (!m_retiredQueues.empty()) {
+        // 先确认入队计数归零再排空：此后的生产者只会看到新队列
+        bool producersDone = m_activePushes.load() == 0;
+        
+        LogRingBuffer<LogEntry>* queue = m_retiredQueues.front().get();
+        batch.clear();
+        while (queue->popBatch(batch, kLogBatchSize) > 0) {
+            processBatch(batch);
+            batch.clear();
+        }
+        if (!producersDone) return;
+        
+        m_retiredDroppedCount.fetch_add(queue->droppedCount());
+        m_retiredQueues.erase(m_retiredQueues.begin());
+    }
 }
 
 void LogWorkerThread::run()
 {
     m_running = true;
+    Tracer::getInstance()->setCurrentThreadName("日志线程");
+    
+    std::vector<LogEntry> batch;
+    batch.reserve(kLogBatchSize);
     
-    while (m_running && !m_shouldExit) {
-        LogEntry entry;
-        bool hasEntry = false;
+    while (m_running) {
+        // 重建队列后先处理旧队列中的日志，保持先后顺序
+        drainRetiredQueues(batch);
         
-        if (!m_logQueue.empty()) {
-            entry = m_logQueue.front();
-            m_logQueue.pop();
-            hasEntry = true;
-        } else {
-            // 检查线程是否应该退出
-            if (m_shouldExit) {
-                break;
-            }
-            // 直接继续循环，Qt事件循环会自动处理CPU占用
-            continue;
-        }
+        // 队列为空时阻塞等待，有日志时整批取出
+        batch.clear();
+        m_logQueue.load()->waitPopBatch(batch, kLogBatchSize, kLogWaitTimeoutMs);
         
-        if (hasEntry) {
-            // 处理日志
-            m_logs.push_back(entry);
-            
-            // 如果日志数量超过限制，删除最旧的
-            if (m_logs.size() > m_config.maxLogCount) {
-                m_logs.pop_front();
-            }
-            
-            // 控制台输出
-            if (m_config.enableConsoleOutput) {
-                QString msg = formatLogMessage(entry);
-                qDebug().noquote() << msg;
-            }
-            
-            // 文件输出
-            if (m_config.enableFileOutput && !m_config.logFilePath.isEmpty()) {
-                writeToFile(entry);
-            }
-            
-            // 发送信号
-            emitLogAdded(entry);
+        if (!batch.empty()) {
+            processBatch(batch);
+        } else if (m_shouldExit && m_retiredQueues.empty()) {
+            // 队列已清空才退出，保证退出前的日志都被处理
+            break;
+        } else {
+            // 空闲时按时间阈值写盘
+            m_fileWriter.flushIfDue();
         }
     }
+    
+    m_fileWriter.close();
+    m_running = false;
 }
 
-void LogWorkerThread::writeToFile(const LogEntry& entry)
+void LogWorkerThread::processBatch(const std::vector<LogEntry>& batch)
 {
-    QFile file(m_config.logFilePath);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-        QTextStream stream(&file);
-        stream.setCodec("UTF-8");
-        stream << formatLogMessage(entry) << "\n";
-        file.close();
+    TRACE_ZONE("LogWorkerThread::processBatch", "日志");
+    TRACE_COUNTER("日志批大小", "日志", batch.size());
+
+    // 每批只取一次配置快照
+    LogConfig config = getConfig();
+    
+    {
+        QMutexLocker locker(&m_logsMutex);
+        m_logs.insert(m_logs.end(), batch.begin(), batch.end());
+        
+        // 如果日志数量超过限制，删除最旧的
+        while (m_logs.size() > static_cast<size_t>(std::max(config.maxLogCount, 0))) {
+            m_logs.pop_front();
+        }
+    }
+    
+    // 文件保持打开，关闭文件输出时写出缓冲并关闭
+    bool fileOutput = config.enableFileOutput && !config.logFilePath.isEmpty();
+    if (fileOutput) {
+        m_fileWriter.configure(config);
+    } else if (m_fileWriter.isOpen()) {
+        m_fileWriter.close();
+    }
+    
+    for (const LogEntry& entry : batch) {
+        if (!config.enableConsoleOutput && !fileOutput) break;
+        
+        QString msg = formatLogMessage(entry);
+        
+        // 控制台输出
+        if (config.enableConsoleOutput) {
+            qDebug().noquote() << msg;
+        }
+        
+        // 文件输出（缓冲，错误级别立即写盘）
+        if (fileOutput) {
+            m_fileWriter.write(msg, entry.level);
+        }
+    }
+    
+    if (fileOutput) {
+        m_fileWriter.flushIfDue();
     }
+    
+    // 发送信号（整批一次投递到主线程）
+    emitLogsAdded(batch);
 }
 
 QString LogWorkerThread::formatLogMessage(const LogEntry& entry) const
@@ -229,28 +339,37 @@ QString LogWorkerThread::formatLogMessage(const LogEntry& entry) const
     return message;
 }
 
-void LogWorkerThread::emitLogAdded(const LogEntry& entry)
-{
-    QMetaObject::invokeMethod(this, [this, entry]() {
-        emit logAdded(entry);
-    }, Qt::QueuedConnection);
-}
-
-bool LogWorkerThread::shouldAcceptLog(const LogEntry& entry) const
+void LogWorkerThread::emitLogsAdded(const std::vector<LogEntry>& batch)
 {
-    // 级别过滤
-    if (m_config.enableLevelFilter) {
-        if (entry.level < m_config.minLogLevel) {
-            return false;
+    QMetaObject::invokeMethod(this, [this, batch]() {
+        for (const LogEntry& entry : batch) {
+            emit logAdded(entry);
         }
-    }
-    
-    return true;
+    }, Qt::QueuedConnection);
 }
 
 // ==================== LogManager 实现 ====================
 
 LogManager* LogManager::s_instance = nullptr;
+std::atomic<int> LogManager::s_minLevel{ static_cast<int>(LogLevel::Debug) };
+std::atomic<int> LogManager::s_categoryOverrideCount{ 0 };
+std::atomic<unsigned int> LogManager::s_levelGeneration{ 0 };
+
+namespace
+{
+    // 分类级别表，设置和调用点刷新时才访问
+    struct CategoryLevelTable
+    {
+        QReadWriteLock lock;
+        QHash<QString, int> levels;
+    };
+    
+    CategoryLevelTable& categoryLevelTable()
+    {
+        static CategoryLevelTable table;
+        return table;
+    }
+}
 
 LogManager::LogManager()
     : m_workerThread(nullptr)
@@ -276,12 +395,9 @@ LogManager::~LogManager()
     if (m_workerThread) {
         qDebug() << "LogManager destructor: stopping worker thread";
         
-        // 请求线程退出
+        // 请求线程退出（唤醒阻塞中的工作线程）
         m_workerThread->requestExit();
         
-        // 停止线程
-        m_workerThread->quit();
-        
         // 等待线程退出
         if (!m_workerThread->wait(3000)) {
             qDebug() << "LogManager destructor: force terminating worker thread";
@@ -303,17 +419,89 @@ LogManager* LogManager::getInstance()
     return s_instance;
 }
 
+// ==================== 级别控制 ====================
+
+void LogManager::setMinLevel(LogLevel level)
+{
+    s_minLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+    bumpLevelGeneration();
+}
+
+LogLevel LogManager::getMinLevel()
+{
+    return static_cast<LogLevel>(s_minLevel.load(std::memory_order_relaxed));
+}
+
+void LogManager::setCategoryLevel(const QString& category, LogLevel level)
+{
+    CategoryLevelTable& table = categoryLevelTable();
+    {
+        QWriteLocker locker(&table.lock);
+        table.levels.insert(category, static_cast<int>(level));
+        s_categoryOverrideCount.store(table.levels.size(), std::memory_order_relaxed);
+    }
+    bumpLevelGeneration();
+}
+
+void LogManager::clearCategoryLevel(const QString& category)
+{
+    CategoryLevelTable& table = categoryLevelTable();
+    {
+        QWriteLocker locker(&table.lock);
+        table.levels.remove(category);
+        s_categoryOverrideCount.store(table.levels.size(), std::memory_order_relaxed);
+    }
+    bumpLevelGeneration();
+}
+
+void LogManager::clearCategoryLevels()
+{
+    CategoryLevelTable& table = categoryLevelTable();
+    {
+        QWriteLocker locker(&table.lock);
+        table.levels.clear();
+        s_categoryOverrideCount.store(0, std::memory_order_relaxed);
+    }
+    bumpLevelGeneration();
+}
+
+LogLevel LogManager::categoryLevel(const QString& category)
+{
+    if (s_categoryOverrideCount.load(std::memory_order_relaxed) > 0) {
+        CategoryLevelTable& table = categoryLevelTable();
+        QReadLocker locker(&table.lock);
+        auto it = table.levels.constFind(category);
+        if (it != table.levels.constEnd()) {
+            return static_cast<LogLevel>(it.value());
+        }
+    }
+    return getMinLevel();
+}
+
+bool LogManager::isEnabled(LogLevel level, const QString& category)
+{
+    if (static_cast<int>(level) < LOG_COMPILE_MIN_LEVEL) return false;
+    return static_cast<int>(level) >= static_cast<int>(categoryLevel(category));
+}
+
+void LogManager::bumpLevelGeneration()
+{
+    s_levelGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
 void LogManager::log(LogLevel level, const QString& message, const QString& category,
                     const QString& fileName, int lineNumber, const QString& functionName)
+{
+    if (!isEnabled(level, category)) return;
+    write(level, message, category, fileName, lineNumber, functionName);
+}
+
+void LogManager::write(LogLevel level, const QString& message, const QString& category,
+                       const QString& fileName, int lineNumber, const QString& functionName)
 {
     if (m_workerThread) {
-        // 当前调用线程构造对象
-        LogEntry entry(level, message, category, fileName, lineNumber, functionName);
-        
-        // 捕获 entry，并将其推入日志线程中执行（拷贝entry）
-        QMetaObject::invokeMethod(m_workerThread, [this, entry]() {
-            m_workerThread->addLog(entry);
-            }, Qt::QueuedConnection);
+        // 当前调用线程构造对象，直接写入无锁队列，由日志线程批量消费
+        m_workerThread->addLog(LogEntry(level, message, category, fileName, lineNumber, functionName));
     }
 }
 
@@ -357,10 +545,12 @@ void LogManager::clearLogs()
 void LogManager::setConfig(const LogConfig& config)
 {
     m_config = config;
+    
+    // 级别过滤在写入前完成（见LOG_AT_LEVEL），这里只更新全局最小级别
+    setMinLevel(config.enableLevelFilter ? config.minLogLevel : LogLevel::Debug);
+    
     if (m_workerThread) {
-        QMetaObject::invokeMethod(m_workerThread, [this, config]() {
-            m_workerThread->setConfig(config);
-        }, Qt::QueuedConnection);
+        m_workerThread->setConfig(config);
     }
 }
 
@@ -374,9 +564,7 @@ void LogManager::setMaxLogCount(int count)
     m_config.maxLogCount = count;
     
     if (m_workerThread) {
-        QMetaObject::invokeMethod(m_workerThread, [this, count]() {
-            m_workerThread->setMaxLogCount(count);
-        }, Qt::QueuedConnection);
+        m_workerThread->setMaxLogCount(count);
     }
 }
 
@@ -387,38 +575,35 @@ int LogManager::getMaxLogCount() const
 
 void LogManager::setConsoleOutput(bool enabled)
 {
+    m_config.enableConsoleOutput = enabled;
     if (m_workerThread) {
-        QMetaObject::invokeMethod(m_workerThread, [this, enabled]() {
-            m_workerThread->setConsoleOutput(enabled);
-        }, Qt::QueuedConnection);
+        m_workerThread->setConsoleOutput(enabled);
     }
 }
 
 bool LogManager::isConsoleOutputEnabled() const
 {
-    return m_workerThread ? true : false;
+    return m_workerThread ? m_workerThread->getConfig().enableConsoleOutput : false;
 }
 
 void LogManager::setFileOutput(bool enabled)
 {
+    m_config.enableFileOutput = enabled;
     if (m_workerThread) {
-        QMetaObject::invokeMethod(m_workerThread, [this, enabled]() {
-            m_workerThread->setFileOutput(enabled);
-        }, Qt::QueuedConnection);
+        m_workerThread->setFileOutput(enabled);
     }
 }
 
 bool LogManager::isFileOutputEnabled() const
 {
-    return m_workerThread ? true : false;
+    return m_workerThread ? m_workerThread->getConfig().enableFileOutput : false;
 }
 
 void LogManager::setLogFilePath(const QString& path)
 {
+    m_config.logFilePath = path;
     if (m_workerThread) {
-        QMetaObject::invokeMethod(m_workerThread, [this, path]() {
-            m_workerThread->setLogFilePath(path);
-        }, Qt::QueuedConnection);
+        m_workerThread->setLogFilePath(path);
     }
 }
 
@@ -427,6 +612,19 @@ QString LogManager::getLogFilePath() const
     return m_workerThread ? m_workerThread->getConfig().logFilePath : "";
 }
 
+void LogManager::setOverflowPolicy(LogOverflowPolicy policy)
+{
+    m_config.overflowPolicy = policy;
+    if (m_workerThread) {
+        m_workerThread->setOverflowPolicy(policy);
+    }
+}
+
+LogOverflowPolicy LogManager::getOverflowPolicy() const
+{
+    return m_config.overflowPolicy;
+}
+
 int LogManager::getPendingLogCount() const
 {
     return m_workerThread ? m_workerThread->getPendingLogCount() : 0;
@@ -435,5 +633,10 @@ int LogManager::getPendingLogCount() const
 int LogManager::getCurrentLogCount() const
 {
     return m_workerThread ? m_workerThread->getCurrentLogCount() : 0;
+}
+
+quint64 LogManager::getDroppedLogCount() const
+{
+    return m_workerThread ? m_workerThread->getDroppedLogCount() : 0;
 } 
 
@@ -5,9 +5,16 @@
 #include <QString>
 #include <QDateTime>
 #include <QThread>
-#include <queue>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QHash>
+#include <atomic>
 #include <list>
+#include <memory>
+#include <vector>
 #include <sstream>
+#include "LogRingBuffer.h"
+#include "LogFileWriter.h"
 
 // 日志级别枚举
 enum class LogLevel
@@ -189,6 +196,16 @@ struct LogConfig
     QString logFilePath = "";             // 日志文件路径
     LogLevel minLogLevel = LogLevel::Debug; // 最小日志级别
     bool enableLevelFilter = false;       // 启用日志级别过滤
+    int queueCapacity = 8192;             // 待处理队列容量（修改后排空旧队列并重建）
+    LogOverflowPolicy overflowPolicy = LogOverflowPolicy::DropOldest; // 队列满时的处理策略
+    
+    // 文件输出缓冲与轮转
+    int fileFlushBytes = 64 * 1024;       // 缓冲达到该大小时写盘
+    int fileFlushIntervalMs = 1000;       // 距上次写盘超过该时间时写盘
+    LogLevel fileFlushLevel = LogLevel::Error; // 达到该级别的日志立即写盘
+    qint64 maxFileBytes = 10 * 1024 * 1024; // 单个日志文件大小上限，超过后轮转（0表示不按大小轮转）
+    int rotationIntervalMinutes = 0;      // 按时间轮转的间隔（0表示不按时间轮转）
+    int maxRotatedFiles = 5;              // 保留的历史日志文件数量
 };
 
 // 日志工作线程类
@@ -200,8 +217,9 @@ public:
     explicit LogWorkerThread(QObject* parent = nullptr);
     ~LogWorkerThread();
 
-    // 添加日志到队列
+    // 添加日志到队列（任意线程可直接调用，不经过事件循环；级别检查已在LogManager完成）
     void addLog(const LogEntry& entry);
+    void addLog(LogEntry&& entry);
     
     // 配置管理
     void setConfig(const LogConfig& config);
@@ -212,6 +230,7 @@ public:
     void setFileOutput(bool enabled);
     void setLogFilePath(const QString& path);
     void setMaxLogCount(int count);
+    void setOverflowPolicy(LogOverflowPolicy policy);
 
     // 获取日志列表
     std::list<LogEntry> getLogs() const;
@@ -225,6 +244,9 @@ public:
     // 获取当前日志数量
     int getCurrentLogCount() const;
     
+    // 获取因队列满被丢弃的日志数量
+    quint64 getDroppedLogCount() const;
+    
     // 线程控制
     void requestExit();
 
@@ -236,23 +258,37 @@ protected:
     void run() override;
 
 private:
-    void writeToFile(const LogEntry& entry);
+    void processBatch(const std::vector<LogEntry>& batch);
     QString formatLogMessage(const LogEntry& entry) const;
-    void emitLogAdded(const LogEntry& entry);
-    bool shouldAcceptLog(const LogEntry& entry) const;
+    void emitLogsAdded(const std::vector<LogEntry>& batch);
+    
+    // 容量变化时重建队列：先让工作线程排空旧队列并退出，换上新队列后重新启动
+    void rebuildQueue(size_t capacity);
+    
+    // 处理换下的旧队列中迟到的日志，确认没有生产者再使用后释放（仅工作线程调用）
+    void drainRetiredQueues(std::vector<LogEntry>& batch);
 
-    // 日志队列
-    std::queue<LogEntry> m_logQueue;
+    // 日志队列（有界多生产者单消费者，空闲时工作线程阻塞等待）
+    // 生产者入队期间计入m_activePushes，计数归零后换下的旧队列不会再被访问
+    std::atomic<LogRingBuffer<LogEntry>*> m_logQueue;
+    alignas(64) std::atomic<int> m_activePushes;
+    std::vector<std::unique_ptr<LogRingBuffer<LogEntry>>> m_retiredQueues;  // 工作线程停止时由配置线程追加
+    std::atomic<quint64> m_retiredDroppedCount;
     
     // 日志存储
     std::list<LogEntry> m_logs;
+    mutable QMutex m_logsMutex;
     
     // 配置
     LogConfig m_config;
+    mutable QMutex m_configMutex;
+    
+    // 文件输出（仅工作线程访问）
+    LogFileWriter m_fileWriter;
     
     // 控制标志
-    bool m_running;
-    bool m_shouldExit;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_shouldExit;
 };
 
 // 日志管理器类（主线程接口）
@@ -263,7 +299,24 @@ class LogManager : public QObject
 public:
     static LogManager* getInstance();
     
-    // 日志输出接口
+    // ============= 级别控制（静态，检查时不创建日志线程） =============
+    // 全局最小级别；分类级别优先于全局级别，可用于单独打开或关闭某个分类
+    static void setMinLevel(LogLevel level);
+    static LogLevel getMinLevel();
+    static void setCategoryLevel(const QString& category, LogLevel level);
+    static void clearCategoryLevel(const QString& category);
+    static void clearCategoryLevels();
+    static LogLevel categoryLevel(const QString& category);
+    static bool isEnabled(LogLevel level, const QString& category);
+    
+    // 级别设置每次变化时递增，供LogCallSite判断缓存是否过期
+    static unsigned int levelGeneration() { return s_levelGeneration.load(std::memory_order_acquire); }
+    
+    // 写入已通过级别检查的日志（日志宏使用，不再重复检查）
+    void write(LogLevel level, const QString& message, const QString& category = "",
+               const QString& fileName = "", int lineNumber = 0, const QString& functionName = "");
+    
+    // 日志输出接口（先做级别检查）
     void log(LogLevel level, const QString& message, const QString& category = "",
              const QString& fileName = "", int lineNumber = 0, const QString& functionName = "");
     void debug(const QString& message, const QString& category = "",
@@ -295,10 +348,13 @@ public:
     bool isFileOutputEnabled() const;
     void setLogFilePath(const QString& path);
     QString getLogFilePath() const;
+    void setOverflowPolicy(LogOverflowPolicy policy);
+    LogOverflowPolicy getOverflowPolicy() const;
     
     // 统计信息
     int getPendingLogCount() const;
     int getCurrentLogCount() const;
+    quint64 getDroppedLogCount() const;
 
 signals:
     // 日志添加信号
@@ -313,10 +369,54 @@ private:
     
     // 这些是线程不安全的，但是应该不影响
     static LogManager* s_instance;
+    
+    // 级别控制
+    static void bumpLevelGeneration();
+    static std::atomic<int> s_minLevel;
+    static std::atomic<int> s_categoryOverrideCount;
+    static std::atomic<unsigned int> s_levelGeneration;
     LogWorkerThread* m_workerThread;
     LogConfig m_config;
 };
 
+// 编译期最小日志级别（0=Debug 1=Info 2=Warning 3=Error），低于该级别的日志语句被整体移除
+#ifndef LOG_COMPILE_MIN_LEVEL
+#define LOG_COMPILE_MIN_LEVEL 0
+#endif
+
+// 日志调用点 - 每条日志语句一个静态实例，缓存所在分类的运行期最小级别
+// 级别设置变化后下一次检查时重新解析，平时只比较整数，不构造消息
+// 分类在首次执行时固定，只能用于分类为字符串字面量的调用点（LOG_AT_LEVEL在编译期检查）
+class LogCallSite
+{
+public:
+    explicit LogCallSite(const QString& category)
+        : m_category(category)
+        , m_minLevel(static_cast<int>(LogLevel::Debug))
+        , m_generation(~0u)
+    {}
+    
+    bool isEnabled(LogLevel level)
+    {
+        unsigned int generation = LogManager::levelGeneration();
+        if (generation != m_generation.load(std::memory_order_acquire)) {
+            refresh(generation);
+        }
+        return static_cast<int>(level) >= m_minLevel.load(std::memory_order_relaxed);
+    }
+
+private:
+    void refresh(unsigned int generation)
+    {
+        m_minLevel.store(static_cast<int>(LogManager::categoryLevel(m_category)), std::memory_order_relaxed);
+        m_generation.store(generation, std::memory_order_release);
+    }
+    
+    QString m_category;
+    std::atomic<int> m_minLevel;
+    std::atomic<unsigned int> m_generation;
+};
+
 // 日志辅助类（支持流式输出）
 class LogStream
 {
@@ -340,7 +440,7 @@ public:
     ~LogStream()
     {
         QString message = m_stream.str().c_str();
-        LogManager::getInstance()->log(m_level, message, m_category, m_fileName, m_lineNumber, m_functionName);
+        LogManager::getInstance()->write(m_level, message, m_category, m_fileName, m_lineNumber, m_functionName);
     }
 
 private:
@@ -353,21 +453,39 @@ private:
 };
 
 // 便捷宏定义
-#define LOG_DEBUG(msg, category) \
-    LogManager::getInstance()->debug(msg, category, __FILE__, __LINE__, __FUNCTION__)
+// 先做编译期和调用点级别检查，通过后才求值消息表达式（QString::arg等），被关闭的日志只有一次比较
+// category必须是字符串字面量（"" category 拼接在传入变量时编译失败），运行期才确定的分类用LOG_AT_LEVEL_DYNAMIC
+#define LOG_AT_LEVEL(level, msg, category) \
+    do { \
+        if constexpr (static_cast<int>(level) >= LOG_COMPILE_MIN_LEVEL) { \
+            static LogCallSite logCallSite_("" category); \
+            if (logCallSite_.isEnabled(level)) { \
+                LogManager::getInstance()->write(level, msg, category, __FILE__, __LINE__, __FUNCTION__); \
+            } \
+        } \
+    } while (0)
 
-#define LOG_INFO(msg, category) \
-    LogManager::getInstance()->info(msg, category, __FILE__, __LINE__, __FUNCTION__)
+// 分类为变量时每次调用都按分类查级别（不缓存）
+#define LOG_AT_LEVEL_DYNAMIC(level, msg, category) \
+    do { \
+        if constexpr (static_cast<int>(level) >= LOG_COMPILE_MIN_LEVEL) { \
+            if (LogManager::isEnabled(level, category)) { \
+                LogManager::getInstance()->write(level, msg, category, __FILE__, __LINE__, __FUNCTION__); \
+            } \
+        } \
+    } while (0)
 
-#define LOG_WARNING(msg, category) \
-    LogManager::getInstance()->warning(msg, category, __FILE__, __LINE__, __FUNCTION__)
+#define LOG_DEBUG(msg, category) LOG_AT_LEVEL(LogLevel::Debug, msg, category)
 
-#define LOG_ERROR(msg, category) \
-    LogManager::getInstance()->error(msg, category, __FILE__, __LINE__, __FUNCTION__)
+#define LOG_INFO(msg, category) LOG_AT_LEVEL(LogLevel::Info, msg, category)
 
-#define LOG_SUCCESS(msg, category) \
-    LogManager::getInstance()->success(msg, category, __FILE__, __LINE__, __FUNCTION__)
+#define LOG_WARNING(msg, category) LOG_AT_LEVEL(LogLevel::Warning, msg, category)
 
-#define LOG_STREAM(level, category) \
-    LogStream(level, category, __FILE__, __LINE__, __FUNCTION__) 
+#define LOG_ERROR(msg, category) LOG_AT_LEVEL(LogLevel::Error, msg, category)
+
+#define LOG_SUCCESS(msg, category) LOG_AT_LEVEL(LogLevel::Success, msg, category)
 
+// 流式日志：级别关闭时不构造LogStream，也不求值<<右侧的表达式
+#define LOG_STREAM(level, category) \
+    for (bool logStreamOnce_ = LogManager::isEnabled(level, category); logStreamOnce_; logStreamOnce_ = false) \
+        LogStream(level, category, __FILE__, __LINE__, __FUNCTION__)
@@ -0,0 +1,237 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 队列满时的处理策略
+enum class LogOverflowPolicy
+{
+    DropOldest,  // 丢弃最旧的条目，为新条目腾出空间（默认）
+    Block,       // 生产者等待消费者腾出空间
+    DropNewest   // 丢弃新条目，只计数
+};
+
+// 有界多生产者单消费者环形队列
+// 入队/出队基于每个槽位的序号做无锁CAS（Vyukov有界队列），互斥量只用于空/满时的休眠与唤醒
+template<typename T>
+class LogRingBuffer
+{
+public:
+    explicit LogRingBuffer(size_t capacity = 8192)
+    {
+        // 容量取不小于capacity的2的幂，下标用掩码计算
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        m_mask = size - 1;
+        m_cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LogRingBuffer(const LogRingBuffer&) = delete;
+    LogRingBuffer& operator=(const LogRingBuffer&) = delete;
+
+    // ============= 生产者接口（任意线程） =============
+    // 返回false表示条目按策略被丢弃
+    bool push(T item)
+    {
+        if (!tryPush(item)) {
+            switch (overflowPolicy()) {
+            case LogOverflowPolicy::DropNewest:
+                m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+
+            case LogOverflowPolicy::DropOldest:
+                // 有界队列对多消费者同样安全，生产者可以直接弹出最旧条目
+                do {
+                    T discarded;
+                    if (tryPop(discarded)) {
+                        m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                    }
+                } while (!tryPush(item));
+                break;
+
+            case LogOverflowPolicy::Block:
+                if (!waitForSpace(item)) {
+                    m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                break;
+            }
+        }
+
+        notifyConsumer();
+        return true;
+    }
+
+    // ============= 消费者接口（单线程） =============
+    // 非阻塞地取出至多maxCount条，追加到out，返回取出条数
+    size_t popBatch(std::vector<T>& out, size_t maxCount)
+    {
+        size_t count = 0;
+        T item;
+        while (count < maxCount && tryPop(item)) {
+            out.push_back(std::move(item));
+            ++count;
+        }
+        if (count > 0) {
+            notifyProducers();
+        }
+        return count;
+    }
+
+    // 队列为空时休眠，直到有新条目、wakeConsumer()或超时
+    size_t waitPopBatch(std::vector<T>& out, size_t maxCount, unsigned long timeoutMs)
+    {
+        size_t count = popBatch(out, maxCount);
+        if (count > 0) return count;
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_consumerWaiting.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            count = popBatch(out, maxCount);
+            if (count == 0 && !m_wakeRequested.exchange(false)) {
+                m_notEmpty.wait(&m_mutex, timeoutMs);
+            }
+            m_consumerWaiting.store(false);
+        }
+
+        return count > 0 ? count : popBatch(out, maxCount);
+    }
+
+    // 唤醒休眠中的消费者（如请求退出时）
+    void wakeConsumer()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_wakeRequested.store(true);
+        m_notEmpty.wakeAll();
+    }
+
+    // ============= 配置与统计 =============
+    void setOverflowPolicy(LogOverflowPolicy policy)
+    {
+        m_policy.store(static_cast<int>(policy), std::memory_order_relaxed);
+        // 从阻塞切换到其他策略时放行等待中的生产者
+        QMutexLocker locker(&m_mutex);
+        m_notFull.wakeAll();
+    }
+    LogOverflowPolicy overflowPolicy() const { return static_cast<LogOverflowPolicy>(m_policy.load(std::memory_order_relaxed)); }
+
+    size_t capacity() const { return m_mask + 1; }
+    size_t size() const
+    {
+        size_t enqueue = m_enqueuePos.load(std::memory_order_relaxed);
+        size_t dequeue = m_dequeuePos.load(std::memory_order_relaxed);
+        return enqueue > dequeue ? enqueue - dequeue : 0;
+    }
+    bool empty() const { return size() == 0; }
+    quint64 droppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    bool tryPush(T& item)
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;  // 已满
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& item)
+    {
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;  // 为空
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(cell->data);
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool waitForSpace(T& item)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_producersWaiting.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool pushed = tryPush(item);
+        while (!pushed && overflowPolicy() == LogOverflowPolicy::Block) {
+            // 超时只是兜底，正常情况下由消费者取出后唤醒
+            m_notFull.wait(&m_mutex, 10);
+            pushed = tryPush(item);
+        }
+        m_producersWaiting.fetch_sub(1);
+        return pushed;
+    }
+
+    void notifyConsumer()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_consumerWaiting.load(std::memory_order_relaxed)) {
+            QMutexLocker locker(&m_mutex);
+            m_notEmpty.wakeOne();
+        }
+    }
+
+    void notifyProducers()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_producersWaiting.load(std::memory_order_relaxed) > 0) {
+            QMutexLocker locker(&m_mutex);
+            m_notFull.wakeAll();
+        }
+    }
+
+    // 生产者与消费者位置分处不同缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> m_enqueuePos{ 0 };
+    alignas(64) std::atomic<size_t> m_dequeuePos{ 0 };
+    alignas(64) std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask = 0;
+
+    std::atomic<int> m_policy{ static_cast<int>(LogOverflowPolicy::DropOldest) };
+    std::atomic<quint64> m_droppedCount{ 0 };
+
+    // 仅用于休眠/唤醒
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    std::atomic<bool> m_consumerWaiting{ false };
+    std::atomic<bool> m_wakeRequested{ false };
+    std::atomic<int> m_producersWaiting{ 0 };
+};
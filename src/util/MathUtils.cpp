@@ -6,6 +6,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/norm.hpp>
 #include <climits>
+#include <cfloat>
 
 // 常量已在头文件中定义为 constexpr，这里不需要重复定义
 
@@ -152,6 +153,47 @@ glm::dvec3 MathUtils::projectPointOnLine(const glm::dvec3& point, const glm::dve
     return lineStart + t * lineDir;
 }
 
+double MathUtils::closestPointsBetweenSegments(const glm::dvec3& p1, const glm::dvec3& q1,
+                                               const glm::dvec3& p2, const glm::dvec3& q2,
+                                               double& s, double& t)
+{
+    const glm::dvec3 d1 = q1 - p1;
+    const glm::dvec3 d2 = q2 - p2;
+    const glm::dvec3 r = p1 - p2;
+    const double a = glm::dot(d1, d1);
+    const double e = glm::dot(d2, d2);
+    const double f = glm::dot(d2, r);
+
+    s = 0.0;
+    t = 0.0;
+    if (a <= DBL_EPSILON && e <= DBL_EPSILON) {
+        return glm::dot(r, r);
+    }
+    if (a <= DBL_EPSILON) {
+        t = glm::clamp(f / e, 0.0, 1.0);
+    } else {
+        const double c = glm::dot(d1, r);
+        if (e <= DBL_EPSILON) {
+            s = glm::clamp(-c / a, 0.0, 1.0);
+        } else {
+            const double b = glm::dot(d1, d2);
+            const double denominator = a * e - b * b;
+            s = denominator > 0.0 ? glm::clamp((b * f - c * e) / denominator, 0.0, 1.0) : 0.0;
+            t = (b * s + f) / e;
+            if (t < 0.0) {
+                t = 0.0;
+                s = glm::clamp(-c / a, 0.0, 1.0);
+            } else if (t > 1.0) {
+                t = 1.0;
+                s = glm::clamp((b - c) / a, 0.0, 1.0);
+            }
+        }
+    }
+
+    const glm::dvec3 difference = (p1 + d1 * s) - (p2 + d2 * t);
+    return glm::dot(difference, difference);
+}
+
 bool MathUtils::rayIntersectsTriangle(const glm::dvec3& rayOrigin, const glm::dvec3& rayDir,
                                      const glm::dvec3& v0, const glm::dvec3& v1, const glm::dvec3& v2,
                                      double& t, glm::dvec3& intersectionPoint)
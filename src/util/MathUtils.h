@@ -35,6 +35,10 @@ public:
     // 投影和变换
     static glm::dvec3 projectPointOnPlane(const glm::dvec3& point, const glm::dvec3& planeNormal, const glm::dvec3& planePoint);
     static glm::dvec3 projectPointOnLine(const glm::dvec3& point, const glm::dvec3& lineStart, const glm::dvec3& lineEnd);
+    // 两条线段上最近点的参数（s在p1->q1上，t在p2->q2上，均在[0, 1]内），返回最近距离的平方
+    static double closestPointsBetweenSegments(const glm::dvec3& p1, const glm::dvec3& q1,
+                                               const glm::dvec3& p2, const glm::dvec3& q2,
+                                               double& s, double& t);
     
     // 相交检测
     static bool rayIntersectsTriangle(const glm::dvec3& rayOrigin, const glm::dvec3& rayDir,
@@ -0,0 +1,251 @@
+﻿#include "Tracer.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+std::atomic<bool> Tracer::s_enabled{ false };
+
+namespace
+{
+    thread_local TraceThreadBuffer* t_buffer = nullptr;
+
+    // JSON字符串转义
+    void appendJsonString(QByteArray& out, const QByteArray& utf8)
+    {
+        out.append('"');
+        for (char c : utf8) {
+            switch (c) {
+            case '"':  out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out.append(QString("\\u%1").arg(static_cast<int>(c), 4, 16, QChar('0')).toLatin1());
+                } else {
+                    out.append(c);
+                }
+                break;
+            }
+        }
+        out.append('"');
+    }
+
+    void appendJsonString(QByteArray& out, const char* text)
+    {
+        appendJsonString(out, QByteArray(text ? text : ""));
+    }
+}
+
+// ============= 单例与开关 =============
+
+Tracer* Tracer::getInstance()
+{
+    static Tracer instance;
+    return &instance;
+}
+
+Tracer::Tracer()
+    : m_epoch(std::chrono::steady_clock::now())
+    , m_maxEventsPerThread(1000000)
+{
+}
+
+void Tracer::start()
+{
+    clear();
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::stop()
+{
+    s_enabled.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::clear()
+{
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    for (const std::shared_ptr<TraceThreadBuffer>& buffer : m_buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+        buffer->droppedCount = 0;
+    }
+}
+
+void Tracer::setCurrentThreadName(const QString& name)
+{
+    TraceThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.threadName = name;
+}
+
+// ============= 记录 =============
+
+int64_t Tracer::nowUs() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+}
+
+void Tracer::recordComplete(const char* name, const char* category, int64_t startUs, int64_t endUs)
+{
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.phase = 'X';
+    event.timestampUs = startUs;
+    event.durationUs = endUs - startUs;
+    append(event);
+}
+
+void Tracer::recordCounter(const char* name, const char* category, double value)
+{
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.phase = 'C';
+    event.timestampUs = nowUs();
+    event.value = value;
+    append(event);
+}
+
+void Tracer::recordInstant(const char* name, const char* category)
+{
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.phase = 'i';
+    event.timestampUs = nowUs();
+    append(event);
+}
+
+TraceThreadBuffer& Tracer::threadBuffer()
+{
+    if (t_buffer) return *t_buffer;
+
+    // 每个线程首次记录时注册一次缓冲
+    std::shared_ptr<TraceThreadBuffer> buffer = std::make_shared<TraceThreadBuffer>();
+    buffer->events.reserve(4096);
+
+    QThread* thread = QThread::currentThread();
+    QCoreApplication* app = QCoreApplication::instance();
+    if (app && thread == app->thread()) {
+        buffer->threadName = "主线程";
+    } else if (thread && !thread->objectName().isEmpty()) {
+        buffer->threadName = thread->objectName();
+    }
+
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    buffer->threadId = static_cast<int>(m_buffers.size()) + 1;
+    if (buffer->threadName.isEmpty()) {
+        buffer->threadName = QString("线程%1").arg(buffer->threadId);
+    }
+    m_buffers.push_back(buffer);
+    t_buffer = buffer.get();
+    return *t_buffer;
+}
+
+void Tracer::append(const TraceEvent& event)
+{
+    TraceThreadBuffer& buffer = threadBuffer();
+
+    // 只有导出/清空时才会与本线程竞争
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() >= m_maxEventsPerThread) {
+        ++buffer.droppedCount;
+        return;
+    }
+    buffer.events.push_back(event);
+}
+
+// ============= 导出 =============
+
+bool Tracer::exportChromeJson(const QString& filePath) const
+{
+    QDir dir(QFileInfo(filePath).absolutePath());
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QByteArray out;
+    out.reserve(1 << 20);
+    out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    for (const std::shared_ptr<TraceThreadBuffer>& buffer : m_buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        QByteArray tid = QByteArray::number(buffer->threadId);
+
+        // 线程名元数据
+        if (!first) out.append(",\n");
+        first = false;
+        out.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":").append(tid).append(",\"args\":{\"name\":");
+        appendJsonString(out, buffer->threadName.toUtf8());
+        out.append("}}");
+
+        for (const TraceEvent& event : buffer->events) {
+            out.append(",\n{\"name\":");
+            appendJsonString(out, event.name);
+            out.append(",\"cat\":");
+            appendJsonString(out, event.category);
+            out.append(",\"ph\":\"").append(event.phase).append("\",\"ts\":").append(QByteArray::number(static_cast<qlonglong>(event.timestampUs)));
+            out.append(",\"pid\":1,\"tid\":").append(tid);
+
+            switch (event.phase) {
+            case 'X':
+                out.append(",\"dur\":").append(QByteArray::number(static_cast<qlonglong>(event.durationUs)));
+                break;
+            case 'C':
+                out.append(",\"args\":{\"value\":").append(QByteArray::number(event.value, 'g', 12)).append('}');
+                break;
+            case 'i':
+                out.append(",\"s\":\"t\"");
+                break;
+            default:
+                break;
+            }
+            out.append('}');
+
+            // 分块写出，避免整份轨迹都留在内存里
+            if (out.size() > (1 << 20)) {
+                file.write(out);
+                out.clear();
+            }
+        }
+    }
+
+    out.append("\n]}\n");
+    file.write(out);
+    file.close();
+    return file.error() == QFileDevice::NoError;
+}
+
+size_t Tracer::getEventCount() const
+{
+    size_t count = 0;
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    for (const std::shared_ptr<TraceThreadBuffer>& buffer : m_buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        count += buffer->events.size();
+    }
+    return count;
+}
+
+uint64_t Tracer::getDroppedCount() const
+{
+    uint64_t count = 0;
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    for (const std::shared_ptr<TraceThreadBuffer>& buffer : m_buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        count += buffer->droppedCount;
+    }
+    return count;
+}
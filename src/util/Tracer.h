@@ -0,0 +1,136 @@
+﻿#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 编译期开关：为0时追踪宏展开为空语句
+#ifndef TRACING_ENABLED
+#define TRACING_ENABLED 1
+#endif
+
+// 追踪事件（名称和分类必须是字符串字面量，只保存指针）
+struct TraceEvent
+{
+    const char* name = nullptr;
+    const char* category = nullptr;
+    char phase = 'X';          // 'X'区间 'C'计数器 'i'瞬时事件
+    int64_t timestampUs = 0;   // 相对追踪起点的微秒数
+    int64_t durationUs = 0;    // 区间事件的持续时间
+    double value = 0.0;        // 计数器数值
+};
+
+// 单个线程的事件缓冲，只有所属线程写入，导出时加锁读取
+struct TraceThreadBuffer
+{
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    int threadId = 0;
+    QString threadName;
+    uint64_t droppedCount = 0;
+};
+
+// 性能追踪器 - 区间/计数器事件写入线程局部缓冲，按需导出为Chrome/Perfetto JSON（chrome://tracing、ui.perfetto.dev可直接打开）
+// 未开启时每个追踪点只有一次原子读
+class Tracer
+{
+public:
+    static Tracer* getInstance();
+
+    // 开始/停止记录（开始时清空之前的事件）
+    void start();
+    void stop();
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // 清空所有线程已记录的事件
+    void clear();
+
+    // 单线程最大事件数，超出后丢弃新事件
+    void setMaxEventsPerThread(size_t maxEvents) { m_maxEventsPerThread = maxEvents; }
+    size_t getMaxEventsPerThread() const { return m_maxEventsPerThread; }
+
+    // 为当前线程命名（在导出的轨迹中显示）
+    void setCurrentThreadName(const QString& name);
+
+    // 记录事件（一般通过TRACE_*宏调用）
+    void recordComplete(const char* name, const char* category, int64_t startUs, int64_t endUs);
+    void recordCounter(const char* name, const char* category, double value);
+    void recordInstant(const char* name, const char* category);
+
+    // 相对追踪起点的当前时间（微秒）
+    int64_t nowUs() const;
+
+    // 导出为Chrome Trace Event格式
+    bool exportChromeJson(const QString& filePath) const;
+
+    // 统计
+    size_t getEventCount() const;
+    uint64_t getDroppedCount() const;
+
+private:
+    Tracer();
+    ~Tracer() = default;
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    TraceThreadBuffer& threadBuffer();
+    void append(const TraceEvent& event);
+
+    static std::atomic<bool> s_enabled;
+
+    std::chrono::steady_clock::time_point m_epoch;
+    size_t m_maxEventsPerThread;
+
+    mutable std::mutex m_buffersMutex;
+    std::vector<std::shared_ptr<TraceThreadBuffer>> m_buffers;  // 线程结束后缓冲仍保留到导出
+};
+
+// 作用域区间 - 构造时记下开始时间，析构时写入一个区间事件
+class TraceZone
+{
+public:
+    TraceZone(const char* name, const char* category)
+        : m_name(name)
+        , m_category(category)
+        , m_startUs(Tracer::isEnabled() ? Tracer::getInstance()->nowUs() : -1)
+    {
+    }
+
+    ~TraceZone()
+    {
+        if (m_startUs >= 0 && Tracer::isEnabled()) {
+            Tracer* tracer = Tracer::getInstance();
+            tracer->recordComplete(m_name, m_category, m_startUs, tracer->nowUs());
+        }
+    }
+
+private:
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+    const char* m_name;
+    const char* m_category;
+    int64_t m_startUs;
+};
+
+// ========================================= 追踪宏 =========================================
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#if TRACING_ENABLED
+#define TRACE_ZONE(name, category) TraceZone TRACE_CONCAT(traceZone_, __LINE__)(name, category)
+#define TRACE_COUNTER(name, category, value) \
+    do { if (Tracer::isEnabled()) Tracer::getInstance()->recordCounter(name, category, static_cast<double>(value)); } while (0)
+#define TRACE_INSTANT(name, category) \
+    do { if (Tracer::isEnabled()) Tracer::getInstance()->recordInstant(name, category); } while (0)
+#else
+#define TRACE_ZONE(name, category) do {} while (0)
+#define TRACE_COUNTER(name, category, value) do {} while (0)
+#define TRACE_INSTANT(name, category) do {} while (0)
+#endif